@@ -1309,6 +1309,44 @@ void btQuantizedBvh::deSerializeDouble(struct btQuantizedBvhDoubleData& quantize
 
 
 
+//btQuantizedBvhNodeData has the layout of btQuantizedBvhNode, so serialized nodes can be used directly
+//if they have the 16 byte alignment of btQuantizedBvhNode (ATTRIBUTE_ALIGNED16)
+static bool btCanReferenceQuantizedNodes(const btQuantizedBvhNodeData* nodes, int numNodes)
+{
+	return numNodes>0 && sizeof(btQuantizedBvhNodeData)==sizeof(btQuantizedBvhNode) && (((size_t)nodes)&15)==0;
+}
+
+void btQuantizedBvh::deSerializeFloatInPlace(struct btQuantizedBvhFloatData& quantizedBvhFloatData)
+{
+	btQuantizedBvhNodeData* nodes = quantizedBvhFloatData.m_quantizedContiguousNodesPtr;
+	int numNodes = quantizedBvhFloatData.m_numQuantizedContiguousNodes;
+	if (!btCanReferenceQuantizedNodes(nodes,numNodes))
+	{
+		btQuantizedBvh::deSerializeFloat(quantizedBvhFloatData);
+		return;
+	}
+	btQuantizedBvhFloatData header = quantizedBvhFloatData;
+	header.m_numQuantizedContiguousNodes = 0;
+	btQuantizedBvh::deSerializeFloat(header);
+	m_quantizedContiguousNodes.initializeFromBuffer(nodes,numNodes,numNodes);
+}
+
+void btQuantizedBvh::deSerializeDoubleInPlace(struct btQuantizedBvhDoubleData& quantizedBvhDoubleData)
+{
+	btQuantizedBvhNodeData* nodes = quantizedBvhDoubleData.m_quantizedContiguousNodesPtr;
+	int numNodes = quantizedBvhDoubleData.m_numQuantizedContiguousNodes;
+	if (!btCanReferenceQuantizedNodes(nodes,numNodes))
+	{
+		btQuantizedBvh::deSerializeDouble(quantizedBvhDoubleData);
+		return;
+	}
+	btQuantizedBvhDoubleData header = quantizedBvhDoubleData;
+	header.m_numQuantizedContiguousNodes = 0;
+	btQuantizedBvh::deSerializeDouble(header);
+	m_quantizedContiguousNodes.initializeFromBuffer(nodes,numNodes,numNodes);
+}
+
+
 ///fills the dataBuffer and returns the struct name (and 0 on failure)
 const char*	btQuantizedBvh::serialize(void* dataBuffer, btSerializer* serializer) const
 {
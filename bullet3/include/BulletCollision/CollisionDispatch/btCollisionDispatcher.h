@@ -23,6 +23,7 @@ subject to the following restrictions:
 
 #include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btThreads.h"
 
 class btIDebugDraw;
 class btOverlappingPairCache;
@@ -49,6 +50,8 @@ protected:
 
 	btAlignedObjectArray<btPersistentManifold*>	m_manifoldsPtr;
 
+	btSpinMutex	m_manifoldsMutex;	// guards m_manifoldsPtr, so manifolds can be created and released from several threads when BT_THREADSAFE is enabled
+
 	btManifoldResult	m_defaultManifoldResult;
 
 	btNearCallback		m_nearCallback;
@@ -15,6 +15,7 @@ subject to the following restrictions:
 
 
 #include "btCollisionObject.h"
+#include "btCollisionWorld.h"
 #include "LinearMath/btSerializer.h"
 
 btCollisionObject::btCollisionObject()
@@ -31,6 +32,7 @@ btCollisionObject::btCollisionObject()
 		m_islandTag1(-1),
 		m_companionId(-1),
         m_worldArrayIndex(-1),
+		m_dormantWorld(0),
 		m_activationState1(1),
 		m_deactivationTime(btScalar(0.)),
 		m_friction(btScalar(0.5)),
@@ -61,11 +63,15 @@ void btCollisionObject::setActivationState(int newState) const
 { 
 	if ( (m_activationState1 != DISABLE_DEACTIVATION) && (m_activationState1 != DISABLE_SIMULATION))
 		m_activationState1 = newState;
+	if (m_dormantWorld && isActive())
+		m_dormantWorld->wakeDormantObject(this);
 }
 
 void btCollisionObject::forceActivationState(int newState) const
 {
 	m_activationState1 = newState;
+	if (m_dormantWorld && isActive())
+		m_dormantWorld->wakeDormantObject(this);
 }
 
 void btCollisionObject::activate(bool forceActivation) const
@@ -30,29 +30,54 @@ btGhostObject::~btGhostObject()
 }
 
 
+int btGhostObject::findOverlappingObject(const btCollisionObject* otherObject) const
+{
+	const int* index = m_overlappingObjectIndices.find(btHashPtr(otherObject));
+	if (!index)
+		return m_overlappingObjects.size();
+	if (*index < m_overlappingObjects.size() && m_overlappingObjects[*index] == otherObject)
+		return *index;
+	//m_overlappingObjects was changed directly
+	return m_overlappingObjects.findLinearSearch(const_cast<btCollisionObject*>(otherObject));
+}
+
+bool btGhostObject::insertOverlappingObject(btCollisionObject* otherObject)
+{
+	if (findOverlappingObject(otherObject) < m_overlappingObjects.size())
+		return false;
+	m_overlappingObjectIndices.insert(btHashPtr(otherObject), m_overlappingObjects.size());
+	m_overlappingObjects.push_back(otherObject);
+	return true;
+}
+
+bool btGhostObject::eraseOverlappingObject(btCollisionObject* otherObject)
+{
+	int index = findOverlappingObject(otherObject);
+	if (index == m_overlappingObjects.size())
+		return false;
+	int lastIndex = m_overlappingObjects.size()-1;
+	m_overlappingObjectIndices.remove(btHashPtr(otherObject));
+	if (index < lastIndex)
+	{
+		m_overlappingObjects[index] = m_overlappingObjects[lastIndex];
+		m_overlappingObjectIndices.insert(btHashPtr(m_overlappingObjects[index]), index);
+	}
+	m_overlappingObjects.pop_back();
+	return true;
+}
+
 void btGhostObject::addOverlappingObjectInternal(btBroadphaseProxy* otherProxy,btBroadphaseProxy* thisProxy)
 {
 	btCollisionObject* otherObject = (btCollisionObject*)otherProxy->m_clientObject;
 	btAssert(otherObject);
-	///if this linearSearch becomes too slow (too many overlapping objects) we should add a more appropriate data structure
-	int index = m_overlappingObjects.findLinearSearch(otherObject);
-	if (index==m_overlappingObjects.size())
-	{
-		//not found
-		m_overlappingObjects.push_back(otherObject);
-	}
+	insertOverlappingObject(otherObject);
 }
 
 void btGhostObject::removeOverlappingObjectInternal(btBroadphaseProxy* otherProxy,btDispatcher* dispatcher,btBroadphaseProxy* thisProxy)
 {
 	btCollisionObject* otherObject = (btCollisionObject*)otherProxy->m_clientObject;
 	btAssert(otherObject);
-	int index = m_overlappingObjects.findLinearSearch(otherObject);
-	if (index<m_overlappingObjects.size())
-	{
-		m_overlappingObjects[index] = m_overlappingObjects[m_overlappingObjects.size()-1];
-		m_overlappingObjects.pop_back();
-	}
+	eraseOverlappingObject(otherObject);
 }
 
 
@@ -74,10 +99,8 @@ void btPairCachingGhostObject::addOverlappingObjectInternal(btBroadphaseProxy* o
 
 	btCollisionObject* otherObject = (btCollisionObject*)otherProxy->m_clientObject;
 	btAssert(otherObject);
-	int index = m_overlappingObjects.findLinearSearch(otherObject);
-	if (index==m_overlappingObjects.size())
+	if (insertOverlappingObject(otherObject))
 	{
-		m_overlappingObjects.push_back(otherObject);
 		m_hashPairCache->addOverlappingPair(actualThisProxy,otherProxy);
 	}
 }
@@ -89,11 +112,8 @@ void btPairCachingGhostObject::removeOverlappingObjectInternal(btBroadphaseProxy
 	btAssert(actualThisProxy);
 
 	btAssert(otherObject);
-	int index = m_overlappingObjects.findLinearSearch(otherObject);
-	if (index<m_overlappingObjects.size())
+	if (eraseOverlappingObject(otherObject))
 	{
-		m_overlappingObjects[index] = m_overlappingObjects[m_overlappingObjects.size()-1];
-		m_overlappingObjects.pop_back();
 		m_hashPairCache->removeOverlappingPair(actualThisProxy,otherProxy,dispatcher);
 	}
 }
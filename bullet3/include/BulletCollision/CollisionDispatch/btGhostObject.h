@@ -20,6 +20,7 @@ subject to the following restrictions:
 #include "btCollisionObject.h"
 #include "BulletCollision/BroadphaseCollision/btOverlappingPairCallback.h"
 #include "LinearMath/btAlignedAllocator.h"
+#include "LinearMath/btHashMap.h"
 #include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
 #include "btCollisionWorld.h"
 
@@ -36,6 +37,17 @@ ATTRIBUTE_ALIGNED16(class) btGhostObject : public btCollisionObject
 protected:
 
 	btAlignedObjectArray<btCollisionObject*> m_overlappingObjects;
+	///index of each overlapping object in m_overlappingObjects, for constant time lookups
+	btHashMap<btHashPtr,int>	m_overlappingObjectIndices;
+
+	///returns the index of otherObject in m_overlappingObjects, or getNumOverlappingObjects() if it doesn't overlap
+	int		findOverlappingObject(const btCollisionObject* otherObject) const;
+
+	///returns false if otherObject was already overlapping
+	bool	insertOverlappingObject(btCollisionObject* otherObject);
+
+	///returns false if otherObject wasn't overlapping
+	bool	eraseOverlappingObject(btCollisionObject* otherObject);
 
 public:
 
@@ -67,6 +79,13 @@ public:
 		return m_overlappingObjects[index];
 	}
 
+	bool	isOverlappingObject(const btCollisionObject* otherObject) const
+	{
+		return findOverlappingObject(otherObject) < m_overlappingObjects.size();
+	}
+
+	///use addOverlappingObjectInternal and removeOverlappingObjectInternal to change the overlapping objects,
+	///or the lookups of isOverlappingObject won't see the change
 	btAlignedObjectArray<btCollisionObject*>&	getOverlappingPairs()
 	{
 		return m_overlappingObjects;
@@ -0,0 +1,144 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btGhostTriggerCallback.h"
+#include "LinearMath/btThreads.h"
+
+
+btGhostTriggerCallback::btGhostTriggerCallback()
+{
+	//one buffer per thread index, and a shared one for threads past BT_MAX_THREAD_COUNT
+	m_threadEvents.resize(BT_MAX_THREAD_COUNT+1);
+}
+
+btGhostTriggerCallback::~btGhostTriggerCallback()
+{
+}
+
+void	btGhostTriggerCallback::recordEvent(btGhostObject* ghost, btCollisionObject* object, int type)
+{
+	btGhostTriggerEvent event;
+	event.m_ghost = ghost;
+	event.m_object = object;
+	event.m_type = type;
+
+	const unsigned int threadIndex = btGetCurrentThreadIndex();
+	if (threadIndex < BT_MAX_THREAD_COUNT)
+	{
+		m_threadEvents[threadIndex].push_back(event);
+	} else
+	{
+		btMutexLock(&m_sharedEventsMutex);
+		m_threadEvents[BT_MAX_THREAD_COUNT].push_back(event);
+		btMutexUnlock(&m_sharedEventsMutex);
+	}
+}
+
+void	btGhostTriggerCallback::addOverlappingObject(btGhostObject* ghost, btBroadphaseProxy* otherProxy, btBroadphaseProxy* thisProxy)
+{
+	btCollisionObject* otherObject = (btCollisionObject*) otherProxy->m_clientObject;
+	//pair caches can report a pair more than once, only a change of the overlapping objects is an event
+	const bool wasOverlapping = ghost->isOverlappingObject(otherObject);
+	ghost->addOverlappingObjectInternal(otherProxy, thisProxy);
+	if (!wasOverlapping && ghost->isOverlappingObject(otherObject))
+	{
+		recordEvent(ghost, otherObject, btGhostTriggerEvent::TRIGGER_ENTER);
+	}
+}
+
+void	btGhostTriggerCallback::removeOverlappingObject(btGhostObject* ghost, btBroadphaseProxy* otherProxy, btBroadphaseProxy* thisProxy, btDispatcher* dispatcher)
+{
+	btCollisionObject* otherObject = (btCollisionObject*) otherProxy->m_clientObject;
+	const bool wasOverlapping = ghost->isOverlappingObject(otherObject);
+	ghost->removeOverlappingObjectInternal(otherProxy, dispatcher, thisProxy);
+	if (wasOverlapping && !ghost->isOverlappingObject(otherObject))
+	{
+		recordEvent(ghost, otherObject, btGhostTriggerEvent::TRIGGER_EXIT);
+	}
+}
+
+btBroadphasePair*	btGhostTriggerCallback::addOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1)
+{
+	btGhostObject* ghost0 = btGhostObject::upcast((btCollisionObject*) proxy0->m_clientObject);
+	btGhostObject* ghost1 = btGhostObject::upcast((btCollisionObject*) proxy1->m_clientObject);
+	if (ghost0)
+		addOverlappingObject(ghost0, proxy1, proxy0);
+	if (ghost1)
+		addOverlappingObject(ghost1, proxy0, proxy1);
+	return 0;
+}
+
+void*	btGhostTriggerCallback::removeOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1,btDispatcher* dispatcher)
+{
+	btGhostObject* ghost0 = btGhostObject::upcast((btCollisionObject*) proxy0->m_clientObject);
+	btGhostObject* ghost1 = btGhostObject::upcast((btCollisionObject*) proxy1->m_clientObject);
+	if (ghost0)
+		removeOverlappingObject(ghost0, proxy1, proxy0, dispatcher);
+	if (ghost1)
+		removeOverlappingObject(ghost1, proxy0, proxy1, dispatcher);
+	return 0;
+}
+
+void	btGhostTriggerCallback::publishEvents()
+{
+	m_events.resize(0);
+	m_eventBalance.resize(0);
+	m_eventIndices.clear();
+
+	//the first event of a pair keeps its position, later events of the pair only change its balance
+	for (int t=0;t<m_threadEvents.size();t++)
+	{
+		btAlignedObjectArray<btGhostTriggerEvent>& threadEvents = m_threadEvents[t];
+		for (int i=0;i<threadEvents.size();i++)
+		{
+			const btGhostTriggerEvent& event = threadEvents[i];
+			const int delta = (event.m_type == btGhostTriggerEvent::TRIGGER_ENTER) ? 1 : -1;
+			PairKey key(event.m_ghost, event.m_object);
+			const int* index = m_eventIndices.find(key);
+			if (index)
+			{
+				m_eventBalance[*index] += delta;
+			} else
+			{
+				m_eventIndices.insert(key, m_events.size());
+				m_events.push_back(event);
+				m_eventBalance.push_back(delta);
+			}
+		}
+		threadEvents.resize(0);
+	}
+
+	//pairs that entered and exited (or exited and entered again) don't report anything
+	int numEvents = 0;
+	for (int i=0;i<m_events.size();i++)
+	{
+		if (m_eventBalance[i])
+		{
+			m_events[numEvents] = m_events[i];
+			m_events[numEvents].m_type = (m_eventBalance[i] > 0) ? btGhostTriggerEvent::TRIGGER_ENTER : btGhostTriggerEvent::TRIGGER_EXIT;
+			numEvents++;
+		}
+	}
+	m_events.resize(numEvents);
+}
+
+void	btGhostTriggerCallback::clearEvents()
+{
+	for (int t=0;t<m_threadEvents.size();t++)
+	{
+		m_threadEvents[t].resize(0);
+	}
+	m_events.resize(0);
+}
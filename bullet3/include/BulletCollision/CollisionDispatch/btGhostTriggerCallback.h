@@ -0,0 +1,116 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_GHOST_TRIGGER_CALLBACK_H
+#define BT_GHOST_TRIGGER_CALLBACK_H
+
+#include "btGhostObject.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btThreads.h"
+
+///btGhostTriggerEvent reports that an object started (TRIGGER_ENTER) or stopped (TRIGGER_EXIT) overlapping a ghost object
+struct btGhostTriggerEvent
+{
+	enum EventType
+	{
+		TRIGGER_ENTER,
+		TRIGGER_EXIT
+	};
+
+	btGhostObject*		m_ghost;
+	btCollisionObject*	m_object;
+	int					m_type;
+};
+
+///btGhostTriggerCallback forwards the overlapping pairs of the broadphase to the ghost objects like btGhostPairCallback,
+///and records an event whenever an object starts or stops overlapping a ghost object. The events are recorded in one buffer
+///per thread and are merged by publishEvents, which is meant to be called once per step or frame, after stepSimulation.
+///An enter and an exit of the same pair between two publishEvents calls cancel out, so getEvents holds at most one event per pair.
+///Objects that stay inside a ghost don't produce events, btGhostObject::isOverlappingObject checks whether an object is
+///still inside in constant time. The events point to the objects, so removed objects can show up in the exit events.
+///Register it with btOverlappingPairCache::setInternalGhostPairCallback instead of a btGhostPairCallback.
+class btGhostTriggerCallback : public btGhostPairCallback
+{
+	struct PairKey
+	{
+		const btGhostObject*		m_ghost;
+		const btCollisionObject*	m_object;
+
+		PairKey(const btGhostObject* ghost, const btCollisionObject* object)
+			:m_ghost(ghost),
+			m_object(object)
+		{
+		}
+
+		bool equals(const PairKey& other) const
+		{
+			return (m_ghost == other.m_ghost) && (m_object == other.m_object);
+		}
+
+		SIMD_FORCE_INLINE	unsigned int getHash() const
+		{
+			unsigned int hash = btHashPtr(m_ghost).getHash();
+			return hash ^ (btHashPtr(m_object).getHash() + 0x9e3779b9 + (hash<<6) + (hash>>2));
+		}
+	};
+
+	btAlignedObjectArray<btAlignedObjectArray<btGhostTriggerEvent> >	m_threadEvents;
+	//guards the last buffer of m_threadEvents, which is shared by the threads without a buffer of their own
+	btSpinMutex	m_sharedEventsMutex;
+	btAlignedObjectArray<btGhostTriggerEvent>	m_events;
+	//sum of the enters (+1) and exits (-1) of each event while publishing
+	btAlignedObjectArray<int>		m_eventBalance;
+	btHashMap<PairKey,int>			m_eventIndices;
+
+	void	recordEvent(btGhostObject* ghost, btCollisionObject* object, int type);
+
+	void	addOverlappingObject(btGhostObject* ghost, btBroadphaseProxy* otherProxy, btBroadphaseProxy* thisProxy);
+
+	void	removeOverlappingObject(btGhostObject* ghost, btBroadphaseProxy* otherProxy, btBroadphaseProxy* thisProxy, btDispatcher* dispatcher);
+
+public:
+
+	btGhostTriggerCallback();
+
+	virtual ~btGhostTriggerCallback();
+
+	virtual btBroadphasePair*	addOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1);
+
+	virtual void*	removeOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1,btDispatcher* dispatcher);
+
+	///merges the events recorded since the last call into getEvents
+	void	publishEvents();
+
+	///drops the recorded and published events
+	void	clearEvents();
+
+	int		getNumEvents() const
+	{
+		return m_events.size();
+	}
+
+	const btGhostTriggerEvent&	getEvent(int index) const
+	{
+		return m_events[index];
+	}
+
+	const btAlignedObjectArray<btGhostTriggerEvent>&	getEvents() const
+	{
+		return m_events;
+	}
+};
+
+#endif //BT_GHOST_TRIGGER_CALLBACK_H
@@ -0,0 +1,436 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btMappedWorldImporter.h"
+#include "btBulletCollisionCommon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///btMappedOptimizedBvh uses the serialized quantized nodes instead of copying them
+ATTRIBUTE_ALIGNED16(class) btMappedOptimizedBvh : public btOptimizedBvh
+{
+public:
+
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	virtual	void deSerializeFloat(struct btQuantizedBvhFloatData& quantizedBvhFloatData)
+	{
+		deSerializeFloatInPlace(quantizedBvhFloatData);
+	}
+
+	virtual	void deSerializeDouble(struct btQuantizedBvhDoubleData& quantizedBvhDoubleData)
+	{
+		deSerializeDoubleInPlace(quantizedBvhDoubleData);
+	}
+};
+
+///btNativeDna gives access to the serialization structures of this build, the DNA that btDefaultSerializer writes
+struct btNativeDna : public btDefaultSerializer
+{
+	btAlignedObjectArray<const char*>	m_names;
+
+	btNativeDna()
+	{
+		//SDNA, NAME, the number of names and the names
+		const char* cp = (const char*)m_dna+8;
+		int numNames = *(const int*)cp;
+		cp += sizeof(int);
+		for (int i=0;i<numNames;i++)
+		{
+			m_names.push_back(cp);
+			while (*cp)
+				cp++;
+			cp++;
+		}
+	}
+
+	bool	equals(const char* dna, int length) const
+	{
+		return length==m_dnaLength && memcmp(dna,m_dna,length)==0;
+	}
+
+	int		getNumStructs() const
+	{
+		return mStructs.size();
+	}
+
+	int		getStructSize(int structIndex) const
+	{
+		return mTlens[mStructs[structIndex][0]];
+	}
+
+	//appends the offsets of the pointers in a struct and in the structs embedded in it
+	void	collectPointerOffsets(int structIndex, int structOffset, btAlignedObjectArray<int>& offsets) const
+	{
+		const short* strc = mStructs[structIndex];
+		const int numMembers = strc[1];
+		const short* member = strc+2;
+		int offset = structOffset;
+		for (int i=0;i<numMembers;i++,member+=2)
+		{
+			const char* name = m_names[member[1]];
+			int arrayLength = 1;
+			for (const char* cp = name;*cp;cp++)
+			{
+				if (*cp=='[')
+					arrayLength *= atoi(cp+1);
+			}
+
+			if (name[0]=='*' || name[0]=='(')
+			{
+				//function pointers are not resolved
+				if (name[0]=='*')
+				{
+					for (int j=0;j<arrayLength;j++)
+					{
+						offsets.push_back(offset+j*int(sizeof(void*)));
+					}
+				}
+				offset += arrayLength*int(sizeof(void*));
+			} else
+			{
+				const int memberSize = mTlens[member[0]];
+				const int* embeddedStruct = mStructReverse.find(member[0]);
+				if (embeddedStruct)
+				{
+					for (int j=0;j<arrayLength;j++)
+					{
+						collectPointerOffsets(*embeddedStruct,offset+j*memberSize,offsets);
+					}
+				}
+				offset += arrayLength*memberSize;
+			}
+		}
+	}
+};
+
+
+btMappedWorldImporter::btMappedWorldImporter(btCollisionWorld* world)
+:btCollisionWorldImporter(world),
+m_data(0)
+{
+}
+
+btMappedWorldImporter::~btMappedWorldImporter()
+{
+}
+
+bool	btMappedWorldImporter::loadFile(const char* fileName)
+{
+	if (m_data)
+		return false;
+
+	if (!m_file.open(fileName,true))
+		return false;
+
+	if (!loadFileFromMemory((char*)m_file.getWritableData(),m_file.getSize()))
+	{
+		m_file.close();
+		return false;
+	}
+	return true;
+}
+
+bool	btMappedWorldImporter::loadFileFromMemory(char* data, size_t size)
+{
+	if (m_data || !data)
+		return false;
+
+	if (!resolvePointers(data,size))
+		return false;
+
+	m_data = data;
+	return convertAllObjects(&m_arrays);
+}
+
+bool	btMappedWorldImporter::resolvePointers(char* data, size_t size)
+{
+	if (size<BT_HEADER_LENGTH || strncmp(data,"BULLET",6))
+		return false;
+
+	int littleEndian= 1;
+	littleEndian= ((char*)&littleEndian)[0];
+	if (data[7]!=(sizeof(void*)==8 ? '-' : '_') || data[8]!=(littleEndian ? 'v' : 'V'))
+	{
+		if (m_verboseMode)
+			printf("error: the file was written with a different pointer size or byte order\n");
+		return false;
+	}
+	if (data[6]!='f' && data[6]!='d')
+		return false;
+	const bool doublePrecision = (data[6]=='d');
+
+	m_chunkMap.clear();
+	m_arrays.m_bvhsDouble.resize(0);
+	m_arrays.m_bvhsFloat.resize(0);
+	m_arrays.m_colShapeData.resize(0);
+	m_arrays.m_dynamicWorldInfoDataDouble.resize(0);
+	m_arrays.m_dynamicWorldInfoDataFloat.resize(0);
+	m_arrays.m_rigidBodyDataDouble.resize(0);
+	m_arrays.m_rigidBodyDataFloat.resize(0);
+	m_arrays.m_collisionObjectDataDouble.resize(0);
+	m_arrays.m_collisionObjectDataFloat.resize(0);
+	m_arrays.m_constraintDataFloat.resize(0);
+	m_arrays.m_constraintDataDouble.resize(0);
+	m_arrays.m_constraintData.resize(0);
+	m_arrays.m_softBodyFloatData.resize(0);
+	m_arrays.m_softBodyDoubleData.resize(0);
+
+	//the chunks follow each other up to the DNA, chunk headers are only aligned to 4 bytes and are copied out
+	btChunk chunk;
+	const char* fileDna = 0;
+	int fileDnaLength = 0;
+	size_t dnaChunkOffset = 0;
+	size_t offset = BT_HEADER_LENGTH;
+	while (offset+sizeof(btChunk)<=size)
+	{
+		memcpy(&chunk,data+offset,sizeof(btChunk));
+		offset += sizeof(btChunk);
+		if (chunk.m_length<0 || size-offset<(size_t)chunk.m_length)
+			return false;
+		if (chunk.m_chunkCode==BT_DNA_CODE)
+		{
+			fileDna = data+offset;
+			fileDnaLength = chunk.m_length;
+			dnaChunkOffset = offset-sizeof(btChunk);
+			break;
+		}
+		m_chunkMap.insert(chunk.m_oldPtr,data+offset);
+		offset += chunk.m_length;
+	}
+
+	const btNativeDna dna;
+	if (!fileDna || !dna.equals(fileDna,fileDnaLength))
+	{
+		if (m_verboseMode)
+			printf("error: the file was written with different serialization structures\n");
+		return false;
+	}
+
+	const int numStructs = dna.getNumStructs();
+	m_pointerOffsets.resize(0);
+	m_firstPointerOffsets.resize(numStructs+1);
+	for (int i=0;i<numStructs;i++)
+	{
+		m_firstPointerOffsets[i] = m_pointerOffsets.size();
+		dna.collectPointerOffsets(i,0,m_pointerOffsets);
+	}
+	m_firstPointerOffsets[numStructs] = m_pointerOffsets.size();
+
+	//replace the old pointers by the addresses of the chunks in place, old pointers without chunk become 0
+	offset = BT_HEADER_LENGTH;
+	while (offset<dnaChunkOffset)
+	{
+		memcpy(&chunk,data+offset,sizeof(btChunk));
+		offset += sizeof(btChunk);
+		char* chunkData = data+offset;
+		offset += chunk.m_length;
+
+		if (chunk.m_dna_nr>=0 && chunk.m_dna_nr<numStructs)
+		{
+			const int structSize = dna.getStructSize(chunk.m_dna_nr);
+			if (chunk.m_number<0 || (size_t)structSize*(size_t)chunk.m_number>(size_t)chunk.m_length)
+				return false;
+
+			const int firstOffset = m_firstPointerOffsets[chunk.m_dna_nr];
+			const int lastOffset = m_firstPointerOffsets[chunk.m_dna_nr+1];
+			if (firstOffset<lastOffset)
+			{
+				for (int i=0;i<chunk.m_number;i++)
+				{
+					char* element = chunkData+i*structSize;
+					for (int j=firstOffset;j<lastOffset;j++)
+					{
+						void* ptr;
+						memcpy(&ptr,element+m_pointerOffsets[j],sizeof(void*));
+						if (ptr)
+						{
+							void** newPtr = m_chunkMap.find(ptr);
+							ptr = newPtr ? *newPtr : 0;
+							memcpy(element+m_pointerOffsets[j],&ptr,sizeof(void*));
+						}
+					}
+				}
+			}
+		}
+
+		switch (chunk.m_chunkCode)
+		{
+		case BT_SOFTBODY_CODE:
+			{
+				if (doublePrecision)
+					m_arrays.m_softBodyDoubleData.push_back((btSoftBodyDoubleData*)chunkData);
+				else
+					m_arrays.m_softBodyFloatData.push_back((btSoftBodyFloatData*)chunkData);
+				break;
+			}
+		case BT_COLLISIONOBJECT_CODE:
+			{
+				if (doublePrecision)
+					m_arrays.m_collisionObjectDataDouble.push_back((btCollisionObjectDoubleData*)chunkData);
+				else
+					m_arrays.m_collisionObjectDataFloat.push_back((btCollisionObjectFloatData*)chunkData);
+				break;
+			}
+		case BT_RIGIDBODY_CODE:
+			{
+				if (doublePrecision)
+					m_arrays.m_rigidBodyDataDouble.push_back((btRigidBodyDoubleData*)chunkData);
+				else
+					m_arrays.m_rigidBodyDataFloat.push_back((btRigidBodyFloatData*)chunkData);
+				break;
+			}
+		case BT_CONSTRAINT_CODE:
+			{
+				if (doublePrecision)
+					m_arrays.m_constraintDataDouble.push_back((btTypedConstraintDoubleData*)chunkData);
+				else
+					m_arrays.m_constraintDataFloat.push_back((btTypedConstraintFloatData*)chunkData);
+				break;
+			}
+		case BT_QUANTIZED_BVH_CODE:
+			{
+				if (doublePrecision)
+					m_arrays.m_bvhsDouble.push_back((btQuantizedBvhDoubleData*)chunkData);
+				else
+					m_arrays.m_bvhsFloat.push_back((btQuantizedBvhFloatData*)chunkData);
+				break;
+			}
+		case BT_DYNAMICSWORLD_CODE:
+			{
+				if (doublePrecision)
+					m_arrays.m_dynamicWorldInfoDataDouble.push_back((btDynamicsWorldDoubleData*)chunkData);
+				else
+					m_arrays.m_dynamicWorldInfoDataFloat.push_back((btDynamicsWorldFloatData*)chunkData);
+				break;
+			}
+		case BT_SHAPE_CODE:
+			{
+				m_arrays.m_colShapeData.push_back((btCollisionShapeData*)chunkData);
+				break;
+			}
+		default:
+			{
+			}
+		};
+	}
+	return true;
+}
+
+btCollisionShape*	btMappedWorldImporter::getCollisionShapeForData(const btCollisionShapeData* shapeData)
+{
+	btCollisionShape** shapePtr = m_shapeMap.find(shapeData);
+	return shapePtr ? *shapePtr : 0;
+}
+
+void	btMappedWorldImporter::deleteAllData()
+{
+	btCollisionWorldImporter::deleteAllData();
+	m_shapeMap.clear();
+	m_bodyMap.clear();
+	m_chunkMap.clear();
+	m_file.close();
+	m_data = 0;
+}
+
+btStridingMeshInterfaceData*	btMappedWorldImporter::createStridingMeshInterfaceData(btStridingMeshInterfaceData* interfaceData)
+{
+	//the serialized mesh stays valid until deleteAllData, no copy needed
+	return interfaceData;
+}
+
+btTriangleIndexVertexArray*	btMappedWorldImporter::createMeshInterface(btStridingMeshInterfaceData& meshData)
+{
+	btTriangleIndexVertexArray* meshInterface = createTriangleMeshContainer();
+
+	for (int i=0;i<meshData.m_numMeshParts;i++)
+	{
+		const btMeshPartData& partData = meshData.m_meshPartsPtr[i];
+		btIndexedMesh meshPart;
+		meshPart.m_numTriangles = partData.m_numTriangles;
+		meshPart.m_numVertices = partData.m_numVertices;
+		meshPart.m_triangleIndexBase = 0;
+		meshPart.m_vertexBase = 0;
+
+		if (partData.m_indices32)
+		{
+			meshPart.m_indexType = PHY_INTEGER;
+			meshPart.m_triangleIndexStride = 3*sizeof(btIntIndexData);
+			meshPart.m_triangleIndexBase = (const unsigned char*)partData.m_indices32;
+		} else if (partData.m_3indices16)
+		{
+			meshPart.m_indexType = PHY_SHORT;
+			meshPart.m_triangleIndexStride = sizeof(btShortIntIndexTripletData);
+			meshPart.m_triangleIndexBase = (const unsigned char*)partData.m_3indices16;
+		} else if (partData.m_indices16)
+		{
+			//single short indices are padded to 4 bytes, they are copied into triplets
+			meshPart.m_indexType = PHY_SHORT;
+			meshPart.m_triangleIndexStride = 3*sizeof(short int);
+			short int* indexArray = (short int*)btAlignedAlloc(sizeof(short int)*3*meshPart.m_numTriangles,16);
+			m_shortIndexArrays.push_back(indexArray);
+			for (int j=0;j<3*meshPart.m_numTriangles;j++)
+			{
+				indexArray[j] = partData.m_indices16[j].m_value;
+			}
+			meshPart.m_triangleIndexBase = (const unsigned char*)indexArray;
+		} else if (partData.m_3indices8)
+		{
+			meshPart.m_indexType = PHY_UCHAR;
+			meshPart.m_triangleIndexStride = sizeof(btCharIndexTripletData);
+			meshPart.m_triangleIndexBase = (const unsigned char*)partData.m_3indices8;
+		}
+
+		if (partData.m_vertices3f)
+		{
+			meshPart.m_vertexType = PHY_FLOAT;
+			meshPart.m_vertexStride = sizeof(btVector3FloatData);
+			meshPart.m_vertexBase = (const unsigned char*)partData.m_vertices3f;
+		} else if (partData.m_vertices3d)
+		{
+			meshPart.m_vertexType = PHY_DOUBLE;
+			meshPart.m_vertexStride = sizeof(btVector3DoubleData);
+			meshPart.m_vertexBase = (const unsigned char*)partData.m_vertices3d;
+		}
+
+		if (meshPart.m_triangleIndexBase && meshPart.m_vertexBase)
+		{
+			meshInterface->addIndexedMesh(meshPart,meshPart.m_indexType);
+		}
+	}
+
+	return meshInterface;
+}
+
+btOptimizedBvh*	btMappedWorldImporter::createOptimizedBvh()
+{
+	btOptimizedBvh* bvh = new btMappedOptimizedBvh();
+	m_allocatedBvhs.push_back(bvh);
+	return bvh;
+}
+
+btBvhTriangleMeshShape*	btMappedWorldImporter::createBvhTriangleMeshShape(btStridingMeshInterface* trimesh, btOptimizedBvh* bvh)
+{
+	//the shape finds its local aabb with a pass over the triangles for each of the six directions,
+	//a single pass gives the same bounds
+	if (!trimesh->hasPremadeAabb())
+	{
+		btVector3 aabbMin,aabbMax;
+		trimesh->calculateAabbBruteForce(aabbMin,aabbMax);
+		trimesh->setPremadeAabb(aabbMin,aabbMax);
+	}
+	return btCollisionWorldImporter::createBvhTriangleMeshShape(trimesh,bvh);
+}
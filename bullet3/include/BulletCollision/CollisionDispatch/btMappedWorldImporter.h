@@ -0,0 +1,79 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_MAPPED_WORLD_IMPORTER_H
+#define BT_MAPPED_WORLD_IMPORTER_H
+
+#include "btCollisionWorldImporter.h"
+#include "LinearMath/btMappedFile.h"
+#include "LinearMath/btSerializer.h"
+
+///btMappedWorldImporter loads a .bullet file written by btDefaultSerializer without copying it. The file is mapped
+///copy-on-write and the pointers in its chunks are resolved in place, so the serialized structs are used where they are.
+///The meshes of btBvhTriangleMeshShape reference the mapped vertices and indices, and their bvh uses the mapped quantized
+///nodes. Only the pages that hold pointers become private copies, the vertices, indices and nodes stay shared with the
+///file cache. btDefaultSerializer and btStreamSerializer pad the chunks so their data starts 16 byte aligned, the nodes of
+///older files without padding are copied. The file has to be written by a build with the same pointer size, byte order and serialization structures,
+///other files are rejected. Files of both float and double precision load.
+///Collision objects are created like btCollisionWorldImporter does. Rigid bodies, constraints and soft bodies belong to
+///the dynamics library, their resolved data is available through getSerializedArrays, getCollisionShapeForData finds
+///the shape created for the collision shape of a rigid body.
+///The shapes reference the data until deleteAllData, which has to be called before the next file is loaded.
+class btMappedWorldImporter : public btCollisionWorldImporter
+{
+	btMappedFile	m_file;
+	char*			m_data;
+
+	btBulletSerializedArrays	m_arrays;
+
+	btHashMap<btHashPtr,void*>	m_chunkMap;
+
+	//the offsets of the pointers in each serialized struct, m_pointerOffsets[m_firstPointerOffsets[structIndex]] onwards
+	btAlignedObjectArray<int>	m_pointerOffsets;
+	btAlignedObjectArray<int>	m_firstPointerOffsets;
+
+	bool	resolvePointers(char* data, size_t size);
+
+public:
+
+	btMappedWorldImporter(btCollisionWorld* world);
+
+	virtual ~btMappedWorldImporter();
+
+	///maps the file and creates its shapes and collision objects, returns false if it can't be loaded in place
+	bool	loadFile(const char* fileName);
+
+	///loads serialized data in place. The data is modified and has to stay valid until deleteAllData.
+	bool	loadFileFromMemory(char* data, size_t size);
+
+	const btBulletSerializedArrays&	getSerializedArrays() const
+	{
+		return m_arrays;
+	}
+
+	btCollisionShape*	getCollisionShapeForData(const btCollisionShapeData* shapeData);
+
+	virtual void	deleteAllData();
+
+	virtual btStridingMeshInterfaceData*	createStridingMeshInterfaceData(btStridingMeshInterfaceData* interfaceData);
+
+	virtual btTriangleIndexVertexArray*	createMeshInterface(btStridingMeshInterfaceData& meshData);
+
+	virtual btOptimizedBvh*	createOptimizedBvh();
+
+	virtual btBvhTriangleMeshShape*	createBvhTriangleMeshShape(btStridingMeshInterface* trimesh, btOptimizedBvh* bvh);
+};
+
+#endif //BT_MAPPED_WORLD_IMPORTER_H
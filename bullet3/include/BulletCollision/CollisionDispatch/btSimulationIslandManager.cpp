@@ -26,7 +26,9 @@ subject to the following restrictions:
 #include "LinearMath/btQuickprof.h"
 
 btSimulationIslandManager::btSimulationIslandManager():
-m_splitIslands(true)
+m_splitIslands(true),
+m_incrementalIslands(false),
+m_collisionObjectsRevision(-1)
 {
 }
 
@@ -72,6 +74,11 @@ void btSimulationIslandManager::findUnions(btDispatcher* /* dispatcher */,btColl
 #ifdef STATIC_SIMULATION_ISLAND_OPTIMIZATION
 void   btSimulationIslandManager::updateActivationState(btCollisionWorld* colWorld,btDispatcher* dispatcher)
 {
+	if (m_incrementalIslands)
+	{
+		updateIncrementalActivationState(colWorld);
+		return;
+	}
 
 	// put the index into m_controllers into m_tag   
 	int index = 0;
@@ -99,6 +106,11 @@ void   btSimulationIslandManager::updateActivationState(btCollisionWorld* colWor
 
 void   btSimulationIslandManager::storeIslandActivationState(btCollisionWorld* colWorld)
 {
+	if (m_incrementalIslands)
+	{
+		storeIncrementalActivationState();
+		return;
+	}
 	// put the islandId ('find' value) into m_tag   
 	{
 		int index = 0;
@@ -126,6 +138,11 @@ void   btSimulationIslandManager::storeIslandActivationState(btCollisionWorld* c
 #else //STATIC_SIMULATION_ISLAND_OPTIMIZATION
 void	btSimulationIslandManager::updateActivationState(btCollisionWorld* colWorld,btDispatcher* dispatcher)
 {
+	if (m_incrementalIslands)
+	{
+		updateIncrementalActivationState(colWorld);
+		return;
+	}
 
 	initUnionFind( int (colWorld->getCollisionObjectArray().size()));
 
@@ -151,6 +168,11 @@ void	btSimulationIslandManager::updateActivationState(btCollisionWorld* colWorld
 
 void	btSimulationIslandManager::storeIslandActivationState(btCollisionWorld* colWorld)
 {
+	if (m_incrementalIslands)
+	{
+		storeIncrementalActivationState();
+		return;
+	}
 	// put the islandId ('find' value) into m_tag	
 	{
 
@@ -199,16 +221,64 @@ class btPersistentManifoldSortPredicate
 		}
 };
 
+inline	int	getManifoldBodyUid(const btCollisionObject* colObj)
+{
+	return colObj->getBroadphaseHandle() ? colObj->getBroadphaseHandle()->getUid() : -1;
+}
+
+///orders the manifolds by island, then by their bodies, see sortManifoldsCanonical
+class btPersistentManifoldCanonicalSortPredicate
+{
+	public:
+
+		bool operator() ( const btPersistentManifold* lhs, const btPersistentManifold* rhs ) const
+		{
+			const int lhsIsland = getIslandId(lhs);
+			const int rhsIsland = getIslandId(rhs);
+			if (lhsIsland != rhsIsland)
+				return lhsIsland < rhsIsland;
+			const int lhsUid0 = getManifoldBodyUid(lhs->getBody0());
+			const int lhsUid1 = getManifoldBodyUid(lhs->getBody1());
+			const int rhsUid0 = getManifoldBodyUid(rhs->getBody0());
+			const int rhsUid1 = getManifoldBodyUid(rhs->getBody1());
+			if (btMin(lhsUid0,lhsUid1) != btMin(rhsUid0,rhsUid1))
+				return btMin(lhsUid0,lhsUid1) < btMin(rhsUid0,rhsUid1);
+			if (btMax(lhsUid0,lhsUid1) != btMax(rhsUid0,rhsUid1))
+				return btMax(lhsUid0,lhsUid1) < btMax(rhsUid0,rhsUid1);
+			//several manifolds between the same bodies belong to different child shapes
+			if (lhs->getNumContacts()==0 || rhs->getNumContacts()==0)
+				return lhs->getNumContacts() < rhs->getNumContacts();
+			const btManifoldPoint& lhsPoint = lhs->getContactPoint(0);
+			const btManifoldPoint& rhsPoint = rhs->getContactPoint(0);
+			if (lhsPoint.m_partId0 != rhsPoint.m_partId0)
+				return lhsPoint.m_partId0 < rhsPoint.m_partId0;
+			if (lhsPoint.m_index0 != rhsPoint.m_index0)
+				return lhsPoint.m_index0 < rhsPoint.m_index0;
+			if (lhsPoint.m_partId1 != rhsPoint.m_partId1)
+				return lhsPoint.m_partId1 < rhsPoint.m_partId1;
+			return lhsPoint.m_index1 < rhsPoint.m_index1;
+		}
+};
+
+void btSimulationIslandManager::sortManifoldsCanonical(btAlignedObjectArray<btPersistentManifold*>& manifolds)
+{
+	manifolds.quickSort(btPersistentManifoldCanonicalSortPredicate());
+}
+
 
 void btSimulationIslandManager::buildIslands(btDispatcher* dispatcher,btCollisionWorld* collisionWorld)
 {
 
+	if (m_incrementalIslands)
+	{
+		buildIncrementalIslands(dispatcher);
+		return;
+	}
+
 	BT_PROFILE("islandUnionFindAndQuickSort");
 	
 	btCollisionObjectArray& collisionObjects = collisionWorld->getCollisionObjectArray();
 
-	m_islandmanifold.resize(0);
-
 	//we are going to sort the unionfind array, and store the element id in the size
 	//afterwards, we clean unionfind, to make sure no-one uses it anymore
 	
@@ -304,7 +374,14 @@ void btSimulationIslandManager::buildIslands(btDispatcher* dispatcher,btCollisio
 		}
 	}
 
-	
+
+	gatherIslandManifolds(dispatcher);
+}
+
+void btSimulationIslandManager::gatherIslandManifolds(btDispatcher* dispatcher)
+{
+	m_islandmanifold.resize(0);
+
 	int i;
 	int maxNumManifolds = dispatcher->getNumManifolds();
 
@@ -357,6 +434,12 @@ void btSimulationIslandManager::buildAndProcessIslands(btDispatcher* dispatcher,
 
 	buildIslands(dispatcher,collisionWorld);
 
+	if (m_incrementalIslands && m_splitIslands)
+	{
+		processIncrementalIslands(dispatcher,collisionWorld,callback);
+		return;
+	}
+
 	int endIslandIndex=1;
 	int startIslandIndex;
 	int numElem = getUnionFind().getNumElements();
@@ -367,6 +450,15 @@ void btSimulationIslandManager::buildAndProcessIslands(btDispatcher* dispatcher,
 	{
 		btPersistentManifold** manifold = dispatcher->getInternalManifoldPointer();
 		int maxNumManifolds = dispatcher->getNumManifolds();
+#ifdef BT_DETERMINISTIC
+		m_islandmanifold.resize(0);
+		for (int i=0;i<maxNumManifolds;i++)
+		{
+			m_islandmanifold.push_back(manifold[i]);
+		}
+		sortManifoldsCanonical(m_islandmanifold);
+		manifold = maxNumManifolds ? &m_islandmanifold[0] : 0;
+#endif //BT_DETERMINISTIC
 		callback->processIsland(&collisionObjects[0],collisionObjects.size(),manifold,maxNumManifolds, -1);
 	}
 	else
@@ -379,7 +471,11 @@ void btSimulationIslandManager::buildAndProcessIslands(btDispatcher* dispatcher,
 
 		//tried a radix sort, but quicksort/heapsort seems still faster
 		//@todo rewrite island management
+#ifdef BT_DETERMINISTIC
+		sortManifoldsCanonical(m_islandmanifold);
+#else
 		m_islandmanifold.quickSort(btPersistentManifoldSortPredicate());
+#endif //BT_DETERMINISTIC
 		//m_islandmanifold.heapSort(btPersistentManifoldSortPredicate());
 
 		//now process all active islands (sets of manifolds for now)
@@ -448,3 +544,318 @@ void btSimulationIslandManager::buildAndProcessIslands(btDispatcher* dispatcher,
 	} // else if(!splitIslands) 
 
 }
+
+
+void btSimulationIslandManager::rebuildIncrementalIslands(btCollisionWorld* colWorld)
+{
+	BT_PROFILE("rebuildIncrementalIslands");
+
+	btCollisionObjectArray& collisionObjects = colWorld->getCollisionObjectArray();
+
+	m_islandObjects.resize(0);
+	m_islandObjectIndices.resize(0);
+	int i;
+	for (i=0;i<collisionObjects.size();i++)
+	{
+		btCollisionObject* collisionObject = collisionObjects[i];
+		if (collisionObject->isStaticObject())
+		{
+			collisionObject->setIslandTag(-1);
+			collisionObject->setCompanionId(-2);
+		} else
+		{
+			m_islandObjects.push_back(collisionObject);
+			m_islandObjectIndices.push_back(i);
+		}
+		collisionObject->setHitFraction(btScalar(1.));
+	}
+	m_collisionObjectsRevision = colWorld->getCollisionObjectsRevision();
+
+	//start from single element islands, they are united again with the current contacts and constraints
+	const int numElements = m_islandObjects.size();
+	initUnionFind(numElements);
+	m_splitElements.resize(0);
+	m_resetElements.resize(numElements);
+	m_elementReset.resize(numElements);
+	for (i=0;i<numElements;i++)
+	{
+		m_resetElements[i] = i;
+		m_elementReset[i] = 1;
+	}
+}
+
+void btSimulationIslandManager::updateIncrementalActivationState(btCollisionWorld* colWorld)
+{
+	btCollisionObjectArray& collisionObjects = colWorld->getCollisionObjectArray();
+
+	//objects were added or removed, or a dynamic object was made static without adding it again
+	bool rebuild = (m_collisionObjectsRevision != colWorld->getCollisionObjectsRevision());
+	int i;
+	for (i=0;(i<m_islandObjects.size()) && !rebuild;i++)
+	{
+		const int index = m_islandObjectIndices[i];
+		rebuild = (index >= collisionObjects.size()) || (collisionObjects[index] != m_islandObjects[i]) || m_islandObjects[i]->isStaticObject();
+	}
+
+	if (rebuild)
+	{
+		rebuildIncrementalIslands(colWorld);
+	} else
+	{
+		//split the islands that were marked in the last buildIslands, by resetting all their elements
+		for (i=0;i<m_resetElements.size();i++)
+		{
+			m_elementReset[m_resetElements[i]] = 0;
+		}
+		m_resetElements.copyFromArray(m_splitElements);
+		m_splitElements.resize(0);
+		for (i=0;i<m_resetElements.size();i++)
+		{
+			const int element = m_resetElements[i];
+			m_elementReset[element] = 1;
+			getUnionFind().getElement(element).m_id = element;
+			getUnionFind().getElement(element).m_sz = 1;
+		}
+	}
+
+#ifdef BT_DEBUG
+	//every non-static object has to be an element, or it would never be simulated
+	{
+		int numNonStaticObjects = 0;
+		for (i=0;i<collisionObjects.size();i++)
+		{
+			if (!collisionObjects[i]->isStaticObject())
+			{
+				numNonStaticObjects++;
+			}
+		}
+		btAssert(numNonStaticObjects == m_islandObjects.size());
+	}
+#endif //BT_DEBUG
+
+	for (i=0;i<m_islandObjects.size();i++)
+	{
+		btCollisionObject* collisionObject = m_islandObjects[i];
+		collisionObject->setIslandTag(i);
+		collisionObject->setCompanionId(-1);
+		collisionObject->setHitFraction(btScalar(1.));
+	}
+
+	findUnions(0,colWorld);
+}
+
+void btSimulationIslandManager::storeIncrementalActivationState()
+{
+	for (int i=0;i<m_islandObjects.size();i++)
+	{
+		btCollisionObject* collisionObject = m_islandObjects[i];
+		if (!collisionObject->isStaticOrKinematicObject())
+		{
+			collisionObject->setIslandTag( m_unionFind.find(i) );
+			collisionObject->setCompanionId(-1);
+		} else
+		{
+			collisionObject->setIslandTag(-1);
+			collisionObject->setCompanionId(-2);
+		}
+	}
+}
+
+void btSimulationIslandManager::buildIncrementalIslands(btDispatcher* dispatcher)
+{
+	BT_PROFILE("islandIncrementalBuild");
+
+	const int numElements = m_islandObjects.size();
+
+	//group the elements by island with a counting sort on the island id, instead of sorting the union find.
+	//m_elementCounts maps an island id to the index of its island afterwards
+	m_elementCounts.resize(numElements);
+	int i;
+	for (i=0;i<numElements;i++)
+	{
+		m_elementCounts[i] = 0;
+	}
+	for (i=0;i<numElements;i++)
+	{
+		const int islandId = m_islandObjects[i]->getIslandTag();
+		if (islandId >= 0)
+		{
+			m_elementCounts[islandId]++;
+		}
+	}
+	m_islandElementStart.resize(0);
+	int numIslandElements = 0;
+	for (i=0;i<numElements;i++)
+	{
+		const int count = m_elementCounts[i];
+		if (count)
+		{
+			m_elementCounts[i] = m_islandElementStart.size();
+			m_islandElementStart.push_back(numIslandElements);
+			numIslandElements += count;
+		}
+	}
+	const int numIslands = m_islandElementStart.size();
+	m_islandElementStart.push_back(numIslandElements);
+	m_islandElements.resize(numIslandElements);
+	m_islandManifoldStart.resize(numIslands+1);
+	for (i=0;i<numIslands;i++)
+	{
+		m_islandManifoldStart[i] = m_islandElementStart[i];
+	}
+	for (i=0;i<numElements;i++)
+	{
+		const int islandId = m_islandObjects[i]->getIslandTag();
+		if (islandId >= 0)
+		{
+			m_islandElements[m_islandManifoldStart[m_elementCounts[islandId]]++] = i;
+		}
+	}
+
+	//update the sleeping state for bodies, if all are sleeping
+	for (int island=0;island<numIslands;island++)
+	{
+		const int startIslandIndex = m_islandElementStart[island];
+		const int endIslandIndex = m_islandElementStart[island+1];
+
+		bool allSleeping = true;
+		bool allIslandSleeping = true;
+		bool hasSleepingCandidate = false;
+		//an island is exact when all its elements were split at this update, otherwise bodies that are no longer in contact may still be merged
+		bool exactIsland = true;
+		int idx;
+		for (idx=startIslandIndex;idx<endIslandIndex;idx++)
+		{
+			const int element = m_islandElements[idx];
+			const int activationState = m_islandObjects[element]->getActivationState();
+			if ((activationState == ACTIVE_TAG) || (activationState == DISABLE_DEACTIVATION))
+			{
+				allSleeping = false;
+			} else
+			{
+				hasSleepingCandidate = true;
+			}
+			if (activationState != ISLAND_SLEEPING)
+			{
+				allIslandSleeping = false;
+			}
+			if (!m_elementReset[element])
+			{
+				exactIsland = false;
+			}
+		}
+		if (endIslandIndex-startIslandIndex == 1)
+		{
+			exactIsland = true;
+		}
+
+		if (allSleeping)
+		{
+			if (exactIsland || allIslandSleeping)
+			{
+				for (idx=startIslandIndex;idx<endIslandIndex;idx++)
+				{
+					m_islandObjects[m_islandElements[idx]]->setActivationState( ISLAND_SLEEPING );
+				}
+			} else
+			{
+				//split the island before it goes to sleep, so only bodies that are still in contact sleep together
+				for (idx=startIslandIndex;idx<endIslandIndex;idx++)
+				{
+					m_splitElements.push_back(m_islandElements[idx]);
+				}
+			}
+		} else
+		{
+			for (idx=startIslandIndex;idx<endIslandIndex;idx++)
+			{
+				btCollisionObject* colObj0 = m_islandObjects[m_islandElements[idx]];
+				if ( colObj0->getActivationState() == ISLAND_SLEEPING)
+				{
+					colObj0->setActivationState( WANTS_DEACTIVATION);
+					colObj0->setDeactivationTime(0.f);
+				}
+			}
+			//bodies that want to sleep may only be kept awake by a merge that is no longer valid
+			if (hasSleepingCandidate && !exactIsland)
+			{
+				for (idx=startIslandIndex;idx<endIslandIndex;idx++)
+				{
+					m_splitElements.push_back(m_islandElements[idx]);
+				}
+			}
+		}
+	}
+
+	gatherIslandManifolds(dispatcher);
+}
+
+void btSimulationIslandManager::processIncrementalIslands(btDispatcher* dispatcher,btCollisionWorld* collisionWorld, IslandCallback* callback)
+{
+	(void) dispatcher;
+	(void) collisionWorld;
+
+	BT_PROFILE("processIslands");
+
+#ifdef BT_DETERMINISTIC
+	sortManifoldsCanonical(m_islandmanifold);
+#endif //BT_DETERMINISTIC
+
+	//group the manifolds by island with a counting sort, in the order of the islands
+	const int numIslands = m_islandElementStart.size()-1;
+	const int numManifolds = m_islandmanifold.size();
+	int i;
+	for (i=0;i<=numIslands;i++)
+	{
+		m_islandManifoldStart[i] = 0;
+	}
+	for (i=0;i<numManifolds;i++)
+	{
+		const int islandId = getIslandId(m_islandmanifold[i]);
+		if (islandId >= 0)
+		{
+			m_islandManifoldStart[m_elementCounts[islandId]+1]++;
+		}
+	}
+	for (i=0;i<numIslands;i++)
+	{
+		m_islandManifoldStart[i+1] += m_islandManifoldStart[i];
+	}
+	m_sortedManifolds.resize(m_islandManifoldStart[numIslands]);
+	for (i=0;i<numManifolds;i++)
+	{
+		const int islandId = getIslandId(m_islandmanifold[i]);
+		if (islandId >= 0)
+		{
+			m_sortedManifolds[m_islandManifoldStart[m_elementCounts[islandId]]++] = m_islandmanifold[i];
+		}
+	}
+	//the scatter moved each start to the end of its island, shift them back
+	for (i=numIslands;i>0;i--)
+	{
+		m_islandManifoldStart[i] = m_islandManifoldStart[i-1];
+	}
+	m_islandManifoldStart[0] = 0;
+
+	//traverse the simulation islands, and call the solver, unless all objects are sleeping/deactivated
+	for (int island=0;island<numIslands;island++)
+	{
+		bool islandSleeping = true;
+		for (int idx=m_islandElementStart[island];idx<m_islandElementStart[island+1];idx++)
+		{
+			btCollisionObject* colObj0 = m_islandObjects[m_islandElements[idx]];
+			m_islandBodies.push_back(colObj0);
+			if (colObj0->isActive())
+				islandSleeping = false;
+		}
+
+		if (!islandSleeping)
+		{
+			const int numIslandManifolds = m_islandManifoldStart[island+1]-m_islandManifoldStart[island];
+			btPersistentManifold** startManifold = numIslandManifolds ? &m_sortedManifolds[m_islandManifoldStart[island]] : 0;
+			callback->processIsland(&m_islandBodies[0],m_islandBodies.size(),startManifold,numIslandManifolds, m_islandBodies[0]->getIslandTag());
+		}
+
+		m_islandBodies.resize(0);
+	}
+}
@@ -17,6 +17,7 @@ subject to the following restrictions:
 #define BT_HEIGHTFIELD_TERRAIN_SHAPE_H
 
 #include "btConcaveShape.h"
+#include "LinearMath/btAlignedObjectArray.h"
 
 ///btHeightfieldTerrainShape simulates a 2D heightfield terrain
 /**
@@ -67,6 +68,13 @@ subject to the following restrictions:
   axis-aligned bounding box, multiplied by localScaling.
 
   For usage and testing see the TerrainDemo.
+
+  Collision queries against large terrains can be accelerated with
+  buildAccelerator(), which computes a min/max height pyramid over blocks
+  of grid cells so that processAllTriangles and performRaycast can reject
+  whole blocks that cannot overlap the query. The pyramid is a snapshot of
+  the heights at the time it is built: if the heightfield data changes,
+  call buildAccelerator() again (or clearAccelerator()).
  */
 ATTRIBUTE_ALIGNED16(class) btHeightfieldTerrainShape : public btConcaveShape
 {
@@ -95,14 +103,52 @@ protected:
 	bool	m_flipQuadEdges;
   	bool  m_useDiamondSubdivision;
 	bool m_useZigzagSubdivision;
+	bool	m_useRowDecoding;
 
 	int	m_upAxis;
 	
 	btVector3	m_localScaling;
 
+	///min/max raw height of a block of grid cells
+	struct Range
+	{
+		btScalar	m_min;
+		btScalar	m_max;
+
+		Range() {}
+		Range(btScalar min, btScalar max) :m_min(min), m_max(max) {}
+
+		bool overlaps(btScalar min, btScalar max) const
+		{
+			return !(m_min > max || min > m_max);
+		}
+	};
+
+	///min/max height pyramid, all levels stored consecutively starting with the finest one.
+	///A block of level 0 covers m_vboundsChunkSize x m_vboundsChunkSize cells, each further level halves the resolution.
+	btAlignedObjectArray<Range>	m_vboundsPyramid;
+	btAlignedObjectArray<int>	m_vboundsLevelOffset;
+	btAlignedObjectArray<int>	m_vboundsLevelWidth;
+	btAlignedObjectArray<int>	m_vboundsLevelLength;
+	int	m_vboundsChunkSize;
+
 	virtual btScalar	getRawHeightFieldValue(int x,int y) const;
+	///decodes count consecutive raw heights of row y, starting at column startX. Unless row decoding is enabled
+	///(see setUseRowDecoding) this calls getRawHeightFieldValue for every height, so derived classes that override it still work.
+	virtual void	getRawHeightFieldRow(int y,int startX,int count,btScalar* out) const;
 	void		quantizeWithClamp(int* out, const btVector3& point,int isMax) const;
 	void		getVertex(int x,int y,btVector3& vertex) const;
+	void		getVertexFromHeight(int x,int y,btScalar height,btVector3& vertex) const;
+
+	///reports the two triangles of cell (x,y), given the raw heights of its corners (x,y), (x+1,y), (x,y+1) and (x+1,y+1)
+	void		processCell(btTriangleCallback* callback,int x,int y,const btScalar* heights) const;
+	///reports all triangles of the cells in [startX,endX) x [startJ,endJ), decoding the heights row by row
+	void		processCells(btTriangleCallback* callback,int startX,int endX,int startJ,int endJ) const;
+	void		processBlock(btTriangleCallback* callback,int level,int blockX,int blockJ,int startX,int endX,int startJ,int endJ,btScalar minHeight,btScalar maxHeight) const;
+	const Range&	getBlockRange(int level,int blockX,int blockJ) const
+	{
+		return m_vboundsPyramid[m_vboundsLevelOffset[level] + blockJ*m_vboundsLevelWidth[level] + blockX];
+	}
 
 
 
@@ -149,10 +195,23 @@ public:
 	///could help compatibility with Ogre heightfields. See https://code.google.com/p/bullet/issues/detail?id=625	
 	void setUseZigzagSubdivision(bool useZigzagSubdivision=true) { m_useZigzagSubdivision = useZigzagSubdivision;}
 
+	///decode whole rows of the height data at once in processAllTriangles, raycasts and buildAccelerator, instead of
+	///calling getRawHeightFieldValue for every height. Only enable it if getRawHeightFieldValue isn't overridden.
+	void setUseRowDecoding(bool useRowDecoding=true) { m_useRowDecoding = useRowDecoding;}
+
 	virtual void getAabb(const btTransform& t,btVector3& aabbMin,btVector3& aabbMax) const;
 
 	virtual void	processAllTriangles(btTriangleCallback* callback,const btVector3& aabbMin,const btVector3& aabbMax) const;
 
+	///reports the triangles of the cells crossed by the ray, in the order they are crossed.
+	///raySource and rayTarget are in the local (scaled) coordinates of the shape, like for processAllTriangles.
+	void	performRaycast(btTriangleCallback* callback,const btVector3& raySource,const btVector3& rayTarget) const;
+
+	///builds the min/max height pyramid used to cull blocks of cells, see the class description
+	void	buildAccelerator(int chunkSize=16);
+	void	clearAccelerator();
+	bool	hasAccelerator() const { return m_vboundsPyramid.size() > 0; }
+
 	virtual void	calculateLocalInertia(btScalar mass,btVector3& inertia) const;
 
 	virtual void	setLocalScaling(const btVector3& scaling);
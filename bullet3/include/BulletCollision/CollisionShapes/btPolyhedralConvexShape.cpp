@@ -19,6 +19,7 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionShapes/btPolyhedralConvexShape.h"
 #include "btConvexPolyhedron.h"
 #include "LinearMath/btConvexHullComputer.h"
+#include "LinearMath/btConvexHullCache.h"
 #include <new>
 #include "LinearMath/btGeometryUtil.h"
 #include "LinearMath/btGrahamScan2dConvexHull.h"
@@ -39,6 +40,18 @@ btPolyhedralConvexShape::~btPolyhedralConvexShape()
 	}
 }
 
+static void computeConvexHull(btConvexHullComputer& conv, const btAlignedObjectArray<btVector3>& points)
+{
+	//large point clouds are split across threads, hulls seen before are taken from the cache
+	btConvexHullCache* cache = btGetConvexHullCache();
+	if (cache)
+	{
+		cache->compute(conv, &points[0].getX(), sizeof(btVector3), points.size(), 0.f, 0.f);
+	} else
+	{
+		conv.computeParallel(&points[0].getX(), sizeof(btVector3), points.size(), 0.f, 0.f);
+	}
+}
 
 bool	btPolyhedralConvexShape::initializePolyhedralFeatures(int shiftVerticesByMargin)
 {
@@ -80,11 +93,11 @@ bool	btPolyhedralConvexShape::initializePolyhedralFeatures(int shiftVerticesByMa
 
 		btGeometryUtil::getVerticesFromPlaneEquations(shiftedPlaneEquations,tmpVertices);
 	
-		conv.compute(&tmpVertices[0].getX(), sizeof(btVector3),tmpVertices.size(),0.f,0.f);
+		computeConvexHull(conv, tmpVertices);
 	} else
 	{
 		
-		conv.compute(&orgVertices[0].getX(), sizeof(btVector3),orgVertices.size(),0.f,0.f);
+		computeConvexHull(conv, orgVertices);
 	}
 
 
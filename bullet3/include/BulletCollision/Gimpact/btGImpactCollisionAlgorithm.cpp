@@ -30,6 +30,7 @@ Concave-Concave Collision
 #include "btGImpactCollisionAlgorithm.h"
 #include "btContactProcessing.h"
 #include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
 
 
 //! Class for accessing the plane equation
@@ -385,78 +386,153 @@ void btGImpactCollisionAlgorithm::collide_gjk_triangles(const btCollisionObjectW
 	shape1->unlockChildShapes();
 }
 
-void btGImpactCollisionAlgorithm::collide_sat_triangles(const btCollisionObjectWrapper* body0Wrap,
-					  const btCollisionObjectWrapper* body1Wrap,
-					  const btGImpactMeshShapePart * shape0,
+//! triangle pairs are gathered and tested for overlap in batches of this size
+#define BT_GIMPACT_TRIANGLE_BATCH 16
+//! pairs per task when the triangle pairs are split across threads
+#define BT_GIMPACT_TRIANGLE_PAIRS_PER_TASK 128
+
+//! Collides the triangle pairs [begin,end), the triangle indices are kept as contact features
+static void bt_collide_triangle_pairs(const btGImpactMeshShapePart * shape0,
 					  const btGImpactMeshShapePart * shape1,
-					  const int * pairs, int pair_count)
+					  const btTransform & trans0,
+					  const btTransform & trans1,
+					  const int * pairs, int begin, int end,
+					  btContactArray & contacts)
 {
-	btTransform orgtrans0 = body0Wrap->getWorldTransform();
-	btTransform orgtrans1 = body1Wrap->getWorldTransform();
-
-	btPrimitiveTriangle ptri0;
-	btPrimitiveTriangle ptri1;
+	btPrimitiveTriangle ptri0[BT_GIMPACT_TRIANGLE_BATCH];
+	btPrimitiveTriangle ptri1[BT_GIMPACT_TRIANGLE_BATCH];
+	bool overlap[BT_GIMPACT_TRIANGLE_BATCH];
 	GIM_TRIANGLE_CONTACT contact_data;
 
-	shape0->lockChildShapes();
-	shape1->lockChildShapes();
-
-	const int * pair_pointer = pairs;
-
-	while(pair_count--)
+	for (int batch = begin; batch < end; batch += BT_GIMPACT_TRIANGLE_BATCH)
 	{
+		int count = btMin(BT_GIMPACT_TRIANGLE_BATCH, end - batch);
+		const int * pair_pointer = pairs + batch * 2;
 
-		m_triface0 = *(pair_pointer);
-		m_triface1 = *(pair_pointer+1);
-		pair_pointer+=2;
-
-
-		shape0->getPrimitiveTriangle(m_triface0,ptri0);
-		shape1->getPrimitiveTriangle(m_triface1,ptri1);
-
-		#ifdef TRI_COLLISION_PROFILING
-		bt_begin_gim02_tri_time();
-		#endif
-
-		ptri0.applyTransform(orgtrans0);
-		ptri1.applyTransform(orgtrans1);
-
+		for (int i = 0; i < count; i++)
+		{
+			shape0->getPrimitiveTriangle(pair_pointer[i * 2], ptri0[i]);
+			shape1->getPrimitiveTriangle(pair_pointer[i * 2 + 1], ptri1[i]);
 
-		//build planes
-		ptri0.buildTriPlane();
-		ptri1.buildTriPlane();
-		// test conservative
+			ptri0[i].applyTransform(trans0);
+			ptri1[i].applyTransform(trans1);
 
+			//build planes
+			ptri0[i].buildTriPlane();
+			ptri1[i].buildTriPlane();
+		}
 
+		// test conservative, the whole batch at once
+		bt_overlap_test_conservative_batch(ptri0, ptri1, count, overlap);
 
-		if(ptri0.overlap_test_conservative(ptri1))
+		for (int i = 0; i < count; i++)
 		{
-			if(ptri0.find_triangle_collision_clip_method(ptri1,contact_data))
+			if (overlap[i] && ptri0[i].find_triangle_collision_clip_method(ptri1[i], contact_data))
 			{
-
 				int j = contact_data.m_point_count;
-				while(j--)
+				while (j--)
 				{
-
-					addContactPoint(body0Wrap, body1Wrap,
-								contact_data.m_points[j],
-								contact_data.m_separating_normal,
-								-contact_data.m_penetration_depth);
+					contacts.push_contact(contact_data.m_points[j],
+						contact_data.m_separating_normal,
+						contact_data.m_penetration_depth,
+						pair_pointer[i * 2], pair_pointer[i * 2 + 1]);
 				}
 			}
 		}
+	}
+}
 
-		#ifdef TRI_COLLISION_PROFILING
-		bt_end_gim02_tri_time();
-		#endif
+//! Collides the triangle pairs of a range of tasks, each task fills its own contact array
+struct btGImpactTrianglePairsTask : public btIParallelForBody
+{
+	const btGImpactMeshShapePart * m_shape0;
+	const btGImpactMeshShapePart * m_shape1;
+	btTransform m_trans0;
+	btTransform m_trans1;
+	const int * m_pairs;
+	int m_pair_count;
+	btContactArray * m_task_contacts;
+
+	virtual void forLoop(int iBegin, int iEnd) const
+	{
+		for (int task = iBegin; task < iEnd; task++)
+		{
+			int begin = task * BT_GIMPACT_TRIANGLE_PAIRS_PER_TASK;
+			int end = btMin(begin + BT_GIMPACT_TRIANGLE_PAIRS_PER_TASK, m_pair_count);
+			bt_collide_triangle_pairs(m_shape0, m_shape1, m_trans0, m_trans1, m_pairs, begin, end, m_task_contacts[task]);
+		}
+	}
+};
+
+void btGImpactCollisionAlgorithm::collide_sat_triangles(const btCollisionObjectWrapper* body0Wrap,
+					  const btCollisionObjectWrapper* body1Wrap,
+					  const btGImpactMeshShapePart * shape0,
+					  const btGImpactMeshShapePart * shape1,
+					  const int * pairs, int pair_count)
+{
+	btTransform orgtrans0 = body0Wrap->getWorldTransform();
+	btTransform orgtrans1 = body1Wrap->getWorldTransform();
+
+	shape0->lockChildShapes();
+	shape1->lockChildShapes();
 
+	#ifdef TRI_COLLISION_PROFILING
+	bt_begin_gim02_tri_time();
+	#endif
+
+	int task_count = (pair_count + BT_GIMPACT_TRIANGLE_PAIRS_PER_TASK - 1) / BT_GIMPACT_TRIANGLE_PAIRS_PER_TASK;
+
+	if (task_count > 1 && btGetTaskScheduler()->getNumThreads() > 1)
+	{
+		// contacts are added to the manifold in task order, which is pair order,
+		// so the result doesn't depend on the number of threads
+		btAlignedObjectArray<btContactArray> task_contacts;
+		task_contacts.resize(task_count);
+
+		btGImpactTrianglePairsTask task;
+		task.m_shape0 = shape0;
+		task.m_shape1 = shape1;
+		task.m_trans0 = orgtrans0;
+		task.m_trans1 = orgtrans1;
+		task.m_pairs = pairs;
+		task.m_pair_count = pair_count;
+		task.m_task_contacts = &task_contacts[0];
+		btParallelFor(0, task_count, 1, task);
+
+		for (int i = 0; i < task_count; i++)
+		{
+			addTriangleContacts(body0Wrap, body1Wrap, task_contacts[i]);
+		}
+	}
+	else
+	{
+		btContactArray contacts;
+		bt_collide_triangle_pairs(shape0, shape1, orgtrans0, orgtrans1, pairs, 0, pair_count, contacts);
+		addTriangleContacts(body0Wrap, body1Wrap, contacts);
 	}
 
+	#ifdef TRI_COLLISION_PROFILING
+	bt_end_gim02_tri_time();
+	#endif
+
 	shape0->unlockChildShapes();
 	shape1->unlockChildShapes();
 
 }
 
+void btGImpactCollisionAlgorithm::addTriangleContacts(const btCollisionObjectWrapper * body0Wrap,
+					const btCollisionObjectWrapper * body1Wrap,
+					const btContactArray & contacts)
+{
+	for (int i = 0; i < contacts.size(); i++)
+	{
+		const GIM_CONTACT & contact = contacts[i];
+		m_triface0 = contact.m_feature1;
+		m_triface1 = contact.m_feature2;
+		addContactPoint(body0Wrap, body1Wrap, contact.m_point, contact.m_normal, -contact.m_depth);
+	}
+}
+
 
 void btGImpactCollisionAlgorithm::gimpact_vs_gimpact(
 						const btCollisionObjectWrapper* body0Wrap,
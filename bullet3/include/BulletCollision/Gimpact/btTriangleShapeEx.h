@@ -127,6 +127,15 @@ public:
 };
 
 
+//! Conservative overlap test for a batch of triangle pairs
+/*!
+Gives the same answer as tris0[i].overlap_test_conservative(tris1[i]) for every pair,
+but classifies four pairs at once with SIMD when available.
+\pre all triangles must have their planes calculated
+*/
+void bt_overlap_test_conservative_batch(const btPrimitiveTriangle * tris0, const btPrimitiveTriangle * tris1, int count, bool * results);
+
+
 
 //! Helper class for colliding Bullet Triangle Shapes
 /*!
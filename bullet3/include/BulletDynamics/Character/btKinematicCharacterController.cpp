@@ -176,6 +176,14 @@ btPairCachingGhostObject* btKinematicCharacterController::getGhostObject()
 }
 
 bool btKinematicCharacterController::recoverFromPenetration ( btCollisionWorld* collisionWorld)
+{
+	updateGhostObjectAabb(collisionWorld);
+	bool penetration = resolvePenetration(collisionWorld, m_manifoldArray);
+	updateGhostObjectPosition();
+	return penetration;
+}
+
+void btKinematicCharacterController::updateGhostObjectAabb ( btCollisionWorld* collisionWorld)
 {
 	// Here we must refresh the overlapping paircache as the penetrating movement itself or the
 	// previous recovery iteration might have used setWorldTransform and pushed us into an object
@@ -191,7 +199,10 @@ bool btKinematicCharacterController::recoverFromPenetration ( btCollisionWorld*
 						 minAabb, 
 						 maxAabb, 
 						 collisionWorld->getDispatcher());
-						 
+}
+
+bool btKinematicCharacterController::resolvePenetration ( btCollisionWorld* collisionWorld, btManifoldArray& manifoldArray)
+{
 	bool penetration = false;
 
 	collisionWorld->getDispatcher()->dispatchAllCollisionPairs(m_ghostObject->getOverlappingPairCache(), collisionWorld->getDispatchInfo(), collisionWorld->getDispatcher());
@@ -201,7 +212,7 @@ bool btKinematicCharacterController::recoverFromPenetration ( btCollisionWorld*
 //	btScalar maxPen = btScalar(0.0);
 	for (int i = 0; i < m_ghostObject->getOverlappingPairCache()->getNumOverlappingPairs(); i++)
 	{
-		m_manifoldArray.resize(0);
+		manifoldArray.resize(0);
 
 		btBroadphasePair* collisionPair = &m_ghostObject->getOverlappingPairCache()->getOverlappingPairArray()[i];
 
@@ -215,12 +226,12 @@ bool btKinematicCharacterController::recoverFromPenetration ( btCollisionWorld*
 			continue;
 		
 		if (collisionPair->m_algorithm)
-			collisionPair->m_algorithm->getAllContactManifolds(m_manifoldArray);
+			collisionPair->m_algorithm->getAllContactManifolds(manifoldArray);
 
 		
-		for (int j=0;j<m_manifoldArray.size();j++)
+		for (int j=0;j<manifoldArray.size();j++)
 		{
-			btPersistentManifold* manifold = m_manifoldArray[j];
+			btPersistentManifold* manifold = manifoldArray[j];
 			btScalar directionSign = manifold->getBody0() == m_ghostObject ? btScalar(-1.0) : btScalar(1.0);
 			for (int p=0;p<manifold->getNumContacts();p++)
 			{
@@ -247,14 +258,41 @@ bool btKinematicCharacterController::recoverFromPenetration ( btCollisionWorld*
 			//manifold->clearManifold();
 		}
 	}
+//	printf("m_touchingNormal = %f,%f,%f\n",m_touchingNormal[0],m_touchingNormal[1],m_touchingNormal[2]);
+	return penetration;
+}
+
+void btKinematicCharacterController::updateGhostObjectPosition()
+{
 	btTransform newTrans = m_ghostObject->getWorldTransform();
 	newTrans.setOrigin(m_currentPosition);
 	m_ghostObject->setWorldTransform(newTrans);
-//	printf("m_touchingNormal = %f,%f,%f\n",m_touchingNormal[0],m_touchingNormal[1],m_touchingNormal[2]);
-	return penetration;
 }
 
 void btKinematicCharacterController::stepUp ( btCollisionWorld* world)
+{
+	if (sweepUp(world))
+	{
+		updateGhostObjectPosition();
+
+		// fix penetration if we hit a ceiling for example
+		int numPenetrationLoops = 0;
+		m_touchingContact = false;
+		while (recoverFromPenetration(world))
+		{
+			numPenetrationLoops++;
+			m_touchingContact = true;
+			if (numPenetrationLoops > 4)
+			{
+				//printf("character could not recover from penetration = %d\n", numPenetrationLoops);
+				break;
+			}
+		}
+		endStepUp();
+	}
+}
+
+bool btKinematicCharacterController::sweepUp ( btCollisionWorld* world)
 {
 	btScalar stepHeight = 0.0f;
 	if (m_verticalVelocity < 0.0)
@@ -302,36 +340,24 @@ void btKinematicCharacterController::stepUp ( btCollisionWorld* world)
 			else
 				m_currentPosition = m_targetPosition;
 		}
+		return true;
+	}
 
-		btTransform& xform = m_ghostObject->getWorldTransform();
-		xform.setOrigin(m_currentPosition);
-		m_ghostObject->setWorldTransform(xform);
+	m_currentStepOffset = stepHeight;
+	m_currentPosition = m_targetPosition;
+	return false;
+}
 
-		// fix penetration if we hit a ceiling for example
-		int numPenetrationLoops = 0;
-		m_touchingContact = false;
-		while (recoverFromPenetration(world))
-		{
-			numPenetrationLoops++;
-			m_touchingContact = true;
-			if (numPenetrationLoops > 4)
-			{
-				//printf("character could not recover from penetration = %d\n", numPenetrationLoops);
-				break;
-			}
-		}
-		m_targetPosition = m_ghostObject->getWorldTransform().getOrigin();
-		m_currentPosition = m_targetPosition;
+void btKinematicCharacterController::endStepUp()
+{
+	m_targetPosition = m_ghostObject->getWorldTransform().getOrigin();
+	m_currentPosition = m_targetPosition;
 
-		if (m_verticalOffset > 0)
-		{
-			m_verticalOffset = 0.0;
-			m_verticalVelocity = 0.0;
-			m_currentStepOffset = m_stepHeight;
-		}
-	} else {
-		m_currentStepOffset = stepHeight;
-		m_currentPosition = m_targetPosition;
+	if (m_verticalOffset > 0)
+	{
+		m_verticalOffset = 0.0;
+		m_verticalVelocity = 0.0;
+		m_currentStepOffset = m_stepHeight;
 	}
 }
 
@@ -719,6 +745,48 @@ void btKinematicCharacterController::playerStep (  btCollisionWorld* collisionWo
 //	printf("playerStep(): ");
 //	printf("  dt = %f", dt);
 
+	if (!beginPlayerStep(dt))
+		return;
+
+	stepUp(collisionWorld);
+	//todo: Experimenting with behavior of controller when it hits a ceiling..
+	//bool hitUp = stepUp (collisionWorld);	
+	//if (hitUp)
+	//{
+	//	m_verticalVelocity -= m_gravity * dt;
+	//	if (m_verticalVelocity > 0.0 && m_verticalVelocity > m_jumpSpeed)
+	//	{
+	//		m_verticalVelocity = m_jumpSpeed;
+	//	}
+	//	if (m_verticalVelocity < 0.0 && btFabs(m_verticalVelocity) > btFabs(m_fallSpeed))
+	//	{
+	//		m_verticalVelocity = -btFabs(m_fallSpeed);
+	//	}
+	//	m_verticalOffset = m_verticalVelocity * dt;
+
+	//	xform = m_ghostObject->getWorldTransform();
+	//}
+
+	stepForwardAndDown(collisionWorld, dt);
+
+	updateGhostObjectPosition();
+
+	int numPenetrationLoops = 0;
+	m_touchingContact = false;
+	while (recoverFromPenetration(collisionWorld))
+	{
+		numPenetrationLoops++;
+		m_touchingContact = true;
+		if (numPenetrationLoops > 4)
+		{
+			//printf("character could not recover from penetration = %d\n", numPenetrationLoops);
+			break;
+		}
+	}
+}
+
+bool btKinematicCharacterController::beginPlayerStep (btScalar dt)
+{
 	if (m_AngVel.length2() > 0.0f)
 	{
 		m_AngVel *= btPow(btScalar(1) - m_angularDamping, dt);
@@ -746,7 +814,7 @@ void btKinematicCharacterController::playerStep (  btCollisionWorld* collisionWo
 	// quick check...
 	if (!m_useWalkDirection && (m_velocityTimeInterval <= 0.0)) {
 //		printf("\n");
-		return;		// no motion
+		return false;		// no motion
 	}
 
 	m_wasOnGround = onGround();
@@ -774,31 +842,14 @@ void btKinematicCharacterController::playerStep (  btCollisionWorld* collisionWo
 	}
 	m_verticalOffset = m_verticalVelocity * dt;
 
-	btTransform xform;
-	xform = m_ghostObject->getWorldTransform();
+	return true;
+}
 
+void btKinematicCharacterController::stepForwardAndDown (  btCollisionWorld* collisionWorld, btScalar dt)
+{
 //	printf("walkDirection(%f,%f,%f)\n",walkDirection[0],walkDirection[1],walkDirection[2]);
 //	printf("walkSpeed=%f\n",walkSpeed);
 
-	stepUp(collisionWorld);
-	//todo: Experimenting with behavior of controller when it hits a ceiling..
-	//bool hitUp = stepUp (collisionWorld);	
-	//if (hitUp)
-	//{
-	//	m_verticalVelocity -= m_gravity * dt;
-	//	if (m_verticalVelocity > 0.0 && m_verticalVelocity > m_jumpSpeed)
-	//	{
-	//		m_verticalVelocity = m_jumpSpeed;
-	//	}
-	//	if (m_verticalVelocity < 0.0 && btFabs(m_verticalVelocity) > btFabs(m_fallSpeed))
-	//	{
-	//		m_verticalVelocity = -btFabs(m_fallSpeed);
-	//	}
-	//	m_verticalOffset = m_verticalVelocity * dt;
-
-	//	xform = m_ghostObject->getWorldTransform();
-	//}
-
 	if (m_useWalkDirection) {
 		stepForwardAndStrafe (collisionWorld, m_walkDirection);
 	} else {
@@ -834,22 +885,6 @@ void btKinematicCharacterController::playerStep (  btCollisionWorld* collisionWo
 	//	}
 	//}
 	// printf("\n");
-
-	xform.setOrigin (m_currentPosition);
-	m_ghostObject->setWorldTransform (xform);
-
-	int numPenetrationLoops = 0;
-	m_touchingContact = false;
-	while (recoverFromPenetration(collisionWorld))
-	{
-		numPenetrationLoops++;
-		m_touchingContact = true;
-		if (numPenetrationLoops > 4)
-		{
-			//printf("character could not recover from penetration = %d\n", numPenetrationLoops);
-			break;
-		}
-	}
 }
 
 void btKinematicCharacterController::setFallSpeed (btScalar fallSpeed)
@@ -167,6 +167,25 @@ public:
 	void preStep (  btCollisionWorld* collisionWorld);
 	void playerStep ( btCollisionWorld* collisionWorld, btScalar dt);
 
+	///The phases of playerStep, btKinematicCharacterControllerManager uses them to update many characters in parallel.
+	///beginPlayerStep integrates the velocities and returns false if the character doesn't move this step.
+	bool beginPlayerStep (btScalar dt);
+	///sweeps the character up, returns true if it hit something and has to recover from penetration before endStepUp
+	bool sweepUp (btCollisionWorld* collisionWorld);
+	void endStepUp ();
+	void stepForwardAndDown (btCollisionWorld* collisionWorld, btScalar dt);
+	///moves the ghost object to the current position
+	void updateGhostObjectPosition ();
+	///updates the broadphase aabb of the ghost object, which also updates its pair cache. This changes the broadphase, so it is not thread safe.
+	void updateGhostObjectAabb (btCollisionWorld* collisionWorld);
+	///computes the contacts in the pair cache of the ghost object and moves the current position out of penetration.
+	///The ghost object keeps its transform until updateGhostObjectPosition. Returns true if the character was penetrating.
+	bool resolvePenetration (btCollisionWorld* collisionWorld, btManifoldArray& manifoldArray);
+	void setTouchingContact (bool touchingContact)
+	{
+		m_touchingContact = touchingContact;
+	}
+
 	void setStepHeight(btScalar h);
 	btScalar getStepHeight() const { return m_stepHeight; }
 	void setFallSpeed (btScalar fallSpeed);
@@ -192,6 +211,11 @@ public:
 	btScalar getMaxPenetrationDepth() const;
 
 	btPairCachingGhostObject* getGhostObject();
+	///the shape used for the sweeps, its margin is increased during the forward sweep
+	btConvexShape*	getConvexShape()
+	{
+		return m_convexShape;
+	}
 	void	setUseGhostSweepTest(bool useGhostObjectSweepTest)
 	{
 		m_useGhostObjectSweepTest = useGhostObjectSweepTest;
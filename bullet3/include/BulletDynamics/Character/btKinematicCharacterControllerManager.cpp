@@ -0,0 +1,254 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btKinematicCharacterControllerManager.h"
+#include "BulletCollision/CollisionDispatch/btGhostObject.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btQuickprof.h"
+
+
+struct btKinematicCharacterControllerManager::CharacterLoop : public btIParallelForBody
+{
+	btKinematicCharacterControllerManager* m_manager;
+	btCollisionWorld* m_collisionWorld;
+	CharacterStage m_stage;
+	btScalar m_step;
+
+	CharacterLoop(btKinematicCharacterControllerManager* manager, btCollisionWorld* collisionWorld, CharacterStage stage, btScalar step)
+		:m_manager(manager),
+		m_collisionWorld(collisionWorld),
+		m_stage(stage),
+		m_step(step)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		m_manager->processCharacterRange(m_collisionWorld, m_stage, m_step, iBegin, iEnd);
+	}
+};
+
+
+btKinematicCharacterControllerManager::btKinematicCharacterControllerManager()
+	:m_characterGrainSize(8),
+	m_sharedShapes(false),
+	m_sharedShapesDirty(false)
+{
+	m_manifoldArrays.resize(BT_MAX_THREAD_COUNT);
+}
+
+btKinematicCharacterControllerManager::~btKinematicCharacterControllerManager()
+{
+}
+
+void	btKinematicCharacterControllerManager::addCharacter(btKinematicCharacterController* character)
+{
+	m_characters.push_back(character);
+	m_sharedShapesDirty = true;
+}
+
+void	btKinematicCharacterControllerManager::removeCharacter(btKinematicCharacterController* character)
+{
+	m_characters.remove(character);
+	m_sharedShapesDirty = true;
+}
+
+void	btKinematicCharacterControllerManager::updateSharedShapes()
+{
+	btHashMap<btHashPtr,int> shapes;
+	m_sharedShapes = false;
+	for (int i=0;i<m_characters.size() && !m_sharedShapes;i++)
+	{
+		btHashPtr key(m_characters[i]->getConvexShape());
+		if (shapes.find(key))
+		{
+			m_sharedShapes = true;
+		}
+		shapes.insert(key, i);
+	}
+	m_sharedShapesDirty = false;
+}
+
+bool	btKinematicCharacterControllerManager::charactersCanHitEachOther() const
+{
+	//conservative, a character whose mask accepts its own group is assumed to accept the other characters too
+	int numInWorld = 0;
+	int groups = 0;
+	int masks = 0;
+	for (int i=0;i<m_characters.size();i++)
+	{
+		const btBroadphaseProxy* proxy = m_characters[i]->getGhostObject()->getBroadphaseHandle();
+		if (proxy)
+		{
+			numInWorld++;
+			groups |= proxy->m_collisionFilterGroup;
+			masks |= proxy->m_collisionFilterMask;
+		}
+	}
+	return numInWorld > 1 && (groups & masks) != 0;
+}
+
+void	btKinematicCharacterControllerManager::processCharacterRange(btCollisionWorld* collisionWorld, CharacterStage stage, btScalar step, int iBegin, int iEnd)
+{
+	for (int k=iBegin;k<iEnd;k++)
+	{
+		const int i = m_stageCharacters[k];
+		btKinematicCharacterController* character = m_characters[i];
+		switch (stage)
+		{
+		case CHARACTER_PREPARE:
+			character->preStep(collisionWorld);
+			m_stageResults[i] = character->beginPlayerStep(step);
+			break;
+		case CHARACTER_SWEEP_UP:
+			m_stageResults[i] = character->sweepUp(collisionWorld);
+			break;
+		case CHARACTER_END_STEP_UP:
+			character->endStepUp();
+			break;
+		case CHARACTER_STEP_FORWARD_AND_DOWN:
+			character->stepForwardAndDown(collisionWorld, step);
+			break;
+		case CHARACTER_UPDATE_GHOST_POSITION:
+			character->updateGhostObjectPosition();
+			break;
+		case CHARACTER_RESOLVE_PENETRATION:
+			{
+				//use the preallocated manifold array of this thread if possible
+				const int threadIndex = btGetCurrentThreadIndex();
+				btManifoldArray localManifoldArray;
+				btManifoldArray& manifoldArray = threadIndex < m_manifoldArrays.size() ? m_manifoldArrays[threadIndex] : localManifoldArray;
+				m_stageResults[i] = character->resolvePenetration(collisionWorld, manifoldArray);
+				break;
+			}
+		}
+	}
+}
+
+void	btKinematicCharacterControllerManager::processCharacters(btCollisionWorld* collisionWorld, CharacterStage stage, btScalar step, bool serial)
+{
+	if (serial)
+	{
+		processCharacterRange(collisionWorld, stage, step, 0, m_stageCharacters.size());
+	}
+	else
+	{
+		btParallelFor(0, m_stageCharacters.size(), m_characterGrainSize, CharacterLoop(this, collisionWorld, stage, step));
+	}
+}
+
+void	btKinematicCharacterControllerManager::selectStageCharacters(const btAlignedObjectArray<int>& characters, bool onlyWithResult)
+{
+	m_stageCharacters.resize(0);
+	for (int k=0;k<characters.size();k++)
+	{
+		const int i = characters[k];
+		if (!onlyWithResult || m_stageResults[i])
+		{
+			m_stageCharacters.push_back(i);
+		}
+	}
+}
+
+void	btKinematicCharacterControllerManager::recoverFromPenetration(btCollisionWorld* collisionWorld)
+{
+	int k;
+	for (k=0;k<m_stageCharacters.size();k++)
+	{
+		const int i = m_stageCharacters[k];
+		m_characters[i]->setTouchingContact(false);
+		m_penetrationLoops[i] = 0;
+	}
+
+	//same iterations as btKinematicCharacterController::recoverFromPenetration, with the contacts
+	//of all characters computed in parallel between the serial broadphase updates
+	while (m_stageCharacters.size())
+	{
+		for (k=0;k<m_stageCharacters.size();k++)
+		{
+			m_characters[m_stageCharacters[k]]->updateGhostObjectAabb(collisionWorld);
+		}
+
+		processCharacters(collisionWorld, CHARACTER_RESOLVE_PENETRATION, btScalar(0));
+		processCharacters(collisionWorld, CHARACTER_UPDATE_GHOST_POSITION, btScalar(0));
+
+		int numPenetrating = 0;
+		for (k=0;k<m_stageCharacters.size();k++)
+		{
+			const int i = m_stageCharacters[k];
+			if (m_stageResults[i])
+			{
+				m_characters[i]->setTouchingContact(true);
+				if (++m_penetrationLoops[i] <= 4)
+				{
+					m_stageCharacters[numPenetrating++] = i;
+				}
+			}
+		}
+		m_stageCharacters.resize(numPenetrating);
+	}
+}
+
+void	btKinematicCharacterControllerManager::updateCharacters(btCollisionWorld* collisionWorld, btScalar step)
+{
+	BT_PROFILE("updateCharacters");
+
+	if (m_sharedShapesDirty)
+	{
+		updateSharedShapes();
+	}
+	//the filters of the ghost objects can change at any time, so this is checked every step
+	const bool serialForwardStage = m_sharedShapes || charactersCanHitEachOther();
+
+	const int numCharacters = m_characters.size();
+	m_stageResults.resize(numCharacters);
+	m_penetrationLoops.resize(numCharacters);
+	m_movingCharacters.resize(numCharacters);
+	for (int i=0;i<numCharacters;i++)
+	{
+		m_movingCharacters[i] = i;
+	}
+
+	selectStageCharacters(m_movingCharacters, false);
+	processCharacters(collisionWorld, CHARACTER_PREPARE, step);
+	selectStageCharacters(m_movingCharacters, true);
+	m_movingCharacters.copyFromArray(m_stageCharacters);
+
+	processCharacters(collisionWorld, CHARACTER_SWEEP_UP, step);
+	selectStageCharacters(m_movingCharacters, true);
+	if (m_stageCharacters.size())
+	{
+		//characters that hit something above recover from penetration before they move on
+		processCharacters(collisionWorld, CHARACTER_UPDATE_GHOST_POSITION, step);
+		m_hitCharacters.copyFromArray(m_stageCharacters);
+		recoverFromPenetration(collisionWorld);
+		m_stageCharacters.copyFromArray(m_hitCharacters);
+		processCharacters(collisionWorld, CHARACTER_END_STEP_UP, step);
+	}
+
+	selectStageCharacters(m_movingCharacters, false);
+	processCharacters(collisionWorld, CHARACTER_STEP_FORWARD_AND_DOWN, step, serialForwardStage);
+	processCharacters(collisionWorld, CHARACTER_UPDATE_GHOST_POSITION, step);
+	recoverFromPenetration(collisionWorld);
+}
+
+void	btKinematicCharacterControllerManager::debugDraw(btIDebugDraw* debugDrawer)
+{
+	for (int i=0;i<m_characters.size();i++)
+	{
+		m_characters[i]->debugDraw(debugDrawer);
+	}
+}
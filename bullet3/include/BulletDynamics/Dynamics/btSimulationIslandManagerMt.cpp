@@ -460,6 +460,12 @@ void btSimulationIslandManagerMt::addManifoldsToIslands( btDispatcher* dispatche
             }
         }
     }
+#ifdef BT_DETERMINISTIC
+    for ( int i = 0; i < m_activeIslands.size(); ++i )
+    {
+        sortManifoldsCanonical( m_activeIslands[ i ]->manifoldArray );
+    }
+#endif //BT_DETERMINISTIC
 }
 
 
@@ -608,6 +614,15 @@ void btSimulationIslandManagerMt::buildAndProcessIslands( btDispatcher* dispatch
                 }
             }
         }
+#ifdef BT_DETERMINISTIC
+        m_canonicalManifolds.resize( 0 );
+        for ( int i = 0; i < maxNumManifolds; i++ )
+        {
+            m_canonicalManifolds.push_back( manifolds[ i ] );
+        }
+        sortManifoldsCanonical( m_canonicalManifolds );
+        manifolds = maxNumManifolds ? &m_canonicalManifolds[ 0 ] : NULL;
+#endif //BT_DETERMINISTIC
         btTypedConstraint** constraintsPtr = constraints.size() ? &constraints[ 0 ] : NULL;
 		callback->processIsland(&collisionObjects[0],
                                  collisionObjects.size(),
@@ -52,6 +52,18 @@ protected:
 	
 	virtual void	serializeMultiBodies(btSerializer* serializer);
 
+	static bool		isMultiBodySleeping(const btMultiBody* bod);
+
+	///the multibody loops of solveConstraints and integrateTransforms, btMultiBodyDynamicsWorldMt runs them on several threads
+	virtual void	integrateMultiBodyVelocities(btScalar timeStep);
+	virtual void	applyMultiBodyConstraintVelocities(btScalar timeStep);
+	virtual void	integrateMultiBodyTransforms(btScalar timeStep);
+
+	///the work for a single multibody, which only touches that multibody and the given scratch arrays
+	void	integrateMultiBodyVelocity(btMultiBody* bod, btScalar timeStep, btAlignedObjectArray<btScalar>& scratch_r, btAlignedObjectArray<btVector3>& scratch_v, btAlignedObjectArray<btMatrix3x3>& scratch_m);
+	void	applyMultiBodyConstraintVelocity(btMultiBody* bod, btScalar timeStep, btAlignedObjectArray<btScalar>& scratch_r, btAlignedObjectArray<btVector3>& scratch_v, btAlignedObjectArray<btMatrix3x3>& scratch_m);
+	void	integrateMultiBodyTransform(btMultiBody* bod, btScalar timeStep, btAlignedObjectArray<btQuaternion>& scratch_world_to_local, btAlignedObjectArray<btVector3>& scratch_local_origin);
+
 public:
 
 	btMultiBodyDynamicsWorld(btDispatcher* dispatcher,btBroadphaseInterface* pairCache,btMultiBodyConstraintSolver* constraintSolver,btCollisionConfiguration* collisionConfiguration);
@@ -97,7 +109,7 @@ public:
 
 	virtual void	debugDrawMultiBodyConstraint(btMultiBodyConstraint* constraint);
 	
-	void	forwardKinematics();
+	virtual void	forwardKinematics();
 	virtual void clearForces();
 	virtual void clearMultiBodyConstraintForces();
 	virtual void clearMultiBodyForces();
@@ -0,0 +1,108 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2013 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btMultiBodyDynamicsWorldMt.h"
+#include "btMultiBody.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+
+
+struct btMultiBodyDynamicsWorldMt::MultiBodyLoop : public btIParallelForBody
+{
+	btMultiBodyDynamicsWorldMt* m_world;
+	MultiBodyStage m_stage;
+	btScalar m_timeStep;
+
+	MultiBodyLoop(btMultiBodyDynamicsWorldMt* world, MultiBodyStage stage, btScalar timeStep)
+		:m_world(world),
+		m_stage(stage),
+		m_timeStep(timeStep)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		m_world->processMultiBodyRange(m_stage, m_timeStep, iBegin, iEnd);
+	}
+};
+
+
+btMultiBodyDynamicsWorldMt::btMultiBodyDynamicsWorldMt(btDispatcher* dispatcher,btBroadphaseInterface* pairCache,btMultiBodyConstraintSolver* constraintSolver,btCollisionConfiguration* collisionConfiguration)
+	:btMultiBodyDynamicsWorld(dispatcher,pairCache,constraintSolver,collisionConfiguration),
+	m_multiBodyGrainSize(1)
+{
+	m_threadScratch.resize(BT_MAX_THREAD_COUNT);
+}
+
+btMultiBodyDynamicsWorldMt::~btMultiBodyDynamicsWorldMt()
+{
+}
+
+void	btMultiBodyDynamicsWorldMt::processMultiBodyRange(MultiBodyStage stage, btScalar timeStep, int iBegin, int iEnd)
+{
+	//use the preallocated scratch of this thread if possible, a thread past the end gets a local one
+	int threadIndex = btGetCurrentThreadIndex();
+	ThreadScratch localScratch;
+	ThreadScratch& scratch = threadIndex < m_threadScratch.size() ? m_threadScratch[threadIndex] : localScratch;
+
+	for (int i=iBegin;i<iEnd;i++)
+	{
+		btMultiBody* bod = m_multiBodies[i];
+		switch (stage)
+		{
+		case MULTIBODY_FORWARD_KINEMATICS:
+			bod->forwardKinematics(scratch.m_scratch_world_to_local, scratch.m_scratch_local_origin);
+			break;
+		case MULTIBODY_INTEGRATE_VELOCITIES:
+			integrateMultiBodyVelocity(bod, timeStep, scratch.m_scratch_r, scratch.m_scratch_v, scratch.m_scratch_m);
+			break;
+		case MULTIBODY_CONSTRAINT_VELOCITIES:
+			applyMultiBodyConstraintVelocity(bod, timeStep, scratch.m_scratch_r, scratch.m_scratch_v, scratch.m_scratch_m);
+			break;
+		case MULTIBODY_INTEGRATE_TRANSFORMS:
+			integrateMultiBodyTransform(bod, timeStep, scratch.m_scratch_world_to_local, scratch.m_scratch_local_origin);
+			break;
+		}
+	}
+}
+
+void	btMultiBodyDynamicsWorldMt::processMultiBodies(MultiBodyStage stage, btScalar timeStep)
+{
+	btParallelFor(0, m_multiBodies.size(), m_multiBodyGrainSize, MultiBodyLoop(this, stage, timeStep));
+}
+
+void	btMultiBodyDynamicsWorldMt::forwardKinematics()
+{
+	BT_PROFILE("btMultiBody forwardKinematics");
+	processMultiBodies(MULTIBODY_FORWARD_KINEMATICS, btScalar(0));
+}
+
+void	btMultiBodyDynamicsWorldMt::integrateMultiBodyVelocities(btScalar timeStep)
+{
+	BT_PROFILE("btMultiBody stepVelocities");
+	processMultiBodies(MULTIBODY_INTEGRATE_VELOCITIES, timeStep);
+}
+
+void	btMultiBodyDynamicsWorldMt::applyMultiBodyConstraintVelocities(btScalar timeStep)
+{
+	BT_PROFILE("btMultiBody stepVelocities");
+	processMultiBodies(MULTIBODY_CONSTRAINT_VELOCITIES, timeStep);
+}
+
+void	btMultiBodyDynamicsWorldMt::integrateMultiBodyTransforms(btScalar timeStep)
+{
+	BT_PROFILE("btMultiBody stepPositions");
+	processMultiBodies(MULTIBODY_INTEGRATE_TRANSFORMS, timeStep);
+}
@@ -0,0 +1,82 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2013 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_MULTIBODY_DYNAMICS_WORLD_MT_H
+#define BT_MULTIBODY_DYNAMICS_WORLD_MT_H
+
+#include "btMultiBodyDynamicsWorld.h"
+
+///
+/// btMultiBodyDynamicsWorldMt -- a version of btMultiBodyDynamicsWorld that runs the per multibody work
+///                               (forward kinematics, the articulated body algorithm, RK4 and position
+///                               integration) for all multibodies in parallel, using btParallelFor.
+///                               Constraints and contacts are still solved by the btMultiBodyConstraintSolver,
+///                               grouped per simulation island.
+///
+ATTRIBUTE_ALIGNED16(class) btMultiBodyDynamicsWorldMt : public btMultiBodyDynamicsWorld
+{
+public:
+	struct ThreadScratch
+	{
+		btAlignedObjectArray<btQuaternion> m_scratch_world_to_local;
+		btAlignedObjectArray<btVector3> m_scratch_local_origin;
+		btAlignedObjectArray<btScalar> m_scratch_r;
+		btAlignedObjectArray<btVector3> m_scratch_v;
+		btAlignedObjectArray<btMatrix3x3> m_scratch_m;
+	};
+
+protected:
+	enum MultiBodyStage
+	{
+		MULTIBODY_FORWARD_KINEMATICS,
+		MULTIBODY_INTEGRATE_VELOCITIES,
+		MULTIBODY_CONSTRAINT_VELOCITIES,
+		MULTIBODY_INTEGRATE_TRANSFORMS
+	};
+	struct MultiBodyLoop;
+
+	//one set of scratch arrays per thread, indexed by btGetCurrentThreadIndex
+	btAlignedObjectArray<ThreadScratch> m_threadScratch;
+	int m_multiBodyGrainSize;
+
+	void	processMultiBodies(MultiBodyStage stage, btScalar timeStep);
+
+	void	processMultiBodyRange(MultiBodyStage stage, btScalar timeStep, int iBegin, int iEnd);
+
+	virtual void	integrateMultiBodyVelocities(btScalar timeStep);
+	virtual void	applyMultiBodyConstraintVelocities(btScalar timeStep);
+	virtual void	integrateMultiBodyTransforms(btScalar timeStep);
+
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btMultiBodyDynamicsWorldMt(btDispatcher* dispatcher,btBroadphaseInterface* pairCache,btMultiBodyConstraintSolver* constraintSolver,btCollisionConfiguration* collisionConfiguration);
+
+	virtual ~btMultiBodyDynamicsWorldMt();
+
+	virtual void	forwardKinematics();
+
+	///the number of multibodies handed to a thread at once, 1 by default since a multibody is usually a sizeable amount of work
+	int		getMultiBodyGrainSize() const
+	{
+		return m_multiBodyGrainSize;
+	}
+	void	setMultiBodyGrainSize(int grainSize)
+	{
+		m_multiBodyGrainSize = btMax(1, grainSize);
+	}
+};
+
+#endif //BT_MULTIBODY_DYNAMICS_WORLD_MT_H
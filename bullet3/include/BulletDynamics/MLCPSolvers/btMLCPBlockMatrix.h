@@ -0,0 +1,207 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_MLCP_BLOCK_MATRIX_H
+#define BT_MLCP_BLOCK_MATRIX_H
+
+#include "LinearMath/btMatrixX.h"
+
+///btMLCPBlockMatrix stores the symmetric MLCP matrix A = J*invM*J^T in block compressed sparse row format.
+///Each block row (and column) holds the rows of one constraint: all rows of a joint, or the rows of a contact.
+///A block (i,j) is only stored when constraints i and j share a dynamic body, so the memory and the time to
+///build and multiply A grow with the number of connected constraint pairs instead of the square of the number of rows.
+struct btMLCPBlockMatrix
+{
+	btAlignedObjectArray<int>		m_blockRowOffset;	//first row of each block row, getNumBlocks()+1 entries
+	btAlignedObjectArray<int>		m_rowBlockStart;	//first stored block of each block row, getNumBlocks()+1 entries
+	btAlignedObjectArray<int>		m_blockColumn;		//block column of each stored block, ascending within a block row
+	btAlignedObjectArray<int>		m_blockValueOffset;	//offset of each stored block in m_values
+	btAlignedObjectArray<int>		m_diagonalBlock;	//stored block index of the diagonal block of each block row
+	btAlignedObjectArray<btScalar>	m_values;			//row-major dense blocks
+
+	int rows() const
+	{
+		return m_blockRowOffset.size() ? m_blockRowOffset[m_blockRowOffset.size()-1] : 0;
+	}
+
+	int getNumBlocks() const
+	{
+		return m_blockRowOffset.size() ? m_blockRowOffset.size()-1 : 0;
+	}
+
+	int getBlockSize(int blockRow) const
+	{
+		return m_blockRowOffset[blockRow+1]-m_blockRowOffset[blockRow];
+	}
+
+	int getNumStoredBlocks() const
+	{
+		return m_blockColumn.size();
+	}
+
+	btScalar* getBlock(int storedBlock)
+	{
+		return &m_values[m_blockValueOffset[storedBlock]];
+	}
+
+	const btScalar* getBlock(int storedBlock) const
+	{
+		return &m_values[m_blockValueOffset[storedBlock]];
+	}
+
+	void clear()
+	{
+		m_blockRowOffset.resize(0);
+		m_rowBlockStart.resize(0);
+		m_blockColumn.resize(0);
+		m_blockValueOffset.resize(0);
+		m_diagonalBlock.resize(0);
+		m_values.resize(0);
+	}
+
+	///starts a new structure, followed by one addBlockRow call per block row and endStructure
+	void beginStructure()
+	{
+		clear();
+		m_blockRowOffset.push_back(0);
+		m_rowBlockStart.push_back(0);
+	}
+
+	///columns are the block columns of the non-zero blocks of the row, in ascending order, including the diagonal
+	void addBlockRow(int numRows, const int* columns, int numColumns)
+	{
+		int blockRow = getNumBlocks();
+		m_blockRowOffset.push_back(m_blockRowOffset[blockRow]+numRows);
+		m_diagonalBlock.push_back(-1);
+		for (int i=0;i<numColumns;i++)
+		{
+			btAssert(i==0 || columns[i-1]<columns[i]);
+			if (columns[i]==blockRow)
+				m_diagonalBlock[blockRow] = m_blockColumn.size();
+			m_blockColumn.push_back(columns[i]);
+		}
+		btAssert(m_diagonalBlock[blockRow]>=0);
+		m_rowBlockStart.push_back(m_blockColumn.size());
+	}
+
+	///allocates the block values and sets them to zero
+	void endStructure()
+	{
+		int numBlocks = getNumBlocks();
+		m_blockValueOffset.resize(m_blockColumn.size());
+		int offset = 0;
+		for (int blockRow=0;blockRow<numBlocks;blockRow++)
+		{
+			int numRows = getBlockSize(blockRow);
+			for (int b=m_rowBlockStart[blockRow];b<m_rowBlockStart[blockRow+1];b++)
+			{
+				m_blockValueOffset[b] = offset;
+				offset += numRows*getBlockSize(m_blockColumn[b]);
+			}
+		}
+		m_values.resize(0);
+		m_values.resize(offset,btScalar(0));
+	}
+
+	///returns the stored block index of block (blockRow,blockCol), or -1 if the block is zero
+	int findBlock(int blockRow, int blockCol) const
+	{
+		int lo = m_rowBlockStart[blockRow];
+		int hi = m_rowBlockStart[blockRow+1]-1;
+		while (lo<=hi)
+		{
+			int mid = (lo+hi)>>1;
+			int col = m_blockColumn[mid];
+			if (col==blockCol)
+				return mid;
+			if (col<blockCol)
+				lo = mid+1;
+			else
+				hi = mid-1;
+		}
+		return -1;
+	}
+
+	void addToDiagonal(btScalar value)
+	{
+		for (int blockRow=0;blockRow<getNumBlocks();blockRow++)
+		{
+			int numRows = getBlockSize(blockRow);
+			btScalar* block = getBlock(m_diagonalBlock[blockRow]);
+			for (int i=0;i<numRows;i++)
+				block[i*numRows+i] += value;
+		}
+	}
+
+	///y = A*x
+	void multiply(const btVectorXu& x, btVectorXu& y) const
+	{
+		y.resize(rows());
+		for (int blockRow=0;blockRow<getNumBlocks();blockRow++)
+		{
+			int row0 = m_blockRowOffset[blockRow];
+			int numRows = getBlockSize(blockRow);
+			for (int i=0;i<numRows;i++)
+				y[row0+i] = btScalar(0);
+			for (int b=m_rowBlockStart[blockRow];b<m_rowBlockStart[blockRow+1];b++)
+			{
+				int col = m_blockColumn[b];
+				int col0 = m_blockRowOffset[col];
+				int numCols = getBlockSize(col);
+				const btScalar* block = getBlock(b);
+				for (int i=0;i<numRows;i++)
+				{
+					btScalar sum = btScalar(0);
+					for (int j=0;j<numCols;j++)
+						sum += block[i*numCols+j]*x[col0+j];
+					y[row0+i] += sum;
+				}
+			}
+		}
+	}
+
+	///writes the matrix into a zero initialized, row-major rows()*rows() buffer
+	void copyToDense(btScalar* dense) const
+	{
+		int n = rows();
+		for (int blockRow=0;blockRow<getNumBlocks();blockRow++)
+		{
+			int row0 = m_blockRowOffset[blockRow];
+			int numRows = getBlockSize(blockRow);
+			for (int b=m_rowBlockStart[blockRow];b<m_rowBlockStart[blockRow+1];b++)
+			{
+				int col = m_blockColumn[b];
+				int col0 = m_blockRowOffset[col];
+				int numCols = getBlockSize(col);
+				const btScalar* block = getBlock(b);
+				for (int i=0;i<numRows;i++)
+					for (int j=0;j<numCols;j++)
+						dense[(size_t)(row0+i)*n+col0+j] = block[i*numCols+j];
+			}
+		}
+	}
+
+	void copyToDense(btMatrixXu& dense) const
+	{
+		dense.resize(rows(),rows());
+		if (rows())
+		{
+			dense.setZero();
+			copyToDense(dense.getBufferPointerWritable());
+		}
+	}
+};
+
+#endif //BT_MLCP_BLOCK_MATRIX_H
@@ -22,7 +22,8 @@ subject to the following restrictions:
 
 btMLCPSolver::btMLCPSolver(	 btMLCPSolverInterface* solver)
 :m_solver(solver),
-m_fallback(0)
+m_fallback(0),
+m_useSparseMLCP(false)
 {
 }
 
@@ -94,6 +95,7 @@ btScalar btMLCPSolver::solveGroupCacheFriendlySetup(btCollisionObject** bodies,
 		if (!m_allConstraintPtrArray.size())
 		{
 			m_A.resize(0,0);
+			m_blockA.clear();
 			m_b.resize(0);
 			m_x.resize(0);
 			m_lo.resize(0);
@@ -103,7 +105,12 @@ btScalar btMLCPSolver::solveGroupCacheFriendlySetup(btCollisionObject** bodies,
 	}
 
 	
-	if (gUseMatrixMultiply)
+	if (m_useSparseMLCP)
+	{
+		BT_PROFILE("createMLCPSparse");
+		createMLCPSparse(infoGlobal);
+	}
+	else if (gUseMatrixMultiply)
 	{
 		BT_PROFILE("createMLCP");
 		createMLCP(infoGlobal);
@@ -121,6 +128,18 @@ bool btMLCPSolver::solveMLCP(const btContactSolverInfo& infoGlobal)
 {
 	bool result = true;
 
+	if (m_useSparseMLCP)
+	{
+		if (m_blockA.rows()==0)
+			return true;
+
+		//the block matrix is not modified by the solvers, so both (M)LCPs of split impulse can share it
+		result = m_solver->solveMLCPSparse(m_blockA, m_b, m_x, m_lo,m_hi, m_limitDependencies,infoGlobal.m_numIterations );
+		if (result && infoGlobal.m_splitImpulse)
+			result = m_solver->solveMLCPSparse(m_blockA, m_bSplit, m_xSplit, m_lo,m_hi, m_limitDependencies,infoGlobal.m_numIterations );
+		return result;
+	}
+
 	if (m_A.rows()==0)
 		return true;
 
@@ -141,22 +160,11 @@ bool btMLCPSolver::solveMLCP(const btContactSolverInfo& infoGlobal)
 	return result;
 }
 
-struct btJointNode
-{
-	int jointIndex;     // pointer to enclosing dxJoint object
-	int otherBodyIndex;       // *other* body this joint is connected to
-	int nextJointNodeIndex;//-1 for null
-	int constraintRowIndex;
-};
-
-
-
-void btMLCPSolver::createMLCPFast(const btContactSolverInfo& infoGlobal)
+int btMLCPSolver::setupMLCPJacobians()
 {
 	int numContactRows = interleaveContactAndFriction ? 3 : 1;
 
 	int numConstraintRows = m_allConstraintPtrArray.size();
-	int n = numConstraintRows;
 	{
 		BT_PROFILE("init b (rhs)");
 		m_b.resize(numConstraintRows);
@@ -204,14 +212,16 @@ void btMLCPSolver::createMLCPFast(const btContactSolverInfo& infoGlobal)
 	int m=m_allConstraintPtrArray.size();
 
 	int numBodies = m_tmpSolverBodyPool.size();
-	btAlignedObjectArray<int> bodyJointNodeArray;
+	btAlignedObjectArray<int>& bodyJointNodeArray = m_scratchBodyJointNodes;
 	{
 		BT_PROFILE("bodyJointNodeArray.resize");
+		bodyJointNodeArray.resize(0);
 		bodyJointNodeArray.resize(numBodies,-1);
 	}
-	btAlignedObjectArray<btJointNode> jointNodeArray;
+	btAlignedObjectArray<btJointNode>& jointNodeArray = m_scratchJointNodes;
 	{
 		BT_PROFILE("jointNodeArray.reserve");
+		jointNodeArray.resize(0);
 		jointNodeArray.reserve(2*m_allConstraintPtrArray.size());
 	}
 
@@ -327,14 +337,51 @@ void btMLCPSolver::createMLCPFast(const btContactSolverInfo& infoGlobal)
 			rowOffset+=numRows;
 
 		}
-		
+		return c;
+	}
+}
+
+void btMLCPSolver::setupMLCPSolution(const btContactSolverInfo& infoGlobal)
+{
+	int numConstraintRows = m_allConstraintPtrArray.size();
+	{
+		BT_PROFILE("resize/init x");
+		m_x.resize(numConstraintRows);
+		m_xSplit.resize(numConstraintRows);
+
+		if (infoGlobal.m_solverMode&SOLVER_USE_WARMSTARTING)
+		{
+			for (int i=0;i<m_allConstraintPtrArray.size();i++)
+			{
+				const btSolverConstraint& c = *m_allConstraintPtrArray[i];
+				m_x[i]=c.m_appliedImpulse;
+				m_xSplit[i] = c.m_appliedPushImpulse;
+			}
+		} else
+		{
+			m_x.setZero();
+			m_xSplit.setZero();
+		}
 	}
+}
+
+void btMLCPSolver::createMLCPFast(const btContactSolverInfo& infoGlobal)
+{
+	int numContactRows = interleaveContactAndFriction ? 3 : 1;
+
+	int numConstraintRows = m_allConstraintPtrArray.size();
+	int n = numConstraintRows;
+
+	setupMLCPJacobians();
 
+	btAlignedObjectArray<int>& bodyJointNodeArray = m_scratchBodyJointNodes;
+	btAlignedObjectArray<btJointNode>& jointNodeArray = m_scratchJointNodes;
+	btAlignedObjectArray<int>& ofs = m_scratchOfs;
 
 	//compute JinvM = J*invM.
-	const btScalar* JinvM = JinvM3.getBufferPointer();
+	const btScalar* JinvM = m_scratchJInvM3.getBufferPointer();
 
-	const btScalar* Jptr = J3.getBufferPointer();
+	const btScalar* Jptr = m_scratchJ3.getBufferPointer();
 	{
 		BT_PROFILE("m_A.resize");
 		m_A.resize(n,n);
@@ -445,26 +492,125 @@ void btMLCPSolver::createMLCPFast(const btContactSolverInfo& infoGlobal)
 		m_A.copyLowerToUpperTriangle();
 	}
 
+	setupMLCPSolution(infoGlobal);
+}
+
+// dst += B*C^T for numRows 8-wide Jacobian rows B and numRowsOther rows C, this assumes the 4th and 8th columns are zero
+static void btMultiplyAddBlock_p8r(btScalar* dst, const btScalar *B, const btScalar *C, int numRows, int numRowsOther)
+{
+	const btScalar *bb = B;
+	for ( int i = 0;i<numRows;i++)
 	{
-		BT_PROFILE("resize/init x");
-		m_x.resize(numConstraintRows);
-		m_xSplit.resize(numConstraintRows);
+		const btScalar *cc = C;
+		for ( int j = 0;j<numRowsOther;j++)
+		{
+			btScalar sum;
+			sum  = bb[0]*cc[0];
+			sum += bb[1]*cc[1];
+			sum += bb[2]*cc[2];
+			sum += bb[4]*cc[4];
+			sum += bb[5]*cc[5];
+			sum += bb[6]*cc[6];
+			dst[i*numRowsOther+j] += sum;
+			cc += 8;
+		}
+		bb += 8;
+	}
+}
 
-		if (infoGlobal.m_solverMode&SOLVER_USE_WARMSTARTING)
+void btMLCPSolver::createMLCPSparse(const btContactSolverInfo& infoGlobal)
+{
+	int numContactRows = interleaveContactAndFriction ? 3 : 1;
+
+	int numBlocks = setupMLCPJacobians();
+
+	const btAlignedObjectArray<int>& bodyJointNodeArray = m_scratchBodyJointNodes;
+	const btAlignedObjectArray<btJointNode>& jointNodeArray = m_scratchJointNodes;
+	const btAlignedObjectArray<int>& ofs = m_scratchOfs;
+	const btScalar* JinvM = m_scratchJInvM3.getBufferPointer();
+	const btScalar* Jptr = m_scratchJ3.getBufferPointer();
+
+	btAlignedObjectArray<int>& blockSize = m_scratchBlockSizes;
+	blockSize.resize(numBlocks);
+	for (int c=0;c<numBlocks;c++)
+	{
+		int i = ofs[c];
+		blockSize[c] = i<m_tmpSolverNonContactConstraintPool.size() ? m_tmpConstraintSizesPool[c].m_numConstraintRows : numContactRows;
+	}
+
+	{
+		BT_PROFILE("block structure");
+		btAlignedObjectArray<int>& columns = m_scratchBlockColumns;
+		m_blockA.beginStructure();
+		for (int c=0;c<numBlocks;c++)
 		{
-			for (int i=0;i<m_allConstraintPtrArray.size();i++)
+			int i = ofs[c];
+			int bodies[2] = {m_allConstraintPtrArray[i]->m_solverBodyIdA, m_allConstraintPtrArray[i]->m_solverBodyIdB};
+			columns.resize(0);
+			columns.push_back(c);
+			for (int side=0;side<2;side++)
 			{
-				const btSolverConstraint& c = *m_allConstraintPtrArray[i];
-				m_x[i]=c.m_appliedImpulse;
-				m_xSplit[i] = c.m_appliedPushImpulse;
+				for (int node = bodyJointNodeArray[bodies[side]];node>=0;node = jointNodeArray[node].nextJointNodeIndex)
+				{
+					int j = jointNodeArray[node].jointIndex;
+					//constraints that share both bodies are linked twice
+					if (columns.findLinearSearch(j)==columns.size())
+						columns.push_back(j);
+				}
 			}
-		} else
+			columns.quickSort(btIntSortPredicate());
+			m_blockA.addBlockRow(blockSize[c],&columns[0],columns.size());
+		}
+		m_blockA.endStructure();
+	}
+
+	{
+		BT_PROFILE("Compute blocks");
+		//lower triangle and diagonal: A(c,j) = JinvM(c)*J(j)^T, summed over the bodies that c and j share
+		for (int c=0;c<numBlocks;c++)
 		{
-			m_x.setZero();
-			m_xSplit.setZero();
+			int i = ofs[c];
+			int numRows = blockSize[c];
+			int bodies[2] = {m_allConstraintPtrArray[i]->m_solverBodyIdA, m_allConstraintPtrArray[i]->m_solverBodyIdB};
+			for (int side=0;side<2;side++)
+			{
+				const btScalar *JinvMrow = JinvM + 2*8*(size_t)i + side*8*(size_t)numRows;
+				for (int node = bodyJointNodeArray[bodies[side]];node>=0;node = jointNodeArray[node].nextJointNodeIndex)
+				{
+					int j = jointNodeArray[node].jointIndex;
+					if (j>c)
+						continue;
+					int cr = jointNodeArray[node].constraintRowIndex;
+					int numRowsOther = blockSize[j];
+					size_t ofsother = (m_allConstraintPtrArray[cr]->m_solverBodyIdB == bodies[side]) ? 8*numRowsOther : 0;
+					int block = m_blockA.findBlock(c,j);
+					btAssert(block>=0);
+					btMultiplyAddBlock_p8r(m_blockA.getBlock(block),JinvMrow,Jptr + 2*8*(size_t)ofs[j] + ofsother,numRows,numRowsOther);
+				}
+			}
+		}
+
+		//upper triangle
+		for (int c=0;c<numBlocks;c++)
+		{
+			int numRows = blockSize[c];
+			for (int b=m_blockA.m_rowBlockStart[c];b<m_blockA.m_diagonalBlock[c];b++)
+			{
+				int j = m_blockA.m_blockColumn[b];
+				int numRowsOther = blockSize[j];
+				const btScalar* lower = m_blockA.getBlock(b);
+				btScalar* upper = m_blockA.getBlock(m_blockA.findBlock(j,c));
+				for (int r=0;r<numRows;r++)
+					for (int k=0;k<numRowsOther;k++)
+						upper[k*numRows+r] = lower[r*numRowsOther+k];
+			}
 		}
 	}
 
+	// add cfm to the diagonal of m_blockA
+	m_blockA.addToDiagonal(infoGlobal.m_globalCfm/ infoGlobal.m_timeStep);
+
+	setupMLCPSolution(infoGlobal);
 }
 
 void btMLCPSolver::createMLCP(const btContactSolverInfo& infoGlobal)
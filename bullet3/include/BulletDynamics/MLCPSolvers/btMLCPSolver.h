@@ -21,12 +21,22 @@ subject to the following restrictions:
 #include "LinearMath/btMatrixX.h"
 #include "BulletDynamics/MLCPSolvers/btMLCPSolverInterface.h"
 
+struct btJointNode
+{
+	int jointIndex;     // index of the constraint block (a joint or contact and its rows), also its index in the Jacobian row offsets
+	int otherBodyIndex;       // solver body index of the *other* body of the constraint, -1 for a static body
+	int nextJointNodeIndex;//next node of the same body, -1 for null
+	int constraintRowIndex;//first row of the constraint in m_allConstraintPtrArray
+};
+
 class btMLCPSolver : public btSequentialImpulseConstraintSolver
 {
 
 protected:
 	
 	btMatrixXu m_A;
+	///block sparse version of m_A, used instead of m_A when m_useSparseMLCP is set
+	btMLCPBlockMatrix m_blockA;
 	btVectorXu m_b;
 	btVectorXu m_x;
 	btVectorXu m_lo;
@@ -42,6 +52,7 @@ protected:
 	btAlignedObjectArray<btSolverConstraint*>	m_allConstraintPtrArray;
 	btMLCPSolverInterface* m_solver;
 	int m_fallback;
+	bool m_useSparseMLCP;
 
     /// The following scratch variables are not stateful -- contents are cleared prior to each use.
     /// They are only cached here to avoid extra memory allocations and deallocations and to ensure
@@ -53,6 +64,10 @@ protected:
     btMatrixXu m_scratchJ;
     btMatrixXu m_scratchJTranspose;
     btMatrixXu m_scratchTmp;
+    btAlignedObjectArray<int> m_scratchBodyJointNodes;
+    btAlignedObjectArray<btJointNode> m_scratchJointNodes;
+    btAlignedObjectArray<int> m_scratchBlockColumns;
+    btAlignedObjectArray<int> m_scratchBlockSizes;
 
 	virtual btScalar solveGroupCacheFriendlySetup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal,btIDebugDraw* debugDrawer);
 	virtual btScalar solveGroupCacheFriendlyIterations(btCollisionObject** bodies ,int numBodies,btPersistentManifold** manifoldPtr, int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal,btIDebugDraw* debugDrawer);
@@ -60,6 +75,12 @@ protected:
 
 	virtual void createMLCP(const btContactSolverInfo& infoGlobal);
 	virtual void createMLCPFast(const btContactSolverInfo& infoGlobal);
+	///builds m_blockA, only the blocks of constraint pairs that share a dynamic body are computed and stored
+	virtual void createMLCPSparse(const btContactSolverInfo& infoGlobal);
+
+	///computes b, lo, hi and the per-body Jacobian rows J3 and J3*invM, and links the constraints of each body, returns the number of constraints
+	int setupMLCPJacobians();
+	void setupMLCPSolution(const btContactSolverInfo& infoGlobal);
 
 	//return true is it solves the problem successfully
 	virtual bool solveMLCP(const btContactSolverInfo& infoGlobal);
@@ -83,6 +104,17 @@ public:
 		m_fallback = num;
 	}
 
+	///assemble the MLCP matrix in block sparse format instead of a dense numRows*numRows matrix, and solve it with btMLCPSolverInterface::solveMLCPSparse.
+	///btSolveProjectedGaussSeidel iterates on the sparse matrix directly, the pivoting solvers still expand it to a dense matrix.
+	void setUseSparseMLCP(bool useSparse)
+	{
+		m_useSparseMLCP = useSparse;
+	}
+	bool getUseSparseMLCP() const
+	{
+		return m_useSparseMLCP;
+	}
+
 	virtual btConstraintSolverType	getSolverType() const
 	{
 		return BT_MLCP_SOLVER;
@@ -23,6 +23,56 @@ subject to the following restrictions:
 ///This solver is mainly for debug/learning purposes: it is functionally equivalent to the btSequentialImpulseConstraintSolver solver, but much slower (it builds the full LCP matrix)
 class btSolveProjectedGaussSeidel : public btMLCPSolverInterface
 {
+protected:
+
+	btAlignedObjectArray<btScalar>	m_blockInverse;
+	btAlignedObjectArray<int>		m_blockInverseOffset;	//-1 for blocks that are relaxed row by row
+	btAlignedObjectArray<btScalar>	m_blockRhs;
+
+	///inverts the symmetric positive definite n*n block using a Cholesky factorization, returns false if the block is singular
+	static bool invertBlock(const btScalar* block, int n, btScalar* inverse)
+	{
+		btScalar L[6*6];
+		btAssert(n<=6);
+		for (int i=0;i<n;i++)
+		{
+			for (int j=0;j<=i;j++)
+			{
+				btScalar sum = block[i*n+j];
+				for (int k=0;k<j;k++)
+					sum -= L[i*n+k]*L[j*n+k];
+				if (i==j)
+				{
+					if (sum <= SIMD_EPSILON*block[i*n+i])
+						return false;
+					L[i*n+i] = btSqrt(sum);
+				} else
+				{
+					L[i*n+j] = sum/L[j*n+j];
+				}
+			}
+		}
+		//solve L*L^T*inverse = identity, one column at a time
+		for (int c=0;c<n;c++)
+		{
+			btScalar y[6];
+			for (int i=0;i<n;i++)
+			{
+				btScalar sum = (i==c) ? btScalar(1) : btScalar(0);
+				for (int k=0;k<i;k++)
+					sum -= L[i*n+k]*y[k];
+				y[i] = sum/L[i*n+i];
+			}
+			for (int i=n-1;i>=0;i--)
+			{
+				btScalar sum = y[i];
+				for (int k=i+1;k<n;k++)
+					sum -= L[k*n+i]*inverse[k*n+c];
+				inverse[i*n+c] = sum/L[i*n+i];
+			}
+		}
+		return true;
+	}
 
 public:
 
@@ -105,6 +155,137 @@ public:
 		return true;
 	}
 
+	///projected Gauss-Seidel on the block sparse matrix, using the diagonal block of each constraint as preconditioner:
+	///blocks of unbounded rows (such as the rows of a hinge or a fixed joint) are solved exactly in one step,
+	///blocks with limits or friction dependencies are relaxed row by row, which gives the same iterates as solveMLCP.
+	virtual bool solveMLCPSparse(const btMLCPBlockMatrix& A, const btVectorXu & b, btVectorXu& x, const btVectorXu & lo,const btVectorXu & hi,const btAlignedObjectArray<int>& limitDependency, int numIterations)
+	{
+		if (!A.rows())
+			return true;
+
+		btAssert(A.rows() == b.rows());
+
+		int numBlocks = A.getNumBlocks();
+		{
+			BT_PROFILE("block diagonal preconditioner");
+			m_blockInverse.resize(0);
+			m_blockInverseOffset.resize(numBlocks);
+			for (int blk=0;blk<numBlocks;blk++)
+			{
+				m_blockInverseOffset[blk] = -1;
+				int row0 = A.m_blockRowOffset[blk];
+				int numRows = A.getBlockSize(blk);
+				if (numRows<2 || numRows>6)
+					continue;
+				bool unbounded = true;
+				for (int i=row0;i<row0+numRows && unbounded;i++)
+				{
+					unbounded = (lo[i] <= -SIMD_INFINITY) && (hi[i] >= SIMD_INFINITY) && (limitDependency[i]<0);
+				}
+				if (!unbounded)
+					continue;
+				int offset = m_blockInverse.size();
+				m_blockInverse.resize(offset+numRows*numRows);
+				if (invertBlock(A.getBlock(A.m_diagonalBlock[blk]),numRows,&m_blockInverse[offset]))
+				{
+					m_blockInverseOffset[blk] = offset;
+				} else
+				{
+					m_blockInverse.resize(offset);
+				}
+			}
+		}
+
+		for (int k = 0; k <numIterations; k++)
+		{
+			m_leastSquaresResidual = 0.f;
+			for (int blk=0;blk<numBlocks;blk++)
+			{
+				int row0 = A.m_blockRowOffset[blk];
+				int numRows = A.getBlockSize(blk);
+				if (m_blockRhs.size()<numRows)
+					m_blockRhs.resize(numRows);
+				btScalar* rhs = &m_blockRhs[0];
+				for (int i=0;i<numRows;i++)
+					rhs[i] = b[row0+i];
+
+				//subtract the coupling with the other constraints
+				int diagonal = A.m_diagonalBlock[blk];
+				for (int sb=A.m_rowBlockStart[blk];sb<A.m_rowBlockStart[blk+1];sb++)
+				{
+					if (sb==diagonal)
+						continue;
+					int col0 = A.m_blockRowOffset[A.m_blockColumn[sb]];
+					int numCols = A.getBlockSize(A.m_blockColumn[sb]);
+					const btScalar* block = A.getBlock(sb);
+					for (int i=0;i<numRows;i++)
+					{
+						btScalar delta = 0.f;
+						for (int j=0;j<numCols;j++)
+							delta += block[i*numCols+j]*x[col0+j];
+						rhs[i] -= delta;
+					}
+				}
+
+				const btScalar* D = A.getBlock(diagonal);
+				if (m_blockInverseOffset[blk]>=0)
+				{
+					const btScalar* Dinv = &m_blockInverse[m_blockInverseOffset[blk]];
+					for (int i=0;i<numRows;i++)
+					{
+						btScalar xNew = 0.f;
+						for (int j=0;j<numRows;j++)
+							xNew += Dinv[i*numRows+j]*rhs[j];
+						btScalar diff = xNew - x[row0+i];
+						x[row0+i] = xNew;
+						m_leastSquaresResidual += diff*diff;
+					}
+					continue;
+				}
+
+				for (int i=0;i<numRows;i++)
+				{
+					int row = row0+i;
+					btScalar delta = 0.f;
+					for (int j=0;j<numRows;j++)
+					{
+						if (j != i)//skip main diagonal
+							delta += D[i*numRows+j]*x[row0+j];
+					}
+
+					btScalar aDiag = D[i*numRows+i];
+					btScalar xOld = x[row];
+					x[row] = (rhs[i] - delta) / aDiag;
+					btScalar s = 1.f;
+
+					if (limitDependency[row]>=0)
+					{
+						s = x[limitDependency[row]];
+						if (s<0)
+							s=1;
+					}
+
+					if (x[row]<lo[row]*s)
+						x[row]=lo[row]*s;
+					if (x[row]>hi[row]*s)
+						x[row]=hi[row]*s;
+					btScalar diff = x[row] - xOld;
+					m_leastSquaresResidual += diff*diff;
+				}
+			}
+
+			btScalar eps  = m_leastSquaresResidualThreshold;
+			if ((m_leastSquaresResidual < eps) || (k >=(numIterations-1)))
+			{
+#ifdef VERBOSE_PRINTF_RESIDUAL
+				printf("totalLenSqr = %f at iteration #%d\n", m_leastSquaresResidual,k);
+#endif
+				break;
+			}
+		}
+		return true;
+	}
+
 };
 
 #endif //BT_SOLVE_PROJECTED_GAUSS_SEIDEL_H
@@ -19,8 +19,10 @@
 #include "btVehicleRaycaster.h"
 #include "btWheelInfo.h"
 #include "LinearMath/btMinMax.h"
+#include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btIDebugDraw.h"
 #include "BulletDynamics/ConstraintSolver/btContactConstraint.h"
+#include "LinearMath/btThreads.h"
 
 #define ROLLING_INFLUENCE_FIX
 
@@ -165,26 +167,38 @@ void	btRaycastVehicle::updateWheelTransformsWS(btWheelInfo& wheel , bool interpo
 }
 
 btScalar btRaycastVehicle::rayCast(btWheelInfo& wheel)
+{
+	btVector3 source, target;
+	getWheelRay(wheel, source, target);
+
+	btVehicleRaycaster::btVehicleRaycasterResult	rayResults;
+
+	btAssert(m_vehicleRaycaster);
+
+	void* object = m_vehicleRaycaster->castRay(source,target,rayResults);
+
+	return processWheelRayResult(wheel, object, rayResults);
+}
+
+void	btRaycastVehicle::getWheelRay(btWheelInfo& wheel, btVector3& from, btVector3& to)
 {
 	updateWheelTransformsWS( wheel,false);
 
-	
-	btScalar depth = -1;
-	
 	btScalar raylen = wheel.getSuspensionRestLength()+wheel.m_wheelsRadius;
 
 	btVector3 rayvector = wheel.m_raycastInfo.m_wheelDirectionWS * (raylen);
-	const btVector3& source = wheel.m_raycastInfo.m_hardPointWS;
-	wheel.m_raycastInfo.m_contactPointWS = source + rayvector;
-	const btVector3& target = wheel.m_raycastInfo.m_contactPointWS;
+	from = wheel.m_raycastInfo.m_hardPointWS;
+	wheel.m_raycastInfo.m_contactPointWS = from + rayvector;
+	to = wheel.m_raycastInfo.m_contactPointWS;
+}
 
-	btScalar param = btScalar(0.);
+btScalar	btRaycastVehicle::processWheelRayResult(btWheelInfo& wheel, void* object, const btVehicleRaycaster::btVehicleRaycasterResult& rayResults)
+{
+	btScalar depth = -1;
 	
-	btVehicleRaycaster::btVehicleRaycasterResult	rayResults;
-
-	btAssert(m_vehicleRaycaster);
+	btScalar raylen = wheel.getSuspensionRestLength()+wheel.m_wheelsRadius;
 
-	void* object = m_vehicleRaycaster->castRay(source,target,rayResults);
+	btScalar param = btScalar(0.);
 
 	wheel.m_raycastInfo.m_groundObject = 0;
 
@@ -266,6 +280,25 @@ const btTransform& btRaycastVehicle::getChassisWorldTransform() const
 
 
 void btRaycastVehicle::updateVehicle( btScalar step )
+{
+	prepareVehicleUpdate();
+
+	//
+	// simulate suspension
+	//
+	
+	int i=0;
+	for (i=0;i<m_wheelInfo.size();i++)
+	{
+		//btScalar depth; 
+		//depth = 
+		rayCast( m_wheelInfo[i]);
+	}
+
+	completeVehicleUpdate(step);
+}
+
+void	btRaycastVehicle::prepareVehicleUpdate()
 {
 	{
 		for (int i=0;i<getNumWheels();i++)
@@ -288,18 +321,11 @@ void btRaycastVehicle::updateVehicle( btScalar step )
 	{
 		m_currentVehicleSpeedKmHour *= btScalar(-1.);
 	}
+}
 
-	//
-	// simulate suspension
-	//
-	
+void	btRaycastVehicle::completeVehicleUpdate(btScalar step)
+{
 	int i=0;
-	for (i=0;i<m_wheelInfo.size();i++)
-	{
-		//btScalar depth; 
-		//depth = 
-		rayCast( m_wheelInfo[i]);
-	}
 
 	updateSuspension(step);
 
@@ -746,6 +772,16 @@ void	btRaycastVehicle::debugDraw(btIDebugDraw* debugDrawer)
 }
 
 
+btDefaultVehicleRaycaster::btDefaultVehicleRaycaster(btDynamicsWorld* world)
+	:m_dynamicsWorld(world)
+{
+#if BT_THREADSAFE
+	m_rayCandidates.resize(BT_MAX_THREAD_COUNT);
+#else
+	m_rayCandidates.resize(1);
+#endif
+}
+
 void* btDefaultVehicleRaycaster::castRay(const btVector3& from,const btVector3& to, btVehicleRaycasterResult& result)
 {
 //	RayResultCallback& resultCallback;
@@ -770,3 +806,102 @@ void* btDefaultVehicleRaycaster::castRay(const btVector3& from,const btVector3&
 	return 0;
 }
 
+struct btVehicleRayCandidateCallback : public btBroadphaseAabbCallback
+{
+	btAlignedObjectArray<const btBroadphaseProxy*>&	m_proxies;
+
+	btVehicleRayCandidateCallback(btAlignedObjectArray<const btBroadphaseProxy*>& proxies)
+		:m_proxies(proxies)
+	{
+	}
+
+	virtual bool	process(const btBroadphaseProxy* proxy)
+	{
+		m_proxies.push_back(proxy);
+		return true;
+	}
+};
+
+void btDefaultVehicleRaycaster::castRays(int numRays, const btVector3* from, const btVector3* to, btVehicleRaycasterResult* results, void** objects)
+{
+	if (numRays<=0)
+		return;
+
+	//one broadphase query for the bounds of all rays, usually the wheels of a vehicle, instead of one per ray
+	btVector3 aabbMin = from[0];
+	btVector3 aabbMax = from[0];
+	int i;
+	for (i=0;i<numRays;i++)
+	{
+		aabbMin.setMin(from[i]);
+		aabbMin.setMin(to[i]);
+		aabbMax.setMax(from[i]);
+		aabbMax.setMax(to[i]);
+	}
+	//use the candidate list of this thread if possible, a thread past the end gets a local one
+	int threadIndex = 0;
+#if BT_THREADSAFE
+	threadIndex = btGetCurrentThreadIndex();
+#endif
+	btAlignedObjectArray<const btBroadphaseProxy*> localProxies;
+	btAlignedObjectArray<const btBroadphaseProxy*>& proxies = threadIndex < m_rayCandidates.size() ? m_rayCandidates[threadIndex] : localProxies;
+	proxies.resize(0);
+	btVehicleRayCandidateCallback candidates(proxies);
+	m_dynamicsWorld->getBroadphase()->aabbTest(aabbMin,aabbMax,candidates);
+
+	for (i=0;i<numRays;i++)
+	{
+		objects[i] = 0;
+
+		btCollisionWorld::ClosestRayResultCallback rayCallback(from[i],to[i]);
+
+		btTransform rayFromTrans, rayToTrans;
+		rayFromTrans.setIdentity();
+		rayFromTrans.setOrigin(from[i]);
+		rayToTrans.setIdentity();
+		rayToTrans.setOrigin(to[i]);
+
+		//same culling as the ray test of the broadphase
+		btVector3 rayDir = to[i]-from[i];
+		rayDir.normalize();
+		btVector3 rayDirectionInverse;
+		rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+		rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+		rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+		unsigned int signs[3] = { rayDirectionInverse[0] < 0.0, rayDirectionInverse[1] < 0.0, rayDirectionInverse[2] < 0.0 };
+		btScalar lambdaMax = rayDir.dot(to[i]-from[i]);
+
+		for (int j=0;j<proxies.size();j++)
+		{
+			if (rayCallback.m_closestHitFraction == btScalar(0.f))
+				break;
+			btBroadphaseProxy* proxy = (btBroadphaseProxy*)proxies[j];
+			if (!rayCallback.needsCollision(proxy))
+				continue;
+			btVector3 bounds[2] = { proxy->m_aabbMin, proxy->m_aabbMax };
+			btScalar tmin;
+			if (!btRayAabb2(from[i],rayDirectionInverse,signs,bounds,tmin,0,lambdaMax))
+				continue;
+			btCollisionObject* collisionObject = (btCollisionObject*)proxy->m_clientObject;
+			btCollisionWorld::rayTestSingle(rayFromTrans,rayToTrans,
+				collisionObject,
+				collisionObject->getCollisionShape(),
+				collisionObject->getWorldTransform(),
+				rayCallback);
+		}
+
+		if (rayCallback.hasHit())
+		{
+			const btRigidBody* body = btRigidBody::upcast(rayCallback.m_collisionObject);
+			if (body && body->hasContactResponse())
+			{
+				results[i].m_hitPointInWorld = rayCallback.m_hitPointWorld;
+				results[i].m_hitNormalInWorld = rayCallback.m_hitNormalWorld;
+				results[i].m_hitNormalInWorld.normalize();
+				results[i].m_distFraction = rayCallback.m_closestHitFraction;
+				objects[i] = (void*)body;
+			}
+		}
+	}
+}
+
@@ -95,6 +95,21 @@ public:
 	btScalar rayCast(btWheelInfo& wheel);
 
 	virtual void updateVehicle(btScalar step);
+
+	///the steps of updateVehicle, btRaycastVehicleManager uses them to cast the wheel rays of many vehicles at once:
+	///prepareVehicleUpdate, getWheelRay for each wheel, castRays, processWheelRayResult for each wheel, completeVehicleUpdate
+	void	prepareVehicleUpdate();
+
+	void	getWheelRay(btWheelInfo& wheel, btVector3& from, btVector3& to);
+
+	btScalar	processWheelRayResult(btWheelInfo& wheel, void* object, const btVehicleRaycaster::btVehicleRaycasterResult& result);
+
+	void	completeVehicleUpdate(btScalar step);
+
+	btVehicleRaycaster*	getVehicleRaycaster()
+	{
+		return m_vehicleRaycaster;
+	}
 	
 	
 	void resetSuspension();
@@ -219,14 +234,16 @@ public:
 class btDefaultVehicleRaycaster : public btVehicleRaycaster
 {
 	btDynamicsWorld*	m_dynamicsWorld;
+	//broadphase candidates of castRays, one list per thread so the lists keep their memory between calls
+	btAlignedObjectArray< btAlignedObjectArray<const btBroadphaseProxy*> >	m_rayCandidates;
 public:
-	btDefaultVehicleRaycaster(btDynamicsWorld* world)
-		:m_dynamicsWorld(world)
-	{
-	}
+	btDefaultVehicleRaycaster(btDynamicsWorld* world);
 
 	virtual void* castRay(const btVector3& from,const btVector3& to, btVehicleRaycasterResult& result);
 
+	///casts all rays with a single broadphase query
+	virtual void castRays(int numRays, const btVector3* from, const btVector3* to, btVehicleRaycasterResult* results, void** objects);
+
 };
 
 
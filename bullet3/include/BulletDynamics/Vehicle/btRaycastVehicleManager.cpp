@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2005 Erwin Coumans http://bulletphysics.org
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies.
+ * Erwin Coumans makes no representations about the suitability 
+ * of this software for any purpose.  
+ * It is provided "as is" without express or implied warranty.
+*/
+
+#include "btRaycastVehicleManager.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btQuickprof.h"
+
+
+struct btRaycastVehicleManager::VehicleLoop : public btIParallelForBody
+{
+	btRaycastVehicleManager* m_manager;
+	VehicleStage m_stage;
+	btScalar m_step;
+
+	VehicleLoop(btRaycastVehicleManager* manager, VehicleStage stage, btScalar step)
+		:m_manager(manager),
+		m_stage(stage),
+		m_step(step)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		m_manager->processVehicleRange(m_stage, m_step, iBegin, iEnd);
+	}
+};
+
+
+btRaycastVehicleManager::btRaycastVehicleManager()
+	:m_vehicleGrainSize(4)
+{
+}
+
+btRaycastVehicleManager::~btRaycastVehicleManager()
+{
+}
+
+void	btRaycastVehicleManager::addVehicle(btRaycastVehicle* vehicle)
+{
+	m_vehicles.push_back(vehicle);
+}
+
+void	btRaycastVehicleManager::removeVehicle(btRaycastVehicle* vehicle)
+{
+	m_vehicles.remove(vehicle);
+}
+
+void	btRaycastVehicleManager::processVehicleRange(VehicleStage stage, btScalar step, int iBegin, int iEnd)
+{
+	for (int i=iBegin;i<iEnd;i++)
+	{
+		btRaycastVehicle* vehicle = m_vehicles[i];
+		const int start = m_wheelStart[i];
+		const int numWheels = vehicle->getNumWheels();
+		switch (stage)
+		{
+		case VEHICLE_PREPARE:
+			vehicle->prepareVehicleUpdate();
+			for (int w=0;w<numWheels;w++)
+			{
+				vehicle->getWheelRay(vehicle->getWheelInfo(w), m_rayFrom[start+w], m_rayTo[start+w]);
+			}
+			break;
+		case VEHICLE_CAST_RAYS:
+			btAssert(vehicle->getVehicleRaycaster());
+			if (numWheels)
+			{
+				vehicle->getVehicleRaycaster()->castRays(numWheels, &m_rayFrom[start], &m_rayTo[start], &m_rayResults[start], &m_rayObjects[start]);
+			}
+			break;
+		case VEHICLE_COMPLETE:
+			vehicle->completeVehicleUpdate(step);
+			break;
+		}
+	}
+}
+
+void	btRaycastVehicleManager::processVehicles(VehicleStage stage, btScalar step)
+{
+	btParallelFor(0, m_vehicles.size(), m_vehicleGrainSize, VehicleLoop(this, stage, step));
+}
+
+void	btRaycastVehicleManager::updateVehicles(btScalar step)
+{
+	BT_PROFILE("updateVehicles");
+
+	int numWheels = 0;
+	m_wheelStart.resize(m_vehicles.size());
+	int i;
+	for (i=0;i<m_vehicles.size();i++)
+	{
+		m_wheelStart[i] = numWheels;
+		numWheels += m_vehicles[i]->getNumWheels();
+	}
+	m_rayFrom.resize(numWheels);
+	m_rayTo.resize(numWheels);
+	m_rayResults.resize(numWheels);
+	m_rayObjects.resize(numWheels);
+
+	processVehicles(VEHICLE_PREPARE, step);
+	processVehicles(VEHICLE_CAST_RAYS, step);
+
+	//the results are applied serially, they all use the shared fixed body of btActionInterface
+	for (i=0;i<m_vehicles.size();i++)
+	{
+		btRaycastVehicle* vehicle = m_vehicles[i];
+		for (int w=0;w<vehicle->getNumWheels();w++)
+		{
+			const int ray = m_wheelStart[i]+w;
+			vehicle->processWheelRayResult(vehicle->getWheelInfo(w), m_rayObjects[ray], m_rayResults[ray]);
+		}
+	}
+
+	processVehicles(VEHICLE_COMPLETE, step);
+}
+
+void	btRaycastVehicleManager::debugDraw(btIDebugDraw* debugDrawer)
+{
+	for (int i=0;i<m_vehicles.size();i++)
+	{
+		m_vehicles[i]->debugDraw(debugDrawer);
+	}
+}
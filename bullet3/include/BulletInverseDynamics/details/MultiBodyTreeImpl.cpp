@@ -319,6 +319,293 @@ int MultiBodyTree::MultiBodyImpl::calculateInverseDynamics(const vecx &q, const
 	return 0;
 }
 
+// derivatives of the rate of change of linear and angular momentum of a body
+static void calculateEomLhsTangent(RigidBody &body) {
+	const vec3 I_ang_vel = body.m_body_I_body * body.m_body_ang_vel;
+	const vec3 I_d_ang_vel = body.m_body_I_body * body.m_d_body_ang_vel;
+	body.m_d_moment_at_joint = body.m_body_I_body * body.m_d_body_ang_acc +
+							   body.m_body_mass_com.cross(body.m_d_body_acc) +
+							   body.m_d_body_ang_vel.cross(I_ang_vel) +
+							   body.m_body_ang_vel.cross(I_d_ang_vel);
+	body.m_d_force_at_joint =
+		body.m_d_body_ang_acc.cross(body.m_body_mass_com) + body.m_mass * body.m_d_body_acc +
+		body.m_d_body_ang_vel.cross(body.m_body_ang_vel.cross(body.m_body_mass_com)) +
+		body.m_body_ang_vel.cross(body.m_d_body_ang_vel.cross(body.m_body_mass_com));
+}
+
+// copy the derivative of the body's joint forces to a column of d_joint_forces
+static void setJointForceTangent(const RigidBody &body, const int column, matxx *d_joint_forces) {
+	switch (body.m_joint_type) {
+		case REVOLUTE:
+			setMatxxElem(body.m_q_index, column, body.m_Jac_JR.dot(body.m_d_moment_at_joint),
+						 d_joint_forces);
+			break;
+		case PRISMATIC:
+			setMatxxElem(body.m_q_index, column, body.m_Jac_JT.dot(body.m_d_force_at_joint),
+						 d_joint_forces);
+			break;
+		case FLOATING:
+			for (int i = 0; i < 3; i++) {
+				setMatxxElem(body.m_q_index + i, column, body.m_d_moment_at_joint(i),
+							 d_joint_forces);
+				setMatxxElem(body.m_q_index + 3 + i, column, body.m_d_force_at_joint(i),
+							 d_joint_forces);
+			}
+			break;
+		case FIXED:
+			break;
+	}
+}
+
+void MultiBodyTree::MultiBodyImpl::calculateInverseDynamicsTangent(
+	const int body_index, const vec3 &body_d_rot, const vec3 &d_parent_pos_parent_body,
+	const vec3 &d_body_ang_vel_rel, const vec3 &d_parent_vel_rel, const vec3 &d_parent_acc_rel,
+	const int column, matxx *d_joint_forces) {
+	// This differentiates the recursions in calculateKinematics and calculateInverseDynamics
+	// (forward mode). Kinematics only change for the body and its subtree,
+	// the ancestors only see different forces transmitted through the joints.
+
+	// 1. kinematics of the body itself. The parent's kinematics do not change.
+	RigidBody &seed = m_body_list[body_index];
+	seed.m_d_is_affected = true;
+	if (0 == body_index) {
+		seed.m_d_body_ang_vel = d_body_ang_vel_rel;
+		seed.m_d_body_vel = d_parent_vel_rel;
+		setZero(seed.m_d_body_ang_acc);
+		seed.m_d_body_acc =
+			seed.m_body_T_parent * d_parent_acc_rel - body_d_rot.cross(seed.m_body_acc);
+	} else {
+		const RigidBody &parent = m_body_list[m_parent_index[body_index]];
+		const vec3 T_parent_ang_vel = seed.m_body_T_parent * parent.m_body_ang_vel;
+		const vec3 T_parent_ang_acc = seed.m_body_T_parent * parent.m_body_ang_acc;
+		seed.m_d_body_ang_vel = d_body_ang_vel_rel - body_d_rot.cross(T_parent_ang_vel);
+		seed.m_d_body_vel =
+			seed.m_body_T_parent *
+				(parent.m_body_ang_vel.cross(d_parent_pos_parent_body) + d_parent_vel_rel) -
+			body_d_rot.cross(seed.m_body_vel);
+		seed.m_d_body_ang_acc = seed.m_body_ang_vel_rel.cross(body_d_rot.cross(T_parent_ang_vel)) -
+								body_d_rot.cross(T_parent_ang_acc) -
+								d_body_ang_vel_rel.cross(T_parent_ang_vel);
+		seed.m_d_body_acc =
+			seed.m_body_T_parent *
+				(parent.m_body_ang_acc.cross(d_parent_pos_parent_body) +
+				 parent.m_body_ang_vel.cross(parent.m_body_ang_vel.cross(d_parent_pos_parent_body)) +
+				 2.0 * parent.m_body_ang_vel.cross(d_parent_vel_rel) + d_parent_acc_rel) -
+			body_d_rot.cross(seed.m_body_acc);
+	}
+	calculateEomLhsTangent(seed);
+
+	// 2. kinematics of the subtree, and contributions to its equations of motion
+	for (int i = body_index + 1; i < m_num_bodies; i++) {
+		RigidBody &body = m_body_list[i];
+		const int parent_index = m_parent_index[i];
+		body.m_d_is_affected =
+			parent_index >= body_index && m_body_list[parent_index].m_d_is_affected;
+		if (!body.m_d_is_affected) {
+			continue;
+		}
+		const RigidBody &parent = m_body_list[parent_index];
+		const vec3 &r = body.m_parent_pos_parent_body;
+		const vec3 T_d_parent_ang_vel = body.m_body_T_parent * parent.m_d_body_ang_vel;
+		body.m_d_body_ang_vel = T_d_parent_ang_vel;
+		body.m_d_body_vel =
+			body.m_body_T_parent * (parent.m_d_body_vel + parent.m_d_body_ang_vel.cross(r));
+		body.m_d_body_ang_acc = body.m_body_T_parent * parent.m_d_body_ang_acc -
+								body.m_body_ang_vel_rel.cross(T_d_parent_ang_vel);
+		body.m_d_body_acc =
+			body.m_body_T_parent *
+			(parent.m_d_body_acc + parent.m_d_body_ang_acc.cross(r) +
+			 parent.m_d_body_ang_vel.cross(parent.m_body_ang_vel.cross(r)) +
+			 parent.m_body_ang_vel.cross(parent.m_d_body_ang_vel.cross(r)) +
+			 2.0 * parent.m_d_body_ang_vel.cross(body.m_parent_vel_rel));
+		calculateEomLhsTangent(body);
+	}
+
+	// 3. forces at the joints of the subtree, from the leaves up to the body
+	for (int i = m_num_bodies - 1; i > body_index; i--) {
+		const RigidBody &body = m_body_list[i];
+		if (!body.m_d_is_affected) {
+			continue;
+		}
+		RigidBody &parent = m_body_list[m_parent_index[i]];
+		const mat33 parent_T_body = body.m_body_T_parent.transpose();
+		const vec3 d_force = parent_T_body * body.m_d_force_at_joint;
+		parent.m_d_force_at_joint += d_force;
+		parent.m_d_moment_at_joint +=
+			parent_T_body * body.m_d_moment_at_joint + body.m_parent_pos_parent_body.cross(d_force);
+	}
+	setJointForceTangent(seed, column, d_joint_forces);
+	for (int i = body_index + 1; i < m_num_bodies; i++) {
+		if (m_body_list[i].m_d_is_affected) {
+			setJointForceTangent(m_body_list[i], column, d_joint_forces);
+		}
+	}
+
+	// 4. forces at the joints of the ancestors. The force transmitted by the body
+	// also changes through the rotation and translation of its frame.
+	if (body_index > 0) {
+		RigidBody &parent = m_body_list[m_parent_index[body_index]];
+		const mat33 parent_T_body = seed.m_body_T_parent.transpose();
+		const vec3 force = parent_T_body * seed.m_force_at_joint;
+		const vec3 d_force =
+			parent_T_body * (seed.m_d_force_at_joint + body_d_rot.cross(seed.m_force_at_joint));
+		parent.m_d_force_at_joint = d_force;
+		parent.m_d_moment_at_joint =
+			parent_T_body *
+				(seed.m_d_moment_at_joint + body_d_rot.cross(seed.m_moment_at_joint)) +
+			d_parent_pos_parent_body.cross(force) + seed.m_parent_pos_parent_body.cross(d_force);
+		setJointForceTangent(parent, column, d_joint_forces);
+	}
+	for (int child_index = m_parent_index[body_index]; child_index > 0;
+		 child_index = m_parent_index[child_index]) {
+		const RigidBody &child = m_body_list[child_index];
+		RigidBody &parent = m_body_list[m_parent_index[child_index]];
+		const mat33 parent_T_child = child.m_body_T_parent.transpose();
+		parent.m_d_force_at_joint = parent_T_child * child.m_d_force_at_joint;
+		parent.m_d_moment_at_joint = parent_T_child * child.m_d_moment_at_joint +
+									 child.m_parent_pos_parent_body.cross(parent.m_d_force_at_joint);
+		setJointForceTangent(parent, column, d_joint_forces);
+	}
+}
+
+int MultiBodyTree::MultiBodyImpl::calculateInverseDynamicsDerivatives(
+	const vecx &q, const vecx &u, const vecx &dot_u, vecx *joint_forces,
+	matxx *d_joint_forces_d_q, matxx *d_joint_forces_d_u) {
+	if (d_joint_forces_d_q->rows() != m_num_dofs || d_joint_forces_d_q->cols() != m_num_dofs ||
+		d_joint_forces_d_u->rows() != m_num_dofs || d_joint_forces_d_u->cols() != m_num_dofs) {
+		error_message("Dimension error. System has %d DOFs,\n"
+					  "but dim(d_joint_forces_d_q)= %d x %d, dim(d_joint_forces_d_u)= %d x %d\n",
+					  m_num_dofs, static_cast<int>(d_joint_forces_d_q->rows()),
+					  static_cast<int>(d_joint_forces_d_q->cols()),
+					  static_cast<int>(d_joint_forces_d_u->rows()),
+					  static_cast<int>(d_joint_forces_d_u->cols()));
+		return -1;
+	}
+	if (-1 == calculateInverseDynamics(q, u, dot_u, joint_forces)) {
+		return -1;
+	}
+
+	for (int i = 0; i < m_num_dofs; i++) {
+		for (int j = 0; j < m_num_dofs; j++) {
+			setMatxxElem(i, j, 0.0, d_joint_forces_d_q);
+			setMatxxElem(i, j, 0.0, d_joint_forces_d_u);
+		}
+	}
+
+	vec3 zero;
+	setZero(zero);
+
+	// 1. revolute joints: q rotates the body frame about the joint axis,
+	// u is the relative angular velocity about the axis
+	for (idArrayIdx i = 0; i < m_body_revolute_list.size(); i++) {
+		const int body_index = m_body_revolute_list[i];
+		const RigidBody &body = m_body_list[body_index];
+		calculateInverseDynamicsTangent(body_index, body.m_Jac_JR, zero, zero, zero, zero,
+										body.m_q_index, d_joint_forces_d_q);
+		calculateInverseDynamicsTangent(body_index, zero, zero, body.m_Jac_JR, zero, zero,
+										body.m_q_index, d_joint_forces_d_u);
+	}
+	// 2. prismatic joints: q translates the body frame along the joint axis,
+	// u is the relative velocity along the axis
+	for (idArrayIdx i = 0; i < m_body_prismatic_list.size(); i++) {
+		const int body_index = m_body_prismatic_list[i];
+		const RigidBody &body = m_body_list[body_index];
+		calculateInverseDynamicsTangent(body_index, zero, body.m_parent_Jac_JT, zero, zero, zero,
+										body.m_q_index, d_joint_forces_d_q);
+		calculateInverseDynamicsTangent(body_index, zero, zero, zero, body.m_parent_Jac_JT, zero,
+										body.m_q_index, d_joint_forces_d_u);
+	}
+	// 3. floating joints: body_T_parent = T_z(q2)*T_y(q1)*T_x(q0). The derivative w.r.t.
+	// each angle is a rotation about the corresponding axis, written in the body frame.
+	// Relative position, velocity and acceleration are rotated with the body frame.
+	for (idArrayIdx i = 0; i < m_body_floating_list.size(); i++) {
+		const int body_index = m_body_floating_list[i];
+		const RigidBody &body = m_body_list[body_index];
+		const mat33 T_z = transformZ(q(body.m_q_index + 2));
+		const mat33 T_zy = T_z * transformY(q(body.m_q_index + 1));
+		const mat33 parent_T_body = body.m_body_T_parent.transpose();
+		const vec3 body_vel_rel = body.m_body_T_parent * body.m_parent_vel_rel;
+		const vec3 body_acc_rel = body.m_body_T_parent * body.m_parent_acc_rel;
+		for (int k = 0; k < 3; k++) {
+			vec3 unit;
+			setZero(unit);
+			unit(k) = 1.0;
+			vec3 body_d_rot;
+			switch (k) {
+				case 0:
+					body_d_rot = T_zy * unit;
+					break;
+				case 1:
+					body_d_rot = T_z * unit;
+					break;
+				default:
+					body_d_rot = unit;
+					break;
+			}
+			calculateInverseDynamicsTangent(
+				body_index, body_d_rot, zero - body_d_rot.cross(body.m_parent_pos_parent_body),
+				zero, parent_T_body * body_d_rot.cross(body_vel_rel),
+				parent_T_body * body_d_rot.cross(body_acc_rel), body.m_q_index + k,
+				d_joint_forces_d_q);
+			calculateInverseDynamicsTangent(body_index, zero, body.m_body_T_parent * unit, zero,
+											zero, zero, body.m_q_index + 3 + k,
+											d_joint_forces_d_q);
+			calculateInverseDynamicsTangent(body_index, zero, zero, unit, zero, zero,
+											body.m_q_index + k, d_joint_forces_d_u);
+			calculateInverseDynamicsTangent(body_index, zero, zero, zero, parent_T_body * unit,
+											zero, body.m_q_index + 3 + k, d_joint_forces_d_u);
+		}
+	}
+
+#ifdef BT_ID_CHECK_DERIVATIVES
+	checkInverseDynamicsDerivatives(q, u, dot_u, *d_joint_forces_d_q, *d_joint_forces_d_u);
+#endif
+
+	return 0;
+}
+
+#ifdef BT_ID_CHECK_DERIVATIVES
+void MultiBodyTree::MultiBodyImpl::checkInverseDynamicsDerivatives(
+	const vecx &q, const vecx &u, const vecx &dot_u, const matxx &d_joint_forces_d_q,
+	const matxx &d_joint_forces_d_u) {
+	const idScalar step = 1e-6;
+	const idScalar tolerance = 1e-4;
+	vecx q_step(m_num_dofs), u_step(m_num_dofs);
+	vecx forces_plus(m_num_dofs), forces_minus(m_num_dofs);
+	for (int i = 0; i < m_num_dofs; i++) {
+		q_step(i) = q(i);
+		u_step(i) = u(i);
+	}
+
+	for (int column = 0; column < m_num_dofs; column++) {
+		// 0: derivative w.r.t. q, 1: derivative w.r.t. u
+		for (int wrt = 0; wrt < 2; wrt++) {
+			vecx &x = (0 == wrt) ? q_step : u_step;
+			const matxx &analytic = (0 == wrt) ? d_joint_forces_d_q : d_joint_forces_d_u;
+			const idScalar x0 = x(column);
+			x(column) = x0 + step;
+			calculateInverseDynamics(q_step, u_step, dot_u, &forces_plus);
+			x(column) = x0 - step;
+			calculateInverseDynamics(q_step, u_step, dot_u, &forces_minus);
+			x(column) = x0;
+			for (int row = 0; row < m_num_dofs; row++) {
+				const idScalar difference = (forces_plus(row) - forces_minus(row)) / (2.0 * step);
+				const idScalar error = BT_ID_FABS(difference - analytic(row, column)) /
+									   BT_ID_MAX(idScalar(1.0), BT_ID_FABS(difference));
+				if (error > tolerance) {
+					warning_message("d(joint_forces(%d))/d(%s(%d)) is %e, central differences give %e\n",
+									row, (0 == wrt) ? "q" : "u", column, analytic(row, column),
+									difference);
+				}
+			}
+		}
+	}
+
+	// restore the kinematics and forces of the unperturbed state
+	calculateInverseDynamics(q, u, dot_u, &forces_plus);
+}
+#endif
+
 int MultiBodyTree::MultiBodyImpl::calculateKinematics(const vecx &q, const vecx &u, const vecx& dot_u,
                                                       const KinUpdateType type) {
     	if (q.size() != m_num_dofs || u.size() != m_num_dofs || dot_u.size() != m_num_dofs ) {
@@ -983,6 +1270,13 @@ void MultiBodyTree::MultiBodyImpl::clearAllUserForcesAndMoments() {
 	}
 }
 
+void MultiBodyTree::MultiBodyImpl::copyBodyDataFrom(const MultiBodyImpl &other) {
+	m_world_gravity = other.m_world_gravity;
+	for (int index = 0; index < m_num_bodies; index++) {
+		m_body_list[index] = other.m_body_list[index];
+	}
+}
+
 int MultiBodyTree::MultiBodyImpl::addUserForce(const int body_index, const vec3 &body_force) {
 	CHECK_IF_BODY_INDEX_IS_VALID(body_index);
 	m_body_list[body_index].m_body_force_user += body_force;
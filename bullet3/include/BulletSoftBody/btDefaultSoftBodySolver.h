@@ -20,7 +20,11 @@ subject to the following restrictions:
 #include "BulletSoftBody/btSoftBodySolvers.h"
 #include "btSoftBodySolverVertexBuffer.h"
 struct btCollisionObjectWrapper;
+struct btSoftBodyIslands;
 
+///btDefaultSoftBodySolver steps the soft bodies on the CPU. When a task scheduler with more than one thread is set,
+///the bodies are predicted and updated in parallel, and solved in parallel in islands of bodies that share anchored
+///rigid bodies, contacts or multibodies. Bodies of an island are solved in order, so the result matches a serial step.
 class btDefaultSoftBodySolver : public btSoftBodySolver
 {
 protected:		
@@ -29,6 +33,24 @@ protected:
 
 	btAlignedObjectArray< btSoftBody * > m_softBodySet;
 
+	enum SoftBodyStage
+	{
+		SOFTBODY_PREDICT_MOTION,
+		SOFTBODY_INTEGRATE_MOTION
+	};
+	struct SoftBodyLoop;
+	struct SoftBodyIslandLoop;
+
+	btSoftBodyIslands* m_islands;
+	btAlignedObjectArray< btSoftBody * > m_activeSoftBodies;
+	int m_softBodyGrainSize;
+
+	void	processSoftBodies(SoftBodyStage stage, btScalar timeStep);
+
+	void	processSoftBodyRange(SoftBodyStage stage, btScalar timeStep, int iBegin, int iEnd);
+
+	void	buildIslands();
+
 
 public:
 	btDefaultSoftBodySolver();
@@ -58,6 +80,16 @@ public:
 
 	virtual void processCollision( btSoftBody*, btSoftBody* );
 
+	///the number of soft bodies handed to a thread at once, 1 by default since a soft body is usually a sizeable amount of work
+	int		getSoftBodyGrainSize() const
+	{
+		return m_softBodyGrainSize;
+	}
+	void	setSoftBodyGrainSize(int grainSize)
+	{
+		m_softBodyGrainSize = btMax(1, grainSize);
+	}
+
 };
 
 #endif // #ifndef BT_ACCELERATED_SOFT_BODY_CPU_SOLVER_H
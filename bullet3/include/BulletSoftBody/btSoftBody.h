@@ -245,6 +245,13 @@ public:
 		BT_DECLARE_ALIGNED_ALLOCATOR();
 
 	};
+	/* PackedLink, a link solved by the batched link solver	*/ 
+	struct	PackedLink
+	{
+		int						m_n[2];			// Node indices
+		btScalar				m_c0;			// (ima+imb)*kLST
+		btScalar				m_c1;			// rl^2
+	};
 	/* Face			*/ 
 	struct	Face : Feature
 	{
@@ -658,6 +665,9 @@ public:
 	tNoteArray				m_notes;		// Notes
 	tNodeArray				m_nodes;		// Nodes
 	tLinkArray				m_links;		// Links
+	btAlignedObjectArray<int>	m_linkBatches;	// Start of each link batch, see generateLinkBatches
+	btAlignedObjectArray<PackedLink>	m_packedLinks;	// Links of the batches, as node indices
+	btAlignedObjectArray<btScalar>	m_packedNodes;	// Position and 1/mass of the nodes, while the batches are solved
 	tFaceArray				m_faces;		// Faces
 	tTetraArray				m_tetras;		// Tetras
 	tAnchorArray			m_anchors;		// Anchors
@@ -851,6 +861,13 @@ public:
 		Material* mat=0);
 	/* Randomize constraints to reduce solver bias							*/ 
 	void				randomizeConstraints();
+	/* Sort links into batches that share no node, solved in parallel		*/ 
+	///generateLinkBatches reorders m_links so that the links of each batch can be solved by several threads
+	///at the same time (see btParallelFor), this changes the order links are solved in.
+	///The positions of the batches are solved on a compact copy of the nodes, four links at a time with SSE.
+	///The batches are discarded when links are added, removed or reordered, call it again after that.
+	void				generateLinkBatches();
+	bool				hasLinkBatches() const;
 	/* Release clusters														*/ 
 	void				releaseCluster(int index);
 	void				releaseClusters();
@@ -870,8 +887,8 @@ public:
 		sRayCast& results);
 	/* Solver presets														*/ 
 	void				setSolver(eSolverPresets::_ preset);
-	/* predictMotion														*/ 
-	void				predictMotion(btScalar dt);
+	/* predictMotion, the broadphase update can be deferred to updateBroadphaseAabb	*/ 
+	void				predictMotion(btScalar dt,bool updateBroadphase=true);
 	/* solveConstraints														*/ 
 	void				solveConstraints();
 	/* staticSolve															*/ 
@@ -967,7 +984,8 @@ public:
 	btVector3			evaluateCom() const;
 	bool				checkContact(const btCollisionObjectWrapper* colObjWrap,const btVector3& x,btScalar margin,btSoftBody::sCti& cti) const;
 	void				updateNormals();
-	void				updateBounds();
+	void				updateBounds(bool updateBroadphase=true);
+	void				updateBroadphaseAabb();
 	void				updatePose();
 	void				updateConstants();
 	void				updateLinkConstants();
@@ -0,0 +1,94 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef _BT_SOFT_BODY_ISLANDS_H
+#define _BT_SOFT_BODY_ISLANDS_H
+
+#include "BulletCollision/CollisionDispatch/btUnionFind.h"
+#include "LinearMath/btHashMap.h"
+
+//
+// btSoftBodyIslands, groups soft bodies that write to the same objects (rigid bodies,
+// multibodies, clusters or nodes of other soft bodies) while they are solved.
+// Different islands can be solved in parallel, and give the same result as a serial solve
+// as long as the bodies of each island are solved in order.
+//
+struct btSoftBodyIslands
+{
+	btUnionFind					m_unionFind;
+	btHashMap<btHashPtr,int>	m_objectBodies;
+	btAlignedObjectArray<int>	m_rootIslands;
+	btAlignedObjectArray<int>	m_islandStart;
+	btAlignedObjectArray<int>	m_islandBodies;
+
+	void					reset(int numBodies)
+	{
+		m_unionFind.reset(numBodies);
+		m_objectBodies.clear();
+	}
+	/* body writes to object	*/ 
+	void					couple(int body,const void* object)
+	{
+		const int*	other=m_objectBodies.find(btHashPtr(object));
+		if(other)
+			m_unionFind.unite(*other,body);
+		else
+			m_objectBodies.insert(btHashPtr(object),body);
+	}
+	/* islands are ordered by their first body, bodies are ascending within an island	*/ 
+	void					build()
+	{
+		const int	n=m_unionFind.getNumElements();
+		m_rootIslands.resize(0);
+		m_rootIslands.resize(n,-1);
+		m_islandStart.resize(0);
+		m_islandBodies.resize(n);
+		int i;
+		for(i=0;i<n;++i)
+		{
+			int&	island=m_rootIslands[m_unionFind.find(i)];
+			if(island<0)
+			{
+				island=m_islandStart.size();
+				m_islandStart.push_back(0);
+			}
+			++m_islandStart[island];
+		}
+		int	start=0;
+		for(i=0;i<m_islandStart.size();++i)
+		{
+			const int	count=m_islandStart[i];
+			m_islandStart[i]=start;
+			start+=count;
+		}
+		m_islandStart.push_back(n);
+		for(i=0;i<n;++i)
+		{
+			const int	island=m_rootIslands[m_unionFind.find(i)];
+			m_islandBodies[m_islandStart[island]++]=i;
+		}
+		/* restore the island starts, the loop above advanced them to the next island	*/ 
+		for(i=m_islandStart.size()-2;i>0;--i)
+		{
+			m_islandStart[i]=m_islandStart[i-1];
+		}
+		if(m_islandStart.size()>1) m_islandStart[0]=0;
+	}
+	int						getNumIslands() const	{ return(m_islandStart.size()-1); }
+	int						getIslandSize(int island) const	{ return(m_islandStart[island+1]-m_islandStart[island]); }
+	const int*				getIslandBodies(int island) const	{ return(&m_islandBodies[m_islandStart[island]]); }
+};
+
+#endif //_BT_SOFT_BODY_ISLANDS_H
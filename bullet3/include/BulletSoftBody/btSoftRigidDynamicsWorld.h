@@ -102,6 +102,9 @@ public:
 
 	virtual	void	serialize(btSerializer* serializer);
 
+	///adds the positions and velocities of the soft body nodes to the hash of btDiscreteDynamicsWorld
+	virtual	void	calculateStateHash(btStateHash& stateHash) const;
+
 };
 
 #endif //BT_SOFT_RIGID_DYNAMICS_WORLD_H
@@ -0,0 +1,129 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_CONVEX_HULL_CACHE_H
+#define BT_CONVEX_HULL_CACHE_H
+
+#include "btConvexHullComputer.h"
+#include "btHashMap.h"
+#include "btThreads.h"
+
+class btMappedFile;
+
+///key of a cached hull: a 64 bit hash of the input coordinates and hull parameters, and the number of input points
+struct btConvexHullCacheKey
+{
+	unsigned int	m_hashLow;
+	unsigned int	m_hashHigh;
+	int				m_count;
+
+	bool equals(const btConvexHullCacheKey& other) const
+	{
+		return (m_hashLow == other.m_hashLow) && (m_hashHigh == other.m_hashHigh) && (m_count == other.m_count);
+	}
+
+	SIMD_FORCE_INLINE	unsigned int getHash() const
+	{
+		return m_hashLow ^ m_hashHigh;
+	}
+};
+
+///btConvexHullCache stores the output of btConvexHullComputer, keyed by the content of the input points.
+///Hulls can be written to a compact binary image with serialize/save, and loaded back with load, which
+///memory-maps the file and uses the hull data in place, so loading a large cache doesn't copy or parse it.
+///The image uses the native byte order and btScalar precision, images with a different btScalar size are rejected.
+///Lookups and inserts are protected by a spin mutex, so a cache can be shared by several threads when BT_THREADSAFE is enabled.
+class btConvexHullCache
+{
+	struct Entry
+	{
+		btConvexHullCacheKey	m_key;
+		btScalar				m_shift;
+		int						m_numVertices;
+		int						m_numEdges;
+		int						m_numFaces;
+		const btScalar*			m_vertices;	//3 scalars per vertex
+		const int*				m_edges;	//next, reverse and target vertex per edge
+		const int*				m_faces;
+	};
+
+	btAlignedObjectArray<Entry>			m_entries;
+	btHashMap<btConvexHullCacheKey,int>	m_entryMap;
+	btAlignedObjectArray<void*>			m_ownedData;
+	btAlignedObjectArray<btMappedFile*>	m_mappedFiles;
+	mutable btSpinMutex					m_mutex;
+
+	btConvexHullCache(const btConvexHullCache&);
+	btConvexHullCache& operator=(const btConvexHullCache&);
+
+	btScalar	compute(btConvexHullComputer& hull, const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp);
+
+	bool	findInternal(const btConvexHullCacheKey& key, btConvexHullComputer& hull, btScalar& shift) const;
+
+	void	insertInternal(const btConvexHullCacheKey& key, const btConvexHullComputer& hull, btScalar shift);
+
+	int		calculateSerializeBufferSizeInternal() const;
+
+	void	serializeInternal(void* buffer) const;
+
+public:
+
+	btConvexHullCache();
+
+	~btConvexHullCache();
+
+	static btConvexHullCacheKey	computeKey(const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp);
+
+	///same as btConvexHullComputer::computeParallel, but the hull is taken from the cache if the same points were seen before
+	btScalar	compute(btConvexHullComputer& hull, const float* coords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
+	{
+		return compute(hull, coords, false, stride, count, shrink, shrinkClamp);
+	}
+
+	btScalar	compute(btConvexHullComputer& hull, const double* coords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
+	{
+		return compute(hull, coords, true, stride, count, shrink, shrinkClamp);
+	}
+
+	int		getNumHulls() const
+	{
+		return m_entries.size();
+	}
+
+	void	clear();
+
+	///size in bytes of the binary image written by serialize
+	int		calculateSerializeBufferSize() const;
+
+	///writes the binary image of all cached hulls into buffer, which needs calculateSerializeBufferSize bytes.
+	///No hulls may be added between the two calls, save doesn't have this restriction.
+	void	serialize(void* buffer) const;
+
+	bool	save(const char* fileName) const;
+
+	///adds the hulls of a binary image, the data is used in place and has to stay valid until the cache is cleared or destroyed.
+	///Hulls that are already cached are skipped. Returns false if the image is invalid: sizes, offsets and all edge and face
+	///indices are checked before anything is added, so a truncated or corrupt image is rejected instead of read out of bounds.
+	bool	attach(const void* data, int size);
+
+	///memory-maps a file written by save and attaches it
+	bool	load(const char* fileName);
+};
+
+///the cache used by btPolyhedralConvexShape::initializePolyhedralFeatures, none by default
+void	btSetConvexHullCache(btConvexHullCache* cache);
+btConvexHullCache*	btGetConvexHullCache();
+
+#endif //BT_CONVEX_HULL_CACHE_H
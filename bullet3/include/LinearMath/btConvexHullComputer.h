@@ -24,7 +24,7 @@ subject to the following restrictions:
 class btConvexHullComputer
 {
 	private:
-		btScalar compute(const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp);
+		btScalar compute(const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp, int pointsPerTask);
 
 	public:
 
@@ -36,6 +36,7 @@ class btConvexHullComputer
 				int targetVertex;
 
 				friend class btConvexHullComputer;
+				friend class btConvexHullCache;
 
 			public:
 				int getSourceVertex() const
@@ -88,13 +89,31 @@ class btConvexHullComputer
 		*/
 		btScalar compute(const float* coords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
 		{
-			return compute(coords, false, stride, count, shrink, shrinkClamp);
+			return compute(coords, false, stride, count, shrink, shrinkClamp, 0);
 		}
 
 		// same as above, but double precision
 		btScalar compute(const double* coords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
 		{
-			return compute(coords, true, stride, count, shrink, shrinkClamp);
+			return compute(coords, true, stride, count, shrink, shrinkClamp, 0);
+		}
+
+		/*
+		Same as compute, but faster for large point clouds. The points are split into chunks of "pointsPerTask"
+		consecutive points and the hulls of the chunks are computed in parallel using btParallelFor. The final
+		hull is computed from the vertices of these hulls only. As all hulls use the same quantization of the
+		input, the hull has the same vertices and faces as the one of compute (possibly in a different order),
+		and the result doesn't depend on the number of threads.
+		*/
+		btScalar computeParallel(const float* coords, int stride, int count, btScalar shrink, btScalar shrinkClamp, int pointsPerTask = 4096)
+		{
+			return compute(coords, false, stride, count, shrink, shrinkClamp, pointsPerTask);
+		}
+
+		// same as above, but double precision
+		btScalar computeParallel(const double* coords, int stride, int count, btScalar shrink, btScalar shrinkClamp, int pointsPerTask = 4096)
+		{
+			return compute(coords, true, stride, count, shrink, shrinkClamp, pointsPerTask);
 		}
 };
 
@@ -0,0 +1,77 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_MAPPED_FILE_H
+#define BT_MAPPED_FILE_H
+
+#include "btScalar.h"
+
+///btMappedFile maps a whole file read-only into memory.
+///It uses mmap on Unix-like systems (including Android) and file mappings on Windows.
+///On other platforms the file is read into a heap buffer, so the data is always
+///accessible through getData(), only the cost of opening differs.
+class btMappedFile
+{
+	const void*	m_data;
+	size_t		m_size;
+	bool		m_isHeapCopy;
+	bool		m_isWritable;
+	void*		m_fileHandle;
+	void*		m_mappingHandle;
+
+	btMappedFile(const btMappedFile&);
+	btMappedFile& operator=(const btMappedFile&);
+
+public:
+
+	btMappedFile();
+
+	~btMappedFile();
+
+	///maps the file, returns false if it can't be opened or is empty.
+	///A copyOnWrite mapping can be written, the written pages become private copies and the file isn't changed.
+	bool	open(const char* fileName, bool copyOnWrite=false);
+
+	void	close();
+
+	bool	isOpen() const
+	{
+		return m_data != 0;
+	}
+
+	const void*	getData() const
+	{
+		return m_data;
+	}
+
+	///the data of a copyOnWrite mapping or heap copy, 0 for a read-only mapping
+	void*	getWritableData() const
+	{
+		return m_isWritable ? (void*)m_data : 0;
+	}
+
+	size_t	getSize() const
+	{
+		return m_size;
+	}
+
+	///true if the data is a private heap copy instead of a mapping of the file
+	bool	isHeapCopy() const
+	{
+		return m_isHeapCopy;
+	}
+};
+
+#endif //BT_MAPPED_FILE_H
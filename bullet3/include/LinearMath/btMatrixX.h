@@ -343,37 +343,37 @@ struct btMatrixX
 
 	btMatrixX operator*(const btMatrixX& other)
 	{
-		//btMatrixX*btMatrixX implementation, brute force
+		//btMatrixX*btMatrixX implementation, cache blocked:
+		//rows of res are accumulated as linear combinations of the rows of other, so all loops stream through
+		//contiguous memory, and the k dimension is split into blocks that keep the touched rows of other in cache.
+		//The inner loop has no dependencies between iterations, so the compiler can vectorize it.
 		btAssert(cols() == other.rows());
 
 		btMatrixX res(rows(),other.cols());
+		if (!res.m_storage.size())
+			return res;
 		res.setZero();
+		const int blockSize = 64;
+		const int n = other.cols();
 //		BT_PROFILE("btMatrixX mul");
-		for (int j=0; j < res.cols(); ++j)
+		for (int k0=0; k0 < cols(); k0+=blockSize)
 		{
+			int k1 = k0+blockSize < cols() ? k0+blockSize : cols();
+			for (int i=0; i < res.rows(); ++i)
 			{
-				for (int i=0; i < res.rows(); ++i)
+				const T* rowA = &m_storage[i*m_cols];
+				T* rowRes = &res.m_storage[i*n];
+				for (int k=k0;k<k1;k++)
 				{
-					T dotProd=0;
-//					T dotProd2=0;
-					//int waste=0,waste2=0;
-
+					T w = rowA[k];
+					//the matrices are sparse, skip zero elements
+					if (w==0.f)
+						continue;
+					const T* rowOther = &other.m_storage[k*n];
+					for (int j=0;j<n;j++)
 					{
-//						bool useOtherCol = true;
-						{
-							for (int v=0;v<rows();v++)
-							{
-								T w = (*this)(i,v);
-								if (other(v,j)!=0.f)
-								{
-									dotProd+=w*other(v,j);	
-								}
-						
-							}
-						}
+						rowRes[j] += w*rowOther[j];
 					}
-					if (dotProd)
-						res.setElem(i,j,dotProd);
 				}
 			}
 		}
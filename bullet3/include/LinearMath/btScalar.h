@@ -282,6 +282,22 @@ inline int btGetVersion()
 	#endif	//__CELLOS_LV2__
 #endif//_WIN32
 
+#ifdef BT_DETERMINISTIC
+	///BT_DETERMINISTIC makes the simulation produce the same bits on every platform, for lockstep simulations
+	///that compare btCollisionWorld::calculateStateHash between peers. It disables the SIMD code paths, the
+	///elementary functions (btSin, btAtan2, btExp...) use btDeterministicSin etc. instead of the C library,
+	///and the solver gets the contact manifolds in a canonical order. The compiler must not contract
+	///multiplications and additions into fused multiply-adds: compile with -ffp-contract=off (gcc, clang)
+	///or /fp:precise (MSVC), and with -mfpmath=sse on 32 bit x86, where the x87 unit rounds differently.
+	#undef BT_USE_SSE
+	#undef BT_USE_SSE_IN_API
+	#undef BT_USE_SIMD_VECTOR3
+	#undef BT_USE_NEON
+	#undef BT_ALLOW_SSE4
+	#if defined(__clang__)
+		#pragma STDC FP_CONTRACT OFF
+	#endif
+#endif //BT_DETERMINISTIC
 
 ///The btScalar type abstracts floating point numbers, to easily switch between double and single floating point precision.
 #if defined(BT_USE_DOUBLE_PRECISION)
@@ -410,6 +426,18 @@ inline int btGetVersion()
 	SIMD_FORCE_INLINE void *operator new[](size_t, void *ptr) { return ptr; }                              \
 	SIMD_FORCE_INLINE void operator delete[](void *, void *) {}
 
+///elementary functions that give the same results on all platforms, see BT_DETERMINISTIC
+double	btDeterministicSin(double x);
+double	btDeterministicCos(double x);
+double	btDeterministicTan(double x);
+double	btDeterministicAsin(double x);
+double	btDeterministicAcos(double x);
+double	btDeterministicAtan(double x);
+double	btDeterministicAtan2(double y, double x);
+double	btDeterministicExp(double x);
+double	btDeterministicLog(double x);
+double	btDeterministicPow(double x, double y);
+
 #if defined(BT_USE_DOUBLE_PRECISION) || defined(BT_FORCE_DOUBLE_FUNCTIONS)
 
 	SIMD_FORCE_INLINE btScalar btSqrt(btScalar x)
@@ -417,6 +445,8 @@ inline int btGetVersion()
 		return sqrt(x);
 	}
 	SIMD_FORCE_INLINE btScalar btFabs(btScalar x) { return fabs(x); }
+	SIMD_FORCE_INLINE btScalar btFmod(btScalar x, btScalar y) { return fmod(x, y); }
+#ifndef BT_DETERMINISTIC
 	SIMD_FORCE_INLINE btScalar btCos(btScalar x) { return cos(x); }
 	SIMD_FORCE_INLINE btScalar btSin(btScalar x) { return sin(x); }
 	SIMD_FORCE_INLINE btScalar btTan(btScalar x) { return tan(x); }
@@ -437,7 +467,7 @@ inline int btGetVersion()
 	SIMD_FORCE_INLINE btScalar btExp(btScalar x) { return exp(x); }
 	SIMD_FORCE_INLINE btScalar btLog(btScalar x) { return log(x); }
 	SIMD_FORCE_INLINE btScalar btPow(btScalar x, btScalar y) { return pow(x, y); }
-	SIMD_FORCE_INLINE btScalar btFmod(btScalar x, btScalar y) { return fmod(x, y); }
+#endif //BT_DETERMINISTIC
 
 #else//BT_USE_DOUBLE_PRECISION
 
@@ -473,6 +503,8 @@ inline int btGetVersion()
 	#endif
 	}
 	SIMD_FORCE_INLINE btScalar btFabs(btScalar x) { return fabsf(x); }
+	SIMD_FORCE_INLINE btScalar btFmod(btScalar x, btScalar y) { return fmodf(x, y); }
+#ifndef BT_DETERMINISTIC
 	SIMD_FORCE_INLINE btScalar btCos(btScalar x) { return cosf(x); }
 	SIMD_FORCE_INLINE btScalar btSin(btScalar x) { return sinf(x); }
 	SIMD_FORCE_INLINE btScalar btTan(btScalar x) { return tanf(x); }
@@ -497,10 +529,38 @@ inline int btGetVersion()
 	SIMD_FORCE_INLINE btScalar btExp(btScalar x) { return expf(x); }
 	SIMD_FORCE_INLINE btScalar btLog(btScalar x) { return logf(x); }
 	SIMD_FORCE_INLINE btScalar btPow(btScalar x, btScalar y) { return powf(x, y); }
-	SIMD_FORCE_INLINE btScalar btFmod(btScalar x, btScalar y) { return fmodf(x, y); }
+#endif //BT_DETERMINISTIC
 
 #endif//BT_USE_DOUBLE_PRECISION
 
+#ifdef BT_DETERMINISTIC
+	//the single precision functions are evaluated in double precision and rounded once
+	SIMD_FORCE_INLINE btScalar btCos(btScalar x) { return btScalar(btDeterministicCos(x)); }
+	SIMD_FORCE_INLINE btScalar btSin(btScalar x) { return btScalar(btDeterministicSin(x)); }
+	SIMD_FORCE_INLINE btScalar btTan(btScalar x) { return btScalar(btDeterministicTan(x)); }
+	SIMD_FORCE_INLINE btScalar btAcos(btScalar x)
+	{
+		if (x < btScalar(-1))
+			x = btScalar(-1);
+		if (x > btScalar(1))
+			x = btScalar(1);
+		return btScalar(btDeterministicAcos(x));
+	}
+	SIMD_FORCE_INLINE btScalar btAsin(btScalar x)
+	{
+		if (x < btScalar(-1))
+			x = btScalar(-1);
+		if (x > btScalar(1))
+			x = btScalar(1);
+		return btScalar(btDeterministicAsin(x));
+	}
+	SIMD_FORCE_INLINE btScalar btAtan(btScalar x) { return btScalar(btDeterministicAtan(x)); }
+	SIMD_FORCE_INLINE btScalar btAtan2(btScalar x, btScalar y) { return btScalar(btDeterministicAtan2(x, y)); }
+	SIMD_FORCE_INLINE btScalar btExp(btScalar x) { return btScalar(btDeterministicExp(x)); }
+	SIMD_FORCE_INLINE btScalar btLog(btScalar x) { return btScalar(btDeterministicLog(x)); }
+	SIMD_FORCE_INLINE btScalar btPow(btScalar x, btScalar y) { return btScalar(btDeterministicPow(x, y)); }
+#endif //BT_DETERMINISTIC
+
 #define SIMD_PI btScalar(3.1415926535897932384626433832795029)
 #define SIMD_2_PI (btScalar(2.0) * SIMD_PI)
 #define SIMD_HALF_PI (SIMD_PI * btScalar(0.5))
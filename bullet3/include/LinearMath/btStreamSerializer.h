@@ -0,0 +1,107 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_STREAM_SERIALIZER_H
+#define BT_STREAM_SERIALIZER_H
+
+#include "btSerializer.h"
+#include "btThreads.h"
+#include <stdio.h>
+
+///btSerializerSink receives the bytes written by a btStreamSerializer, in order
+class btSerializerSink
+{
+public:
+
+	virtual ~btSerializerSink() {}
+
+	///returns false if the data couldn't be written
+	virtual bool	write(const void* data, int size) = 0;
+};
+
+///btFileSerializerSink writes to a file opened in binary mode
+class btFileSerializerSink : public btSerializerSink
+{
+	FILE*	m_file;
+
+public:
+
+	btFileSerializerSink(FILE* file)
+		:m_file(file)
+	{
+	}
+
+	virtual bool	write(const void* data, int size)
+	{
+		return fwrite(data,1,size_t(size),m_file)==size_t(size);
+	}
+};
+
+///btStreamSerializer writes the same .bullet format as btDefaultSerializer, but passes each chunk to a sink as soon as
+///it is finalized and frees it, so memory is bounded by the chunks that are being filled instead of the whole file.
+///It is thread safe: btCollisionWorld and btDiscreteDynamicsWorld serialize their shapes, objects and constraints with
+///btParallelFor when the serializer is. The order of the chunks then differs between runs, which readers don't depend on.
+///findPointer reserves a pointer when it isn't serialized yet, the caller that gets 0 serializes the object, so shapes
+///shared by several objects or compounds are written once. The serializer can be reused for the next serialization.
+class btStreamSerializer : public btDefaultSerializer
+{
+	btSerializerSink*	m_sink;
+	bool				m_writeFailed;
+	btSpinMutex			m_mutex;
+
+	void	writeToSink(const void* data, int size);
+
+public:
+
+	btStreamSerializer(btSerializerSink* sink);
+
+	virtual ~btStreamSerializer();
+
+	///false if the sink failed to write some data since startSerialization
+	bool	isComplete() const
+	{
+		return !m_writeFailed;
+	}
+
+	virtual bool	isThreadSafe() const
+	{
+		return true;
+	}
+
+	virtual void	startSerialization();
+
+	virtual void	finishSerialization();
+
+	virtual btChunk*	allocate(size_t size, int numElements);
+
+	virtual void	finalizeChunk(btChunk* chunk, const char* structType, int chunkCode, void* oldPtr);
+
+	virtual void*	findPointer(void* oldPtr);
+
+	virtual void*	getUniquePointer(void* oldPtr);
+
+	virtual const unsigned char*	getBufferPointer() const
+	{
+		return 0;
+	}
+
+	///the number of bytes written since startSerialization
+	virtual int		getCurrentBufferSize() const
+	{
+		return m_currentSize;
+	}
+};
+
+#endif //BT_STREAM_SERIALIZER_H
@@ -482,6 +482,12 @@ public:
 
 	virtual	void deSerializeDouble(struct btQuantizedBvhDoubleData& quantizedBvhDoubleData);
 
+	///like deSerializeFloat, but the quantized nodes reference the serialized data instead of being copied, so the data has to outlive the bvh.
+	///The nodes are copied when the data isn't aligned to 16 bytes like btQuantizedBvhNode.
+	void	deSerializeFloatInPlace(struct btQuantizedBvhFloatData& quantizedBvhFloatData);
+
+	void	deSerializeDoubleInPlace(struct btQuantizedBvhDoubleData& quantizedBvhDoubleData);
+
 
 ////////////////////////////////////////////////////////////////////
 
@@ -27,6 +27,7 @@ subject to the following restrictions:
 
 struct	btBroadphaseProxy;
 class	btCollisionShape;
+class	btCollisionWorld;
 struct btCollisionShapeData;
 #include "../../LinearMath/btMotionState.h"
 #include "../../LinearMath/btAlignedAllocator.h"
@@ -80,6 +81,8 @@ protected:
 	int				m_islandTag1;
 	int				m_companionId;
     int             m_worldArrayIndex;  // index of object in world's collisionObjects array
+	///the world that skips this object while it sleeps, activating the object wakes it up in that world
+	btCollisionWorld*	m_dormantWorld;
 
 	mutable int				m_activationState1;
 	mutable btScalar			m_deactivationTime;
@@ -471,6 +474,18 @@ public:
         m_worldArrayIndex = ix;
     }
 
+	///the world that currently treats this object as dormant, see btCollisionWorld::setSkipDormantObjects
+	btCollisionWorld*	getDormantWorld() const
+	{
+		return m_dormantWorld;
+	}
+
+	// only should be called by CollisionWorld
+	void	setDormantWorld(btCollisionWorld* world)
+	{
+		m_dormantWorld = world;
+	}
+
     SIMD_FORCE_INLINE btScalar			getHitFraction() const
 	{
 		return m_hitFraction; 
@@ -21,6 +21,7 @@ subject to the following restrictions:
 #include "BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h"
 #include "BulletCollision/CollisionShapes/btSphereShape.h" //for raycasting
 #include "BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h" //for raycasting
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h" //for raycasting
 #include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 #include "BulletCollision/CollisionShapes/btCompoundShape.h"
 #include "BulletCollision/NarrowPhaseCollision/btSubSimplexConvexCast.h"
@@ -32,6 +33,7 @@ subject to the following restrictions:
 #include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btQuickprof.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btStateHash.h"
 #include "BulletCollision/CollisionShapes/btConvexPolyhedron.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
@@ -70,7 +72,10 @@ btCollisionWorld::btCollisionWorld(btDispatcher* dispatcher,btBroadphaseInterfac
 :m_dispatcher1(dispatcher),
 m_broadphasePairCache(pairCache),
 m_debugDrawer(0),
-m_forceUpdateAllAabbs(true)
+m_forceUpdateAllAabbs(true),
+m_skipDormantObjects(false),
+m_awakeObjectsRevision(0),
+m_collisionObjectsRevision(0)
 {
 }
 
@@ -83,6 +88,7 @@ btCollisionWorld::~btCollisionWorld()
 	for (i=0;i<m_collisionObjects.size();i++)
 	{
 		btCollisionObject* collisionObject= m_collisionObjects[i];
+		collisionObject->setDormantWorld(0);
 
 		btBroadphaseProxy* bp = collisionObject->getBroadphaseHandle();
 		if (bp)
@@ -119,6 +125,12 @@ void	btCollisionWorld::addCollisionObject(btCollisionObject* collisionObject, in
 
     collisionObject->setWorldArrayIndex(m_collisionObjects.size());
 	m_collisionObjects.push_back(collisionObject);
+	m_collisionObjectsRevision++;
+	if (m_skipDormantObjects)
+	{
+		m_awakeObjects.push_back(collisionObject);
+		m_awakeObjectsRevision++;
+	}
 
 	//calculate new AABB
 	btTransform trans = collisionObject->getWorldTransform();
@@ -192,6 +204,17 @@ void	btCollisionWorld::updateAabbs()
 {
 	BT_PROFILE("updateAabbs");
 
+	if (m_skipDormantObjects)
+	{
+		//all objects left in m_awakeObjects are active
+		updateAwakeObjects(true);
+		for ( int i=0;i<m_awakeObjects.size();i++)
+		{
+			updateSingleAabb(m_awakeObjects[i]);
+		}
+		return;
+	}
+
 	btTransform predictedTrans;
 	for ( int i=0;i<m_collisionObjects.size();i++)
 	{
@@ -206,6 +229,73 @@ void	btCollisionWorld::updateAabbs()
 	}
 }
 
+void	btCollisionWorld::updateAwakeObjects(bool removeInactive)
+{
+	btMutexLock(&m_wokenObjectsMutex);
+	if (m_wokenObjects.size())
+	{
+		for (int i=0;i<m_wokenObjects.size();i++)
+		{
+			m_awakeObjects.push_back(m_wokenObjects[i]);
+		}
+		m_wokenObjects.resize(0);
+		m_awakeObjectsRevision++;
+	}
+	btMutexUnlock(&m_wokenObjectsMutex);
+
+	if (removeInactive)
+	{
+		int numAwake = 0;
+		for (int i=0;i<m_awakeObjects.size();i++)
+		{
+			btCollisionObject* colObj = m_awakeObjects[i];
+			if (colObj->isActive())
+			{
+				m_awakeObjects[numAwake++] = colObj;
+			} else
+			{
+				colObj->setDormantWorld(this);
+			}
+		}
+		if (numAwake < m_awakeObjects.size())
+		{
+			m_awakeObjects.resize(numAwake);
+			m_awakeObjectsRevision++;
+		}
+	}
+}
+
+void	btCollisionWorld::wakeDormantObject(const btCollisionObject* colObj)
+{
+	btMutexLock(&m_wokenObjectsMutex);
+	//another thread may have woken it up already
+	if (colObj->getDormantWorld() == this)
+	{
+		btCollisionObject* obj = const_cast<btCollisionObject*>(colObj);
+		obj->setDormantWorld(0);
+		m_wokenObjects.push_back(obj);
+	}
+	btMutexUnlock(&m_wokenObjectsMutex);
+}
+
+void	btCollisionWorld::setSkipDormantObjects(bool skipDormantObjects)
+{
+	if (skipDormantObjects == m_skipDormantObjects)
+		return;
+
+	m_skipDormantObjects = skipDormantObjects;
+	m_awakeObjects.resize(0);
+	m_wokenObjects.resize(0);
+	//all objects start awake, the inactive ones become dormant at the next updateAabbs
+	for (int i=0;i<m_collisionObjects.size();i++)
+	{
+		m_collisionObjects[i]->setDormantWorld(0);
+		if (m_skipDormantObjects)
+			m_awakeObjects.push_back(m_collisionObjects[i]);
+	}
+	m_awakeObjectsRevision++;
+}
+
 
 void	btCollisionWorld::computeOverlappingPairs()
 {
@@ -274,6 +364,20 @@ void	btCollisionWorld::removeCollisionObject(btCollisionObject* collisionObject)
         m_collisionObjects.remove(collisionObject);
     }
     collisionObject->setWorldArrayIndex(-1);
+	m_collisionObjectsRevision++;
+
+	if (m_skipDormantObjects)
+	{
+		if (collisionObject->getDormantWorld() == this)
+		{
+			collisionObject->setDormantWorld(0);
+		} else
+		{
+			m_awakeObjects.remove(collisionObject);
+			m_wokenObjects.remove(collisionObject);
+			m_awakeObjectsRevision++;
+		}
+	}
 }
 
 
@@ -463,12 +567,21 @@ void	btCollisionWorld::rayTestSingleInternal(const btTransform& rayFromTrans,con
 				BridgeTriangleRaycastCallback	rcb(rayFromLocal,rayToLocal,&resultCallback,collisionObjectWrap->getCollisionObject(),concaveShape, colObjWorldTransform);
 				rcb.m_hitFraction = resultCallback.m_closestHitFraction;
 
-				btVector3 rayAabbMinLocal = rayFromLocal;
-				rayAabbMinLocal.setMin(rayToLocal);
-				btVector3 rayAabbMaxLocal = rayFromLocal;
-				rayAabbMaxLocal.setMax(rayToLocal);
+				if (collisionShape->getShapeType()==TERRAIN_SHAPE_PROXYTYPE)
+				{
+					///optimized version for btHeightfieldTerrainShape, only visits the cells crossed by the ray
+					btHeightfieldTerrainShape* heightfield = (btHeightfieldTerrainShape*)collisionShape;
+					heightfield->performRaycast(&rcb,rayFromLocal,rayToLocal);
+				}
+				else
+				{
+					btVector3 rayAabbMinLocal = rayFromLocal;
+					rayAabbMinLocal.setMin(rayToLocal);
+					btVector3 rayAabbMaxLocal = rayFromLocal;
+					rayAabbMaxLocal.setMax(rayToLocal);
 
-				concaveShape->processAllTriangles(&rcb,rayAabbMinLocal,rayAabbMaxLocal);
+					concaveShape->processAllTriangles(&rcb,rayAabbMinLocal,rayAabbMaxLocal);
+				}
 			}
 		} else {
 			//			BT_PROFILE("rayTestCompound");
@@ -1281,6 +1394,457 @@ void	btCollisionWorld::contactPairTest(btCollisionObject* colObjA, btCollisionOb
 }
 
 
+//the bounds of a query of convexSweepTestBatch or contactTestBatch
+struct btBatchQueryBounds
+{
+	btVector3	m_aabbMin;
+	btVector3	m_aabbMax;
+};
+
+//consecutive queries of the sorted order that share a broadphase query of their combined bounds
+struct btBatchQueryCluster
+{
+	int	m_begin;
+	int	m_end;
+	btVector3	m_aabbMin;
+	btVector3	m_aabbMax;
+};
+
+struct btBatchQueryKey
+{
+	unsigned int	m_code;
+	int	m_query;
+};
+
+struct btBatchQueryKeySortPredicate
+{
+	bool operator() (const btBatchQueryKey& a, const btBatchQueryKey& b) const
+	{
+		return a.m_code < b.m_code || (a.m_code == b.m_code && a.m_query < b.m_query);
+	}
+};
+
+static unsigned int btSpreadBits10(unsigned int x)
+{
+	x &= 0x3ff;
+	x = (x | (x << 16)) & 0x030000ff;
+	x = (x | (x << 8)) & 0x0300f00f;
+	x = (x | (x << 4)) & 0x030c30c3;
+	x = (x | (x << 2)) & 0x09249249;
+	return x;
+}
+
+static btScalar btAabbSurfaceArea(const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	btVector3 extent = aabbMax-aabbMin;
+	return btScalar(2.)*(extent.x()*extent.y()+extent.y()*extent.z()+extent.z()*extent.x());
+}
+
+///sorts the queries along a Morton curve, and groups neighbours as long as their combined bounds have no more surface area
+///than their own bounds together. The broadphase query of a cluster then finds few objects that none of its queries overlaps.
+static void btClusterBatchQueries(const btAlignedObjectArray<btBatchQueryBounds>& bounds, btAlignedObjectArray<int>& order, btAlignedObjectArray<btBatchQueryCluster>& clusters)
+{
+	const int maxClusterSize = 32;
+	const int numQueries = bounds.size();
+
+	btVector3 centerMin(BT_LARGE_FLOAT,BT_LARGE_FLOAT,BT_LARGE_FLOAT);
+	btVector3 centerMax(-BT_LARGE_FLOAT,-BT_LARGE_FLOAT,-BT_LARGE_FLOAT);
+	int i;
+	for (i=0;i<numQueries;i++)
+	{
+		btVector3 center = (bounds[i].m_aabbMin+bounds[i].m_aabbMax)*btScalar(0.5);
+		centerMin.setMin(center);
+		centerMax.setMax(center);
+	}
+	btVector3 extent = centerMax-centerMin;
+	btVector3 scale;
+	for (int axis=0;axis<3;axis++)
+	{
+		scale[axis] = extent[axis] > SIMD_EPSILON ? btScalar(1023.)/extent[axis] : btScalar(0.);
+	}
+
+	btAlignedObjectArray<btBatchQueryKey> keys;
+	keys.resize(numQueries);
+	for (i=0;i<numQueries;i++)
+	{
+		btVector3 cell = ((bounds[i].m_aabbMin+bounds[i].m_aabbMax)*btScalar(0.5)-centerMin)*scale;
+		keys[i].m_code = btSpreadBits10((unsigned int)cell.x()) | (btSpreadBits10((unsigned int)cell.y())<<1) | (btSpreadBits10((unsigned int)cell.z())<<2);
+		keys[i].m_query = i;
+	}
+	keys.quickSort(btBatchQueryKeySortPredicate());
+
+	order.resize(numQueries);
+	clusters.resize(0);
+	btScalar areaSum = btScalar(0.);
+	for (i=0;i<numQueries;i++)
+	{
+		const int query = keys[i].m_query;
+		order[i] = query;
+		const btBatchQueryBounds& queryBounds = bounds[query];
+		const btScalar area = btAabbSurfaceArea(queryBounds.m_aabbMin,queryBounds.m_aabbMax);
+		if (clusters.size())
+		{
+			btBatchQueryCluster& cluster = clusters[clusters.size()-1];
+			btVector3 aabbMin = cluster.m_aabbMin;
+			btVector3 aabbMax = cluster.m_aabbMax;
+			aabbMin.setMin(queryBounds.m_aabbMin);
+			aabbMax.setMax(queryBounds.m_aabbMax);
+			if (cluster.m_end-cluster.m_begin < maxClusterSize && btAabbSurfaceArea(aabbMin,aabbMax) <= areaSum+area)
+			{
+				cluster.m_aabbMin = aabbMin;
+				cluster.m_aabbMax = aabbMax;
+				cluster.m_end = i+1;
+				areaSum += area;
+				continue;
+			}
+		}
+		btBatchQueryCluster cluster;
+		cluster.m_begin = i;
+		cluster.m_end = i+1;
+		cluster.m_aabbMin = queryBounds.m_aabbMin;
+		cluster.m_aabbMax = queryBounds.m_aabbMax;
+		clusters.push_back(cluster);
+		areaSum = area;
+	}
+}
+
+struct btBatchCandidateCallback : public btBroadphaseAabbCallback
+{
+	btAlignedObjectArray<const btBroadphaseProxy*>&	m_proxies;
+	int	m_collisionFilterGroup;
+	int	m_collisionFilterMask;
+
+	btBatchCandidateCallback(btAlignedObjectArray<const btBroadphaseProxy*>& proxies, int collisionFilterGroup, int collisionFilterMask)
+		:m_proxies(proxies),
+		m_collisionFilterGroup(collisionFilterGroup),
+		m_collisionFilterMask(collisionFilterMask)
+	{
+	}
+
+	virtual bool	process(const btBroadphaseProxy* proxy)
+	{
+		//same filter as ConvexResultCallback::needsCollision and ContactResultCallback::needsCollision
+		if ((proxy->m_collisionFilterGroup & m_collisionFilterMask) && (m_collisionFilterGroup & proxy->m_collisionFilterMask))
+		{
+			m_proxies.push_back(proxy);
+		}
+		return true;
+	}
+};
+
+struct btConvexSweepBatchLoop : public btIParallelForBody
+{
+	btBroadphaseInterface*	m_broadphase;
+	const btConvexShape* const*	m_castShapes;
+	const btTransform*	m_from;
+	const btTransform*	m_to;
+	btCollisionWorld::ConvexSweepBatchResult*	m_results;
+	const btAlignedObjectArray<btBatchQueryBounds>&	m_castShapeBounds;
+	const btAlignedObjectArray<int>&	m_order;
+	const btAlignedObjectArray<btBatchQueryCluster>&	m_clusters;
+	int	m_collisionFilterGroup;
+	int	m_collisionFilterMask;
+	btScalar	m_allowedCcdPenetration;
+
+	btConvexSweepBatchLoop(btBroadphaseInterface* broadphase, const btConvexShape* const* castShapes, const btTransform* from, const btTransform* to, btCollisionWorld::ConvexSweepBatchResult* results,
+		const btAlignedObjectArray<btBatchQueryBounds>& castShapeBounds, const btAlignedObjectArray<int>& order, const btAlignedObjectArray<btBatchQueryCluster>& clusters,
+		int collisionFilterGroup, int collisionFilterMask, btScalar allowedCcdPenetration)
+		:m_broadphase(broadphase),
+		m_castShapes(castShapes),
+		m_from(from),
+		m_to(to),
+		m_results(results),
+		m_castShapeBounds(castShapeBounds),
+		m_order(order),
+		m_clusters(clusters),
+		m_collisionFilterGroup(collisionFilterGroup),
+		m_collisionFilterMask(collisionFilterMask),
+		m_allowedCcdPenetration(allowedCcdPenetration)
+	{
+	}
+
+	void	sweep(int query, const btAlignedObjectArray<const btBroadphaseProxy*>& proxies) const
+	{
+		const btVector3& convexFrom = m_from[query].getOrigin();
+		const btVector3& convexTo = m_to[query].getOrigin();
+		const btVector3& castShapeAabbMin = m_castShapeBounds[query].m_aabbMin;
+		const btVector3& castShapeAabbMax = m_castShapeBounds[query].m_aabbMax;
+
+		btCollisionWorld::ClosestConvexResultCallback resultCallback(convexFrom,convexTo);
+		resultCallback.m_collisionFilterGroup = m_collisionFilterGroup;
+		resultCallback.m_collisionFilterMask = m_collisionFilterMask;
+
+		//same culling as the ray test of the broadphase in convexSweepTest, see btSingleSweepCallback
+		btVector3 unnormalizedRayDir = convexTo-convexFrom;
+		btVector3 rayDir = unnormalizedRayDir.normalized();
+		btVector3 rayDirectionInverse;
+		rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+		rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+		rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+		unsigned int signs[3] = { rayDirectionInverse[0] < 0.0, rayDirectionInverse[1] < 0.0, rayDirectionInverse[2] < 0.0 };
+		btScalar lambdaMax = rayDir.dot(unnormalizedRayDir);
+
+		for (int j=0;j<proxies.size();j++)
+		{
+			///terminate further convex sweep tests, once the closestHitFraction reached zero
+			if (resultCallback.m_closestHitFraction == btScalar(0.f))
+				break;
+			const btBroadphaseProxy* proxy = proxies[j];
+			btVector3 bounds[2] = { proxy->m_aabbMin-castShapeAabbMax, proxy->m_aabbMax-castShapeAabbMin };
+			btScalar tmin;
+			if (!btRayAabb2(convexFrom,rayDirectionInverse,signs,bounds,tmin,0,lambdaMax))
+				continue;
+			btCollisionObject* collisionObject = (btCollisionObject*)proxy->m_clientObject;
+			btCollisionWorld::objectQuerySingle(m_castShapes[query], m_from[query], m_to[query],
+				collisionObject,
+				collisionObject->getCollisionShape(),
+				collisionObject->getWorldTransform(),
+				resultCallback,
+				m_allowedCcdPenetration);
+		}
+
+		btCollisionWorld::ConvexSweepBatchResult& result = m_results[query];
+		result.m_hitCollisionObject = resultCallback.m_hitCollisionObject;
+		result.m_hitFraction = resultCallback.m_closestHitFraction;
+		if (resultCallback.hasHit())
+		{
+			result.m_hitPointWorld = resultCallback.m_hitPointWorld;
+			result.m_hitNormalWorld = resultCallback.m_hitNormalWorld;
+		} else
+		{
+			result.m_hitPointWorld.setZero();
+			result.m_hitNormalWorld.setZero();
+		}
+	}
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		btAlignedObjectArray<const btBroadphaseProxy*> proxies;
+		btBatchCandidateCallback candidates(proxies,m_collisionFilterGroup,m_collisionFilterMask);
+		for (int c=iBegin;c<iEnd;c++)
+		{
+			const btBatchQueryCluster& cluster = m_clusters[c];
+			proxies.resize(0);
+			m_broadphase->aabbTest(cluster.m_aabbMin,cluster.m_aabbMax,candidates);
+			for (int i=cluster.m_begin;i<cluster.m_end;i++)
+			{
+				sweep(m_order[i],proxies);
+			}
+		}
+	}
+};
+
+void	btCollisionWorld::convexSweepTestBatch(int numSweeps, const btConvexShape* const* castShapes, const btTransform* from, const btTransform* to, ConvexSweepBatchResult* results,
+				int collisionFilterGroup, int collisionFilterMask, btScalar allowedCcdPenetration) const
+{
+	BT_PROFILE("convexSweepTestBatch");
+	if (numSweeps<=0)
+		return;
+
+	btAlignedObjectArray<btBatchQueryBounds> castShapeBounds;
+	btAlignedObjectArray<btBatchQueryBounds> sweptBounds;
+	castShapeBounds.resize(numSweeps);
+	sweptBounds.resize(numSweeps);
+	for (int i=0;i<numSweeps;i++)
+	{
+		/* Compute AABB that encompasses angular movement, as convexSweepTest does */
+		btVector3 linVel, angVel;
+		btTransformUtil::calculateVelocity (from[i], to[i], 1.0f, linVel, angVel);
+		btVector3 zeroLinVel;
+		zeroLinVel.setValue(0,0,0);
+		btTransform R;
+		R.setIdentity ();
+		R.setRotation (from[i].getRotation());
+		castShapes[i]->calculateTemporalAabb (R, zeroLinVel, angVel, 1.0f, castShapeBounds[i].m_aabbMin, castShapeBounds[i].m_aabbMax);
+
+		//the bounds of the whole sweep
+		btVector3 sweepMin = from[i].getOrigin();
+		btVector3 sweepMax = from[i].getOrigin();
+		sweepMin.setMin(to[i].getOrigin());
+		sweepMax.setMax(to[i].getOrigin());
+		sweptBounds[i].m_aabbMin = sweepMin+castShapeBounds[i].m_aabbMin;
+		sweptBounds[i].m_aabbMax = sweepMax+castShapeBounds[i].m_aabbMax;
+	}
+
+	btAlignedObjectArray<int> order;
+	btAlignedObjectArray<btBatchQueryCluster> clusters;
+	btClusterBatchQueries(sweptBounds,order,clusters);
+
+	btConvexSweepBatchLoop sweepLoop(m_broadphasePairCache,castShapes,from,to,results,castShapeBounds,order,clusters,collisionFilterGroup,collisionFilterMask,allowedCcdPenetration);
+	btParallelFor(0,clusters.size(),1,sweepLoop);
+}
+
+
+struct btBatchContactCallback : public btCollisionWorld::ContactResultCallback
+{
+	btAlignedObjectArray<btCollisionWorld::ContactBatchResult>&	m_contacts;
+	const btCollisionObject*	m_queryObject;
+	int	m_queryIndex;
+
+	btBatchContactCallback(btAlignedObjectArray<btCollisionWorld::ContactBatchResult>& contacts, const btCollisionObject* queryObject)
+		:m_contacts(contacts),
+		m_queryObject(queryObject),
+		m_queryIndex(-1)
+	{
+	}
+
+	virtual	btScalar	addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap,int partId0,int index0,const btCollisionObjectWrapper* colObj1Wrap,int partId1,int index1)
+	{
+		btCollisionWorld::ContactBatchResult& contact = m_contacts.expandNonInitializing();
+		contact.m_queryIndex = m_queryIndex;
+		//point A is on the object of colObj0Wrap, which is the query shape unless the algorithm swapped the objects
+		if (colObj0Wrap->getCollisionObject() == m_queryObject)
+		{
+			contact.m_collisionObject = colObj1Wrap->getCollisionObject();
+			contact.m_positionWorldOnQuery = cp.m_positionWorldOnA;
+			contact.m_positionWorldOnObject = cp.m_positionWorldOnB;
+			contact.m_normalWorldOnObject = cp.m_normalWorldOnB;
+			contact.m_partId = partId1;
+			contact.m_index = index1;
+		} else
+		{
+			contact.m_collisionObject = colObj0Wrap->getCollisionObject();
+			contact.m_positionWorldOnQuery = cp.m_positionWorldOnB;
+			contact.m_positionWorldOnObject = cp.m_positionWorldOnA;
+			contact.m_normalWorldOnObject = -cp.m_normalWorldOnB;
+			contact.m_partId = partId0;
+			contact.m_index = index0;
+		}
+		contact.m_distance = cp.getDistance();
+		return 0;
+	}
+};
+
+struct btContactTestBatchLoop : public btIParallelForBody
+{
+	btCollisionWorld*	m_world;
+	const btCollisionShape* const*	m_shapes;
+	const btTransform*	m_transforms;
+	const btAlignedObjectArray<btBatchQueryBounds>&	m_bounds;
+	const btAlignedObjectArray<int>&	m_order;
+	const btAlignedObjectArray<btBatchQueryCluster>&	m_clusters;
+	btAlignedObjectArray<btAlignedObjectArray<btCollisionWorld::ContactBatchResult> >&	m_clusterContacts;
+	int	m_collisionFilterGroup;
+	int	m_collisionFilterMask;
+
+	btContactTestBatchLoop(btCollisionWorld* world, const btCollisionShape* const* shapes, const btTransform* transforms,
+		const btAlignedObjectArray<btBatchQueryBounds>& bounds, const btAlignedObjectArray<int>& order, const btAlignedObjectArray<btBatchQueryCluster>& clusters,
+		btAlignedObjectArray<btAlignedObjectArray<btCollisionWorld::ContactBatchResult> >& clusterContacts, int collisionFilterGroup, int collisionFilterMask)
+		:m_world(world),
+		m_shapes(shapes),
+		m_transforms(transforms),
+		m_bounds(bounds),
+		m_order(order),
+		m_clusters(clusters),
+		m_clusterContacts(clusterContacts),
+		m_collisionFilterGroup(collisionFilterGroup),
+		m_collisionFilterMask(collisionFilterMask)
+	{
+	}
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		btAlignedObjectArray<const btBroadphaseProxy*> proxies;
+		btBatchCandidateCallback candidates(proxies,m_collisionFilterGroup,m_collisionFilterMask);
+		//stands in for the query shapes, which aren't collision objects
+		btCollisionObject queryObject;
+		btDispatcher* dispatcher = m_world->getDispatcher();
+
+		for (int c=iBegin;c<iEnd;c++)
+		{
+			const btBatchQueryCluster& cluster = m_clusters[c];
+			proxies.resize(0);
+			m_world->getBroadphase()->aabbTest(cluster.m_aabbMin,cluster.m_aabbMax,candidates);
+
+			btBatchContactCallback resultCallback(m_clusterContacts[c],&queryObject);
+			for (int i=cluster.m_begin;i<cluster.m_end;i++)
+			{
+				const int query = m_order[i];
+				queryObject.setCollisionShape(const_cast<btCollisionShape*>(m_shapes[query]));
+				queryObject.setWorldTransform(m_transforms[query]);
+				resultCallback.m_queryIndex = query;
+
+				for (int j=0;j<proxies.size();j++)
+				{
+					const btBroadphaseProxy* proxy = proxies[j];
+					if (!TestAabbAgainstAabb2(m_bounds[query].m_aabbMin,m_bounds[query].m_aabbMax,proxy->m_aabbMin,proxy->m_aabbMax))
+						continue;
+
+					//same as btSingleContactCallback
+					btCollisionObject* collisionObject = (btCollisionObject*)proxy->m_clientObject;
+					btCollisionObjectWrapper ob0(0,queryObject.getCollisionShape(),&queryObject,queryObject.getWorldTransform(),-1,-1);
+					btCollisionObjectWrapper ob1(0,collisionObject->getCollisionShape(),collisionObject,collisionObject->getWorldTransform(),-1,-1);
+
+					btCollisionAlgorithm* algorithm = dispatcher->findAlgorithm(&ob0,&ob1,0, BT_CLOSEST_POINT_ALGORITHMS);
+					if (algorithm)
+					{
+						btBridgedManifoldResult contactPointResult(&ob0,&ob1, resultCallback);
+						algorithm->processCollision(&ob0,&ob1, m_world->getDispatchInfo(),&contactPointResult);
+
+						algorithm->~btCollisionAlgorithm();
+						dispatcher->freeCollisionAlgorithm(algorithm);
+					}
+				}
+			}
+		}
+	}
+};
+
+void	btCollisionWorld::contactTestBatch(int numQueries, const btCollisionShape* const* shapes, const btTransform* transforms, btAlignedObjectArray<ContactBatchResult>& contacts,
+				int collisionFilterGroup, int collisionFilterMask)
+{
+	BT_PROFILE("contactTestBatch");
+	contacts.resize(0);
+	if (numQueries<=0)
+		return;
+
+	//the proxies of the objects are enlarged by the contact breaking threshold, see updateSingleAabb
+	btVector3 contactThreshold(gContactBreakingThreshold,gContactBreakingThreshold,gContactBreakingThreshold);
+	btAlignedObjectArray<btBatchQueryBounds> bounds;
+	bounds.resize(numQueries);
+	for (int i=0;i<numQueries;i++)
+	{
+		shapes[i]->getAabb(transforms[i],bounds[i].m_aabbMin,bounds[i].m_aabbMax);
+		bounds[i].m_aabbMin -= contactThreshold;
+		bounds[i].m_aabbMax += contactThreshold;
+	}
+
+	btAlignedObjectArray<int> order;
+	btAlignedObjectArray<btBatchQueryCluster> clusters;
+	btClusterBatchQueries(bounds,order,clusters);
+
+	btAlignedObjectArray<btAlignedObjectArray<ContactBatchResult> > clusterContacts;
+	clusterContacts.resize(clusters.size());
+	btContactTestBatchLoop contactLoop(this,shapes,transforms,bounds,order,clusters,clusterContacts,collisionFilterGroup,collisionFilterMask);
+	btParallelFor(0,clusters.size(),1,contactLoop);
+
+	//the clusters hold the contacts in the sorted order of the queries, put them in query order
+	btAlignedObjectArray<int> firstContact;
+	firstContact.resize(numQueries+1,0);
+	int c,j;
+	for (c=0;c<clusterContacts.size();c++)
+	{
+		for (j=0;j<clusterContacts[c].size();j++)
+		{
+			firstContact[clusterContacts[c][j].m_queryIndex+1]++;
+		}
+	}
+	for (int i=0;i<numQueries;i++)
+	{
+		firstContact[i+1] += firstContact[i];
+	}
+	contacts.resizeNoInitialize(firstContact[numQueries]);
+	for (c=0;c<clusterContacts.size();c++)
+	{
+		for (j=0;j<clusterContacts[c].size();j++)
+		{
+			const ContactBatchResult& contact = clusterContacts[c][j];
+			contacts[firstContact[contact.m_queryIndex]++] = contact;
+		}
+	}
+}
+
+
 
 
 class DebugDrawcallback : public btTriangleCallback, public btInternalTriangleIndexCallback
@@ -1606,6 +2170,54 @@ void	btCollisionWorld::debugDrawWorld()
 }
 
 
+struct btSerializeShapesLoop : public btIParallelForBody
+{
+	btCollisionShape* const*	m_shapes;
+	btSerializer*	m_serializer;
+
+	btSerializeShapesLoop(btCollisionShape* const* shapes, btSerializer* serializer)
+		:m_shapes(shapes),
+		m_serializer(serializer)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			//a shape can be the child of a compound that another thread serializes
+			if (!m_serializer->findPointer(m_shapes[i]))
+			{
+				m_shapes[i]->serializeSingleShape(m_serializer);
+			}
+		}
+	}
+};
+
+struct btSerializeCollisionObjectsLoop : public btIParallelForBody
+{
+	btCollisionObject* const*	m_collisionObjects;
+	btSerializer*	m_serializer;
+
+	btSerializeCollisionObjectsLoop(btCollisionObject* const* collisionObjects, btSerializer* serializer)
+		:m_collisionObjects(collisionObjects),
+		m_serializer(serializer)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			btCollisionObject* colObj = m_collisionObjects[i];
+			if ((colObj->getInternalType() == btCollisionObject::CO_COLLISION_OBJECT) || (colObj->getInternalType() == btCollisionObject::CO_FEATHERSTONE_LINK))
+			{
+				colObj->serializeSingleObject(m_serializer);
+			}
+		}
+	}
+};
+
 void	btCollisionWorld::serializeCollisionObjects(btSerializer* serializer)
 {
 	int i;
@@ -1613,6 +2225,29 @@ void	btCollisionWorld::serializeCollisionObjects(btSerializer* serializer)
 	///keep track of shapes already serialized
 	btHashMap<btHashPtr,btCollisionShape*>	serializedShapes;
 
+	if (serializer->isThreadSafe())
+	{
+		btAlignedObjectArray<btCollisionShape*> shapes;
+		for (i=0;i<m_collisionObjects.size();i++)
+		{
+			btCollisionShape* shape = m_collisionObjects[i]->getCollisionShape();
+			if (!serializedShapes.find(shape))
+			{
+				serializedShapes.insert(shape,shape);
+				shapes.push_back(shape);
+			}
+		}
+		if (shapes.size())
+		{
+			btParallelFor(0, shapes.size(), 1, btSerializeShapesLoop(&shapes[0], serializer));
+		}
+		if (m_collisionObjects.size())
+		{
+			btParallelFor(0, m_collisionObjects.size(), 64, btSerializeCollisionObjectsLoop(&m_collisionObjects[0], serializer));
+		}
+		return;
+	}
+
 	for (i=0;i<m_collisionObjects.size();i++)
 	{
 		btCollisionObject* colObj = m_collisionObjects[i];
@@ -1647,3 +2282,46 @@ void	btCollisionWorld::serialize(btSerializer* serializer)
 	serializer->finishSerialization();
 }
 
+void	btCollisionWorld::calculateStateHash(btStateHash& stateHash) const
+{
+	int i;
+	stateHash.addInt(m_collisionObjects.size());
+	for (i=0;i<m_collisionObjects.size();i++)
+	{
+		const btCollisionObject* colObj = m_collisionObjects[i];
+		stateHash.addTransform(colObj->getWorldTransform());
+		stateHash.addInt(colObj->getActivationState());
+	}
+
+	//the order of the manifolds depends on the order in which the pairs were found, their hashes are combined unordered.
+	//Manifolds without contacts carry no state, the broadphase keeps them for pairs with overlapping bounds.
+	const int numManifolds = m_dispatcher1->getNumManifolds();
+	int numContactManifolds = 0;
+	for (i=0;i<numManifolds;i++)
+	{
+		const btPersistentManifold* manifold = m_dispatcher1->getManifoldByIndexInternal(i);
+		if (manifold->getNumContacts() == 0)
+		{
+			continue;
+		}
+		numContactManifolds++;
+		btStateHash manifoldHash;
+		manifoldHash.addInt(manifold->getBody0()->getBroadphaseHandle() ? manifold->getBody0()->getBroadphaseHandle()->getUid() : -1);
+		manifoldHash.addInt(manifold->getBody1()->getBroadphaseHandle() ? manifold->getBody1()->getBroadphaseHandle()->getUid() : -1);
+		manifoldHash.addInt(manifold->getNumContacts());
+		for (int j=0;j<manifold->getNumContacts();j++)
+		{
+			const btManifoldPoint& pt = manifold->getContactPoint(j);
+			manifoldHash.addVector3(pt.m_localPointA);
+			manifoldHash.addVector3(pt.m_localPointB);
+			manifoldHash.addVector3(pt.m_normalWorldOnB);
+			manifoldHash.addScalar(pt.m_distance1);
+			manifoldHash.addScalar(pt.m_appliedImpulse);
+			manifoldHash.addScalar(pt.m_appliedImpulseLateral1);
+			manifoldHash.addScalar(pt.m_appliedImpulseLateral2);
+			manifoldHash.addInt(pt.m_lifeTime);
+		}
+		stateHash.addUnordered(manifoldHash);
+	}
+	stateHash.addInt(numContactManifolds);
+}
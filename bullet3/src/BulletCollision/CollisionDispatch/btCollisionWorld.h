@@ -76,6 +76,7 @@ class btCollisionShape;
 class btConvexShape;
 class btBroadphaseInterface;
 class btSerializer;
+class btStateHash;
 
 #include "../../LinearMath/btVector3.h"
 #include "../../LinearMath/btTransform.h"
@@ -83,6 +84,7 @@ class btSerializer;
 #include "btCollisionDispatcher.h"
 #include "../../BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
 #include "../../LinearMath/btAlignedObjectArray.h"
+#include "../../LinearMath/btThreads.h"
 
 ///CollisionWorld is interface and container for the collision detection
 class btCollisionWorld
@@ -105,8 +107,22 @@ protected:
 	///it is true by default, because it is error-prone (setting the position of static objects wouldn't update their AABB)
 	bool m_forceUpdateAllAabbs;
 
+	///with m_skipDormantObjects, m_awakeObjects holds the objects that are not dormant and the per-step loops only visit those
+	bool m_skipDormantObjects;
+	btAlignedObjectArray<btCollisionObject*>	m_awakeObjects;
+	///dormant objects that were activated since the last updateAwakeObjects
+	btAlignedObjectArray<btCollisionObject*>	m_wokenObjects;
+	btSpinMutex	m_wokenObjectsMutex;
+	///incremented whenever m_awakeObjects changes
+	int	m_awakeObjectsRevision;
+	///incremented whenever an object is added to or removed from m_collisionObjects
+	int	m_collisionObjectsRevision;
+
 	void	serializeCollisionObjects(btSerializer* serializer);
 
+	///adds the objects that were woken up to m_awakeObjects, and with removeInactive makes the objects that are no longer active dormant
+	void	updateAwakeObjects(bool removeInactive);
+
 public:
 
 	//this constructor doesn't own the dispatcher and paircache/broadphase
@@ -435,6 +451,28 @@ public:
 		virtual	btScalar	addSingleResult(btManifoldPoint& cp,	const btCollisionObjectWrapper* colObj0Wrap,int partId0,int index0,const btCollisionObjectWrapper* colObj1Wrap,int partId1,int index1) = 0;
 	};
 
+	///the closest hit of one sweep of convexSweepTestBatch
+	struct	ConvexSweepBatchResult
+	{
+		const btCollisionObject*	m_hitCollisionObject;	//0 if the sweep hits nothing
+		btScalar	m_hitFraction;
+		btVector3	m_hitPointWorld;
+		btVector3	m_hitNormalWorld;
+	};
+
+	///a contact point found by contactTestBatch, between the shape of query m_queryIndex and m_collisionObject
+	struct	ContactBatchResult
+	{
+		int	m_queryIndex;
+		const btCollisionObject*	m_collisionObject;
+		btVector3	m_positionWorldOnQuery;
+		btVector3	m_positionWorldOnObject;
+		btVector3	m_normalWorldOnObject;	//points from the object to the query shape
+		btScalar	m_distance;
+		int	m_partId;	//part and triangle of the object, for meshes
+		int	m_index;
+	};
+
 
 
 	int	getNumCollisionObjects() const
@@ -442,6 +480,12 @@ public:
 		return int(m_collisionObjects.size());
 	}
 
+	///changes whenever an object is added to or removed from the world, so cached per-object data can tell when it is stale
+	int	getCollisionObjectsRevision() const
+	{
+		return m_collisionObjectsRevision;
+	}
+
 	/// rayTest performs a raycast on all objects in the btCollisionWorld, and calls the resultCallback
 	/// This allows for several queries: first hit, all hits, any hit, dependent on the value returned by the callback.
 	virtual void rayTest(const btVector3& rayFromWorld, const btVector3& rayToWorld, RayResultCallback& resultCallback) const; 
@@ -458,6 +502,21 @@ public:
 	///it reports one or more contact points (including the one with deepest penetration)
 	void	contactPairTest(btCollisionObject* colObjA, btCollisionObject* colObjB, ContactResultCallback& resultCallback);
 
+	///convexSweepTestBatch performs numSweeps closest hit convexSweepTests at once: castShapes[i] is swept from from[i] to
+	///to[i] and its closest hit is written to results[i], like convexSweepTest with a ClosestConvexResultCallback does.
+	///Sweeps close to each other share a broadphase query for their combined bounds, and the sweeps run in parallel
+	///(see btParallelFor). The shapes and callbacks of the collision objects have to be safe to query from several threads.
+	void	convexSweepTestBatch(int numSweeps, const btConvexShape* const* castShapes, const btTransform* from, const btTransform* to, ConvexSweepBatchResult* results,
+				int collisionFilterGroup=btBroadphaseProxy::DefaultFilter, int collisionFilterMask=btBroadphaseProxy::AllFilter, btScalar allowedCcdPenetration=btScalar(0.)) const;
+
+	///contactTestBatch performs numQueries contactTests at once, for shapes[i] at transforms[i], which don't have to be
+	///part of the world. contacts is filled with the contact points of all queries, ordered by query. The objects tested are
+	///those whose bounds overlap the bounds of the shape enlarged by gContactBreakingThreshold, contactTest tests the
+	///objects found by the broadphase, which can add points at a small positive distance depending on its margins.
+	///Queries close to each other share a broadphase query and the queries run in parallel, like convexSweepTestBatch.
+	void	contactTestBatch(int numQueries, const btCollisionShape* const* shapes, const btTransform* transforms, btAlignedObjectArray<ContactBatchResult>& contacts,
+				int collisionFilterGroup=btBroadphaseProxy::DefaultFilter, int collisionFilterMask=btBroadphaseProxy::AllFilter);
+
 
 	/// rayTestSingle performs a raycast call and calls the resultCallback. It is used internally by rayTest.
 	/// In a future implementation, we consider moving the ray test as a virtual method in btCollisionShape.
@@ -519,9 +578,28 @@ public:
 		m_forceUpdateAllAabbs = forceUpdateAllAabbs;
 	}
 
+	///Objects that are not active (sleeping or with simulation disabled) become dormant: updateAabbs and the per-step loops of
+	///the dynamics world no longer visit them, so the cost of a step grows with the number of awake objects.
+	///Activating a dormant object (see btCollisionObject::activate) wakes it up again. While this is enabled,
+	///m_forceUpdateAllAabbs is ignored and the aabb of a dormant object that is moved without activating it isn't updated.
+	///The broadphase proxies of dormant objects aren't updated either, so btDbvtBroadphase keeps them in its fixed set.
+	void	setSkipDormantObjects(bool skipDormantObjects);
+	bool	getSkipDormantObjects() const
+	{
+		return m_skipDormantObjects;
+	}
+
+	///called by btCollisionObject when a dormant object becomes active, can be called from several threads
+	void	wakeDormantObject(const btCollisionObject* colObj);
+
 	///Preliminary serialization test for Bullet 2.76. Loading those files requires a separate parser (Bullet/Demos/SerializeDemo)
 	virtual	void	serialize(btSerializer* serializer);
 
+	///adds the transforms and activation states of the collision objects and the contact points of the manifolds,
+	///including their applied impulses, to stateHash. Worlds that were set up and stepped the same way have the same
+	///hash, lockstep simulations can compare it after each step to detect a desync (see BT_DETERMINISTIC in btScalar.h).
+	virtual	void	calculateStateHash(btStateHash& stateHash) const;
+
 };
 
 
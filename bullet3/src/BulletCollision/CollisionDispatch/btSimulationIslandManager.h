@@ -28,6 +28,11 @@ class btPersistentManifold;
 
 
 ///SimulationIslandManager creates and handles simulation islands, using btUnionFind
+///By default the islands are rebuilt from scratch every step. With setIncrementalIslands(true) the union find
+///is kept between steps and only covers the non-static objects: islands are merged as contacts and constraints
+///form, and an island is only split again (by resetting its elements and uniting them with the current contacts)
+///when it contains bodies that want to go to sleep. Static objects are only visited when objects are added to or
+///removed from the world, so in worlds with many static objects the cost scales with the moving objects.
 class btSimulationIslandManager
 {
 	btUnionFind m_unionFind;
@@ -36,6 +41,22 @@ class btSimulationIslandManager
 	btAlignedObjectArray<btCollisionObject* >  m_islandBodies;
 	
 	bool m_splitIslands;
+
+	bool m_incrementalIslands;
+	//incremental islands: element i of the union find is m_islandObjects[i], which was at m_islandObjectIndices[i] in the world
+	btAlignedObjectArray<btCollisionObject*>	m_islandObjects;
+	btAlignedObjectArray<int>	m_islandObjectIndices;
+	int	m_collisionObjectsRevision;
+	//elements of the islands, grouped by island, the elements of island j start at m_islandElementStart[j]
+	btAlignedObjectArray<int>	m_islandElements;
+	btAlignedObjectArray<int>	m_islandElementStart;
+	btAlignedObjectArray<int>	m_islandManifoldStart;
+	btAlignedObjectArray<int>	m_elementCounts;
+	btAlignedObjectArray<btPersistentManifold*>	m_sortedManifolds;
+	//elements of the islands that are split at the next update, and the elements that were split at the last update
+	btAlignedObjectArray<int>	m_splitElements;
+	btAlignedObjectArray<int>	m_resetElements;
+	btAlignedObjectArray<unsigned char>	m_elementReset;
 	
 public:
 	btSimulationIslandManager();
@@ -75,6 +96,32 @@ public:
 		m_splitIslands = doSplitIslands;
 	}
 
+	bool getIncrementalIslands() const
+	{
+		return m_incrementalIslands;
+	}
+	///keep the islands between steps, see the class comment. Not used by btSimulationIslandManagerMt, which builds its own islands.
+	///Objects that switch between static and dynamic have to be removed from the world and added again, as btDiscreteDynamicsWorld requires.
+	void setIncrementalIslands(bool incrementalIslands)
+	{
+		m_incrementalIslands = incrementalIslands;
+		m_collisionObjectsRevision = -1;
+	}
+
+	///sorts manifolds by island, then by the broadphase ids of their bodies and the parts of their first contact.
+	///The order of the dispatcher depends on the order in which the pairs were processed, which differs between
+	///multithreaded runs, BT_DETERMINISTIC builds hand the manifolds to the solver in this order.
+	static void	sortManifoldsCanonical(btAlignedObjectArray<btPersistentManifold*>& manifolds);
+
+protected:
+
+	void	gatherIslandManifolds(btDispatcher* dispatcher);
+
+	void	rebuildIncrementalIslands(btCollisionWorld* colWorld);
+	void	updateIncrementalActivationState(btCollisionWorld* colWorld);
+	void	storeIncrementalActivationState();
+	void	buildIncrementalIslands(btDispatcher* dispatcher);
+	void	processIncrementalIslands(btDispatcher* dispatcher,btCollisionWorld* collisionWorld, IslandCallback* callback);
 };
 
 #endif //BT_SIMULATION_ISLAND_MANAGER_H
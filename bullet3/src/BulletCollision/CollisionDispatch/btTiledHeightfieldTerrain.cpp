@@ -0,0 +1,432 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btTiledHeightfieldTerrain.h"
+#include "btCollisionWorld.h"
+#include "btCollisionObject.h"
+#include "BulletCollision/BroadphaseCollision/btBroadphaseInterface.h"
+#include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "LinearMath/btMappedFile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+static size_t getHeightSampleSize(PHY_ScalarType heightDataType)
+{
+	switch (heightDataType)
+	{
+	case PHY_FLOAT:
+		return sizeof(btScalar);
+	case PHY_SHORT:
+		return sizeof(short);
+	case PHY_UCHAR:
+		return sizeof(unsigned char);
+	default:
+		btAssert(!"Bad heightDataType");
+		return 1;
+	}
+}
+
+btMappedFileHeightfieldTileProvider::btMappedFileHeightfieldTileProvider(const char* fileNameFormat, PHY_ScalarType heightDataType, size_t tileDataSize, size_t headerSize)
+:m_tileDataSize(tileDataSize),
+m_headerSize(headerSize),
+m_sampleSize(getHeightSampleSize(heightDataType))
+{
+	btAssert((headerSize % m_sampleSize) == 0);
+	strncpy(m_fileNameFormat, fileNameFormat, sizeof(m_fileNameFormat) - 1);
+	m_fileNameFormat[sizeof(m_fileNameFormat) - 1] = 0;
+}
+
+btMappedFileHeightfieldTileProvider::~btMappedFileHeightfieldTileProvider()
+{
+	for (int i = 0; i < m_mappedFiles.size(); i++)
+	{
+		btMappedFile* file = *m_mappedFiles.getAtIndex(i);
+		file->~btMappedFile();
+		btAlignedFree(file);
+	}
+}
+
+const void*	btMappedFileHeightfieldTileProvider::acquireTile(int tileX, int tileJ)
+{
+	//the height samples are read in place, a header that shifts them off their natural alignment is rejected
+	if ((m_headerSize % m_sampleSize) != 0)
+		return 0;
+
+	char fileName[512];
+	snprintf(fileName, sizeof(fileName), m_fileNameFormat, tileX, tileJ);
+
+	void* mem = btAlignedAlloc(sizeof(btMappedFile), 16);
+	btMappedFile* file = new (mem) btMappedFile();
+	if (!file->open(fileName) || file->getSize() < m_headerSize + m_tileDataSize)
+	{
+		file->~btMappedFile();
+		btAlignedFree(file);
+		return 0;
+	}
+
+	const char* data = (const char*)file->getData() + m_headerSize;
+	if (((size_t)data % m_sampleSize) != 0)
+	{
+		file->~btMappedFile();
+		btAlignedFree(file);
+		return 0;
+	}
+
+	btAssert(m_mappedFiles.find(btTileKey(tileX, tileJ)) == 0);
+	m_mappedFiles.insert(btTileKey(tileX, tileJ), file);
+	return data;
+}
+
+void	btMappedFileHeightfieldTileProvider::releaseTile(int tileX, int tileJ, const void* /*data*/)
+{
+	btTileKey key(tileX, tileJ);
+	btMappedFile** file = m_mappedFiles.find(key);
+	if (file)
+	{
+		btMappedFile* f = *file;
+		m_mappedFiles.remove(key);
+		f->~btMappedFile();
+		btAlignedFree(f);
+	}
+}
+
+
+
+btTiledHeightfieldTerrain::ConstructionInfo::ConstructionInfo(int numTilesX, int numTilesJ, int tileCells, PHY_ScalarType heightDataType, btScalar heightScale)
+:m_numTilesX(numTilesX),
+m_numTilesJ(numTilesJ),
+m_tileCells(tileCells),
+m_heightScale(heightScale),
+m_heightDataType(heightDataType),
+m_upAxis(1),
+m_flipQuadEdges(false),
+m_useDiamondSubdivision(false),
+m_localScaling(btScalar(1.), btScalar(1.), btScalar(1.)),
+m_acceleratorChunkSize(16),
+m_friction(btScalar(0.5)),
+m_restitution(btScalar(0.)),
+m_collisionFilterGroup(btBroadphaseProxy::StaticFilter),
+m_collisionFilterMask(btBroadphaseProxy::AllFilter ^ btBroadphaseProxy::StaticFilter)
+{
+	m_terrainTransform.setIdentity();
+}
+
+
+
+btTiledHeightfieldTerrain::btTiledHeightfieldTerrain(btCollisionWorld* world, btHeightfieldTileProvider* provider, const ConstructionInfo& info)
+:m_world(world),
+m_provider(provider),
+m_info(info)
+{
+	btAssert(info.m_numTilesX > 0 && info.m_numTilesJ > 0);
+	btAssert(info.m_tileCells > 0);
+	btAssert(info.m_upAxis >= 0 && info.m_upAxis < 3);
+
+	Tile empty;
+	empty.m_object = 0;
+	empty.m_shape = 0;
+	empty.m_data = 0;
+	empty.m_residentIndex = -1;
+	m_tiles.resize(info.m_numTilesX * info.m_numTilesJ, empty);
+}
+
+btTiledHeightfieldTerrain::~btTiledHeightfieldTerrain()
+{
+	while (m_residentTiles.size())
+	{
+		int index = m_residentTiles[m_residentTiles.size() - 1];
+		evictTile(index % m_info.m_numTilesX, index / m_info.m_numTilesX);
+	}
+}
+
+
+
+void	btTiledHeightfieldTerrain::getHeightRange(const void* data, btScalar& minHeight, btScalar& maxHeight) const
+{
+	int count = (m_info.m_tileCells + 1) * (m_info.m_tileCells + 1);
+	switch (m_info.m_heightDataType)
+	{
+	case PHY_FLOAT:
+		{
+			const btScalar* heights = (const btScalar*)data;
+			minHeight = maxHeight = heights[0];
+			for (int i = 1; i < count; i++)
+			{
+				minHeight = btMin(minHeight, heights[i]);
+				maxHeight = btMax(maxHeight, heights[i]);
+			}
+			break;
+		}
+	case PHY_SHORT:
+		{
+			const short* heights = (const short*)data;
+			short lo = heights[0], hi = heights[0];
+			for (int i = 1; i < count; i++)
+			{
+				lo = btMin(lo, heights[i]);
+				hi = btMax(hi, heights[i]);
+			}
+			minHeight = lo * m_info.m_heightScale;
+			maxHeight = hi * m_info.m_heightScale;
+			break;
+		}
+	case PHY_UCHAR:
+		{
+			const unsigned char* heights = (const unsigned char*)data;
+			unsigned char lo = heights[0], hi = heights[0];
+			for (int i = 1; i < count; i++)
+			{
+				lo = btMin(lo, heights[i]);
+				hi = btMax(hi, heights[i]);
+			}
+			minHeight = lo * m_info.m_heightScale;
+			maxHeight = hi * m_info.m_heightScale;
+			break;
+		}
+	default:
+		{
+			btAssert(!"Bad m_heightDataType");
+			minHeight = maxHeight = btScalar(0.);
+		}
+	}
+	//a negative scale swaps the extremes
+	if (minHeight > maxHeight)
+		btSwap(minHeight, maxHeight);
+}
+
+btHeightfieldTerrainShape*	btTiledHeightfieldTerrain::createTileShape(const void* data, btScalar minHeight, btScalar maxHeight) const
+{
+	int sticks = m_info.m_tileCells + 1;
+	btHeightfieldTerrainShape* shape = new btHeightfieldTerrainShape(sticks, sticks, data, m_info.m_heightScale,
+		minHeight, maxHeight, m_info.m_upAxis, m_info.m_heightDataType, m_info.m_flipQuadEdges);
+	shape->setUseDiamondSubdivision(m_info.m_useDiamondSubdivision);
+	shape->setUseRowDecoding();
+	shape->setLocalScaling(m_info.m_localScaling);
+	if (m_info.m_acceleratorChunkSize > 0)
+		shape->buildAccelerator(m_info.m_acceleratorChunkSize);
+	return shape;
+}
+
+btTransform	btTiledHeightfieldTerrain::getTileTransform(int tileX, int tileJ, btScalar minHeight, btScalar maxHeight) const
+{
+	//btHeightfieldTerrainShape is centered on its aabb, so the tile object sits at the center of the tile
+	btScalar halfCells = btScalar(0.5) * m_info.m_tileCells;
+	btVector3 center;
+	center[getIndexX()] = (tileX * m_info.m_tileCells + halfCells) * m_info.m_localScaling[getIndexX()];
+	center[getIndexJ()] = (tileJ * m_info.m_tileCells + halfCells) * m_info.m_localScaling[getIndexJ()];
+	center[m_info.m_upAxis] = btScalar(0.5) * (minHeight + maxHeight) * m_info.m_localScaling[m_info.m_upAxis];
+
+	btTransform local;
+	local.setIdentity();
+	local.setOrigin(center);
+	return m_info.m_terrainTransform * local;
+}
+
+///activates the non-static objects overlapping a tile, so they don't keep sleeping on terrain that changed or vanished
+struct btTileWakeupCallback : public btBroadphaseAabbCallback
+{
+	virtual bool	process(const btBroadphaseProxy* proxy)
+	{
+		btCollisionObject* colObj = (btCollisionObject*)proxy->m_clientObject;
+		if (colObj && !colObj->isStaticOrKinematicObject())
+			colObj->activate();
+		return true;
+	}
+};
+
+void	btTiledHeightfieldTerrain::wakeObjectsOnTile(const Tile& tile)
+{
+	btBroadphaseProxy* proxy = tile.m_object->getBroadphaseHandle();
+	if (!proxy)
+		return;
+	btTileWakeupCallback callback;
+	m_world->getBroadphase()->aabbTest(proxy->m_aabbMin, proxy->m_aabbMax, callback);
+}
+
+
+
+bool	btTiledHeightfieldTerrain::loadTile(int tileX, int tileJ)
+{
+	btAssert(tileX >= 0 && tileX < m_info.m_numTilesX && tileJ >= 0 && tileJ < m_info.m_numTilesJ);
+	int index = tileJ * m_info.m_numTilesX + tileX;
+	Tile& tile = m_tiles[index];
+	if (tile.m_object)
+		return true;
+
+	const void* data = m_provider->acquireTile(tileX, tileJ);
+	if (!data)
+		return false;
+
+	//each tile gets the exact height range of its data, for a tight broadphase aabb
+	btScalar minHeight, maxHeight;
+	getHeightRange(data, minHeight, maxHeight);
+
+	tile.m_data = data;
+	tile.m_shape = createTileShape(data, minHeight, maxHeight);
+	tile.m_object = new btCollisionObject();
+	tile.m_object->setCollisionShape(tile.m_shape);
+	tile.m_object->setCollisionFlags(tile.m_object->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
+	tile.m_object->setWorldTransform(getTileTransform(tileX, tileJ, minHeight, maxHeight));
+	tile.m_object->setFriction(m_info.m_friction);
+	tile.m_object->setRestitution(m_info.m_restitution);
+	m_world->addCollisionObject(tile.m_object, m_info.m_collisionFilterGroup, m_info.m_collisionFilterMask);
+
+	tile.m_residentIndex = m_residentTiles.size();
+	m_residentTiles.push_back(index);
+	return true;
+}
+
+void	btTiledHeightfieldTerrain::removeTile(int index)
+{
+	Tile& tile = m_tiles[index];
+
+	wakeObjectsOnTile(tile);
+	//removing the object only cleans the overlapping pairs of this tile
+	m_world->removeCollisionObject(tile.m_object);
+	delete tile.m_object;
+	delete tile.m_shape;
+
+	//swap-remove from the resident list
+	int last = m_residentTiles[m_residentTiles.size() - 1];
+	m_residentTiles[tile.m_residentIndex] = last;
+	m_tiles[last].m_residentIndex = tile.m_residentIndex;
+	m_residentTiles.pop_back();
+
+	tile.m_object = 0;
+	tile.m_shape = 0;
+	tile.m_data = 0;
+	tile.m_residentIndex = -1;
+}
+
+void	btTiledHeightfieldTerrain::evictTile(int tileX, int tileJ)
+{
+	btAssert(tileX >= 0 && tileX < m_info.m_numTilesX && tileJ >= 0 && tileJ < m_info.m_numTilesJ);
+	int index = tileJ * m_info.m_numTilesX + tileX;
+	if (!m_tiles[index].m_object)
+		return;
+
+	const void* data = m_tiles[index].m_data;
+	removeTile(index);
+	m_provider->releaseTile(tileX, tileJ, data);
+}
+
+bool	btTiledHeightfieldTerrain::reloadTile(int tileX, int tileJ)
+{
+	btAssert(tileX >= 0 && tileX < m_info.m_numTilesX && tileJ >= 0 && tileJ < m_info.m_numTilesJ);
+	int index = tileJ * m_info.m_numTilesX + tileX;
+	Tile& tile = m_tiles[index];
+	if (!tile.m_object)
+		return loadTile(tileX, tileJ);
+
+	m_provider->releaseTile(tileX, tileJ, tile.m_data);
+	tile.m_data = m_provider->acquireTile(tileX, tileJ);
+	if (!tile.m_data)
+	{
+		removeTile(index);
+		return false;
+	}
+
+	btScalar minHeight, maxHeight;
+	getHeightRange(tile.m_data, minHeight, maxHeight);
+
+	//swap the shape in place: the collision object keeps its broadphase proxy,
+	//and only the contacts of this tile are discarded
+	wakeObjectsOnTile(tile);
+	btHeightfieldTerrainShape* oldShape = tile.m_shape;
+	tile.m_shape = createTileShape(tile.m_data, minHeight, maxHeight);
+	btBroadphaseProxy* proxy = tile.m_object->getBroadphaseHandle();
+	if (proxy)
+		m_world->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(proxy, m_world->getDispatcher());
+	tile.m_object->setCollisionShape(tile.m_shape);
+	tile.m_object->setWorldTransform(getTileTransform(tileX, tileJ, minHeight, maxHeight));
+	m_world->updateSingleAabb(tile.m_object);
+	//the new aabb may cover objects the old one did not
+	wakeObjectsOnTile(tile);
+	delete oldShape;
+	return true;
+}
+
+
+
+static inline int getFloor(btScalar x)
+{
+	int i = (int)x;
+	return (x < i) ? i - 1 : i;
+}
+
+void	btTiledHeightfieldTerrain::getTileAt(const btVector3& worldPosition, int& tileX, int& tileJ) const
+{
+	btVector3 local = m_info.m_terrainTransform.invXform(worldPosition);
+	tileX = getFloor(local[getIndexX()] / (m_info.m_localScaling[getIndexX()] * m_info.m_tileCells));
+	tileJ = getFloor(local[getIndexJ()] / (m_info.m_localScaling[getIndexJ()] * m_info.m_tileCells));
+}
+
+void	btTiledHeightfieldTerrain::updateResidentTiles(const btVector3* focusPoints, int numFocusPoints, btScalar loadRadius, btScalar evictRadius)
+{
+	//work in grid units, where tile (x,j) covers [x,x+1] x [j,j+1]
+	btScalar tileSizeX = btFabs(m_info.m_localScaling[getIndexX()]) * m_info.m_tileCells;
+	btScalar tileSizeJ = btFabs(m_info.m_localScaling[getIndexJ()]) * m_info.m_tileCells;
+
+	btAlignedObjectArray<btVector3> gridPoints;
+	gridPoints.resize(numFocusPoints);
+	for (int p = 0; p < numFocusPoints; p++)
+	{
+		btVector3 local = m_info.m_terrainTransform.invXform(focusPoints[p]);
+		gridPoints[p].setValue(
+			local[getIndexX()] / (m_info.m_localScaling[getIndexX()] * m_info.m_tileCells),
+			local[getIndexJ()] / (m_info.m_localScaling[getIndexJ()] * m_info.m_tileCells),
+			0);
+	}
+
+	//evict first, so the resident set never grows beyond what the loads need
+	for (int r = m_residentTiles.size() - 1; r >= 0; r--)
+	{
+		int index = m_residentTiles[r];
+		int tileX = index % m_info.m_numTilesX;
+		int tileJ = index / m_info.m_numTilesX;
+		bool keep = false;
+		for (int p = 0; p < numFocusPoints && !keep; p++)
+		{
+			btScalar dx = btMax(btScalar(0.), btMax(tileX - gridPoints[p][0], gridPoints[p][0] - (tileX + 1))) * tileSizeX;
+			btScalar dj = btMax(btScalar(0.), btMax(tileJ - gridPoints[p][1], gridPoints[p][1] - (tileJ + 1))) * tileSizeJ;
+			keep = (dx * dx + dj * dj) <= evictRadius * evictRadius;
+		}
+		if (!keep)
+			evictTile(tileX, tileJ);
+	}
+
+	for (int p = 0; p < numFocusPoints; p++)
+	{
+		const btVector3& pt = gridPoints[p];
+		int minX = btMax(0, getFloor(pt[0] - loadRadius / tileSizeX));
+		int maxX = btMin(m_info.m_numTilesX - 1, getFloor(pt[0] + loadRadius / tileSizeX));
+		int minJ = btMax(0, getFloor(pt[1] - loadRadius / tileSizeJ));
+		int maxJ = btMin(m_info.m_numTilesJ - 1, getFloor(pt[1] + loadRadius / tileSizeJ));
+		for (int tileJ = minJ; tileJ <= maxJ; tileJ++)
+		{
+			for (int tileX = minX; tileX <= maxX; tileX++)
+			{
+				if (isTileResident(tileX, tileJ))
+					continue;
+				btScalar dx = btMax(btScalar(0.), btMax(tileX - pt[0], pt[0] - (tileX + 1))) * tileSizeX;
+				btScalar dj = btMax(btScalar(0.), btMax(tileJ - pt[1], pt[1] - (tileJ + 1))) * tileSizeJ;
+				if ((dx * dx + dj * dj) <= loadRadius * loadRadius)
+					loadTile(tileX, tileJ);
+			}
+		}
+	}
+}
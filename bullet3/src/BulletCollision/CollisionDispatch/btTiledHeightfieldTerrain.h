@@ -0,0 +1,200 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_TILED_HEIGHTFIELD_TERRAIN_H
+#define BT_TILED_HEIGHTFIELD_TERRAIN_H
+
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btTransform.h"
+
+class btCollisionWorld;
+class btCollisionObject;
+class btMappedFile;
+
+///btHeightfieldTileProvider supplies the height data of the tiles of a btTiledHeightfieldTerrain.
+///A tile of N x N cells has (N+1) x (N+1) heights in row-major order: the last row and column
+///duplicate the first row and column of the neighbouring tiles, so tiles can be loaded independently.
+class btHeightfieldTileProvider
+{
+public:
+
+	virtual ~btHeightfieldTileProvider() {}
+
+	///returns the heights of the tile, or 0 if the tile is not available.
+	///The data must stay valid until releaseTile is called for it.
+	virtual const void*	acquireTile(int tileX, int tileJ) = 0;
+
+	virtual void	releaseTile(int tileX, int tileJ, const void* data) = 0;
+};
+
+///btMappedFileHeightfieldTileProvider memory-maps one file per tile.
+///The file name is built from a printf format with two %d, for tileX and tileJ, for example "terrain/tile_%d_%d.raw".
+///Each file holds an optional header of headerSize bytes followed by the raw height data.
+///headerSize must be a multiple of the size of one height sample, tiles with misaligned samples are not loaded.
+class btMappedFileHeightfieldTileProvider : public btHeightfieldTileProvider
+{
+	///hash key made of both tile indices, so distinct tiles never share an entry
+	class btTileKey
+	{
+		int	m_tileX;
+		int	m_tileJ;
+	public:
+
+		btTileKey(int tileX, int tileJ)
+			:m_tileX(tileX),
+			m_tileJ(tileJ)
+		{
+		}
+
+		bool equals(const btTileKey& other) const
+		{
+			return m_tileX == other.m_tileX && m_tileJ == other.m_tileJ;
+		}
+
+		SIMD_FORCE_INLINE	unsigned int getHash()const
+		{
+			unsigned int key = (unsigned int)m_tileX * 73856093u ^ (unsigned int)m_tileJ * 19349663u;
+			// Thomas Wang's hash
+			key += ~(key << 15);	key ^=  (key >> 10);	key +=  (key << 3);	key ^=  (key >> 6);	key += ~(key << 11);	key ^=  (key >> 16);
+			return key;
+		}
+	};
+
+	char	m_fileNameFormat[256];
+	size_t	m_tileDataSize;
+	size_t	m_headerSize;
+	size_t	m_sampleSize;
+	btHashMap<btTileKey, btMappedFile*>	m_mappedFiles;
+
+public:
+
+	btMappedFileHeightfieldTileProvider(const char* fileNameFormat, PHY_ScalarType heightDataType, size_t tileDataSize, size_t headerSize = 0);
+
+	virtual ~btMappedFileHeightfieldTileProvider();
+
+	virtual const void*	acquireTile(int tileX, int tileJ);
+
+	virtual void	releaseTile(int tileX, int tileJ, const void* data);
+};
+
+///btTiledHeightfieldTerrain streams a large heightfield terrain as a grid of tiles.
+///Each resident tile is a separate static collision object with its own btHeightfieldTerrainShape,
+///so the broadphase only sees the tiles that are loaded, each with a tight bounding box.
+///Loading, evicting or reloading a tile only touches the contacts of that tile: contacts with
+///other tiles stay valid, and objects resting on a tile that goes away are woken up.
+class btTiledHeightfieldTerrain
+{
+public:
+
+	struct ConstructionInfo
+	{
+		int				m_numTilesX;
+		int				m_numTilesJ;
+		///number of cells along each side of a tile
+		int				m_tileCells;
+		btScalar		m_heightScale;
+		PHY_ScalarType	m_heightDataType;
+		int				m_upAxis;
+		bool			m_flipQuadEdges;
+		bool			m_useDiamondSubdivision;
+		btVector3		m_localScaling;
+		///world transform of the terrain, the grid corner of tile (0,0) at height zero is its origin
+		btTransform		m_terrainTransform;
+		///chunk size of the height pyramid built for each tile, 0 disables it (see btHeightfieldTerrainShape::buildAccelerator)
+		int				m_acceleratorChunkSize;
+		btScalar		m_friction;
+		btScalar		m_restitution;
+		int				m_collisionFilterGroup;
+		int				m_collisionFilterMask;
+
+		ConstructionInfo(int numTilesX, int numTilesJ, int tileCells, PHY_ScalarType heightDataType, btScalar heightScale = btScalar(1.));
+	};
+
+protected:
+
+	struct Tile
+	{
+		btCollisionObject*			m_object;
+		btHeightfieldTerrainShape*	m_shape;
+		const void*					m_data;
+		int							m_residentIndex;
+	};
+
+	btCollisionWorld*			m_world;
+	btHeightfieldTileProvider*	m_provider;
+	ConstructionInfo			m_info;
+	btAlignedObjectArray<Tile>	m_tiles;
+	///indices of the resident tiles, so per-update work scales with the resident set
+	btAlignedObjectArray<int>	m_residentTiles;
+
+	int	getIndexX() const { return (m_info.m_upAxis == 0) ? 1 : 0; }
+	int	getIndexJ() const { return (m_info.m_upAxis == 2) ? 1 : 2; }
+
+	btHeightfieldTerrainShape*	createTileShape(const void* data, btScalar minHeight, btScalar maxHeight) const;
+	btTransform	getTileTransform(int tileX, int tileJ, btScalar minHeight, btScalar maxHeight) const;
+	void	getHeightRange(const void* data, btScalar& minHeight, btScalar& maxHeight) const;
+	void	wakeObjectsOnTile(const Tile& tile);
+	///removes a resident tile from the world without releasing its data
+	void	removeTile(int index);
+
+public:
+
+	btTiledHeightfieldTerrain(btCollisionWorld* world, btHeightfieldTileProvider* provider, const ConstructionInfo& info);
+
+	///evicts all resident tiles
+	virtual ~btTiledHeightfieldTerrain();
+
+	///acquires the tile data from the provider and adds the tile to the world, returns false if the provider has no data for it
+	bool	loadTile(int tileX, int tileJ);
+
+	///removes the tile from the world and releases its data
+	void	evictTile(int tileX, int tileJ);
+
+	///replaces the data of a resident tile (or loads it), for example after the heights were edited.
+	///The previous data is released before the new data is acquired.
+	bool	reloadTile(int tileX, int tileJ);
+
+	///loads the tiles within loadRadius of any of the focus points and evicts the resident tiles farther than evictRadius from all of them.
+	///Distances are measured in the horizontal plane of the terrain, evictRadius should be larger than loadRadius to avoid thrashing.
+	void	updateResidentTiles(const btVector3* focusPoints, int numFocusPoints, btScalar loadRadius, btScalar evictRadius);
+
+	bool	isTileResident(int tileX, int tileJ) const
+	{
+		return getTileObject(tileX, tileJ) != 0;
+	}
+
+	const btCollisionObject*	getTileObject(int tileX, int tileJ) const
+	{
+		btAssert(tileX >= 0 && tileX < m_info.m_numTilesX && tileJ >= 0 && tileJ < m_info.m_numTilesJ);
+		return m_tiles[tileJ * m_info.m_numTilesX + tileX].m_object;
+	}
+
+	int	getNumResidentTiles() const
+	{
+		return m_residentTiles.size();
+	}
+
+	const ConstructionInfo&	getConstructionInfo() const
+	{
+		return m_info;
+	}
+
+	///returns the tile containing the world position, the indices are not clamped to the terrain
+	void	getTileAt(const btVector3& worldPosition, int& tileX, int& tileJ) const;
+};
+
+#endif //BT_TILED_HEIGHTFIELD_TERRAIN_H
@@ -95,6 +95,13 @@ class btUnionFind
 				m_elements[j].m_id = i; m_elements[i].m_sz += m_elements[j].m_sz; 
 			}
 #else
+#ifdef BT_DETERMINISTIC
+			//the smallest index is the root, the island ids don't depend on the order in which the pairs are united
+			if (i < j)
+			{
+				btSwap(i, j);
+			}
+#endif //BT_DETERMINISTIC
 			m_elements[i].m_id = j; m_elements[j].m_sz += m_elements[i].m_sz; 
 #endif //USE_PATH_COMPRESSION
 		}
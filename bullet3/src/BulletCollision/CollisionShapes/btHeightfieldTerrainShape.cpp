@@ -81,8 +81,10 @@ PHY_ScalarType hdt, bool flipQuadEdges
 	m_flipQuadEdges = flipQuadEdges;
 	m_useDiamondSubdivision = false;
 	m_useZigzagSubdivision = false;
+	m_useRowDecoding = false;
 	m_upAxis = upAxis;
 	m_localScaling.setValue(btScalar(1.), btScalar(1.), btScalar(1.));
+	m_vboundsChunkSize = 0;
 
 	// determine min/max axis-aligned bounding box (aabb) values
 	switch (m_upAxis)
@@ -182,6 +184,102 @@ btHeightfieldTerrainShape::getRawHeightFieldValue(int x,int y) const
 
 
 
+/// Same as getRawHeightFieldValue for a span of a row. With row decoding enabled the
+/// switch on the data type is hoisted out of the loop so the conversion can be vectorized.
+void
+btHeightfieldTerrainShape::getRawHeightFieldRow(int y,int startX,int count,btScalar* out) const
+{
+	btAssert(y>=0 && y<m_heightStickLength);
+	btAssert(startX>=0 && startX+count<=m_heightStickWidth);
+
+	int i = 0;
+	if (!m_useRowDecoding)
+	{
+		for (; i < count; i++)
+			out[i] = getRawHeightFieldValue(startX + i, y);
+		return;
+	}
+
+	const int offset = (y*m_heightStickWidth)+startX;
+	switch (m_heightDataType)
+	{
+	case PHY_FLOAT:
+		{
+			const btScalar* src = m_heightfieldDataFloat + offset;
+			for (; i < count; i++)
+				out[i] = src[i];
+			break;
+		}
+
+	case PHY_UCHAR:
+		{
+			const unsigned char* src = m_heightfieldDataUnsignedChar + offset;
+#if defined(BT_USE_SSE) && !defined(BT_USE_DOUBLE_PRECISION)
+			const __m128 scale = _mm_set1_ps(m_heightScale);
+			const __m128i zero = _mm_setzero_si128();
+			for (; i + 8 <= count; i += 8)
+			{
+				__m128i v16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + i)), zero);
+				__m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v16, zero));
+				__m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v16, zero));
+				_mm_storeu_ps(out + i, _mm_mul_ps(lo, scale));
+				_mm_storeu_ps(out + i + 4, _mm_mul_ps(hi, scale));
+			}
+#elif defined(BT_USE_NEON) && !defined(BT_USE_DOUBLE_PRECISION)
+			for (; i + 8 <= count; i += 8)
+			{
+				uint16x8_t v16 = vmovl_u8(vld1_u8(src + i));
+				float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v16)));
+				float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v16)));
+				vst1q_f32(out + i, vmulq_n_f32(lo, m_heightScale));
+				vst1q_f32(out + i + 4, vmulq_n_f32(hi, m_heightScale));
+			}
+#endif
+			for (; i < count; i++)
+				out[i] = src[i] * m_heightScale;
+			break;
+		}
+
+	case PHY_SHORT:
+		{
+			const short* src = m_heightfieldDataShort + offset;
+#if defined(BT_USE_SSE) && !defined(BT_USE_DOUBLE_PRECISION)
+			const __m128 scale = _mm_set1_ps(m_heightScale);
+			for (; i + 8 <= count; i += 8)
+			{
+				__m128i v16 = _mm_loadu_si128((const __m128i*)(src + i));
+				//sign extend by moving each short into the upper half of a 32-bit lane
+				__m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v16, v16), 16));
+				__m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v16, v16), 16));
+				_mm_storeu_ps(out + i, _mm_mul_ps(lo, scale));
+				_mm_storeu_ps(out + i + 4, _mm_mul_ps(hi, scale));
+			}
+#elif defined(BT_USE_NEON) && !defined(BT_USE_DOUBLE_PRECISION)
+			for (; i + 8 <= count; i += 8)
+			{
+				int16x8_t v16 = vld1q_s16(src + i);
+				float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v16)));
+				float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v16)));
+				vst1q_f32(out + i, vmulq_n_f32(lo, m_heightScale));
+				vst1q_f32(out + i + 4, vmulq_n_f32(hi, m_heightScale));
+			}
+#endif
+			for (; i < count; i++)
+				out[i] = src[i] * m_heightScale;
+			break;
+		}
+
+	default:
+		{
+			btAssert(!"Bad m_heightDataType");
+			for (; i < count; i++)
+				out[i] = getRawHeightFieldValue(startX + i, y);
+		}
+	}
+}
+
+
+
 
 /// this returns the vertex in bullet-local coordinates
 void	btHeightfieldTerrainShape::getVertex(int x,int y,btVector3& vertex) const
@@ -191,8 +289,14 @@ void	btHeightfieldTerrainShape::getVertex(int x,int y,btVector3& vertex) const
 	btAssert(x<m_heightStickWidth);
 	btAssert(y<m_heightStickLength);
 
-	btScalar	height = getRawHeightFieldValue(x,y);
+	getVertexFromHeight(x,y,getRawHeightFieldValue(x,y),vertex);
+}
+
+
 
+/// same as getVertex, for a raw height that was already fetched
+void	btHeightfieldTerrainShape::getVertexFromHeight(int x,int y,btScalar height,btVector3& vertex) const
+{
 	switch (m_upAxis)
 	{
 	case 0:
@@ -248,6 +352,18 @@ btScalar x
 
 
 
+static inline int
+getFloor
+(
+btScalar x
+)
+{
+	int i = (int) x;
+	return (x < i) ? i - 1 : i;
+}
+
+
+
 /// given input vector, return quantized version
 /**
   This routine is basically determining the gridpoint indices for a given
@@ -354,42 +470,325 @@ void	btHeightfieldTerrainShape::processAllTriangles(btTriangleCallback* callback
 	
   
 
-	for(int j=startJ; j<endJ; j++)
+	if (startX >= endX || startJ >= endJ)
+		return;
+
+	if (m_vboundsPyramid.size())
+	{
+		// only visit the blocks whose height range overlaps the query
+		btScalar minHeight = btMin(localAabbMin[m_upAxis], localAabbMax[m_upAxis]);
+		btScalar maxHeight = btMax(localAabbMin[m_upAxis], localAabbMax[m_upAxis]);
+		int topLevel = m_vboundsLevelOffset.size() - 1;
+		processBlock(callback, topLevel, 0, 0, startX, endX, startJ, endJ, minHeight, maxHeight);
+	}
+	else
+	{
+		processCells(callback, startX, endX, startJ, endJ);
+	}
+}
+
+
+
+void	btHeightfieldTerrainShape::processCell(btTriangleCallback* callback,int x,int j,const btScalar* heights) const
+{
+	btVector3 vertices[3];
+	if (m_flipQuadEdges || (m_useDiamondSubdivision && !((j+x) & 1))|| (m_useZigzagSubdivision  && !(j & 1)))
+	{
+		//first triangle
+		getVertexFromHeight(x, j, heights[0], vertices[0]);
+		getVertexFromHeight(x, j + 1, heights[2], vertices[1]);
+		getVertexFromHeight(x + 1, j + 1, heights[3], vertices[2]);
+		callback->processTriangle(vertices, x, j);
+		//second triangle
+		getVertexFromHeight(x + 1, j + 1, heights[3], vertices[1]);
+		getVertexFromHeight(x + 1, j, heights[1], vertices[2]);
+		callback->processTriangle(vertices, x, j);
+	} else
 	{
-		for(int x=startX; x<endX; x++)
+		//first triangle
+		getVertexFromHeight(x, j, heights[0], vertices[0]);
+		getVertexFromHeight(x, j + 1, heights[2], vertices[1]);
+		getVertexFromHeight(x + 1, j, heights[1], vertices[2]);
+		callback->processTriangle(vertices, x, j);
+		//second triangle
+		getVertexFromHeight(x + 1, j, heights[1], vertices[0]);
+		getVertexFromHeight(x + 1, j + 1, heights[3], vertices[2]);
+		callback->processTriangle(vertices, x, j);
+	}
+}
+
+
+
+void	btHeightfieldTerrainShape::processCells(btTriangleCallback* callback,int startX,int endX,int startJ,int endJ) const
+{
+	// rows are decoded in spans of at most maxSpan cells, so the buffers fit on the stack
+	const int maxSpan = 64;
+	btScalar rowBuffers[2][maxSpan + 1];
+
+	for (int spanX = startX; spanX < endX; spanX += maxSpan)
+	{
+		int spanEndX = btMin(spanX + maxSpan, endX);
+		int count = spanEndX - spanX + 1;
+		btScalar* row0 = rowBuffers[0];
+		btScalar* row1 = rowBuffers[1];
+		getRawHeightFieldRow(startJ, spanX, count, row0);
+
+		for (int j = startJ; j < endJ; j++)
 		{
-			btVector3 vertices[3];
-			if (m_flipQuadEdges || (m_useDiamondSubdivision && !((j+x) & 1))|| (m_useZigzagSubdivision  && !(j & 1)))
+			getRawHeightFieldRow(j + 1, spanX, count, row1);
+			for (int x = spanX; x < spanEndX; x++)
 			{
-        //first triangle
-        getVertex(x,j,vertices[0]);
-		getVertex(x, j + 1, vertices[1]);
-		getVertex(x + 1, j + 1, vertices[2]);
-        callback->processTriangle(vertices,x,j);
-        //second triangle
-      //  getVertex(x,j,vertices[0]);//already got this vertex before, thanks to Danny Chapman
-        getVertex(x+1,j+1,vertices[1]);
-		getVertex(x + 1, j, vertices[2]);
-		callback->processTriangle(vertices, x, j);
+				int i = x - spanX;
+				btScalar heights[4] = { row0[i], row0[i + 1], row1[i], row1[i + 1] };
+				processCell(callback, x, j, heights);
+			}
+			btSwap(row0, row1);
+		}
+	}
+}
+
+
+
+void	btHeightfieldTerrainShape::processBlock(btTriangleCallback* callback,int level,int blockX,int blockJ,int startX,int endX,int startJ,int endJ,btScalar minHeight,btScalar maxHeight) const
+{
+	if (!getBlockRange(level, blockX, blockJ).overlaps(minHeight, maxHeight))
+		return;
+
+	if (level == 0)
+	{
+		int x0 = btMax(startX, blockX * m_vboundsChunkSize);
+		int x1 = btMin(endX, (blockX + 1) * m_vboundsChunkSize);
+		int j0 = btMax(startJ, blockJ * m_vboundsChunkSize);
+		int j1 = btMin(endJ, (blockJ + 1) * m_vboundsChunkSize);
+		if (x0 < x1 && j0 < j1)
+			processCells(callback, x0, x1, j0, j1);
+		return;
+	}
+
+	// recurse into the children that intersect the query range
+	int childLevel = level - 1;
+	int childCells = m_vboundsChunkSize << childLevel;
+	for (int cj = 2 * blockJ; cj < btMin(2 * blockJ + 2, m_vboundsLevelLength[childLevel]); cj++)
+	{
+		if (cj * childCells >= endJ || (cj + 1) * childCells <= startJ)
+			continue;
+		for (int cx = 2 * blockX; cx < btMin(2 * blockX + 2, m_vboundsLevelWidth[childLevel]); cx++)
+		{
+			if (cx * childCells >= endX || (cx + 1) * childCells <= startX)
+				continue;
+			processBlock(callback, childLevel, cx, cj, startX, endX, startJ, endJ, minHeight, maxHeight);
+		}
+	}
+}
+
+
+
+/// walk the grid cells crossed by the ray (a 2D DDA over the horizontal axes)
+/**
+  Only the cells whose height range overlaps the height range of the ray
+  segment inside the cell are reported, so a ray that stays above the
+  terrain produces no triangles at all.
+ */
+void	btHeightfieldTerrainShape::performRaycast(btTriangleCallback* callback,const btVector3& raySource,const btVector3& rayTarget) const
+{
+	// transform the ray into grid coordinates: cell (x,j) spans [x,x+1] x [j,j+1]
+	// on the horizontal axes, and the up axis holds raw heights
+	btVector3 invScaling(btScalar(1.)/m_localScaling[0],btScalar(1.)/m_localScaling[1],btScalar(1.)/m_localScaling[2]);
+	btVector3 begin = raySource*invScaling + m_localOrigin;
+	btVector3 end = rayTarget*invScaling + m_localOrigin;
+	btVector3 dir = end - begin;
+
+	// heights are compared with a little slack, so rounding can't make the ray
+	// miss a cell it touches (flat terrain has an aabb without thickness)
+	btScalar slack = btScalar(16.) * SIMD_EPSILON * (btFabs(m_minHeight) + btFabs(m_maxHeight) + btScalar(1.));
+	btVector3 clipMin = m_localAabbMin;
+	btVector3 clipMax = m_localAabbMax;
+	clipMin[m_upAxis] -= slack;
+	clipMax[m_upAxis] += slack;
+
+	// clip the ray against the local aabb
+	btScalar tEnter = btScalar(0.);
+	btScalar tExit = btScalar(1.);
+	for (int i = 0; i < 3; i++)
+	{
+		if (btFabs(dir[i]) < SIMD_EPSILON)
+		{
+			if (begin[i] < clipMin[i] || begin[i] > clipMax[i])
+				return;
+			continue;
+		}
+		btScalar t0 = (clipMin[i] - begin[i]) / dir[i];
+		btScalar t1 = (clipMax[i] - begin[i]) / dir[i];
+		if (t0 > t1)
+			btSwap(t0, t1);
+		tEnter = btMax(tEnter, t0);
+		tExit = btMin(tExit, t1);
+		if (tEnter > tExit)
+			return;
+	}
+
+	int indexX = (m_upAxis == 0) ? 1 : 0;
+	int indexJ = (m_upAxis == 2) ? 1 : 2;
+	int cellsX = m_heightStickWidth - 1;
+	int cellsJ = m_heightStickLength - 1;
+
+	btVector3 entry = begin + dir * tEnter;
+	int x = btMax(0, btMin(cellsX - 1, getFloor(entry[indexX])));
+	int j = btMax(0, btMin(cellsJ - 1, getFloor(entry[indexJ])));
+
+	int stepX = dir[indexX] > 0 ? 1 : -1;
+	int stepJ = dir[indexJ] > 0 ? 1 : -1;
+	btScalar tDeltaX = BT_LARGE_FLOAT;
+	btScalar tDeltaJ = BT_LARGE_FLOAT;
+	btScalar tMaxX = BT_LARGE_FLOAT;
+	btScalar tMaxJ = BT_LARGE_FLOAT;
+	if (btFabs(dir[indexX]) >= SIMD_EPSILON)
+	{
+		tDeltaX = btFabs(btScalar(1.) / dir[indexX]);
+		tMaxX = (btScalar(stepX > 0 ? x + 1 : x) - begin[indexX]) / dir[indexX];
+	}
+	if (btFabs(dir[indexJ]) >= SIMD_EPSILON)
+	{
+		tDeltaJ = btFabs(btScalar(1.) / dir[indexJ]);
+		tMaxJ = (btScalar(stepJ > 0 ? j + 1 : j) - begin[indexJ]) / dir[indexJ];
+	}
 
-			} else
+	btScalar t = tEnter;
+	for (;;)
+	{
+		btScalar tNext = btMin(btMin(tMaxX, tMaxJ), tExit);
+
+		// height range of the ray segment inside this cell
+		btScalar h0 = begin[m_upAxis] + dir[m_upAxis] * t;
+		btScalar h1 = begin[m_upAxis] + dir[m_upAxis] * tNext;
+		btScalar rayMin = btMin(h0, h1) - slack;
+		btScalar rayMax = btMax(h0, h1) + slack;
+
+		if (!m_vboundsPyramid.size() || getBlockRange(0, x / m_vboundsChunkSize, j / m_vboundsChunkSize).overlaps(rayMin, rayMax))
+		{
+			btScalar heights[4];
+			getRawHeightFieldRow(j, x, 2, heights);
+			getRawHeightFieldRow(j + 1, x, 2, heights + 2);
+			btScalar cellMin = btMin(btMin(heights[0], heights[1]), btMin(heights[2], heights[3]));
+			btScalar cellMax = btMax(btMax(heights[0], heights[1]), btMax(heights[2], heights[3]));
+			if (Range(cellMin, cellMax).overlaps(rayMin, rayMax))
+				processCell(callback, x, j, heights);
+		}
+
+		if (tNext >= tExit)
+			break;
+
+		if (tMaxX < tMaxJ)
+		{
+			x += stepX;
+			if (x < 0 || x >= cellsX)
+				break;
+			t = tMaxX;
+			tMaxX += tDeltaX;
+		} else
+		{
+			j += stepJ;
+			if (j < 0 || j >= cellsJ)
+				break;
+			t = tMaxJ;
+			tMaxJ += tDeltaJ;
+		}
+	}
+}
+
+
+
+void	btHeightfieldTerrainShape::buildAccelerator(int chunkSize)
+{
+	clearAccelerator();
+	if (chunkSize <= 0)
+		return;
+
+	m_vboundsChunkSize = chunkSize;
+	int cellsX = m_heightStickWidth - 1;
+	int cellsJ = m_heightStickLength - 1;
+	int width = (cellsX + chunkSize - 1) / chunkSize;
+	int length = (cellsJ + chunkSize - 1) / chunkSize;
+
+	// level 0: the blocks of a chunk also include the vertices on its far borders,
+	// so vertices on a chunk border contribute to the neighbouring chunks too
+	m_vboundsLevelOffset.push_back(0);
+	m_vboundsLevelWidth.push_back(width);
+	m_vboundsLevelLength.push_back(length);
+	m_vboundsPyramid.resize(width * length, Range(BT_LARGE_FLOAT, -BT_LARGE_FLOAT));
+
+	btAlignedObjectArray<btScalar> row;
+	row.resize(m_heightStickWidth);
+	btAlignedObjectArray<Range> rowRanges;
+	rowRanges.resize(width);
+
+	for (int y = 0; y < m_heightStickLength; y++)
+	{
+		getRawHeightFieldRow(y, 0, m_heightStickWidth, &row[0]);
+
+		for (int bx = 0; bx < width; bx++)
+		{
+			int x0 = bx * chunkSize;
+			int x1 = btMin(x0 + chunkSize, cellsX);
+			Range r(row[x0], row[x0]);
+			for (int x = x0 + 1; x <= x1; x++)
 			{
-        //first triangle
-        getVertex(x,j,vertices[0]);
-        getVertex(x,j+1,vertices[1]);
-        getVertex(x+1,j,vertices[2]);
-        callback->processTriangle(vertices,x,j);
-        //second triangle
-        getVertex(x+1,j,vertices[0]);
-        //getVertex(x,j+1,vertices[1]);
-        getVertex(x+1,j+1,vertices[2]);
-        callback->processTriangle(vertices,x,j);
+				r.m_min = btMin(r.m_min, row[x]);
+				r.m_max = btMax(r.m_max, row[x]);
+			}
+			rowRanges[bx] = r;
+		}
+
+		int byLast = btMin(y / chunkSize, length - 1);
+		int byFirst = (y > 0 && (y % chunkSize) == 0) ? y / chunkSize - 1 : byLast;
+		for (int by = byFirst; by <= byLast; by++)
+		{
+			for (int bx = 0; bx < width; bx++)
+			{
+				Range& block = m_vboundsPyramid[by * width + bx];
+				block.m_min = btMin(block.m_min, rowRanges[bx].m_min);
+				block.m_max = btMax(block.m_max, rowRanges[bx].m_max);
 			}
 		}
 	}
 
-	
+	// coarser levels, until a single block covers the whole heightfield
+	while (width > 1 || length > 1)
+	{
+		int childOffset = m_vboundsLevelOffset[m_vboundsLevelOffset.size() - 1];
+		int childWidth = width;
+		int childLength = length;
+		width = (width + 1) / 2;
+		length = (length + 1) / 2;
+
+		int offset = m_vboundsPyramid.size();
+		m_vboundsLevelOffset.push_back(offset);
+		m_vboundsLevelWidth.push_back(width);
+		m_vboundsLevelLength.push_back(length);
+		m_vboundsPyramid.resize(offset + width * length, Range(BT_LARGE_FLOAT, -BT_LARGE_FLOAT));
+
+		for (int cj = 0; cj < childLength; cj++)
+		{
+			for (int cx = 0; cx < childWidth; cx++)
+			{
+				const Range child = m_vboundsPyramid[childOffset + cj * childWidth + cx];
+				Range& block = m_vboundsPyramid[offset + (cj / 2) * width + (cx / 2)];
+				block.m_min = btMin(block.m_min, child.m_min);
+				block.m_max = btMax(block.m_max, child.m_max);
+			}
+		}
+	}
+}
+
 
+
+void	btHeightfieldTerrainShape::clearAccelerator()
+{
+	m_vboundsPyramid.clear();
+	m_vboundsLevelOffset.clear();
+	m_vboundsLevelWidth.clear();
+	m_vboundsLevelLength.clear();
+	m_vboundsChunkSize = 0;
 }
 
 void	btHeightfieldTerrainShape::calculateLocalInertia(btScalar ,btVector3& inertia) const
@@ -42,6 +42,7 @@ class btDispatcher;
 #include "LinearMath/btIDebugDraw.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
+class btContactArray;
 
 //! Collision Algorithm for GImpact Shapes
 /*!
@@ -142,6 +143,11 @@ protected:
 					const btVector3 & normal,
 					btScalar distance);
 
+	//! Adds contacts collected from triangle pairs, features are the triangle indices
+	void addTriangleContacts(const btCollisionObjectWrapper * body0Wrap,
+					const btCollisionObjectWrapper * body1Wrap,
+					const btContactArray & contacts);
+
 //! Collision routines
 //!@{
 
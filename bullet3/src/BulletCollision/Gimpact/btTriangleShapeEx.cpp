@@ -86,6 +86,113 @@ bool btPrimitiveTriangle::overlap_test_conservative(const btPrimitiveTriangle& o
     return true;
 }
 
+//! pairs are classified in groups of this many lanes
+#define BT_TRIANGLE_BATCH_LANES 4
+
+//! Structure of arrays holding one plane and the three vertices of the other triangle, per lane
+struct BT_TRIANGLE_PLANE_LANES
+{
+	btScalar m_plane[4][BT_TRIANGLE_BATCH_LANES];
+	btScalar m_vertices[3][3][BT_TRIANGLE_BATCH_LANES];
+	btScalar m_margin[BT_TRIANGLE_BATCH_LANES];
+
+	SIMD_FORCE_INLINE void set_lane(int lane, const btPrimitiveTriangle & planeTri, const btPrimitiveTriangle & pointTri, btScalar margin)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			m_plane[c][lane] = planeTri.m_plane[c];
+		}
+		for (int v = 0; v < 3; v++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				m_vertices[v][c][lane] = pointTri.m_vertices[v][c];
+			}
+		}
+		m_margin[lane] = margin;
+	}
+
+	//! returns a bit per lane, set if the three points lie beyond the plane plus margin
+	SIMD_FORCE_INLINE int classify_separated() const
+	{
+#if defined(BT_USE_SSE) && !defined(BT_USE_DOUBLE_PRECISION)
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 nx = _mm_loadu_ps(m_plane[0]);
+		const __m128 ny = _mm_loadu_ps(m_plane[1]);
+		const __m128 nz = _mm_loadu_ps(m_plane[2]);
+		const __m128 nw = _mm_loadu_ps(m_plane[3]);
+		const __m128 margin = _mm_loadu_ps(m_margin);
+		__m128 separated = _mm_cmpeq_ps(zero, zero);
+		for (int v = 0; v < 3; v++)
+		{
+			__m128 dis = _mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(m_vertices[v][0])), _mm_mul_ps(ny, _mm_loadu_ps(m_vertices[v][1])));
+			dis = _mm_add_ps(dis, _mm_mul_ps(nz, _mm_loadu_ps(m_vertices[v][2])));
+			dis = _mm_sub_ps(_mm_sub_ps(dis, nw), margin);
+			separated = _mm_and_ps(separated, _mm_cmpgt_ps(dis, zero));
+		}
+		return _mm_movemask_ps(separated);
+#elif defined(BT_USE_NEON) && !defined(BT_USE_DOUBLE_PRECISION)
+		const float32x4_t zero = vdupq_n_f32(0.f);
+		const float32x4_t nx = vld1q_f32(m_plane[0]);
+		const float32x4_t ny = vld1q_f32(m_plane[1]);
+		const float32x4_t nz = vld1q_f32(m_plane[2]);
+		const float32x4_t nw = vld1q_f32(m_plane[3]);
+		const float32x4_t margin = vld1q_f32(m_margin);
+		uint32x4_t separated = vdupq_n_u32(0xffffffff);
+		for (int v = 0; v < 3; v++)
+		{
+			float32x4_t dis = vaddq_f32(vmulq_f32(nx, vld1q_f32(m_vertices[v][0])), vmulq_f32(ny, vld1q_f32(m_vertices[v][1])));
+			dis = vaddq_f32(dis, vmulq_f32(nz, vld1q_f32(m_vertices[v][2])));
+			dis = vsubq_f32(vsubq_f32(dis, nw), margin);
+			separated = vandq_u32(separated, vcgtq_f32(dis, zero));
+		}
+		uint32_t lanes[4];
+		vst1q_u32(lanes, separated);
+		return (lanes[0] & 1) | (lanes[1] & 2) | (lanes[2] & 4) | (lanes[3] & 8);
+#else
+		int mask = 0;
+		for (int lane = 0; lane < BT_TRIANGLE_BATCH_LANES; lane++)
+		{
+			bool separated = true;
+			for (int v = 0; v < 3; v++)
+			{
+				btScalar dis = m_plane[0][lane] * m_vertices[v][0][lane] + m_plane[1][lane] * m_vertices[v][1][lane]
+					+ m_plane[2][lane] * m_vertices[v][2][lane] - m_plane[3][lane] - m_margin[lane];
+				separated = separated && dis > 0.0f;
+			}
+			mask |= separated ? (1 << lane) : 0;
+		}
+		return mask;
+#endif
+	}
+};
+
+void bt_overlap_test_conservative_batch(const btPrimitiveTriangle * tris0, const btPrimitiveTriangle * tris1, int count, bool * results)
+{
+	BT_TRIANGLE_PLANE_LANES planes0;
+	BT_TRIANGLE_PLANE_LANES planes1;
+
+	for (int base = 0; base < count; base += BT_TRIANGLE_BATCH_LANES)
+	{
+		int lanes = btMin(BT_TRIANGLE_BATCH_LANES, count - base);
+		for (int lane = 0; lane < BT_TRIANGLE_BATCH_LANES; lane++)
+		{
+			// unused lanes repeat the first pair, their result is ignored
+			int i = base + (lane < lanes ? lane : 0);
+			btScalar total_margin = tris0[i].m_margin + tris1[i].m_margin;
+			// points of the second triangle against the first plane, and the other way around
+			planes0.set_lane(lane, tris0[i], tris1[i], total_margin);
+			planes1.set_lane(lane, tris1[i], tris0[i], total_margin);
+		}
+
+		int separated = planes0.classify_separated() | planes1.classify_separated();
+		for (int lane = 0; lane < lanes; lane++)
+		{
+			results[base + lane] = (separated & (1 << lane)) == 0;
+		}
+	}
+}
+
 int btPrimitiveTriangle::clip_triangle(btPrimitiveTriangle & other, btVector3 * clipped_points )
 {
     // edge 0
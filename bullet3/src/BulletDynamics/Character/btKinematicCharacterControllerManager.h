@@ -0,0 +1,118 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_KINEMATIC_CHARACTER_CONTROLLER_MANAGER_H
+#define BT_KINEMATIC_CHARACTER_CONTROLLER_MANAGER_H
+
+#include "BulletDynamics/Dynamics/btActionInterface.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "btKinematicCharacterController.h"
+
+///btKinematicCharacterControllerManager updates many btKinematicCharacterControllers as a single action.
+///All characters do their step up sweep, then all do their forward and down sweeps, then the penetrations of all
+///characters are resolved together. The sweeps and the contact generation of the penetration recovery run in parallel
+///over the characters when a task scheduler is set (see btParallelFor), only the broadphase updates are serial.
+///During a phase the ghost objects don't move, so the sweeps of a character see the other characters where they were at
+///the start of the phase, instead of where the characters that were updated before it moved to.
+///The forward sweep temporarily changes the margin of the convex shape of a character (see getConvexShape), so the
+///forward and down sweeps only run in parallel when no two characters share a convex shape and the characters can't hit
+///each other according to the collision filters of their ghost objects. Add the manager to the world with addAction,
+///instead of the characters.
+class btKinematicCharacterControllerManager : public btActionInterface
+{
+protected:
+	struct CharacterLoop;
+
+	enum CharacterStage
+	{
+		CHARACTER_PREPARE,
+		CHARACTER_SWEEP_UP,
+		CHARACTER_END_STEP_UP,
+		CHARACTER_STEP_FORWARD_AND_DOWN,
+		CHARACTER_UPDATE_GHOST_POSITION,
+		CHARACTER_RESOLVE_PENETRATION
+	};
+
+	btAlignedObjectArray<btKinematicCharacterController*>	m_characters;
+	//characters that take part in the current stage, as indices into m_characters
+	btAlignedObjectArray<int>	m_stageCharacters;
+	btAlignedObjectArray<int>	m_movingCharacters;
+	btAlignedObjectArray<int>	m_hitCharacters;
+	//per character results of a stage
+	btAlignedObjectArray<int>	m_stageResults;
+	btAlignedObjectArray<int>	m_penetrationLoops;
+	//contact manifold arrays for resolvePenetration, one per thread
+	btAlignedObjectArray<btManifoldArray>	m_manifoldArrays;
+	int	m_characterGrainSize;
+	bool	m_sharedShapes;
+	bool	m_sharedShapesDirty;
+
+	void	processCharacters(btCollisionWorld* collisionWorld, CharacterStage stage, btScalar step, bool serial=false);
+
+	void	processCharacterRange(btCollisionWorld* collisionWorld, CharacterStage stage, btScalar step, int iBegin, int iEnd);
+
+	void	selectStageCharacters(const btAlignedObjectArray<int>& characters, bool onlyWithResult);
+
+	void	recoverFromPenetration(btCollisionWorld* collisionWorld);
+
+	void	updateSharedShapes();
+
+	bool	charactersCanHitEachOther() const;
+
+public:
+
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btKinematicCharacterControllerManager();
+
+	virtual ~btKinematicCharacterControllerManager();
+
+	void	addCharacter(btKinematicCharacterController* character);
+
+	void	removeCharacter(btKinematicCharacterController* character);
+
+	int		getNumCharacters() const
+	{
+		return m_characters.size();
+	}
+
+	btKinematicCharacterController*	getCharacter(int index)
+	{
+		return m_characters[index];
+	}
+
+	///btActionInterface interface
+	virtual void updateAction( btCollisionWorld* collisionWorld, btScalar step)
+	{
+		updateCharacters(collisionWorld, step);
+	}
+
+	///btActionInterface interface
+	virtual void	debugDraw(btIDebugDraw* debugDrawer);
+
+	void	updateCharacters(btCollisionWorld* collisionWorld, btScalar step);
+
+	///the number of characters handed to a thread at once
+	int		getCharacterGrainSize() const
+	{
+		return m_characterGrainSize;
+	}
+	void	setCharacterGrainSize(int grainSize)
+	{
+		m_characterGrainSize = btMax(1, grainSize);
+	}
+};
+
+#endif //BT_KINEMATIC_CHARACTER_CONTROLLER_MANAGER_H
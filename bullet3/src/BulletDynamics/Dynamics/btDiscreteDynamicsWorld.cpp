@@ -41,6 +41,7 @@ subject to the following restrictions:
 
 #include "LinearMath/btIDebugDraw.h"
 #include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
 
 #include "BulletDynamics/Dynamics/btActionInterface.h"
@@ -48,6 +49,7 @@ subject to the following restrictions:
 #include "LinearMath/btMotionState.h"
 
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btStateHash.h"
 
 #if 0
 btAlignedObjectArray<btVector3> debugContacts;
@@ -205,11 +207,13 @@ btDiscreteDynamicsWorld::btDiscreteDynamicsWorld(btDispatcher* dispatcher,btBroa
 m_sortedConstraints	(),
 m_solverIslandCallback ( NULL ),
 m_constraintSolver(constraintSolver),
+m_awakeRigidBodiesRevision(-1),
 m_gravity(0,-10,0),
 m_localTime(0),
 m_fixedTimeStep(0),
 m_synchronizeAllMotionStates(false),
 m_applySpeculativeContactRestitution(false),
+m_useSpeculativeContacts(false),
 m_profileTimings(0),
 m_latencyMotionStateInterpolation(true)
 
@@ -259,14 +263,37 @@ btDiscreteDynamicsWorld::~btDiscreteDynamicsWorld()
 	}
 }
 
+btAlignedObjectArray<btRigidBody*>&	btDiscreteDynamicsWorld::getAwakeRigidBodies()
+{
+	if (!m_skipDormantObjects)
+		return m_nonStaticRigidBodies;
+
+	updateAwakeObjects(false);
+	if (m_awakeRigidBodiesRevision != m_awakeObjectsRevision)
+	{
+		m_awakeRigidBodies.resize(0);
+		for (int i=0;i<m_awakeObjects.size();i++)
+		{
+			btRigidBody* body = btRigidBody::upcast(m_awakeObjects[i]);
+			if (body && !body->isStaticObject())
+				m_awakeRigidBodies.push_back(body);
+		}
+		m_awakeRigidBodiesRevision = m_awakeObjectsRevision;
+	}
+	return m_awakeRigidBodies;
+}
+
 void	btDiscreteDynamicsWorld::saveKinematicState(btScalar timeStep)
 {
 ///would like to iterate over m_nonStaticRigidBodies, but unfortunately old API allows
 ///to switch status _after_ adding kinematic objects to the world
 ///fix it for Bullet 3.x release
-	for (int i=0;i<m_collisionObjects.size();i++)
+	if (m_skipDormantObjects)
+		updateAwakeObjects(false);
+	btCollisionObjectArray& objects = m_skipDormantObjects ? m_awakeObjects : m_collisionObjects;
+	for (int i=0;i<objects.size();i++)
 	{
-		btCollisionObject* colObj = m_collisionObjects[i];
+		btCollisionObject* colObj = objects[i];
 		btRigidBody* body = btRigidBody::upcast(colObj);
 		if (body && body->getActivationState() != ISLAND_SLEEPING)
 		{
@@ -326,9 +353,11 @@ void	btDiscreteDynamicsWorld::debugDrawWorld()
 void	btDiscreteDynamicsWorld::clearForces()
 {
 	///@todo: iterate over awake simulation islands!
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	//dormant bodies keep their forces until they wake up
+	btAlignedObjectArray<btRigidBody*>& bodies = getAwakeRigidBodies();
+	for ( int i=0;i<bodies.size();i++)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		btRigidBody* body = bodies[i];
 		//need to check if next line is ok
 		//it might break backward compatibility (people applying forces on sleeping objects get never cleared and accumulate on wake-up
 		body->clearForces();
@@ -339,9 +368,10 @@ void	btDiscreteDynamicsWorld::clearForces()
 void	btDiscreteDynamicsWorld::applyGravity()
 {
 	///@todo: iterate over awake simulation islands!
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	btAlignedObjectArray<btRigidBody*>& bodies = getAwakeRigidBodies();
+	for ( int i=0;i<bodies.size();i++)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		btRigidBody* body = bodies[i];
 		if (body->isActive())
 		{
 			body->applyGravity();
@@ -388,9 +418,10 @@ void	btDiscreteDynamicsWorld::synchronizeMotionStates()
 	} else
 	{
 		//iterate over all active rigid bodies
-		for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+		btAlignedObjectArray<btRigidBody*>& bodies = getAwakeRigidBodies();
+		for ( int i=0;i<bodies.size();i++)
 		{
-			btRigidBody* body = m_nonStaticRigidBodies[i];
+			btRigidBody* body = bodies[i];
 			if (body->isActive())
 				synchronizeSingleMotionState(body);
 		}
@@ -621,9 +652,11 @@ void	btDiscreteDynamicsWorld::updateActivationState(btScalar timeStep)
 {
 	BT_PROFILE("updateActivationState");
 
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	//a body that fell asleep during this step is still awake here, so its velocity is cleared before it becomes dormant
+	btAlignedObjectArray<btRigidBody*>& bodies = getAwakeRigidBodies();
+	for ( int i=0;i<bodies.size();i++)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		btRigidBody* body = bodies[i];
 		if (body)
 		{
 			body->updateDeactivation(timeStep);
@@ -894,6 +927,12 @@ void btDiscreteDynamicsWorld::createPredictiveContactsInternal( btRigidBody** bo
 
 			if (getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
 			{
+				if (m_useSpeculativeContacts)
+				{
+					createSpeculativeContacts(body, predictedTrans, timeStep);
+					continue;
+				}
+
 				BT_PROFILE("predictive convexSweepTest");
 				if (body->getCollisionShape()->isConvex())
 				{
@@ -963,6 +1002,171 @@ void btDiscreteDynamicsWorld::createPredictiveContactsInternal( btRigidBody** bo
 	}
 }
 
+///adds the closest points reported by the narrowphase as speculative contacts, if the body can reach them within the time step
+struct btSpeculativeManifoldResult : public btManifoldResult
+{
+	btRigidBody* m_body;
+	const btCollisionObject* m_otherObj;
+	btDispatcher* m_dispatcher;
+	btScalar m_timeStep;
+	btPersistentManifold* m_speculativeManifold;
+
+	btSpeculativeManifoldResult(const btCollisionObjectWrapper* obj0Wrap, const btCollisionObjectWrapper* obj1Wrap, btDispatcher* dispatcher, btScalar timeStep)
+		:btManifoldResult(obj0Wrap, obj1Wrap),
+		m_body(btRigidBody::upcast((btCollisionObject*)obj0Wrap->getCollisionObject())),
+		m_otherObj(obj1Wrap->getCollisionObject()),
+		m_dispatcher(dispatcher),
+		m_timeStep(timeStep),
+		m_speculativeManifold(0)
+	{
+	}
+
+	virtual void addContactPoint(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth)
+	{
+		//touching and penetrating contacts are created by the regular narrowphase
+		if (depth <= btScalar(0.))
+			return;
+
+		//the algorithm may have swapped the objects
+		bool isSwapped = m_manifoldPtr && (m_manifoldPtr->getBody0() != m_body);
+		btVector3 normalOnOther = isSwapped ? -normalOnBInWorld : normalOnBInWorld;
+		btVector3 pointOnOther = isSwapped ? pointInWorld + normalOnBInWorld * depth : pointInWorld;
+		btVector3 pointOnBody = pointOnOther + normalOnOther * depth;
+
+		btVector3 relativeVelocity = m_body->getVelocityInLocalPoint(pointOnBody - m_body->getCenterOfMassPosition());
+		const btRigidBody* otherBody = btRigidBody::upcast(m_otherObj);
+		if (otherBody)
+		{
+			relativeVelocity -= otherBody->getVelocityInLocalPoint(pointOnOther - otherBody->getCenterOfMassPosition());
+		}
+		if (-relativeVelocity.dot(normalOnOther) * m_timeStep <= depth)
+			return;
+
+		if (!m_speculativeManifold)
+		{
+			m_speculativeManifold = m_dispatcher->getNewManifold(m_body, m_otherObj);
+		}
+
+		btVector3 localA = m_body->getWorldTransform().invXform(pointOnBody);
+		btVector3 localB = m_otherObj->getWorldTransform().invXform(pointOnOther);
+		btManifoldPoint newPt(localA, localB, normalOnOther, depth);
+		newPt.m_positionWorldOnA = pointOnBody;
+		newPt.m_positionWorldOnB = pointOnOther;
+		newPt.m_combinedFriction = calculateCombinedFriction(m_body, m_otherObj);
+		newPt.m_combinedRestitution = 0;
+		if (isSwapped)
+		{
+			newPt.m_partId0 = m_partId1;
+			newPt.m_partId1 = m_partId0;
+			newPt.m_index0 = m_index1;
+			newPt.m_index1 = m_index0;
+		} else
+		{
+			newPt.m_partId0 = m_partId0;
+			newPt.m_partId1 = m_partId1;
+			newPt.m_index0 = m_index0;
+			newPt.m_index1 = m_index1;
+		}
+
+		bool isPredictive = true;
+		m_speculativeManifold->addManifoldPoint(newPt, isPredictive);
+	}
+};
+
+///runs the closest point algorithms between a fast body and the objects overlapping its swept aabb
+struct btSpeculativeContactCallback : public btBroadphaseAabbCallback
+{
+	btRigidBody* m_body;
+	btDispatcher* m_dispatcher;
+	const btDispatcherInfo& m_dispatchInfo;
+	btScalar m_timeStep;
+	btScalar m_distanceThreshold;
+	btAlignedObjectArray<btPersistentManifold*>& m_manifolds;
+
+	btSpeculativeContactCallback(btRigidBody* body, btDispatcher* dispatcher, const btDispatcherInfo& dispatchInfo, btScalar timeStep, btScalar distanceThreshold, btAlignedObjectArray<btPersistentManifold*>& manifolds)
+		:m_body(body),
+		m_dispatcher(dispatcher),
+		m_dispatchInfo(dispatchInfo),
+		m_timeStep(timeStep),
+		m_distanceThreshold(distanceThreshold),
+		m_manifolds(manifolds)
+	{
+	}
+
+	virtual bool process(const btBroadphaseProxy* proxy)
+	{
+		btCollisionObject* otherObj = (btCollisionObject*) proxy->m_clientObject;
+		if (otherObj == m_body)
+			return true;
+
+		const btBroadphaseProxy* bodyProxy = m_body->getBroadphaseHandle();
+		bool collides = (proxy->m_collisionFilterGroup & bodyProxy->m_collisionFilterMask) != 0;
+		collides = collides && (bodyProxy->m_collisionFilterGroup & proxy->m_collisionFilterMask);
+		if (!collides)
+			return true;
+
+		//soft bodies and other special objects are left to their own collision handling
+		if (!(otherObj->getInternalType() & (btCollisionObject::CO_RIGID_BODY | btCollisionObject::CO_COLLISION_OBJECT)))
+			return true;
+
+		if (!m_dispatcher->needsCollision(m_body, otherObj) || !m_dispatcher->needsResponse(m_body, otherObj))
+			return true;
+
+		btCollisionObjectWrapper ob0(0, m_body->getCollisionShape(), m_body, m_body->getWorldTransform(), -1, -1);
+		btCollisionObjectWrapper ob1(0, otherObj->getCollisionShape(), otherObj, otherObj->getWorldTransform(), -1, -1);
+
+		btCollisionAlgorithm* algorithm = m_dispatcher->findAlgorithm(&ob0, &ob1, 0, BT_CLOSEST_POINT_ALGORITHMS);
+		if (algorithm)
+		{
+			btSpeculativeManifoldResult result(&ob0, &ob1, m_dispatcher, m_timeStep);
+			result.m_closestPointDistanceThreshold = m_distanceThreshold;
+			algorithm->processCollision(&ob0, &ob1, m_dispatchInfo, &result);
+
+			algorithm->~btCollisionAlgorithm();
+			m_dispatcher->freeCollisionAlgorithm(algorithm);
+
+			if (result.m_speculativeManifold)
+			{
+				m_manifolds.push_back(result.m_speculativeManifold);
+			}
+		}
+		return true;
+	}
+};
+
+void btDiscreteDynamicsWorld::createSpeculativeContacts(btRigidBody* body, const btTransform& predictedTrans, btScalar timeStep)
+{
+	BT_PROFILE("speculative contacts");
+
+	//same aabb as the one the broadphase uses for continuous collision detection
+	btVector3 contactThreshold(gContactBreakingThreshold, gContactBreakingThreshold, gContactBreakingThreshold);
+	btVector3 aabbMin, aabbMax, predictedAabbMin, predictedAabbMax;
+	body->getCollisionShape()->getAabb(body->getWorldTransform(), aabbMin, aabbMax);
+	body->getCollisionShape()->getAabb(predictedTrans, predictedAabbMin, predictedAabbMax);
+	aabbMin.setMin(predictedAabbMin);
+	aabbMax.setMax(predictedAabbMax);
+	aabbMin -= contactThreshold;
+	aabbMax += contactThreshold;
+
+	//the largest distance any point of the body can travel in this step
+	btScalar distanceThreshold = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()).length();
+	distanceThreshold += body->getCollisionShape()->getAngularMotionDisc() * body->getAngularVelocity().length() * timeStep;
+
+	btAlignedObjectArray<btPersistentManifold*> manifolds;
+	btSpeculativeContactCallback callback(body, m_dispatcher1, getDispatchInfo(), timeStep, distanceThreshold, manifolds);
+	getBroadphase()->aabbTest(aabbMin, aabbMax, callback);
+
+	if (manifolds.size())
+	{
+		btMutexLock( &m_predictiveManifoldsMutex );
+		for (int i = 0; i < manifolds.size(); i++)
+		{
+			m_predictiveManifolds.push_back(manifolds[i]);
+		}
+		btMutexUnlock( &m_predictiveManifoldsMutex );
+	}
+}
+
 void btDiscreteDynamicsWorld::releasePredictiveContacts()
 {
     BT_PROFILE( "release predictive contact manifolds" );
@@ -979,9 +1183,10 @@ void btDiscreteDynamicsWorld::createPredictiveContacts(btScalar timeStep)
 {
 	BT_PROFILE("createPredictiveContacts");
     releasePredictiveContacts();
-    if (m_nonStaticRigidBodies.size() > 0)
+    btAlignedObjectArray<btRigidBody*>& bodies = getAwakeRigidBodies();
+    if (bodies.size() > 0)
     {
-        createPredictiveContactsInternal( &m_nonStaticRigidBodies[ 0 ], m_nonStaticRigidBodies.size(), timeStep );
+        createPredictiveContactsInternal( &bodies[ 0 ], bodies.size(), timeStep );
     }
 }
 
@@ -1002,7 +1207,7 @@ void btDiscreteDynamicsWorld::integrateTransformsInternal( btRigidBody** bodies,
 
 
 
-			if (getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
+			if (!m_useSpeculativeContacts && getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
 			{
 				BT_PROFILE("CCD motion clamping");
 				if (body->getCollisionShape()->isConvex())
@@ -1095,9 +1300,10 @@ void btDiscreteDynamicsWorld::integrateTransformsInternal( btRigidBody** bodies,
 void btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 {
 	BT_PROFILE("integrateTransforms");
-    if (m_nonStaticRigidBodies.size() > 0)
+    btAlignedObjectArray<btRigidBody*>& bodies = getAwakeRigidBodies();
+    if (bodies.size() > 0)
     {
-        integrateTransformsInternal(&m_nonStaticRigidBodies[0], m_nonStaticRigidBodies.size(), timeStep);
+        integrateTransformsInternal(&bodies[0], bodies.size(), timeStep);
     }
 
     ///this should probably be switched on by default, but it is not well tested yet
@@ -1143,9 +1349,10 @@ void btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 void	btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
 {
 	BT_PROFILE("predictUnconstraintMotion");
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	btAlignedObjectArray<btRigidBody*>& bodies = getAwakeRigidBodies();
+	for ( int i=0;i<bodies.size();i++)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		btRigidBody* body = bodies[i];
 		if (!body->isStaticOrKinematicObject())
 		{
 			//don't integrate/update velocities here, it happens in the constraint solver
@@ -1440,9 +1647,73 @@ const btTypedConstraint* btDiscreteDynamicsWorld::getConstraint(int index) const
 
 
 
+struct btSerializeRigidBodiesLoop : public btIParallelForBody
+{
+	btCollisionObject* const*	m_collisionObjects;
+	btSerializer*	m_serializer;
+
+	btSerializeRigidBodiesLoop(btCollisionObject* const* collisionObjects, btSerializer* serializer)
+		:m_collisionObjects(collisionObjects),
+		m_serializer(serializer)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			btCollisionObject* colObj = m_collisionObjects[i];
+			if (colObj->getInternalType() & btCollisionObject::CO_RIGID_BODY)
+			{
+				int len = colObj->calculateSerializeBufferSize();
+				btChunk* chunk = m_serializer->allocate(len,1);
+				const char* structType = colObj->serialize(chunk->m_oldPtr, m_serializer);
+				m_serializer->finalizeChunk(chunk,structType,BT_RIGIDBODY_CODE,colObj);
+			}
+		}
+	}
+};
+
+struct btSerializeConstraintsLoop : public btIParallelForBody
+{
+	btTypedConstraint* const*	m_constraints;
+	btSerializer*	m_serializer;
+
+	btSerializeConstraintsLoop(btTypedConstraint* const* constraints, btSerializer* serializer)
+		:m_constraints(constraints),
+		m_serializer(serializer)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			btTypedConstraint* constraint = m_constraints[i];
+			int size = constraint->calculateSerializeBufferSize();
+			btChunk* chunk = m_serializer->allocate(size,1);
+			const char* structType = constraint->serialize(chunk->m_oldPtr,m_serializer);
+			m_serializer->finalizeChunk(chunk,structType,BT_CONSTRAINT_CODE,constraint);
+		}
+	}
+};
+
 void	btDiscreteDynamicsWorld::serializeRigidBodies(btSerializer* serializer)
 {
 	int i;
+	if (serializer->isThreadSafe())
+	{
+		if (m_collisionObjects.size())
+		{
+			btParallelFor(0, m_collisionObjects.size(), 64, btSerializeRigidBodiesLoop(&m_collisionObjects[0], serializer));
+		}
+		if (m_constraints.size())
+		{
+			btParallelFor(0, m_constraints.size(), 64, btSerializeConstraintsLoop(&m_constraints[0], serializer));
+		}
+		return;
+	}
+
 	//serialize all collision objects
 	for (i=0;i<m_collisionObjects.size();i++)
 	{
@@ -1536,3 +1807,29 @@ void	btDiscreteDynamicsWorld::serialize(btSerializer* serializer)
 	serializer->finishSerialization();
 }
 
+void	btDiscreteDynamicsWorld::calculateStateHash(btStateHash& stateHash) const
+{
+	btCollisionWorld::calculateStateHash(stateHash);
+
+	int i;
+	stateHash.addInt(m_nonStaticRigidBodies.size());
+	for (i=0;i<m_nonStaticRigidBodies.size();i++)
+	{
+		const btRigidBody* body = m_nonStaticRigidBodies[i];
+		stateHash.addVector3(body->getLinearVelocity());
+		stateHash.addVector3(body->getAngularVelocity());
+		stateHash.addScalar(body->getDeactivationTime());
+	}
+
+	stateHash.addInt(m_constraints.size());
+	for (i=0;i<m_constraints.size();i++)
+	{
+		const btTypedConstraint* constraint = m_constraints[i];
+		stateHash.addInt(constraint->isEnabled());
+		//the applied impulse is only stored with feedback enabled
+		if (constraint->needsFeedback())
+		{
+			stateHash.addScalar(constraint->getAppliedImpulse());
+		}
+	}
+}
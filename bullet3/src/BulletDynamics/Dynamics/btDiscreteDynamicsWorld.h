@@ -55,6 +55,9 @@ protected:
 	btAlignedObjectArray<btTypedConstraint*> m_constraints;
 
 	btAlignedObjectArray<btRigidBody*> m_nonStaticRigidBodies;
+	///the non-static rigid bodies in m_awakeObjects, gathered again when m_awakeObjectsRevision changes
+	btAlignedObjectArray<btRigidBody*> m_awakeRigidBodies;
+	int	m_awakeRigidBodiesRevision;
 
 	btVector3	m_gravity;
 
@@ -67,6 +70,7 @@ protected:
 	bool	m_ownsConstraintSolver;
 	bool	m_synchronizeAllMotionStates;
 	bool	m_applySpeculativeContactRestitution;
+	bool	m_useSpeculativeContacts;
 
 	btAlignedObjectArray<btActionInterface*>	m_actions;
 	
@@ -77,6 +81,9 @@ protected:
 	btAlignedObjectArray<btPersistentManifold*>	m_predictiveManifolds;
     btSpinMutex m_predictiveManifoldsMutex;  // used to synchronize threads creating predictive contacts
 
+	///the non-static rigid bodies the per-step loops visit: all of them, or only the awake ones when dormant objects are skipped
+	btAlignedObjectArray<btRigidBody*>&	getAwakeRigidBodies();
+
 	virtual void	predictUnconstraintMotion(btScalar timeStep);
 	
     void integrateTransformsInternal( btRigidBody** bodies, int numBodies, btScalar timeStep );  // can be called in parallel
@@ -97,6 +104,7 @@ protected:
     void releasePredictiveContacts();
     void createPredictiveContactsInternal( btRigidBody** bodies, int numBodies, btScalar timeStep );  // can be called in parallel
 	virtual void	createPredictiveContacts(btScalar timeStep);
+    void createSpeculativeContacts( btRigidBody* body, const btTransform& predictedTrans, btScalar timeStep );  // can be called in parallel
 
 	virtual void	saveKinematicState(btScalar timeStep);
 
@@ -217,6 +225,16 @@ public:
 		return m_synchronizeAllMotionStates;
 	}
 
+	///the time that stepSimulation accumulated but didn't simulate yet, less than a fixed time step
+	btScalar	getLocalTime() const
+	{
+		return m_localTime;
+	}
+	void	setLocalTime(btScalar localTime)
+	{
+		m_localTime = localTime;
+	}
+
 	void setApplySpeculativeContactRestitution(bool enable)
 	{
 		m_applySpeculativeContactRestitution = enable;
@@ -227,9 +245,26 @@ public:
 		return m_applySpeculativeContactRestitution;
 	}
 
+	///Speculative contacts replace the swept sphere CCD of fast bodies (see btCollisionObject::setCcdMotionThreshold).
+	///Instead of clamping the motion to the time of impact, the closest points between the actual shapes of the body and
+	///the objects overlapping its swept aabb are added as contacts, which the solver lets the body approach but not pass.
+	///Fast rotating polyhedra need several contact points per pair, see btDefaultCollisionConfiguration::setConvexConvexMultipointIterations.
+	void setUseSpeculativeContacts(bool enable)
+	{
+		m_useSpeculativeContacts = enable;
+	}
+
+	bool getUseSpeculativeContacts() const
+	{
+		return m_useSpeculativeContacts;
+	}
+
 	///Preliminary serialization test for Bullet 2.76. Loading those files requires a separate parser (see Bullet/Demos/SerializeDemo)
 	virtual	void	serialize(btSerializer* serializer);
 
+	///adds the velocities and deactivation times of the rigid bodies and the state of the constraints to the hash of btCollisionWorld
+	virtual	void	calculateStateHash(btStateHash& stateHash) const;
+
 	///Interpolate motion state between previous and current transform, instead of current and next transform.
 	///This can relieve discontinuities in the rendering, due to penetrations
 	void setLatencyMotionStateInterpolation(bool latencyInterpolation )
@@ -0,0 +1,194 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btDynamicsWorldGroup.h"
+#include "btDiscreteDynamicsWorld.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btQuickprof.h"
+
+
+struct btDynamicsWorldGroup::WorldLoop : public btIParallelForBody
+{
+	btDynamicsWorldGroup* m_group;
+	btScalar m_timeStep;
+
+	WorldLoop(btDynamicsWorldGroup* group, btScalar timeStep)
+		:m_group(group),
+		m_timeStep(timeStep)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			m_group->stepWorld(m_group->m_worlds[m_group->m_order[i]], m_timeStep);
+		}
+	}
+};
+
+struct btLongestStepFirst
+{
+	const btAlignedObjectArray<btWorldGroupInfo>& m_worlds;
+
+	btLongestStepFirst(const btAlignedObjectArray<btWorldGroupInfo>& worlds)
+		:m_worlds(worlds)
+	{
+	}
+
+	bool operator() (int a, int b) const
+	{
+		return m_worlds[a].m_stepTime > m_worlds[b].m_stepTime;
+	}
+};
+
+
+btDynamicsWorldGroup::btDynamicsWorldGroup(btCollisionConfiguration* collisionConfiguration)
+	:m_collisionConfiguration(collisionConfiguration)
+{
+}
+
+btDynamicsWorldGroup::~btDynamicsWorldGroup()
+{
+	for (int i=m_worlds.size()-1;i>=0;i--)
+	{
+		if (m_worlds[i].m_createdByGroup)
+		{
+			destroyWorld(m_worlds[i].m_world);
+		}
+	}
+}
+
+btDiscreteDynamicsWorld*	btDynamicsWorldGroup::createWorld(int maxSubSteps, btScalar fixedTimeStep)
+{
+	btCollisionDispatcher* dispatcher = new btCollisionDispatcher(m_collisionConfiguration);
+	btBroadphaseInterface* broadphase = new btDbvtBroadphase();
+	btSequentialImpulseConstraintSolver* solver = new btSequentialImpulseConstraintSolver;
+	btDiscreteDynamicsWorld* world = new btDiscreteDynamicsWorld(dispatcher,broadphase,solver,m_collisionConfiguration);
+
+	addWorld(world,maxSubSteps,fixedTimeStep);
+	m_worlds[m_worlds.size()-1].m_createdByGroup = true;
+	return world;
+}
+
+void	btDynamicsWorldGroup::destroyWorld(btDiscreteDynamicsWorld* world)
+{
+	int index = findWorld(world);
+	btAssert(index>=0 && m_worlds[index].m_createdByGroup);
+	if (index<0 || !m_worlds[index].m_createdByGroup)
+		return;
+
+	m_worlds[index].m_createdByGroup = false;
+	removeWorld(world);
+
+	//the world removes the proxies of its remaining objects from the broadphase, so it goes first
+	btConstraintSolver* solver = world->getConstraintSolver();
+	btBroadphaseInterface* broadphase = world->getBroadphase();
+	btDispatcher* dispatcher = world->getDispatcher();
+	delete world;
+	delete solver;
+	delete broadphase;
+	delete dispatcher;
+}
+
+void	btDynamicsWorldGroup::addWorld(btDiscreteDynamicsWorld* world, int maxSubSteps, btScalar fixedTimeStep)
+{
+	btAssert(findWorld(world)<0);
+
+	btWorldGroupInfo info;
+	info.m_world = world;
+	info.m_maxSubSteps = maxSubSteps;
+	info.m_fixedTimeStep = fixedTimeStep;
+	info.m_maxStepTime = btScalar(0.);
+	info.m_numSubSteps = 0;
+	info.m_stepTime = btScalar(0.);
+	info.m_subStepTime = btScalar(0.);
+	info.m_createdByGroup = false;
+	m_worlds.push_back(info);
+}
+
+void	btDynamicsWorldGroup::removeWorld(btDiscreteDynamicsWorld* world)
+{
+	int index = findWorld(world);
+	if (index<0)
+		return;
+
+	//worlds made by createWorld are deleted with destroyWorld
+	btAssert(!m_worlds[index].m_createdByGroup);
+	m_worlds.swap(index,m_worlds.size()-1);
+	m_worlds.pop_back();
+}
+
+int		btDynamicsWorldGroup::findWorld(const btDiscreteDynamicsWorld* world) const
+{
+	for (int i=0;i<m_worlds.size();i++)
+	{
+		if (m_worlds[i].m_world==world)
+			return i;
+	}
+	return -1;
+}
+
+void	btDynamicsWorldGroup::stepWorld(btWorldGroupInfo& info, btScalar timeStep)
+{
+	int maxSubSteps = info.m_maxSubSteps;
+	if (maxSubSteps>0 && info.m_maxStepTime>btScalar(0.) && info.m_subStepTime>btScalar(0.))
+	{
+		int affordableSubSteps = int(info.m_maxStepTime/info.m_subStepTime);
+		maxSubSteps = btMax(1,btMin(maxSubSteps,affordableSubSteps));
+	}
+
+	//a clock per call, btClock keeps state that isn't safe to share between the threads stepping the worlds
+	btClock clock;
+	int numSubSteps = info.m_world->stepSimulation(timeStep,maxSubSteps,info.m_fixedTimeStep);
+	unsigned long long int stepMicroseconds = clock.getTimeMicroseconds();
+
+	//stepSimulation returns the substeps that were due, before clamping them to maxSubSteps
+	if (maxSubSteps>0)
+	{
+		numSubSteps = btMin(numSubSteps,maxSubSteps);
+	}
+	info.m_numSubSteps = numSubSteps;
+	info.m_stepTime = btScalar(stepMicroseconds)*btScalar(1e-6);
+	if (numSubSteps>0)
+	{
+		//smooth the cost of a substep, so a single slow step doesn't cut the next ones short
+		btScalar subStepTime = info.m_stepTime/btScalar(numSubSteps);
+		info.m_subStepTime = info.m_subStepTime>btScalar(0.) ? btScalar(0.75)*info.m_subStepTime+btScalar(0.25)*subStepTime : subStepTime;
+	}
+}
+
+int		btDynamicsWorldGroup::stepSimulation(btScalar timeStep)
+{
+	//no profile sample here, stepSimulation of each world resets the profile tree of its thread
+	m_order.resize(m_worlds.size());
+	for (int i=0;i<m_order.size();i++)
+	{
+		m_order[i] = i;
+	}
+	m_order.quickSort(btLongestStepFirst(m_worlds));
+
+	btParallelFor(0,m_order.size(),1,WorldLoop(this,timeStep));
+
+	int numSubSteps = 0;
+	for (int i=0;i<m_worlds.size();i++)
+	{
+		numSubSteps += m_worlds[i].m_numSubSteps;
+	}
+	return numSubSteps;
+}
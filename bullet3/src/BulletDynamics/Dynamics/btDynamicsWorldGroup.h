@@ -0,0 +1,120 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_DYNAMICS_WORLD_GROUP_H
+#define BT_DYNAMICS_WORLD_GROUP_H
+
+#include "LinearMath/btAlignedObjectArray.h"
+
+class btDiscreteDynamicsWorld;
+class btCollisionConfiguration;
+
+///the stepping settings of a world in a btDynamicsWorldGroup, and the statistics of its last step
+struct btWorldGroupInfo
+{
+	btDiscreteDynamicsWorld*	m_world;
+
+	///passed to btDiscreteDynamicsWorld::stepSimulation
+	int			m_maxSubSteps;
+	btScalar	m_fixedTimeStep;
+
+	///the wall clock time in seconds a step of the world may take, 0 for no limit. When the substeps the world owes
+	///would take longer, judging by the cost of its previous substeps, fewer are taken and the rest of the time is
+	///dropped, like stepSimulation drops the time beyond maxSubSteps. At least one substep is always taken.
+	btScalar	m_maxStepTime;
+
+	///written by btDynamicsWorldGroup::stepSimulation
+	int			m_numSubSteps;
+	btScalar	m_stepTime;
+	btScalar	m_subStepTime;
+
+	bool		m_createdByGroup;
+};
+
+///btDynamicsWorldGroup steps many independent btDiscreteDynamicsWorlds in one call, for servers that run a small world
+///per match. The worlds are stepped in parallel with btParallelFor on the task scheduler that is set, one world per
+///task, so a single pool of threads serves all worlds. Parallel loops inside a world step then run on the thread that
+///steps the world (see btITaskScheduler::parallelFor). The worlds that took longest in the previous step start first.
+///Worlds created with createWorld have their own dispatcher, broadphase and solver, and share the collision
+///configuration of the group, so its pool allocators serve all worlds. Size the pools for all worlds with
+///btDefaultCollisionConstructionInfo, when they run out the dispatcher falls back to btAlignedAlloc.
+///Collision shapes can be shared by the worlds, as long as they aren't changed while the group steps. Shapes that
+///update themselves during collision detection, like btGImpactMeshShape after postUpdate, can't be shared.
+///Motion states, tick callbacks, actions and the global contact callbacks are called from the thread that steps
+///their world, so the global callbacks have to be thread safe. Build with BT_THREADSAFE to step in parallel.
+class btDynamicsWorldGroup
+{
+	struct WorldLoop;
+
+	btCollisionConfiguration*	m_collisionConfiguration;
+
+	btAlignedObjectArray<btWorldGroupInfo>	m_worlds;
+
+	//the worlds in the order they are handed to the threads, longest step first
+	btAlignedObjectArray<int>	m_order;
+
+	void	stepWorld(btWorldGroupInfo& info, btScalar timeStep);
+
+public:
+
+	btDynamicsWorldGroup(btCollisionConfiguration* collisionConfiguration);
+
+	virtual ~btDynamicsWorldGroup();
+
+	///creates a world with its own btCollisionDispatcher, btDbvtBroadphase and btSequentialImpulseConstraintSolver,
+	///which is deleted by destroyWorld or the group
+	btDiscreteDynamicsWorld*	createWorld(int maxSubSteps=1, btScalar fixedTimeStep=btScalar(1.)/btScalar(60.));
+
+	void	destroyWorld(btDiscreteDynamicsWorld* world);
+
+	///adds a world created by the caller, which stays owned by the caller
+	void	addWorld(btDiscreteDynamicsWorld* world, int maxSubSteps=1, btScalar fixedTimeStep=btScalar(1.)/btScalar(60.));
+
+	///removes a world without deleting it. The order of the other worlds can change.
+	void	removeWorld(btDiscreteDynamicsWorld* world);
+
+	///returns -1 if the world isn't in the group
+	int		findWorld(const btDiscreteDynamicsWorld* world) const;
+
+	int		getNumWorlds() const
+	{
+		return m_worlds.size();
+	}
+
+	btDiscreteDynamicsWorld*	getWorld(int index)
+	{
+		return m_worlds[index].m_world;
+	}
+
+	btWorldGroupInfo&	getWorldInfo(int index)
+	{
+		return m_worlds[index];
+	}
+
+	const btWorldGroupInfo&	getWorldInfo(int index) const
+	{
+		return m_worlds[index];
+	}
+
+	btCollisionConfiguration*	getCollisionConfiguration()
+	{
+		return m_collisionConfiguration;
+	}
+
+	///steps every world by timeStep with its own settings, returns the number of substeps taken by all worlds
+	int		stepSimulation(btScalar timeStep);
+};
+
+#endif //BT_DYNAMICS_WORLD_GROUP_H
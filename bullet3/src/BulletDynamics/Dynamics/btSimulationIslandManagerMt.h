@@ -65,6 +65,7 @@ protected:
     btAlignedObjectArray<Island*> m_activeIslands;  // islands actively in use
     btAlignedObjectArray<Island*> m_freeIslands;  // islands ready to be reused
     btAlignedObjectArray<Island*> m_lookupIslandFromId;  // big lookup table to map islandId to Island pointer
+    btAlignedObjectArray<btPersistentManifold*> m_canonicalManifolds;  // manifolds in canonical order, when islands are not split (BT_DETERMINISTIC)
     Island* m_batchIsland;
     int m_minimumSolverBatchSize;
     int m_batchIslandMinBodyCount;
@@ -0,0 +1,737 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btWorldSnapshot.h"
+#include "btDiscreteDynamicsWorld.h"
+#include "btRigidBody.h"
+#include "BulletCollision/BroadphaseCollision/btDispatcher.h"
+#include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "BulletCollision/CollisionShapes/btCollisionShape.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
+#include "BulletDynamics/ConstraintSolver/btTypedConstraint.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btQuickprof.h"
+#include <string.h>
+
+//The image is an array of 32 bit words: a header, a fixed size record per collision object and per constraint,
+//then a record per manifold that has contact points: the broadphase ids of its bodies, the number of points and the points.
+static const int btSnapshotScalarWords = int(sizeof(btScalar)/sizeof(unsigned int));
+static const int btSnapshotHeaderWords = 5+btSnapshotScalarWords;
+static const int btSnapshotObjectWords = 1+44*btSnapshotScalarWords;
+static const int btSnapshotConstraintWords = 1+btSnapshotScalarWords;
+static const int btSnapshotManifoldWords = 3;
+static const int btSnapshotPointWords = 6+34*btSnapshotScalarWords;
+
+struct btSnapshotWriter
+{
+	unsigned int* m_ptr;
+
+	void	writeInt(int value)
+	{
+		*m_ptr++ = (unsigned int)value;
+	}
+
+	void	writeScalar(btScalar value)
+	{
+		memcpy(m_ptr, &value, sizeof(btScalar));
+		m_ptr += btSnapshotScalarWords;
+	}
+
+	void	writeVector3(const btVector3& v)
+	{
+		writeScalar(v.getX());
+		writeScalar(v.getY());
+		writeScalar(v.getZ());
+	}
+
+	void	writeTransform(const btTransform& t)
+	{
+		writeVector3(t.getBasis()[0]);
+		writeVector3(t.getBasis()[1]);
+		writeVector3(t.getBasis()[2]);
+		writeVector3(t.getOrigin());
+	}
+};
+
+struct btSnapshotReader
+{
+	const unsigned int* m_ptr;
+
+	int		readInt()
+	{
+		return int(*m_ptr++);
+	}
+
+	btScalar	readScalar()
+	{
+		btScalar value;
+		memcpy(&value, m_ptr, sizeof(btScalar));
+		m_ptr += btSnapshotScalarWords;
+		return value;
+	}
+
+	btVector3	readVector3()
+	{
+		const btScalar x = readScalar();
+		const btScalar y = readScalar();
+		const btScalar z = readScalar();
+		return btVector3(x, y, z);
+	}
+
+	btTransform	readTransform()
+	{
+		const btVector3 row0 = readVector3();
+		const btVector3 row1 = readVector3();
+		const btVector3 row2 = readVector3();
+		const btVector3 origin = readVector3();
+		return btTransform(btMatrix3x3(row0.getX(), row0.getY(), row0.getZ(),
+			row1.getX(), row1.getY(), row1.getZ(),
+			row2.getX(), row2.getY(), row2.getZ()), origin);
+	}
+};
+
+static int btGetSnapshotUid(const btCollisionObject* colObj)
+{
+	return colObj->getBroadphaseHandle() ? colObj->getBroadphaseHandle()->getUid() : -1;
+}
+
+static unsigned int btGetSnapshotPairHash(unsigned int uid0, unsigned int uid1)
+{
+	unsigned int key = uid0 | (uid1 << 16);
+	key += ~(key << 15);
+	key ^=  (key >> 10);
+	key +=  (key << 3);
+	key ^=  (key >> 6);
+	key += ~(key << 11);
+	key ^=  (key >> 16);
+	return key;
+}
+
+static btSequentialImpulseConstraintSolver* btGetSnapshotSolver(btDiscreteDynamicsWorld* world)
+{
+	btConstraintSolver* solver = world->getConstraintSolver();
+	if (solver && (solver->getSolverType() & (BT_SEQUENTIAL_IMPULSE_SOLVER | BT_MLCP_SOLVER | BT_NNCG_SOLVER)))
+	{
+		return static_cast<btSequentialImpulseConstraintSolver*>(solver);
+	}
+	return 0;
+}
+
+//the part ids and indices come first, findManifoldRecord compares them
+static void btWriteSnapshotPoint(btSnapshotWriter& writer, const btManifoldPoint& pt)
+{
+	writer.writeInt(pt.m_partId0);
+	writer.writeInt(pt.m_partId1);
+	writer.writeInt(pt.m_index0);
+	writer.writeInt(pt.m_index1);
+	writer.writeInt(pt.m_contactPointFlags);
+	writer.writeInt(pt.m_lifeTime);
+	writer.writeVector3(pt.m_localPointA);
+	writer.writeVector3(pt.m_localPointB);
+	writer.writeVector3(pt.m_positionWorldOnB);
+	writer.writeVector3(pt.m_positionWorldOnA);
+	writer.writeVector3(pt.m_normalWorldOnB);
+	writer.writeScalar(pt.m_distance1);
+	writer.writeScalar(pt.m_combinedFriction);
+	writer.writeScalar(pt.m_combinedRollingFriction);
+	writer.writeScalar(pt.m_combinedSpinningFriction);
+	writer.writeScalar(pt.m_combinedRestitution);
+	writer.writeScalar(pt.m_appliedImpulse);
+	writer.writeScalar(pt.m_appliedImpulseLateral1);
+	writer.writeScalar(pt.m_appliedImpulseLateral2);
+	writer.writeScalar(pt.m_contactMotion1);
+	writer.writeScalar(pt.m_contactMotion2);
+	writer.writeScalar(pt.m_contactCFM);
+	writer.writeScalar(pt.m_contactERP);
+	writer.writeScalar(pt.m_frictionCFM);
+	writer.writeVector3(pt.m_lateralFrictionDir1);
+	writer.writeVector3(pt.m_lateralFrictionDir2);
+}
+
+static void btReadSnapshotPoint(btSnapshotReader& reader, btManifoldPoint& pt)
+{
+	pt.m_partId0 = reader.readInt();
+	pt.m_partId1 = reader.readInt();
+	pt.m_index0 = reader.readInt();
+	pt.m_index1 = reader.readInt();
+	pt.m_contactPointFlags = reader.readInt();
+	pt.m_lifeTime = reader.readInt();
+	pt.m_localPointA = reader.readVector3();
+	pt.m_localPointB = reader.readVector3();
+	pt.m_positionWorldOnB = reader.readVector3();
+	pt.m_positionWorldOnA = reader.readVector3();
+	pt.m_normalWorldOnB = reader.readVector3();
+	pt.m_distance1 = reader.readScalar();
+	pt.m_combinedFriction = reader.readScalar();
+	pt.m_combinedRollingFriction = reader.readScalar();
+	pt.m_combinedSpinningFriction = reader.readScalar();
+	pt.m_combinedRestitution = reader.readScalar();
+	pt.m_appliedImpulse = reader.readScalar();
+	pt.m_appliedImpulseLateral1 = reader.readScalar();
+	pt.m_appliedImpulseLateral2 = reader.readScalar();
+	pt.m_contactMotion1 = reader.readScalar();
+	pt.m_contactMotion2 = reader.readScalar();
+	pt.m_contactCFM = reader.readScalar();
+	pt.m_contactERP = reader.readScalar();
+	pt.m_frictionCFM = reader.readScalar();
+	pt.m_lateralFrictionDir1 = reader.readVector3();
+	pt.m_lateralFrictionDir2 = reader.readVector3();
+	pt.m_userPersistentData = 0;
+}
+
+
+btWorldSnapshot::btWorldSnapshot()
+{
+}
+
+void	btWorldSnapshot::capture(btDiscreteDynamicsWorld* world)
+{
+	BT_PROFILE("captureSnapshot");
+
+	const btCollisionObjectArray& collisionObjects = world->getCollisionObjectArray();
+	btDispatcher* dispatcher = world->getDispatcher();
+	const int numObjects = collisionObjects.size();
+	const int numConstraints = world->getNumConstraints();
+	const int numDispatcherManifolds = dispatcher->getNumManifolds();
+	int numManifolds = 0;
+	int numPoints = 0;
+	int i;
+	for (i=0;i<numDispatcherManifolds;i++)
+	{
+		const int numContacts = dispatcher->getManifoldByIndexInternal(i)->getNumContacts();
+		if (numContacts)
+		{
+			numManifolds++;
+			numPoints += numContacts;
+		}
+	}
+
+	m_data.resize(btSnapshotHeaderWords+numObjects*btSnapshotObjectWords+numConstraints*btSnapshotConstraintWords+
+		numManifolds*btSnapshotManifoldWords+numPoints*btSnapshotPointWords);
+	btSnapshotWriter writer;
+	writer.m_ptr = &m_data[0];
+
+	btSequentialImpulseConstraintSolver* solver = btGetSnapshotSolver(world);
+	writer.writeInt(int(sizeof(btScalar)));
+	writer.writeInt(numObjects);
+	writer.writeInt(numConstraints);
+	writer.writeInt(numManifolds);
+	writer.writeInt(solver ? int(solver->getRandSeed()) : 0);
+	writer.writeScalar(world->getLocalTime());
+
+	for (i=0;i<numObjects;i++)
+	{
+		const btCollisionObject* colObj = collisionObjects[i];
+		const btRigidBody* body = btRigidBody::upcast(colObj);
+		writer.writeInt(colObj->getActivationState());
+		writer.writeTransform(colObj->getWorldTransform());
+		writer.writeTransform(colObj->getInterpolationWorldTransform());
+		writer.writeVector3(colObj->getInterpolationLinearVelocity());
+		writer.writeVector3(colObj->getInterpolationAngularVelocity());
+		writer.writeVector3(body ? body->getLinearVelocity() : btVector3(0,0,0));
+		writer.writeVector3(body ? body->getAngularVelocity() : btVector3(0,0,0));
+		writer.writeScalar(colObj->getDeactivationTime());
+		writer.writeScalar(colObj->getHitFraction());
+		//the bounds the broadphase found the current pairs with, the transform moved since
+		const btBroadphaseProxy* proxy = colObj->getBroadphaseHandle();
+		writer.writeVector3(proxy ? proxy->m_aabbMin : btVector3(0,0,0));
+		writer.writeVector3(proxy ? proxy->m_aabbMax : btVector3(0,0,0));
+	}
+
+	for (i=0;i<numConstraints;i++)
+	{
+		btTypedConstraint* constraint = world->getConstraint(i);
+		writer.writeInt(constraint->isEnabled());
+		writer.writeScalar(constraint->internalGetAppliedImpulse());
+	}
+
+	for (i=0;i<numDispatcherManifolds;i++)
+	{
+		const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+		const int numContacts = manifold->getNumContacts();
+		if (numContacts)
+		{
+			writer.writeInt(btGetSnapshotUid(manifold->getBody0()));
+			writer.writeInt(btGetSnapshotUid(manifold->getBody1()));
+			writer.writeInt(numContacts);
+			for (int j=0;j<numContacts;j++)
+			{
+				btWriteSnapshotPoint(writer, manifold->getContactPoint(j));
+			}
+		}
+	}
+	btAssert(writer.m_ptr == &m_data[0]+m_data.size());
+}
+
+bool	btWorldSnapshot::restore(btDiscreteDynamicsWorld* world)
+{
+	BT_PROFILE("restoreSnapshot");
+
+	btCollisionObjectArray& collisionObjects = world->getCollisionObjectArray();
+	btBroadphaseInterface* broadphase = world->getBroadphase();
+	btDispatcher* dispatcher = world->getDispatcher();
+	const int numObjects = collisionObjects.size();
+	const int numConstraints = world->getNumConstraints();
+	if (m_data.size() < btSnapshotHeaderWords+numObjects*btSnapshotObjectWords+numConstraints*btSnapshotConstraintWords)
+	{
+		return false;
+	}
+	btSnapshotReader reader;
+	reader.m_ptr = &m_data[0];
+	if (reader.readInt() != int(sizeof(btScalar)) || reader.readInt() != numObjects || reader.readInt() != numConstraints)
+	{
+		return false;
+	}
+	const int numManifolds = reader.readInt();
+	const unsigned int seed = (unsigned int)reader.readInt();
+	const btScalar localTime = reader.readScalar();
+
+	//the offsets of the manifold records, grouped by the ids of their bodies
+	int i;
+	int offset = btSnapshotHeaderWords+numObjects*btSnapshotObjectWords+numConstraints*btSnapshotConstraintWords;
+	//every manifold record holds at least one point, which bounds the count before anything is allocated for it
+	if (numManifolds < 0 || numManifolds > (m_data.size()-offset)/(btSnapshotManifoldWords+btSnapshotPointWords))
+	{
+		return false;
+	}
+	int tableSize = 16;
+	while (tableSize < 2*numManifolds)
+	{
+		tableSize *= 2;
+	}
+	m_manifoldTable.resize(0);
+	m_manifoldTable.resize(tableSize, -1);
+	m_manifoldOffsets.resize(numManifolds);
+	m_nextManifolds.resize(numManifolds);
+	for (i=0;i<numManifolds;i++)
+	{
+		if (offset+btSnapshotManifoldWords > m_data.size())
+		{
+			return false;
+		}
+		const int numContacts = int(m_data[offset+2]);
+		if (numContacts <= 0 || numContacts > MANIFOLD_CACHE_SIZE ||
+			numContacts > (m_data.size()-offset-btSnapshotManifoldWords)/btSnapshotPointWords)
+		{
+			return false;
+		}
+		m_manifoldOffsets[i] = offset;
+		m_nextManifolds[i] = -1;
+		unsigned int slot = btGetSnapshotPairHash(m_data[offset], m_data[offset+1]);
+		for (;;slot++)
+		{
+			int& head = m_manifoldTable[slot & (tableSize-1)];
+			if (head < 0 || (m_data[m_manifoldOffsets[head]] == m_data[offset] && m_data[m_manifoldOffsets[head]+1] == m_data[offset+1]))
+			{
+				m_nextManifolds[i] = head;
+				head = i;
+				break;
+			}
+		}
+		offset += btSnapshotManifoldWords+numContacts*btSnapshotPointWords;
+	}
+	if (offset != m_data.size())
+	{
+		return false;
+	}
+
+	for (i=0;i<numObjects;i++)
+	{
+		btCollisionObject* colObj = collisionObjects[i];
+		const int activationState = reader.readInt();
+		colObj->setWorldTransform(reader.readTransform());
+		colObj->setInterpolationWorldTransform(reader.readTransform());
+		colObj->setInterpolationLinearVelocity(reader.readVector3());
+		colObj->setInterpolationAngularVelocity(reader.readVector3());
+		const btVector3 linearVelocity = reader.readVector3();
+		const btVector3 angularVelocity = reader.readVector3();
+		if (btRigidBody* body = btRigidBody::upcast(colObj))
+		{
+			body->setLinearVelocity(linearVelocity);
+			body->setAngularVelocity(angularVelocity);
+			body->clearForces();
+			body->updateInertiaTensor();
+		}
+		colObj->forceActivationState(activationState);
+		colObj->setDeactivationTime(reader.readScalar());
+		colObj->setHitFraction(reader.readScalar());
+		const btVector3 aabbMin = reader.readVector3();
+		const btVector3 aabbMax = reader.readVector3();
+		if (btBroadphaseProxy* proxy = colObj->getBroadphaseHandle())
+		{
+			broadphase->setAabb(proxy, aabbMin, aabbMax, dispatcher);
+		}
+	}
+
+	for (i=0;i<numConstraints;i++)
+	{
+		btTypedConstraint* constraint = world->getConstraint(i);
+		constraint->setEnabled(reader.readInt() != 0);
+		constraint->internalSetAppliedImpulse(reader.readScalar());
+	}
+
+	if (btSequentialImpulseConstraintSolver* solver = btGetSnapshotSolver(world))
+	{
+		solver->setRandSeed(seed);
+	}
+	world->setLocalTime(localTime);
+
+	//a pair that the broadphase doesn't find from the restored bounds, see btWorldSnapshot, or that has no collision
+	//algorithm yet gets its manifolds from the narrowphase of that pair
+	if (!restoreManifolds(world))
+	{
+		addMissingPairs(world);
+		if (!restoreManifolds(world))
+		{
+			restoreEmptyChildManifolds();
+		}
+	}
+
+	for (i=0;i<numObjects;i++)
+	{
+		if (btRigidBody* body = btRigidBody::upcast(collisionObjects[i]))
+		{
+			world->synchronizeSingleMotionState(body);
+		}
+	}
+	return true;
+}
+
+//pairs with a compound have a manifold per child, the points of the manifold have the index of that child
+static bool btHasChildManifolds(const btPersistentManifold* manifold)
+{
+	return manifold->getBody0()->getCollisionShape()->isCompound() || manifold->getBody1()->getCollisionShape()->isCompound();
+}
+
+int		btWorldSnapshot::findFirstManifoldRecord(int uid0, int uid1) const
+{
+	const int tableSize = m_manifoldTable.size();
+	for (unsigned int slot=btGetSnapshotPairHash(uid0, uid1);;slot++)
+	{
+		const int head = m_manifoldTable[slot & (tableSize-1)];
+		if (head < 0 || (int(m_data[m_manifoldOffsets[head]]) == uid0 && int(m_data[m_manifoldOffsets[head]+1]) == uid1))
+		{
+			return head;
+		}
+	}
+}
+
+int		btWorldSnapshot::findManifoldRecord(const btPersistentManifold* manifold) const
+{
+	const int head = findFirstManifoldRecord(btGetSnapshotUid(manifold->getBody0()), btGetSnapshotUid(manifold->getBody1()));
+	if (head < 0)
+	{
+		return -1;
+	}
+	if (!btHasChildManifolds(manifold))
+	{
+		return m_restoredManifolds[head] ? -1 : head;
+	}
+
+	//a manifold without points can belong to any child, see restoreManifolds
+	if (manifold->getNumContacts() == 0)
+	{
+		return -1;
+	}
+	const btManifoldPoint& pt = manifold->getContactPoint(0);
+	const bool compound0 = manifold->getBody0()->getCollisionShape()->isCompound();
+	const bool compound1 = manifold->getBody1()->getCollisionShape()->isCompound();
+	for (int record=head;record>=0;record=m_nextManifolds[record])
+	{
+		if (!m_restoredManifolds[record])
+		{
+			const unsigned int* ids = &m_data[m_manifoldOffsets[record]+btSnapshotManifoldWords];
+			if ((!compound0 || int(ids[2]) == pt.m_index0) && (!compound1 || int(ids[3]) == pt.m_index1))
+			{
+				return record;
+			}
+		}
+	}
+	return -1;
+}
+
+void	btWorldSnapshot::restoreManifold(btPersistentManifold* manifold, int record)
+{
+	m_restoredManifolds[record] = 1;
+	btSnapshotReader reader;
+	reader.m_ptr = &m_data[m_manifoldOffsets[record]+2];
+	const int numContacts = reader.readInt();
+	manifold->setNumContacts(numContacts);
+	for (int j=0;j<numContacts;j++)
+	{
+		btReadSnapshotPoint(reader, manifold->getContactPoint(j));
+	}
+}
+
+bool	btWorldSnapshot::restoreManifolds(btDiscreteDynamicsWorld* world)
+{
+	int i;
+	m_restoredManifolds.resize(0);
+	m_restoredManifolds.resize(m_manifoldOffsets.size(), 0);
+	m_emptyManifolds.resize(0);
+	btDispatcher* dispatcher = world->getDispatcher();
+	const int numDispatcherManifolds = dispatcher->getNumManifolds();
+	for (i=0;i<numDispatcherManifolds;i++)
+	{
+		btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+		const int record = findManifoldRecord(manifold);
+		if (record < 0 && btHasChildManifolds(manifold) && manifold->getNumContacts() == 0)
+		{
+			m_emptyManifolds.push_back(manifold);
+		}
+		for (int j=0;j<manifold->getNumContacts();j++)
+		{
+			manifold->clearUserCache(manifold->getContactPoint(j));
+		}
+		manifold->setNumContacts(0);
+		if (record >= 0)
+		{
+			restoreManifold(manifold, record);
+		}
+	}
+
+	for (i=0;i<m_restoredManifolds.size();i++)
+	{
+		if (!m_restoredManifolds[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//A child manifold that has no points at the restored transforms can't be told apart from the other children of its pair.
+//Records whose points don't survive the refresh of the next step are dropped, the remaining record of a pair goes to
+//the remaining manifold of that pair.
+void	btWorldSnapshot::restoreEmptyChildManifolds()
+{
+	for (int i=0;i<m_emptyManifolds.size();i++)
+	{
+		btPersistentManifold* manifold = m_emptyManifolds[i];
+		int record = -1;
+		int numRecords = 0;
+		for (int r=findFirstManifoldRecord(btGetSnapshotUid(manifold->getBody0()), btGetSnapshotUid(manifold->getBody1()));r>=0;r=m_nextManifolds[r])
+		{
+			if (!m_restoredManifolds[r])
+			{
+				restoreManifold(manifold, r);
+				manifold->refreshContactPoints(manifold->getBody0()->getWorldTransform(), manifold->getBody1()->getWorldTransform());
+				if (manifold->getNumContacts())
+				{
+					record = r;
+					numRecords++;
+					m_restoredManifolds[r] = 0;
+				}
+				manifold->setNumContacts(0);
+			}
+		}
+		int numEmptyManifolds = 0;
+		for (int j=0;j<m_emptyManifolds.size();j++)
+		{
+			numEmptyManifolds += (m_emptyManifolds[j]->getBody0() == manifold->getBody0() && m_emptyManifolds[j]->getBody1() == manifold->getBody1());
+		}
+		if (numRecords == 1 && numEmptyManifolds == 1)
+		{
+			restoreManifold(manifold, record);
+		}
+	}
+}
+
+void	btWorldSnapshot::addMissingPairs(btDiscreteDynamicsWorld* world)
+{
+	btCollisionObjectArray& collisionObjects = world->getCollisionObjectArray();
+	btHashMap<btHashInt,btBroadphaseProxy*> proxies;
+	int i;
+	for (i=0;i<collisionObjects.size();i++)
+	{
+		if (btBroadphaseProxy* proxy = collisionObjects[i]->getBroadphaseHandle())
+		{
+			proxies.insert(btHashInt(proxy->getUid()), proxy);
+		}
+	}
+
+	btOverlappingPairCache* pairCache = world->getPairCache();
+	btCollisionDispatcher* dispatcher = static_cast<btCollisionDispatcher*>(world->getDispatcher());
+	for (i=0;i<m_restoredManifolds.size();i++)
+	{
+		if (m_restoredManifolds[i])
+		{
+			continue;
+		}
+		btBroadphaseProxy** proxy0 = proxies.find(btHashInt(int(m_data[m_manifoldOffsets[i]])));
+		btBroadphaseProxy** proxy1 = proxies.find(btHashInt(int(m_data[m_manifoldOffsets[i]+1])));
+		if (!proxy0 || !proxy1)
+		{
+			continue;
+		}
+		btBroadphasePair* pair = pairCache->findPair(*proxy0, *proxy1);
+		if (!pair)
+		{
+			pair = pairCache->addOverlappingPair(*proxy0, *proxy1);
+		}
+		if (pair)
+		{
+			//creates the collision algorithm and its manifolds, their contacts are replaced by the snapshot
+			dispatcher->getNearCallback()(*pair, *dispatcher, world->getDispatchInfo());
+		}
+	}
+}
+
+bool	btWorldSnapshot::setData(const void* data, int size)
+{
+	if (size < btSnapshotHeaderWords*int(sizeof(unsigned int)) || (size % sizeof(unsigned int)))
+	{
+		return false;
+	}
+	m_data.resize(size/sizeof(unsigned int));
+	memcpy(&m_data[0], data, size);
+	return m_data[0] == sizeof(btScalar);
+}
+
+static void btAppendDeltaCount(btAlignedObjectArray<unsigned char>& delta, unsigned int count)
+{
+	while (count >= 0x80)
+	{
+		delta.push_back((unsigned char)(count | 0x80));
+		count >>= 7;
+	}
+	delta.push_back((unsigned char)count);
+}
+
+static bool btReadDeltaCount(const unsigned char* bytes, int size, int& pos, unsigned int& count)
+{
+	count = 0;
+	for (int shift=0;shift<32;shift+=7)
+	{
+		if (pos >= size)
+		{
+			return false;
+		}
+		const unsigned char byte = bytes[pos++];
+		count |= (unsigned int)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//The delta is the number of words of the snapshot, followed by blocks of a number of words that are the same as in the
+//base, a number of changed words and the changed words xor the base, counts are stored 7 bits per byte. The xor of
+//scalars that moved a little has leading zero bytes: the changed words are stored in groups of four, a byte with the
+//number of bytes of each word minus one, then the low bytes of the words. Words past the end of the base xor zero.
+void	btWorldSnapshot::computeDelta(const btWorldSnapshot& base, btAlignedObjectArray<unsigned char>& delta) const
+{
+	const int numWords = m_data.size();
+	const int numBaseWords = base.m_data.size();
+	delta.resize(0);
+	delta.reserve(numWords*int(sizeof(unsigned int))+numWords/4+16);
+	btAppendDeltaCount(delta, (unsigned int)numWords);
+	int i = 0;
+	while (i < numWords)
+	{
+		const int sameBegin = i;
+		while (i < numWords && m_data[i] == (i < numBaseWords ? base.m_data[i] : 0))
+		{
+			i++;
+		}
+		//single unchanged words between changed ones are cheaper to send as changed
+		const int changedBegin = i;
+		while (i < numWords && (m_data[i] != (i < numBaseWords ? base.m_data[i] : 0) ||
+			(i+1 < numWords && m_data[i+1] != (i+1 < numBaseWords ? base.m_data[i+1] : 0))))
+		{
+			i++;
+		}
+		btAppendDeltaCount(delta, (unsigned int)(changedBegin-sameBegin));
+		btAppendDeltaCount(delta, (unsigned int)(i-changedBegin));
+		for (int j=changedBegin;j<i;j+=4)
+		{
+			const int control = delta.size();
+			delta.push_back(0);
+			for (int k=0;k<4 && j+k<i;k++)
+			{
+				const unsigned int word = m_data[j+k] ^ (j+k < numBaseWords ? base.m_data[j+k] : 0);
+				int numBytes = 1;
+				while (numBytes < 4 && (word >> (8*numBytes)))
+				{
+					numBytes++;
+				}
+				delta[control] |= (unsigned char)((numBytes-1) << (2*k));
+				for (int b=0;b<numBytes;b++)
+				{
+					delta.push_back((unsigned char)(word >> (8*b)));
+				}
+			}
+		}
+	}
+}
+
+bool	btWorldSnapshot::applyDelta(const btWorldSnapshot& base, const void* delta, int size)
+{
+	btAssert(&base != this);
+	const unsigned char* bytes = static_cast<const unsigned char*>(delta);
+	const int numBaseWords = base.m_data.size();
+	int pos = 0;
+	unsigned int numWords;
+	//a run of zero words past the end of the base takes a few bytes, the bound keeps a broken delta from allocating gigabytes
+	if (!btReadDeltaCount(bytes, size, pos, numWords) || numWords < (unsigned int)btSnapshotHeaderWords || numWords > (unsigned int)numBaseWords+(unsigned int)size*64)
+	{
+		return false;
+	}
+	m_data.resize(int(numWords));
+	int i = 0;
+	while (i < int(numWords))
+	{
+		unsigned int counts[2];
+		if (!btReadDeltaCount(bytes, size, pos, counts[0]) || !btReadDeltaCount(bytes, size, pos, counts[1]))
+		{
+			return false;
+		}
+		if ((counts[0] | counts[1]) == 0 || counts[0] > numWords-i || counts[1] > numWords-i-counts[0])
+		{
+			return false;
+		}
+		for (const int sameEnd=i+int(counts[0]);i<sameEnd;i++)
+		{
+			m_data[i] = i < numBaseWords ? base.m_data[i] : 0;
+		}
+		for (const int changedEnd=i+int(counts[1]);i<changedEnd;)
+		{
+			if (pos >= size)
+			{
+				return false;
+			}
+			const unsigned char control = bytes[pos++];
+			for (int k=0;k<4 && i<changedEnd;k++,i++)
+			{
+				const int numBytes = 1+((control >> (2*k)) & 3);
+				if (pos+numBytes > size)
+				{
+					return false;
+				}
+				unsigned int word = 0;
+				for (int b=0;b<numBytes;b++)
+				{
+					word |= (unsigned int)bytes[pos++] << (8*b);
+				}
+				m_data[i] = word ^ (i < numBaseWords ? base.m_data[i] : 0);
+			}
+		}
+	}
+	return pos == size;
+}
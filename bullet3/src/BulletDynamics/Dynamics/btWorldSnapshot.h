@@ -0,0 +1,97 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_WORLD_SNAPSHOT_H
+#define BT_WORLD_SNAPSHOT_H
+
+#include "LinearMath/btAlignedObjectArray.h"
+
+class btDiscreteDynamicsWorld;
+class btPersistentManifold;
+
+///btWorldSnapshot captures the dynamic state of a btDiscreteDynamicsWorld into a compact binary image, and restores it,
+///for rollback networking that rewinds the world several times per frame. The image holds the transforms, velocities and
+///activation states of the collision objects, the contact points of the manifolds with their applied impulses (the warm
+///starting data of the solver), the enabled state and applied impulse of the constraints, the random seed of a
+///btSequentialImpulseConstraintSolver and the time accumulated by stepSimulation.
+///The world has to contain the same objects and constraints in the same order as when the snapshot was captured, only
+///their state is restored. Forces are not part of the snapshot, capture and restore between steps, after the world
+///cleared them. Kinematic bodies take their transform from their motion state, which the user has to rewind as well.
+///With BT_DETERMINISTIC, stepping the restored world gives the same bits as stepping the world that was captured, when
+///the broadphase finds its pairs from the bounding boxes alone, like btAxisSweep3. The pairs of btDbvtBroadphase also
+///depend on the enlarged bounds of its tree and the order of its incremental cleanup, which the snapshot doesn't hold.
+///Compound shapes have a manifold per child, a child manifold without contacts at the restored transforms can't always
+///be told apart from the other children of its pair, its points are then dropped.
+///Consecutive snapshots are similar, computeDelta encodes a snapshot as the difference to an older one for sending.
+class btWorldSnapshot
+{
+	btAlignedObjectArray<unsigned int>	m_data;
+
+	//scratch of restore: the offsets of the manifold records, an open addressing table of the first record of each pair
+	//of bodies, the next record of the same pair and the records that were restored
+	btAlignedObjectArray<int>	m_manifoldOffsets;
+	btAlignedObjectArray<int>	m_manifoldTable;
+	btAlignedObjectArray<int>	m_nextManifolds;
+	btAlignedObjectArray<int>	m_restoredManifolds;
+	btAlignedObjectArray<btPersistentManifold*>	m_emptyManifolds;
+
+	int		findFirstManifoldRecord(int uid0, int uid1) const;
+
+	int		findManifoldRecord(const btPersistentManifold* manifold) const;
+
+	void	restoreManifold(btPersistentManifold* manifold, int record);
+
+	bool	restoreManifolds(btDiscreteDynamicsWorld* world);
+
+	void	restoreEmptyChildManifolds();
+
+	void	addMissingPairs(btDiscreteDynamicsWorld* world);
+
+public:
+
+	btWorldSnapshot();
+
+	void	capture(btDiscreteDynamicsWorld* world);
+
+	///returns false if the snapshot doesn't match the objects and constraints of the world
+	bool	restore(btDiscreteDynamicsWorld* world);
+
+	void	clear()
+	{
+		m_data.resize(0);
+	}
+
+	///size of the binary image in bytes
+	int		getSize() const
+	{
+		return m_data.size()*int(sizeof(unsigned int));
+	}
+
+	const void*	getData() const
+	{
+		return m_data.size() ? &m_data[0] : 0;
+	}
+
+	///sets the binary image of a snapshot of a platform with the same byte order and btScalar precision
+	bool	setData(const void* data, int size);
+
+	///encodes this snapshot as its difference to base into delta, unchanged parts take a few bytes
+	void	computeDelta(const btWorldSnapshot& base, btAlignedObjectArray<unsigned char>& delta) const;
+
+	///sets this snapshot to base with the delta from computeDelta applied. Returns false if the delta is invalid.
+	bool	applyDelta(const btWorldSnapshot& base, const void* delta, int size);
+};
+
+#endif //BT_WORLD_SNAPSHOT_H
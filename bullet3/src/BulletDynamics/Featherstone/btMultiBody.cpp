@@ -343,8 +343,36 @@ void btMultiBody::finalizeMultiDof()
 	m_deltaV.resize(6 + m_dofCount);
 	m_realBuf.resize(6 + m_dofCount + m_dofCount*m_dofCount + 6 + m_dofCount);			//m_dofCount for joint-space vels + m_dofCount^2 for "D" matrices + delta-pos vector (6 base "vels" + joint "vels")
 	m_vectorBuf.resize(2 * m_dofCount);													//two 3-vectors (i.e. one six-vector) for each system dof	("h" matrices)
+	if (m_useRK4)
+		getRK4ScratchBuffer();
 
 	updateLinksDofOffsets();
+
+	//the constraint jacobian of a link only depends on the links between it and the base
+	int num_links = getNumLinks();
+	m_linkPathOffset.resize(num_links + 1);
+	m_linkPath.resize(0);
+	m_linkPathOffset[0] = 0;
+	for (int i = 0; i < num_links; ++i)
+	{
+		const int parent = m_links[i].m_parent;
+		btAssert(parent < i);
+		if (parent >= 0)
+		{
+			for (int j = m_linkPathOffset[parent]; j < m_linkPathOffset[parent+1]; ++j)
+				m_linkPath.push_back(m_linkPath[j]);
+		}
+		m_linkPath.push_back(i);
+		m_linkPathOffset[i+1] = m_linkPath.size();
+	}
+}
+
+btScalar* btMultiBody::getRK4ScratchBuffer()
+{
+	int size = 2*(m_posVarCnt + 7) + 10*(m_dofCount + 6);
+	if (m_rk4Buf.size() < size)
+		m_rk4Buf.resize(size);
+	return &m_rk4Buf[0];
 }
 	
 int btMultiBody::getParent(int i) const
@@ -665,6 +693,16 @@ btScalar * btMultiBody::getJointTorqueMultiDof(int i)
     return &m_links[i].m_jointTorque[0];
 }
 
+//The scratch arrays are usually shared by all multibodies of a world or solver. They are only grown,
+//so that alternating between multibodies of different sizes doesn't reinitialize the elements every call.
+//The elements are written before they are read, so new ones are left uninitialized.
+template <typename T>
+static SIMD_FORCE_INLINE void btGrowScratch(btAlignedObjectArray<T>& scratch, int size)
+{
+	if (scratch.size() < size)
+		scratch.resizeNoInitialize(size);
+}
+
 inline btMatrix3x3 outerProduct(const btVector3& v0, const btVector3& v1)				//renamed it from vecMulVecTranspose (http://en.wikipedia.org/wiki/Outer_product); maybe it should be moved to btVector3 like dot and cross?
 {
 		btVector3 row0 = btVector3( 
@@ -725,9 +763,9 @@ void btMultiBody::computeAccelerationsArticulatedBodyAlgorithmMultiDof(btScalar
     // Temporary matrices/vectors -- use scratch space from caller
     // so that we don't have to keep reallocating every frame
 
-    scratch_r.resize(2*m_dofCount + 6);				//multidof? ("Y"s use it and it is used to store qdd) => 2 x m_dofCount
-    scratch_v.resize(8*num_links + 6);
-    scratch_m.resize(4*num_links + 4);
+    btGrowScratch(scratch_r, 2*m_dofCount + 6);				//multidof? ("Y"s use it and it is used to store qdd) => 2 x m_dofCount
+    btGrowScratch(scratch_v, 8*num_links + 6);
+    btGrowScratch(scratch_m, 4*num_links + 4);
 
 	//btScalar * r_ptr = &scratch_r[0];
     btScalar * output = &scratch_r[m_dofCount];  // "output" holds the q_double_dot results
@@ -1364,8 +1402,8 @@ void btMultiBody::calcAccelerationDeltasMultiDof(const btScalar *force, btScalar
 
 	
 	int num_links = getNumLinks();	
-    scratch_r.resize(m_dofCount);
-    scratch_v.resize(4*num_links + 4);	    
+    btGrowScratch(scratch_r, m_dofCount);
+    btGrowScratch(scratch_v, 4*num_links + 4);
 
     btScalar * r_ptr = m_dofCount ? &scratch_r[0] : 0;
     btVector3 * v_ptr = &scratch_v[0];
@@ -1663,28 +1701,29 @@ void btMultiBody::fillConstraintJacobianMultiDof(int link,
                                     btAlignedObjectArray<btVector3> &scratch_v,
                                     btAlignedObjectArray<btMatrix3x3> &scratch_m) const
 {
+	//the vectors are rotated from parent to child link by link, so no rotations are stored. scratch_m is unused and stays
+	//in the signature for existing callers.
+	(void)scratch_m;
+
     // temporary space
 	int num_links = getNumLinks();
 	int m_dofCount = getNumDofs();
-    scratch_v.resize(3*num_links + 3);			//(num_links + base) offsets + (num_links + base) normals_lin + (num_links + base) normals_ang
-    scratch_m.resize(num_links + 1);
+    btGrowScratch(scratch_v, 3*num_links + 3);			//(num_links + base) offsets + (num_links + base) normals_lin + (num_links + base) normals_ang
 
     btVector3 * v_ptr = &scratch_v[0];
     btVector3 * p_minus_com_local = v_ptr; v_ptr += num_links + 1;
     btVector3 * n_local_lin = v_ptr; v_ptr += num_links + 1;
 	btVector3 * n_local_ang = v_ptr; v_ptr += num_links + 1;
-    btAssert(v_ptr - &scratch_v[0] == scratch_v.size());
+    btAssert(v_ptr - &scratch_v[0] <= scratch_v.size());
 
-    scratch_r.resize(m_dofCount);
+    btGrowScratch(scratch_r, m_dofCount);
     btScalar * results = m_dofCount > 0 ? &scratch_r[0] : 0;
 
-    btMatrix3x3 * rot_from_world = &scratch_m[0];
-
     const btVector3 p_minus_com_world = contact_point - m_basePos;
 	const btVector3 &normal_lin_world = normal_lin;							//convenience
 	const btVector3 &normal_ang_world = normal_ang;
 
-    rot_from_world[0] = btMatrix3x3(m_baseQuat);    
+    const btMatrix3x3 rot_from_world(m_baseQuat);
     
     // omega coeffients first.
     btVector3 omega_coeffs_world;
@@ -1698,9 +1737,9 @@ void btMultiBody::fillConstraintJacobianMultiDof(int link,
     jac[5] = normal_lin_world[2];
 
 	//create link-local versions of p_minus_com and normal
-	p_minus_com_local[0] = rot_from_world[0] * p_minus_com_world;
-    n_local_lin[0] = rot_from_world[0] * normal_lin_world;
-	n_local_ang[0] = rot_from_world[0] * normal_ang_world;
+	p_minus_com_local[0] = rot_from_world * p_minus_com_world;
+    n_local_lin[0] = rot_from_world * normal_lin_world;
+	n_local_ang[0] = rot_from_world * normal_ang_world;
 
     // Set remaining jac values to zero for now.
     for (int i = 6; i < 6 + m_dofCount; ++i) 
@@ -1711,17 +1750,18 @@ void btMultiBody::fillConstraintJacobianMultiDof(int link,
     // Qdot coefficients, if necessary.
     if (num_links > 0 && link > -1) {
 
-        // TODO: speed this up -- don't calculate for m_links we don't need.
-        // (Also, we are making 3 separate calls to this function, for the normal & the 2 friction directions,
+        // (We are making 3 separate calls to this function, for the normal & the 2 friction directions,
         // which is resulting in repeated work being done...)
 
-        // calculate required normals & positions in the local frames.
-        for (int i = 0; i < num_links; ++i) {
+        // calculate required normals & positions in the local frames,
+        // only for the links between the base and this link, the other jacobian entries are zero.
+        btAssert(m_linkPathOffset.size() == num_links + 1);
+        for (int p = m_linkPathOffset[link]; p < m_linkPathOffset[link+1]; ++p) {
+            const int i = m_linkPath[p];
 
             // transform to local frame
             const int parent = m_links[i].m_parent;
             const btMatrix3x3 mtx(m_links[i].m_cachedRotParentToThis);
-            rot_from_world[i+1] = mtx * rot_from_world[parent+1];
 
             n_local_lin[i+1] = mtx * n_local_lin[parent+1];
 			n_local_ang[i+1] = mtx * n_local_ang[parent+1];
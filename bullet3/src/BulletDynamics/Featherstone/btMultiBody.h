@@ -545,6 +545,9 @@ void addJointTorque(int i, btScalar Q);
 	void finalizeMultiDof();
 
 	void useRK4Integration(bool use) { m_useRK4 = use; }
+	///scratch space for the RK4 integration in btMultiBodyDynamicsWorld, 2*(getNumPosVars()+7) + 10*(getNumDofs()+6) reals.
+	///It is allocated by finalizeMultiDof (or on first use), so that stepping doesn't allocate memory.
+	btScalar* getRK4ScratchBuffer();
 	bool isUsingRK4Integration() const { return m_useRK4; }
 	void useGlobalVelocities(bool use) { m_useGlobalVelocities = use; }
 	bool isUsingGlobalVelocities() const { return m_useGlobalVelocities; }
@@ -677,6 +680,12 @@ private:
     btAlignedObjectArray<btScalar> m_realBuf;
     btAlignedObjectArray<btVector3> m_vectorBuf;
     btAlignedObjectArray<btMatrix3x3> m_matrixBuf;
+	btAlignedObjectArray<btScalar> m_rk4Buf;
+
+	// links on the way from the base to each link, built by finalizeMultiDof:
+	// m_linkPath[m_linkPathOffset[i]] .. m_linkPath[m_linkPathOffset[i+1]-1] is the path to link i, ending with i
+	btAlignedObjectArray<int> m_linkPathOffset;
+	btAlignedObjectArray<int> m_linkPath;
 
 
 	btMatrix3x3 m_cachedInertiaTopLeft;
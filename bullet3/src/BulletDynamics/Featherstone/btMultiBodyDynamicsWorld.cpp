@@ -394,6 +394,18 @@ btMultiBodyDynamicsWorld::~btMultiBodyDynamicsWorld ()
 	delete m_solverMultiBodyIslandCallback;
 }
 
+bool	btMultiBodyDynamicsWorld::isMultiBodySleeping(const btMultiBody* bod)
+{
+	if (bod->getBaseCollider() && bod->getBaseCollider()->getActivationState() == ISLAND_SLEEPING)
+		return true;
+	for (int b=0;b<bod->getNumLinks();b++)
+	{
+		if (bod->getLink(b).m_collider && bod->getLink(b).m_collider->getActivationState()==ISLAND_SLEEPING)
+			return true;
+	}
+	return false;
+}
+
 void	btMultiBodyDynamicsWorld::forwardKinematics()
 {
 
@@ -436,137 +448,112 @@ void	btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 	/// solve all the constraints for this island
 	m_islandManager->buildAndProcessIslands(getCollisionWorld()->getDispatcher(),getCollisionWorld(),m_solverMultiBodyIslandCallback);
 
-#ifndef BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
-	{
-		BT_PROFILE("btMultiBody addForce");
-		for (int i=0;i<this->m_multiBodies.size();i++)
-		{
-			btMultiBody* bod = m_multiBodies[i];
+	integrateMultiBodyVelocities(solverInfo.m_timeStep);
 
-			bool isSleeping = false;
-			
-			if (bod->getBaseCollider() && bod->getBaseCollider()->getActivationState() == ISLAND_SLEEPING)
-			{
-				isSleeping = true;
-			} 
-			for (int b=0;b<bod->getNumLinks();b++)
-			{
-				if (bod->getLink(b).m_collider && bod->getLink(b).m_collider->getActivationState()==ISLAND_SLEEPING)
-					isSleeping = true;
-			} 
+	clearMultiBodyConstraintForces();
 
-			if (!isSleeping)
-			{
-				//useless? they get resized in stepVelocities once again (AND DIFFERENTLY)
-				m_scratch_r.resize(bod->getNumLinks()+1);			//multidof? ("Y"s use it and it is used to store qdd)
-				m_scratch_v.resize(bod->getNumLinks()+1);
-				m_scratch_m.resize(bod->getNumLinks()+1);
+	m_solverMultiBodyIslandCallback->processConstraints();
+	
+	m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
 
-				bod->addBaseForce(m_gravity * bod->getBaseMass());
+	applyMultiBodyConstraintVelocities(solverInfo.m_timeStep);
+}
 
-				for (int j = 0; j < bod->getNumLinks(); ++j) 
-				{
-					bod->addLinkForce(j, m_gravity * bod->getLinkMass(j));
-				}
-			}//if (!isSleeping)
-		}
+void	btMultiBodyDynamicsWorld::integrateMultiBodyVelocities(btScalar timeStep)
+{
+	BT_PROFILE("btMultiBody stepVelocities");
+	for (int i=0;i<this->m_multiBodies.size();i++)
+	{
+		integrateMultiBodyVelocity(m_multiBodies[i], timeStep, m_scratch_r, m_scratch_v, m_scratch_m);
+	}
+}
+
+void	btMultiBodyDynamicsWorld::integrateMultiBodyVelocity(btMultiBody* bod, btScalar timeStep, btAlignedObjectArray<btScalar>& scratch_r, btAlignedObjectArray<btVector3>& scratch_v, btAlignedObjectArray<btMatrix3x3>& scratch_m)
+{
+	if (isMultiBodySleeping(bod))
+		return;
+
+#ifndef BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
+	bod->addBaseForce(m_gravity * bod->getBaseMass());
+
+	for (int j = 0; j < bod->getNumLinks(); ++j) 
+	{
+		bod->addLinkForce(j, m_gravity * bod->getLinkMass(j));
 	}
 #endif //BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
-	
+
+	//the scratch arrays are sized by computeAccelerationsArticulatedBodyAlgorithmMultiDof, and only grow
+	bool doNotUpdatePos = false;
 
 	{
-		BT_PROFILE("btMultiBody stepVelocities");
-		for (int i=0;i<this->m_multiBodies.size();i++)
+		if(!bod->isUsingRK4Integration())
 		{
-			btMultiBody* bod = m_multiBodies[i];
-
-			bool isSleeping = false;
-			
-			if (bod->getBaseCollider() && bod->getBaseCollider()->getActivationState() == ISLAND_SLEEPING)
-			{
-				isSleeping = true;
-			} 
-			for (int b=0;b<bod->getNumLinks();b++)
+			bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(timeStep, scratch_r, scratch_v, scratch_m);
+		}
+		else
+		{						
+			//
+			int numDofs = bod->getNumDofs() + 6;
+			int numPosVars = bod->getNumPosVars() + 7;
+			//convenience, the buffer is owned by the multibody so that RK4 doesn't allocate every step
+			btScalar *pRK4Buf = bod->getRK4ScratchBuffer();
+			btScalar *pMem = pRK4Buf;
+			btScalar *scratch_q0 = pMem; pMem += numPosVars;
+			btScalar *scratch_qx = pMem; pMem += numPosVars;
+			btScalar *scratch_qd0 = pMem; pMem += numDofs;
+			btScalar *scratch_qd1 = pMem; pMem += numDofs;
+			btScalar *scratch_qd2 = pMem; pMem += numDofs;
+			btScalar *scratch_qd3 = pMem; pMem += numDofs;
+			btScalar *scratch_qdd0 = pMem; pMem += numDofs;
+			btScalar *scratch_qdd1 = pMem; pMem += numDofs;
+			btScalar *scratch_qdd2 = pMem; pMem += numDofs;
+			btScalar *scratch_qdd3 = pMem; pMem += numDofs;
+			btScalar *delta_q = pMem; pMem += numDofs;
+			btScalar *delta_qd = pMem; pMem += numDofs;
+			btAssert((pMem - (2*numPosVars + 10*numDofs)) == pRK4Buf);
+
+			/////						
+			//copy q0 to scratch_q0 and qd0 to scratch_qd0
+			scratch_q0[0] = bod->getWorldToBaseRot().x();
+			scratch_q0[1] = bod->getWorldToBaseRot().y();
+			scratch_q0[2] = bod->getWorldToBaseRot().z();
+			scratch_q0[3] = bod->getWorldToBaseRot().w();
+			scratch_q0[4] = bod->getBasePos().x();
+			scratch_q0[5] = bod->getBasePos().y();
+			scratch_q0[6] = bod->getBasePos().z();
+			//
+			for(int link = 0; link < bod->getNumLinks(); ++link)
 			{
-				if (bod->getLink(b).m_collider && bod->getLink(b).m_collider->getActivationState()==ISLAND_SLEEPING)
-					isSleeping = true;
-			} 
-
-			if (!isSleeping)
+				for(int dof = 0; dof < bod->getLink(link).m_posVarCount; ++dof)
+					scratch_q0[7 + bod->getLink(link).m_cfgOffset + dof] = bod->getLink(link).m_jointPos[dof];							
+			}
+			//
+			for(int dof = 0; dof < numDofs; ++dof)								
+				scratch_qd0[dof] = bod->getVelocityVector()[dof];
+			////
+			struct
 			{
-				//useless? they get resized in stepVelocities once again (AND DIFFERENTLY)
-				m_scratch_r.resize(bod->getNumLinks()+1);			//multidof? ("Y"s use it and it is used to store qdd)
-				m_scratch_v.resize(bod->getNumLinks()+1);
-				m_scratch_m.resize(bod->getNumLinks()+1);
-				bool doNotUpdatePos = false;
-
-				{
-					if(!bod->isUsingRK4Integration())
-					{
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(solverInfo.m_timeStep, m_scratch_r, m_scratch_v, m_scratch_m);
-					}
-					else
-					{						
-						//
-						int numDofs = bod->getNumDofs() + 6;
-						int numPosVars = bod->getNumPosVars() + 7;
-						btAlignedObjectArray<btScalar> scratch_r2; scratch_r2.resize(2*numPosVars + 8*numDofs);
-						//convenience
-						btScalar *pMem = &scratch_r2[0];
-						btScalar *scratch_q0 = pMem; pMem += numPosVars;
-						btScalar *scratch_qx = pMem; pMem += numPosVars;
-						btScalar *scratch_qd0 = pMem; pMem += numDofs;
-						btScalar *scratch_qd1 = pMem; pMem += numDofs;
-						btScalar *scratch_qd2 = pMem; pMem += numDofs;
-						btScalar *scratch_qd3 = pMem; pMem += numDofs;
-						btScalar *scratch_qdd0 = pMem; pMem += numDofs;
-						btScalar *scratch_qdd1 = pMem; pMem += numDofs;
-						btScalar *scratch_qdd2 = pMem; pMem += numDofs;
-						btScalar *scratch_qdd3 = pMem; pMem += numDofs;
-						btAssert((pMem - (2*numPosVars + 8*numDofs)) == &scratch_r2[0]);
-
-						/////						
-						//copy q0 to scratch_q0 and qd0 to scratch_qd0
-						scratch_q0[0] = bod->getWorldToBaseRot().x();
-						scratch_q0[1] = bod->getWorldToBaseRot().y();
-						scratch_q0[2] = bod->getWorldToBaseRot().z();
-						scratch_q0[3] = bod->getWorldToBaseRot().w();
-						scratch_q0[4] = bod->getBasePos().x();
-						scratch_q0[5] = bod->getBasePos().y();
-						scratch_q0[6] = bod->getBasePos().z();
-						//
-						for(int link = 0; link < bod->getNumLinks(); ++link)
-						{
-							for(int dof = 0; dof < bod->getLink(link).m_posVarCount; ++dof)
-								scratch_q0[7 + bod->getLink(link).m_cfgOffset + dof] = bod->getLink(link).m_jointPos[dof];							
-						}
-						//
-						for(int dof = 0; dof < numDofs; ++dof)								
-							scratch_qd0[dof] = bod->getVelocityVector()[dof];
-						////
-						struct
-						{
-						    btMultiBody *bod;
+			    btMultiBody *bod;
                             btScalar *scratch_qx, *scratch_q0;
 
-						    void operator()()
-						    {
-						        for(int dof = 0; dof < bod->getNumPosVars() + 7; ++dof)
+			    void operator()()
+			    {
+			        for(int dof = 0; dof < bod->getNumPosVars() + 7; ++dof)
                                     scratch_qx[dof] = scratch_q0[dof];
-						    }
-						} pResetQx = {bod, scratch_qx, scratch_q0};
-						//
-						struct
-						{
-						    void operator()(btScalar dt, const btScalar *pDer, const btScalar *pCurVal, btScalar *pVal, int size)
-						    {
-						        for(int i = 0; i < size; ++i)
+			    }
+			} pResetQx = {bod, scratch_qx, scratch_q0};
+			//
+			struct
+			{
+			    void operator()(btScalar dt, const btScalar *pDer, const btScalar *pCurVal, btScalar *pVal, int size)
+			    {
+			        for(int i = 0; i < size; ++i)
                                     pVal[i] = pCurVal[i] + dt * pDer[i];
-						    }
+			    }
 
-						} pEulerIntegrate;
-						//
-						struct
+			} pEulerIntegrate;
+			//
+			struct
                         {
                             void operator()(btMultiBody *pBody, const btScalar *pData)
                             {
@@ -577,206 +564,156 @@ void	btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 
                             }
                         } pCopyToVelocityVector;
-						//
+			//
                         struct
-						{
-						    void operator()(const btScalar *pSrc, btScalar *pDst, int start, int size)
-						    {
-						        for(int i = 0; i < size; ++i)
+			{
+			    void operator()(const btScalar *pSrc, btScalar *pDst, int start, int size)
+			    {
+			        for(int i = 0; i < size; ++i)
                                     pDst[i] = pSrc[start + i];
-						    }
-						} pCopy;
-						//
-
-						btScalar h = solverInfo.m_timeStep;
-						#define output &m_scratch_r[bod->getNumDofs()]
-						//calc qdd0 from: q0 & qd0	
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., m_scratch_r, m_scratch_v, m_scratch_m);
-						pCopy(output, scratch_qdd0, 0, numDofs);
-						//calc q1 = q0 + h/2 * qd0
-						pResetQx();
-						bod->stepPositionsMultiDof(btScalar(.5)*h, scratch_qx, scratch_qd0);
-						//calc qd1 = qd0 + h/2 * qdd0
-						pEulerIntegrate(btScalar(.5)*h, scratch_qdd0, scratch_qd0, scratch_qd1, numDofs);
-						//
-						//calc qdd1 from: q1 & qd1
-						pCopyToVelocityVector(bod, scratch_qd1);
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., m_scratch_r, m_scratch_v, m_scratch_m);
-						pCopy(output, scratch_qdd1, 0, numDofs);
-						//calc q2 = q0 + h/2 * qd1
-						pResetQx();
-						bod->stepPositionsMultiDof(btScalar(.5)*h, scratch_qx, scratch_qd1);
-						//calc qd2 = qd0 + h/2 * qdd1
-						pEulerIntegrate(btScalar(.5)*h, scratch_qdd1, scratch_qd0, scratch_qd2, numDofs);
-						//
-						//calc qdd2 from: q2 & qd2
-						pCopyToVelocityVector(bod, scratch_qd2);
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., m_scratch_r, m_scratch_v, m_scratch_m);
-						pCopy(output, scratch_qdd2, 0, numDofs);
-						//calc q3 = q0 + h * qd2
-						pResetQx();
-						bod->stepPositionsMultiDof(h, scratch_qx, scratch_qd2);
-						//calc qd3 = qd0 + h * qdd2
-						pEulerIntegrate(h, scratch_qdd2, scratch_qd0, scratch_qd3, numDofs);
-						//
-						//calc qdd3 from: q3 & qd3
-						pCopyToVelocityVector(bod, scratch_qd3);
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., m_scratch_r, m_scratch_v, m_scratch_m);
-						pCopy(output, scratch_qdd3, 0, numDofs);
-
-						//
-						//calc q = q0 + h/6(qd0 + 2*(qd1 + qd2) + qd3)
-						//calc qd = qd0 + h/6(qdd0 + 2*(qdd1 + qdd2) + qdd3)						
-						btAlignedObjectArray<btScalar> delta_q; delta_q.resize(numDofs);
-						btAlignedObjectArray<btScalar> delta_qd; delta_qd.resize(numDofs);
-						for(int i = 0; i < numDofs; ++i)
-						{
-							delta_q[i] = h/btScalar(6.)*(scratch_qd0[i] + 2*scratch_qd1[i] + 2*scratch_qd2[i] + scratch_qd3[i]);
-							delta_qd[i] = h/btScalar(6.)*(scratch_qdd0[i] + 2*scratch_qdd1[i] + 2*scratch_qdd2[i] + scratch_qdd3[i]);							
-							//delta_q[i] = h*scratch_qd0[i];
-							//delta_qd[i] = h*scratch_qdd0[i];
-						}
-						//
-						pCopyToVelocityVector(bod, scratch_qd0);
-						bod->applyDeltaVeeMultiDof(&delta_qd[0], 1);						
-						//
-						if(!doNotUpdatePos)
-						{
-							btScalar *pRealBuf = const_cast<btScalar *>(bod->getVelocityVector());
-							pRealBuf += 6 + bod->getNumDofs() + bod->getNumDofs()*bod->getNumDofs();
-
-							for(int i = 0; i < numDofs; ++i)
-								pRealBuf[i] = delta_q[i];
-
-							//bod->stepPositionsMultiDof(1, 0, &delta_q[0]);
-							bod->setPosUpdated(true);							
-						}
-
-						//ugly hack which resets the cached data to t0 (needed for constraint solver)
-						{
-							for(int link = 0; link < bod->getNumLinks(); ++link)
-								bod->getLink(link).updateCacheMultiDof();
-							bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0, m_scratch_r, m_scratch_v, m_scratch_m);
-						}
-						
-					}
-				}
-				
-#ifndef BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
-				bod->clearForcesAndTorques();
-#endif //BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
-			}//if (!isSleeping)
-		}
-	}
-
-	clearMultiBodyConstraintForces();
-
-	m_solverMultiBodyIslandCallback->processConstraints();
-	
-	m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
-
-	{
-                BT_PROFILE("btMultiBody stepVelocities");
-                for (int i=0;i<this->m_multiBodies.size();i++)
-                {
-                        btMultiBody* bod = m_multiBodies[i];
-
-                        bool isSleeping = false;
+			    }
+			} pCopy;
+			//
+
+			btScalar h = timeStep;
+			#define output &scratch_r[bod->getNumDofs()]
+			//calc qdd0 from: q0 & qd0	
+			bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
+			pCopy(output, scratch_qdd0, 0, numDofs);
+			//calc q1 = q0 + h/2 * qd0
+			pResetQx();
+			bod->stepPositionsMultiDof(btScalar(.5)*h, scratch_qx, scratch_qd0);
+			//calc qd1 = qd0 + h/2 * qdd0
+			pEulerIntegrate(btScalar(.5)*h, scratch_qdd0, scratch_qd0, scratch_qd1, numDofs);
+			//
+			//calc qdd1 from: q1 & qd1
+			pCopyToVelocityVector(bod, scratch_qd1);
+			bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
+			pCopy(output, scratch_qdd1, 0, numDofs);
+			//calc q2 = q0 + h/2 * qd1
+			pResetQx();
+			bod->stepPositionsMultiDof(btScalar(.5)*h, scratch_qx, scratch_qd1);
+			//calc qd2 = qd0 + h/2 * qdd1
+			pEulerIntegrate(btScalar(.5)*h, scratch_qdd1, scratch_qd0, scratch_qd2, numDofs);
+			//
+			//calc qdd2 from: q2 & qd2
+			pCopyToVelocityVector(bod, scratch_qd2);
+			bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
+			pCopy(output, scratch_qdd2, 0, numDofs);
+			//calc q3 = q0 + h * qd2
+			pResetQx();
+			bod->stepPositionsMultiDof(h, scratch_qx, scratch_qd2);
+			//calc qd3 = qd0 + h * qdd2
+			pEulerIntegrate(h, scratch_qdd2, scratch_qd0, scratch_qd3, numDofs);
+			//
+			//calc qdd3 from: q3 & qd3
+			pCopyToVelocityVector(bod, scratch_qd3);
+			bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
+			pCopy(output, scratch_qdd3, 0, numDofs);
+
+			//
+			//calc q = q0 + h/6(qd0 + 2*(qd1 + qd2) + qd3)
+			//calc qd = qd0 + h/6(qdd0 + 2*(qdd1 + qdd2) + qdd3)						
+			for(int i = 0; i < numDofs; ++i)
+			{
+				delta_q[i] = h/btScalar(6.)*(scratch_qd0[i] + 2*scratch_qd1[i] + 2*scratch_qd2[i] + scratch_qd3[i]);
+				delta_qd[i] = h/btScalar(6.)*(scratch_qdd0[i] + 2*scratch_qdd1[i] + 2*scratch_qdd2[i] + scratch_qdd3[i]);							
+				//delta_q[i] = h*scratch_qd0[i];
+				//delta_qd[i] = h*scratch_qdd0[i];
+			}
+			//
+			pCopyToVelocityVector(bod, scratch_qd0);
+			bod->applyDeltaVeeMultiDof(delta_qd, 1);						
+			//
+			if(!doNotUpdatePos)
+			{
+				btScalar *pRealBuf = const_cast<btScalar *>(bod->getVelocityVector());
+				pRealBuf += 6 + bod->getNumDofs() + bod->getNumDofs()*bod->getNumDofs();
 
-                        if (bod->getBaseCollider() && bod->getBaseCollider()->getActivationState() == ISLAND_SLEEPING)
-                        {
-                                isSleeping = true;
-                        }
-                        for (int b=0;b<bod->getNumLinks();b++)
-                        {
-                                if (bod->getLink(b).m_collider && bod->getLink(b).m_collider->getActivationState()==ISLAND_SLEEPING)
-                                        isSleeping = true;
-                        }
+				for(int i = 0; i < numDofs; ++i)
+					pRealBuf[i] = delta_q[i];
 
-                        if (!isSleeping)
-                        {
-                                //useless? they get resized in stepVelocities once again (AND DIFFERENTLY)
-                                m_scratch_r.resize(bod->getNumLinks()+1);                 //multidof? ("Y"s use it and it is used to store qdd)
-                                m_scratch_v.resize(bod->getNumLinks()+1);
-                                m_scratch_m.resize(bod->getNumLinks()+1);
+				//bod->stepPositionsMultiDof(1, 0, &delta_q[0]);
+				bod->setPosUpdated(true);							
+			}
 
-                                
-                            {
-                                if(!bod->isUsingRK4Integration())
-                                {
-									bool isConstraintPass = true;
-                                    bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(solverInfo.m_timeStep, m_scratch_r, m_scratch_v, m_scratch_m, isConstraintPass);
-                                }
-				}
+			//ugly hack which resets the cached data to t0 (needed for constraint solver)
+			{
+				for(int link = 0; link < bod->getNumLinks(); ++link)
+					bod->getLink(link).updateCacheMultiDof();
+				bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0, scratch_r, scratch_v, scratch_m);
 			}
+			
 		}
 	}
+	
+#ifndef BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
+	bod->clearForcesAndTorques();
+#endif //BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
+}
 
+void	btMultiBodyDynamicsWorld::applyMultiBodyConstraintVelocities(btScalar timeStep)
+{
+	BT_PROFILE("btMultiBody stepVelocities");
 	for (int i=0;i<this->m_multiBodies.size();i++)
 	{
-		btMultiBody* bod = m_multiBodies[i];
-		bod->processDeltaVeeMultiDof2();
+		applyMultiBodyConstraintVelocity(m_multiBodies[i], timeStep, m_scratch_r, m_scratch_v, m_scratch_m);
 	}
-
 }
 
-void	btMultiBodyDynamicsWorld::integrateTransforms(btScalar timeStep)
+void	btMultiBodyDynamicsWorld::applyMultiBodyConstraintVelocity(btMultiBody* bod, btScalar timeStep, btAlignedObjectArray<btScalar>& scratch_r, btAlignedObjectArray<btVector3>& scratch_v, btAlignedObjectArray<btMatrix3x3>& scratch_m)
 {
-	btDiscreteDynamicsWorld::integrateTransforms(timeStep);
-
+	if (!isMultiBodySleeping(bod))
 	{
-		BT_PROFILE("btMultiBody stepPositions");
-		//integrate and update the Featherstone hierarchies
-	
-		for (int b=0;b<m_multiBodies.size();b++)
+		if(!bod->isUsingRK4Integration())
 		{
-			btMultiBody* bod = m_multiBodies[b];
-			bool isSleeping = false;
-			if (bod->getBaseCollider() && bod->getBaseCollider()->getActivationState() == ISLAND_SLEEPING)
-			{
-				isSleeping = true;
-			} 
-			for (int b=0;b<bod->getNumLinks();b++)
-			{
-				if (bod->getLink(b).m_collider && bod->getLink(b).m_collider->getActivationState()==ISLAND_SLEEPING)
-					isSleeping = true;
-			}
-
+			bool isConstraintPass = true;
+			bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(timeStep, scratch_r, scratch_v, scratch_m, isConstraintPass);
+		}
+	}
 
-			if (!isSleeping)
-			{
-				int nLinks = bod->getNumLinks();
+	bod->processDeltaVeeMultiDof2();
+}
 
-				///base + num m_links
-			
-				
-				{
-					if(!bod->isPosUpdated())
-						bod->stepPositionsMultiDof(timeStep);
-					else
-					{
-						btScalar *pRealBuf = const_cast<btScalar *>(bod->getVelocityVector());
-						pRealBuf += 6 + bod->getNumDofs() + bod->getNumDofs()*bod->getNumDofs();
+void	btMultiBodyDynamicsWorld::integrateTransforms(btScalar timeStep)
+{
+	btDiscreteDynamicsWorld::integrateTransforms(timeStep);
 
-						bod->stepPositionsMultiDof(1, 0, pRealBuf);
-						bod->setPosUpdated(false);
-					}
-				}
-				
-				m_scratch_world_to_local.resize(nLinks+1);
-				m_scratch_local_origin.resize(nLinks+1);
+	integrateMultiBodyTransforms(timeStep);
+}
 
-				bod->updateCollisionObjectWorldTransforms(m_scratch_world_to_local,m_scratch_local_origin);
-				
-			} else
-			{
-				bod->clearVelocities();
-			}
-		}
+void	btMultiBodyDynamicsWorld::integrateMultiBodyTransforms(btScalar timeStep)
+{
+	BT_PROFILE("btMultiBody stepPositions");
+	//integrate and update the Featherstone hierarchies
+	for (int b=0;b<m_multiBodies.size();b++)
+	{
+		integrateMultiBodyTransform(m_multiBodies[b], timeStep, m_scratch_world_to_local, m_scratch_local_origin);
 	}
 }
 
+void	btMultiBodyDynamicsWorld::integrateMultiBodyTransform(btMultiBody* bod, btScalar timeStep, btAlignedObjectArray<btQuaternion>& scratch_world_to_local, btAlignedObjectArray<btVector3>& scratch_local_origin)
+{
+	if (!isMultiBodySleeping(bod))
+	{
+		///base + num m_links
+		if(!bod->isPosUpdated())
+			bod->stepPositionsMultiDof(timeStep);
+		else
+		{
+			btScalar *pRealBuf = const_cast<btScalar *>(bod->getVelocityVector());
+			pRealBuf += 6 + bod->getNumDofs() + bod->getNumDofs()*bod->getNumDofs();
+
+			bod->stepPositionsMultiDof(1, 0, pRealBuf);
+			bod->setPosUpdated(false);
+		}
 
+		bod->updateCollisionObjectWorldTransforms(scratch_world_to_local,scratch_local_origin);
+	} else
+	{
+		bod->clearVelocities();
+	}
+}
 
 void	btMultiBodyDynamicsWorld::addMultiBodyConstraint( btMultiBodyConstraint* constraint)
 {
@@ -523,7 +523,7 @@ void btFactorLDLT (btScalar *A, btScalar *d, int n, int nskip1)
  * if this is in the factorizer source file, n must be a multiple of 4.
  */
 
-void btSolveL1 (const btScalar *L, btScalar *B, int n, int lskip1)
+static void btSolveL1Scalar (const btScalar *L, btScalar *B, int n, int lskip1)
 {  
   /* declare variables - Z matrix, p and q vectors, etc */
   btScalar Z11,Z21,Z31,Z41,p1,q1,p2,p3,p4,*ex;
@@ -816,7 +816,7 @@ void btSolveL1 (const btScalar *L, btScalar *B, int n, int lskip1)
  * this processes blocks of 4.
  */
 
-void btSolveL1T (const btScalar *L, btScalar *B, int n, int lskip1)
+static void btSolveL1TScalar (const btScalar *L, btScalar *B, int n, int lskip1)
 {  
   /* declare variables - Z matrix, p and q vectors, etc */
   btScalar Z11,m11,Z21,m21,Z31,m31,Z41,m41,p1,q1,p2,p3,p4,*ex;
@@ -1007,6 +1007,229 @@ void btSolveL1T (const btScalar *L, btScalar *B, int n, int lskip1)
 
 
 
+//***************************************************************************
+// SIMD kernels. they compute the same results as the scalar code above (up to
+// rounding, the dot products are summed in a different order) and are used
+// unless btSetDantzigLCPUseReferenceKernels(true) selects the original code.
+
+//the SIMD kernels sum in a different order on each platform, BT_DETERMINISTIC uses the scalar code
+#if !defined (BT_USE_DOUBLE_PRECISION) && !defined (BT_DETERMINISTIC)
+#if defined (BT_USE_SSE) || defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BT_DANTZIG_SSE
+#include <emmintrin.h>
+#elif defined (BT_USE_NEON) || defined (__ARM_NEON) || defined (__ARM_NEON__)
+#define BT_DANTZIG_NEON
+#include <arm_neon.h>
+#endif
+#endif //!BT_USE_DOUBLE_PRECISION && !BT_DETERMINISTIC
+
+static bool gDantzigUseReferenceKernels = false;
+
+bool btDantzigLCPHasSimd()
+{
+#if defined (BT_DANTZIG_SSE) || defined (BT_DANTZIG_NEON)
+	return true;
+#else
+	return false;
+#endif
+}
+
+void btSetDantzigLCPUseReferenceKernels(bool useReference)
+{
+	gDantzigUseReferenceKernels = useReference;
+}
+
+bool btGetDantzigLCPUseReferenceKernels()
+{
+	return gDantzigUseReferenceKernels;
+}
+
+#if defined (BT_DANTZIG_SSE) || defined (BT_DANTZIG_NEON)
+
+#ifdef BT_DANTZIG_SSE
+typedef __m128 btDantzigVec4;
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Zero() { return _mm_setzero_ps(); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Load(const btScalar* p) { return _mm_loadu_ps(p); }
+static SIMD_FORCE_INLINE void btVec4Store(btScalar* p, btDantzigVec4 v) { _mm_storeu_ps(p,v); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Splat(btScalar s) { return _mm_set1_ps(s); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Add(btDantzigVec4 a, btDantzigVec4 b) { return _mm_add_ps(a,b); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Sub(btDantzigVec4 a, btDantzigVec4 b) { return _mm_sub_ps(a,b); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Mul(btDantzigVec4 a, btDantzigVec4 b) { return _mm_mul_ps(a,b); }
+static SIMD_FORCE_INLINE btScalar btVec4Sum(btDantzigVec4 v)
+{
+	v = _mm_add_ps(v,_mm_movehl_ps(v,v));
+	v = _mm_add_ss(v,_mm_shuffle_ps(v,v,1));
+	return _mm_cvtss_f32(v);
+}
+static SIMD_FORCE_INLINE void btVec4Transpose(btDantzigVec4& r0, btDantzigVec4& r1, btDantzigVec4& r2, btDantzigVec4& r3)
+{
+	_MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+}
+#else
+typedef float32x4_t btDantzigVec4;
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Zero() { return vdupq_n_f32(0.f); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Load(const btScalar* p) { return vld1q_f32(p); }
+static SIMD_FORCE_INLINE void btVec4Store(btScalar* p, btDantzigVec4 v) { vst1q_f32(p,v); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Splat(btScalar s) { return vdupq_n_f32(s); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Add(btDantzigVec4 a, btDantzigVec4 b) { return vaddq_f32(a,b); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Sub(btDantzigVec4 a, btDantzigVec4 b) { return vsubq_f32(a,b); }
+static SIMD_FORCE_INLINE btDantzigVec4 btVec4Mul(btDantzigVec4 a, btDantzigVec4 b) { return vmulq_f32(a,b); }
+static SIMD_FORCE_INLINE btScalar btVec4Sum(btDantzigVec4 v)
+{
+	float32x2_t s = vadd_f32(vget_low_f32(v),vget_high_f32(v));
+	return vget_lane_f32(vpadd_f32(s,s),0);
+}
+static SIMD_FORCE_INLINE void btVec4Transpose(btDantzigVec4& r0, btDantzigVec4& r1, btDantzigVec4& r2, btDantzigVec4& r3)
+{
+	float32x4x2_t t01 = vtrnq_f32(r0,r1);
+	float32x4x2_t t23 = vtrnq_f32(r2,r3);
+	r0 = vcombine_f32(vget_low_f32(t01.val[0]),vget_low_f32(t23.val[0]));
+	r1 = vcombine_f32(vget_low_f32(t01.val[1]),vget_low_f32(t23.val[1]));
+	r2 = vcombine_f32(vget_high_f32(t01.val[0]),vget_high_f32(t23.val[0]));
+	r3 = vcombine_f32(vget_high_f32(t01.val[1]),vget_high_f32(t23.val[1]));
+}
+#endif //BT_DANTZIG_SSE
+
+static btScalar btLargeDotSimd (const btScalar *a, const btScalar *b, int n)
+{
+  btDantzigVec4 sum0 = btVec4Zero(), sum1 = btVec4Zero();
+  int i=0;
+  for (; i <= n-8; i+=8) {
+    sum0 = btVec4Add(sum0,btVec4Mul(btVec4Load(a+i),btVec4Load(b+i)));
+    sum1 = btVec4Add(sum1,btVec4Mul(btVec4Load(a+i+4),btVec4Load(b+i+4)));
+  }
+  if (i <= n-4) {
+    sum0 = btVec4Add(sum0,btVec4Mul(btVec4Load(a+i),btVec4Load(b+i)));
+    i += 4;
+  }
+  btScalar sum = btVec4Sum(btVec4Add(sum0,sum1));
+  for (; i<n; i++) sum += a[i]*b[i];
+  return sum;
+}
+
+/* same as btSolveL1Scalar: the dot products of 4 rows of L with the solved part
+ * of B are computed 4 columns at a time, then the 4*4 triangle is finished in scalar code.
+ */
+static void btSolveL1Simd (const btScalar *L, btScalar *B, int n, int lskip1)
+{
+  int i=0;
+  for (; i <= n-4; i+=4) {
+    const btScalar *l0 = L + i*lskip1;
+    const btScalar *l1 = l0 + lskip1;
+    const btScalar *l2 = l1 + lskip1;
+    const btScalar *l3 = l2 + lskip1;
+    btDantzigVec4 z0 = btVec4Zero(), z1 = btVec4Zero(), z2 = btVec4Zero(), z3 = btVec4Zero();
+    /* i is a multiple of 4, so there are no left-over columns */
+    for (int j=0; j<i; j+=4) {
+      btDantzigVec4 q = btVec4Load(B+j);
+      z0 = btVec4Add(z0,btVec4Mul(btVec4Load(l0+j),q));
+      z1 = btVec4Add(z1,btVec4Mul(btVec4Load(l1+j),q));
+      z2 = btVec4Add(z2,btVec4Mul(btVec4Load(l2+j),q));
+      z3 = btVec4Add(z3,btVec4Mul(btVec4Load(l3+j),q));
+    }
+    btScalar *ex = B + i;
+    btScalar Z11 = ex[0] - btVec4Sum(z0);
+    ex[0] = Z11;
+    btScalar Z21 = ex[1] - btVec4Sum(z1) - l1[i]*Z11;
+    ex[1] = Z21;
+    btScalar Z31 = ex[2] - btVec4Sum(z2) - l2[i]*Z11 - l2[i+1]*Z21;
+    ex[2] = Z31;
+    ex[3] = ex[3] - btVec4Sum(z3) - l3[i]*Z11 - l3[i+1]*Z21 - l3[i+2]*Z31;
+  }
+  /* compute rows at end that are not a multiple of block size */
+  for (; i < n; i++) {
+    B[i] -= btLargeDotSimd(L + i*lskip1,B,i);
+  }
+}
+
+/* same as btSolveL1TScalar: rows i-7..i of x are solved together, the 8 entries
+ * L(k,i-7..i) of each already solved row k are adjacent in memory, so every pass
+ * down the rows of L produces 8 results.
+ */
+static void btSolveL1TSimd (const btScalar *L, btScalar *B, int n, int lskip1)
+{
+  int i=n-1;
+  for (; i >= 7; i-=8) {
+    btDantzigVec4 zlo = btVec4Zero(), zhi = btVec4Zero();
+    btDantzigVec4 zlo2 = btVec4Zero(), zhi2 = btVec4Zero();
+    const btScalar *ell = L + (i+1)*lskip1 + i-7;
+    int k=i+1;
+    /* two rows per iteration with separate sums, to hide the latency of the additions */
+    for (; k<n-1; k+=2, ell+=2*lskip1) {
+      btDantzigVec4 q = btVec4Splat(B[k]);
+      btDantzigVec4 q2 = btVec4Splat(B[k+1]);
+      zlo = btVec4Add(zlo,btVec4Mul(btVec4Load(ell),q));
+      zhi = btVec4Add(zhi,btVec4Mul(btVec4Load(ell+4),q));
+      zlo2 = btVec4Add(zlo2,btVec4Mul(btVec4Load(ell+lskip1),q2));
+      zhi2 = btVec4Add(zhi2,btVec4Mul(btVec4Load(ell+lskip1+4),q2));
+    }
+    if (k<n) {
+      btDantzigVec4 q = btVec4Splat(B[k]);
+      zlo = btVec4Add(zlo,btVec4Mul(btVec4Load(ell),q));
+      zhi = btVec4Add(zhi,btVec4Mul(btVec4Load(ell+4),q));
+    }
+    zlo = btVec4Add(zlo,zlo2);
+    zhi = btVec4Add(zhi,zhi2);
+    btScalar Z[8];
+    btVec4Store(Z,zlo);
+    btVec4Store(Z+4,zhi);
+    /* finish the 8*8 triangle */
+    for (int m=0; m<8; m++) {
+      const int row = i-m;
+      btScalar sum = B[row] - Z[7-m];
+      const btScalar *lt = L + i*lskip1 + row;
+      for (int t=0; t<m; t++, lt-=lskip1) {
+        sum -= lt[0]*B[i-t];
+      }
+      B[row] = sum;
+    }
+  }
+  /* compute rows at the start that are not a multiple of block size */
+  for (; i >= 0; i--) {
+    btScalar Z11 = 0;
+    const btScalar *ell = L + (i+1)*lskip1 + i;
+    for (int k=i+1; k<n; ++k, ell+=lskip1) {
+      Z11 += ell[0]*B[k];
+    }
+    B[i] -= Z11;
+  }
+}
+
+#endif //BT_DANTZIG_SSE || BT_DANTZIG_NEON
+
+static SIMD_FORCE_INLINE btScalar btDantzigDot (const btScalar *a, const btScalar *b, int n)
+{
+#if defined (BT_DANTZIG_SSE) || defined (BT_DANTZIG_NEON)
+  if (!gDantzigUseReferenceKernels)
+    return btLargeDotSimd(a,b,n);
+#endif
+  return btLargeDot(a,b,n);
+}
+
+void btSolveL1 (const btScalar *L, btScalar *B, int n, int lskip1)
+{
+#if defined (BT_DANTZIG_SSE) || defined (BT_DANTZIG_NEON)
+  if (!gDantzigUseReferenceKernels) {
+    btSolveL1Simd(L,B,n,lskip1);
+    return;
+  }
+#endif
+  btSolveL1Scalar(L,B,n,lskip1);
+}
+
+void btSolveL1T (const btScalar *L, btScalar *B, int n, int lskip1)
+{
+#if defined (BT_DANTZIG_SSE) || defined (BT_DANTZIG_NEON)
+  //below this size the unrolled scalar loops are just as fast
+  if (!gDantzigUseReferenceKernels && n >= 128) {
+    btSolveL1TSimd(L,B,n,lskip1);
+    return;
+  }
+#endif
+  btSolveL1TScalar(L,B,n,lskip1);
+}
+
+
 void btVectorScale (btScalar *a, const btScalar *d, int n)
 {
   btAssert (a && d && n >= 0);
@@ -1213,8 +1436,8 @@ struct btLCP
 	int indexC (int i) const { return i; }
 	int indexN (int i) const { return i+m_nC; }
 	btScalar Aii (int i) const  { return BTAROW(i)[i]; }
-	btScalar AiC_times_qC (int i, btScalar *q) const { return btLargeDot (BTAROW(i), q, m_nC); }
-	btScalar AiN_times_qN (int i, btScalar *q) const { return btLargeDot (BTAROW(i)+m_nC, q+m_nC, m_nN); }
+	btScalar AiC_times_qC (int i, btScalar *q) const { return btDantzigDot (BTAROW(i), q, m_nC); }
+	btScalar AiN_times_qN (int i, btScalar *q) const { return btDantzigDot (BTAROW(i)+m_nC, q+m_nC, m_nN); }
 	void pN_equals_ANC_times_qC (btScalar *p, btScalar *q);
 	void pN_plusequals_ANi (btScalar *p, int i, int sign=1);
 	void pC_plusequals_s_times_qC (btScalar *p, btScalar s, btScalar *q);
@@ -1359,7 +1582,7 @@ void btLCP::transfer_i_to_C (int i)
         for (int j=0; j<nC; ++j) Ltgt[j] = ell[j];
       }
       const int nC = m_nC;
-      m_d[nC] = btRecip (BTAROW(i)[i] - btLargeDot(m_ell,m_Dell,nC));
+      m_d[nC] = btRecip (BTAROW(i)[i] - btDantzigDot(m_ell,m_Dell,nC));
     }
     else {
       m_d[0] = btRecip (BTAROW(i)[i]);
@@ -1403,7 +1626,7 @@ void btLCP::transfer_i_from_N_to_C (int i)
         for (int j=0; j<nC; ++j) Ltgt[j] = ell[j] = Dell[j] * d[j];
       }
       const int nC = m_nC;
-      m_d[nC] = btRecip (BTAROW(i)[i] - btLargeDot(m_ell,m_Dell,nC));
+      m_d[nC] = btRecip (BTAROW(i)[i] - btDantzigDot(m_ell,m_Dell,nC));
     }
     else {
       m_d[0] = btRecip (BTAROW(i)[i]);
@@ -1462,7 +1685,7 @@ void btRemoveRowCol (btScalar *A, int n, int nskip, int r)
 
 
 
-void btLDLTAddTL (btScalar *L, btScalar *d, const btScalar *a, int n, int nskip, btAlignedObjectArray<btScalar>& scratch)
+static void btLDLTAddTLScalar (btScalar *L, btScalar *d, const btScalar *a, int n, int nskip, btAlignedObjectArray<btScalar>& scratch)
 {
   btAssert (L && d && a && n > 0 && nskip >= n);
 
@@ -1540,6 +1763,180 @@ void btLDLTAddTL (btScalar *L, btScalar *d, const btScalar *a, int n, int nskip,
 }
 
 
+#define BT_LDLT_ADDTL_BLOCK 16
+
+#if defined (BT_DANTZIG_SSE) || defined (BT_DANTZIG_NEON)
+static SIMD_FORCE_INLINE void btLDLTAddTLUpdate4 (btDantzigVec4& ell, btDantzigVec4& W1, btDantzigVec4& W2,
+    btScalar k1, btScalar gamma1, btScalar k2, btScalar gamma2)
+{
+  btDantzigVec4 Wp = btVec4Sub(W1,btVec4Mul(btVec4Splat(k1),ell));
+  ell = btVec4Add(ell,btVec4Mul(btVec4Splat(gamma1),Wp));
+  W1 = Wp;
+  Wp = btVec4Sub(W2,btVec4Mul(btVec4Splat(k2),ell));
+  ell = btVec4Sub(ell,btVec4Mul(btVec4Splat(gamma2),Wp));
+  W2 = Wp;
+}
+#endif //BT_DANTZIG_SSE || BT_DANTZIG_NEON
+
+/* cache-blocked btLDLTAddTLScalar: the rank 2 updates of BT_LDLT_ADDTL_BLOCK columns are
+ * applied to each row of L while it is in cache, instead of walking down all rows once
+ * per column. every element goes through the same operations in the same order as in
+ * btLDLTAddTLScalar. with SIMD, 4 rows are updated at once on transposed 4*4 tiles of L.
+ */
+static void btLDLTAddTLBlocked (btScalar *L, btScalar *d, const btScalar *a, int n, int nskip, btAlignedObjectArray<btScalar>& scratch)
+{
+  btAssert (L && d && a && n > 0 && nskip >= n);
+
+  if (n < 2) return;
+  scratch.resize(2*nskip);
+  btScalar *W1 = &scratch[0];
+  
+  btScalar *W2 = W1 + nskip;
+
+  W1[0] = btScalar(0.0);
+  W2[0] = btScalar(0.0);
+  for (int j=1; j<n; ++j) {
+    W1[j] = W2[j] = (btScalar) (a[j] * SIMDSQRT12);
+  }
+  btScalar W11 = (btScalar) ((btScalar(0.5)*a[0]+1)*SIMDSQRT12);
+  btScalar W21 = (btScalar) ((btScalar(0.5)*a[0]-1)*SIMDSQRT12);
+
+  btScalar alpha1 = btScalar(1.0);
+  btScalar alpha2 = btScalar(1.0);
+
+  {
+    btScalar dee = d[0];
+    btScalar alphanew = alpha1 + (W11*W11)*dee;
+    btAssert(alphanew != btScalar(0.0));
+    dee /= alphanew;
+    btScalar gamma1 = W11 * dee;
+    dee *= alpha1;
+    alpha1 = alphanew;
+    alphanew = alpha2 - (W21*W21)*dee;
+    dee /= alphanew;
+    alpha2 = alphanew;
+    btScalar k1 = btScalar(1.0) - W21*gamma1;
+    btScalar k2 = W21*gamma1*W11 - W21;
+    btScalar *ll = L + nskip;
+    for (int p=1; p<n; ll+=nskip, ++p) {
+      btScalar Wp = W1[p];
+      btScalar ell = *ll;
+      W1[p] =    Wp - W11*ell;
+      W2[p] = k1*Wp +  k2*ell;
+    }
+  }
+
+  btScalar K1[BT_LDLT_ADDTL_BLOCK], K2[BT_LDLT_ADDTL_BLOCK];
+  btScalar G1[BT_LDLT_ADDTL_BLOCK], G2[BT_LDLT_ADDTL_BLOCK];
+
+  for (int j0=1; j0<n; j0+=BT_LDLT_ADDTL_BLOCK) {
+    const int j1 = (j0+BT_LDLT_ADDTL_BLOCK < n) ? j0+BT_LDLT_ADDTL_BLOCK : n;
+    const int nb = j1-j0;
+
+    /* the columns of the block, updating only the rows inside the block */
+    for (int j=j0; j<j1; ++j) {
+      btScalar k1 = W1[j];
+      btScalar k2 = W2[j];
+
+      btScalar dee = d[j];
+      btScalar alphanew = alpha1 + (k1*k1)*dee;
+      btAssert(alphanew != btScalar(0.0));
+      dee /= alphanew;
+      btScalar gamma1 = k1 * dee;
+      dee *= alpha1;
+      alpha1 = alphanew;
+      alphanew = alpha2 - (k2*k2)*dee;
+      dee /= alphanew;
+      btScalar gamma2 = k2 * dee;
+      dee *= alpha2;
+      d[j] = dee;
+      alpha2 = alphanew;
+
+      K1[j-j0] = k1;
+      K2[j-j0] = k2;
+      G1[j-j0] = gamma1;
+      G2[j-j0] = gamma2;
+
+      btScalar *l = L + (j+1)*nskip + j;
+      for (int p=j+1; p<j1; l+=nskip, ++p) {
+        btScalar ell = *l;
+        btScalar Wp = W1[p] - k1 * ell;
+        ell += gamma1 * Wp;
+        W1[p] = Wp;
+        Wp = W2[p] - k2 * ell;
+        ell -= gamma2 * Wp;
+        W2[p] = Wp;
+        *l = ell;
+      }
+    }
+
+    /* all columns of the block for the rows below it */
+    int p = j1;
+#if defined (BT_DANTZIG_SSE) || defined (BT_DANTZIG_NEON)
+    for (; p <= n-4; p+=4) {
+      btScalar *r0 = L + p*nskip + j0;
+      btScalar *r1 = r0 + nskip;
+      btScalar *r2 = r1 + nskip;
+      btScalar *r3 = r2 + nskip;
+      btDantzigVec4 w1 = btVec4Load(W1+p);
+      btDantzigVec4 w2 = btVec4Load(W2+p);
+      int c=0;
+      for (; c <= nb-4; c+=4) {
+        btDantzigVec4 e0 = btVec4Load(r0+c), e1 = btVec4Load(r1+c), e2 = btVec4Load(r2+c), e3 = btVec4Load(r3+c);
+        btVec4Transpose(e0,e1,e2,e3);
+        btLDLTAddTLUpdate4(e0,w1,w2,K1[c],G1[c],K2[c],G2[c]);
+        btLDLTAddTLUpdate4(e1,w1,w2,K1[c+1],G1[c+1],K2[c+1],G2[c+1]);
+        btLDLTAddTLUpdate4(e2,w1,w2,K1[c+2],G1[c+2],K2[c+2],G2[c+2]);
+        btLDLTAddTLUpdate4(e3,w1,w2,K1[c+3],G1[c+3],K2[c+3],G2[c+3]);
+        btVec4Transpose(e0,e1,e2,e3);
+        btVec4Store(r0+c,e0);
+        btVec4Store(r1+c,e1);
+        btVec4Store(r2+c,e2);
+        btVec4Store(r3+c,e3);
+      }
+      for (; c<nb; ++c) {
+        btScalar column[4] = {r0[c],r1[c],r2[c],r3[c]};
+        btDantzigVec4 e = btVec4Load(column);
+        btLDLTAddTLUpdate4(e,w1,w2,K1[c],G1[c],K2[c],G2[c]);
+        btVec4Store(column,e);
+        r0[c] = column[0];
+        r1[c] = column[1];
+        r2[c] = column[2];
+        r3[c] = column[3];
+      }
+      btVec4Store(W1+p,w1);
+      btVec4Store(W2+p,w2);
+    }
+#endif //BT_DANTZIG_SSE || BT_DANTZIG_NEON
+    for (; p<n; ++p) {
+      btScalar *l = L + p*nskip + j0;
+      btScalar w1 = W1[p];
+      btScalar w2 = W2[p];
+      for (int c=0; c<nb; ++c) {
+        btScalar ell = l[c];
+        btScalar Wp = w1 - K1[c] * ell;
+        ell += G1[c] * Wp;
+        w1 = Wp;
+        Wp = w2 - K2[c] * ell;
+        ell -= G2[c] * Wp;
+        w2 = Wp;
+        l[c] = ell;
+      }
+      W1[p] = w1;
+      W2[p] = w2;
+    }
+  }
+}
+
+void btLDLTAddTL (btScalar *L, btScalar *d, const btScalar *a, int n, int nskip, btAlignedObjectArray<btScalar>& scratch)
+{
+  if (gDantzigUseReferenceKernels)
+    btLDLTAddTLScalar(L,d,a,n,nskip,scratch);
+  else
+    btLDLTAddTLBlocked(L,d,a,n,nskip,scratch);
+}
+
+
 #define _BTGETA(i,j) (A[i][j])
 //#define _GETA(i,j) (A[(i)*nskip+(j)])
 #define BTGETA(i,j) ((i > j) ? _BTGETA(i,j) : _BTGETA(j,i))
@@ -1592,7 +1989,7 @@ void btLDLTRemove (btScalar **A, const int *p, btScalar *L, btScalar *d,
         const int *pp_r = p + r, p_r = *pp_r;
         const int n2_minus_r = n2-r;
         for (int i=0; i<n2_minus_r; Lcurr+=nskip,++i) {
-          a[i] = btLargeDot(Lcurr,t,r) - BTGETA(pp_r[i],p_r);
+          a[i] = btDantzigDot(Lcurr,t,r) - BTGETA(pp_r[i],p_r);
         }
       }
       a[0] += btScalar(1.0);
@@ -1660,7 +2057,7 @@ void btLCP::pN_equals_ANC_times_qC (btScalar *p, btScalar *q)
   btScalar *ptgt = p + nC;
   const int nN = m_nN;
   for (int i=0; i<nN; ++i) {
-    ptgt[i] = btLargeDot (BTAROW(i+nC),q,nC);
+    ptgt[i] = btDantzigDot (BTAROW(i+nC),q,nC);
   }
 }
 
@@ -72,6 +72,20 @@ struct btDantzigScratchMemory
 bool btSolveDantzigLCP (int n, btScalar *A, btScalar *x, btScalar *b, btScalar *w,
 	int nub, btScalar *lo, btScalar *hi, int *findex,btDantzigScratchMemory& scratch);
 
+///solve L*X=B in place, L is an n*n lower triangular matrix with ones on the diagonal, stored by rows with leading dimension lskip1
+void btSolveL1 (const btScalar *L, btScalar *B, int n, int lskip1);
+///solve L^T*X=B in place
+void btSolveL1T (const btScalar *L, btScalar *B, int n, int lskip1);
+///update the L*D*L^T factorization for a change of the first row and column of the factorized matrix by a
+void btLDLTAddTL (btScalar *L, btScalar *d, const btScalar *a, int n, int nskip, btAlignedObjectArray<btScalar>& scratch);
+
+///The kernels above, and the dot products and factorization updates of btSolveDantzigLCP, use SIMD (SSE2 or NEON, single precision only)
+///and cache-blocked loops by default. The original scalar code can be selected at runtime, for comparison and benchmarking.
+void btSetDantzigLCPUseReferenceKernels(bool useReference);
+bool btGetDantzigLCPUseReferenceKernels();
+///returns true if the SIMD kernels are compiled in
+bool btDantzigLCPHasSimd();
+
 
 
 #endif //_BT_LCP_H_
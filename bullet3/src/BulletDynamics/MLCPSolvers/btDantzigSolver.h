@@ -36,6 +36,59 @@ protected:
 	btAlignedObjectArray<btScalar> m_hi;
 	btAlignedObjectArray<int>	m_dependencies;
 	btDantzigScratchMemory m_scratchMemory;
+
+	///solves the LCP stored in m_A, which has to be filled by the caller
+	bool solveDantzig(int n, const btVectorXu & b, btVectorXu& x, const btVectorXu & lo,const btVectorXu & hi,const btAlignedObjectArray<int>& limitDependency)
+	{
+		bool result = true;
+		int nub = 0;
+		btAlignedObjectArray<btScalar> ww;
+		ww.resize(n);
+
+		m_b.resize(n);
+		m_x.resize(n);
+		m_lo.resize(n);
+		m_hi.resize(n);
+		m_dependencies.resize(n);
+		for (int i=0;i<n;i++)
+		{
+			m_lo[i] = lo[i];
+			m_hi[i] = hi[i];
+			m_b[i] = b[i];
+			m_x[i] = x[i];
+			m_dependencies[i] = limitDependency[i];
+		}
+
+
+		result = btSolveDantzigLCP (n,&m_A[0],&m_x[0],&m_b[0],&ww[0],nub,&m_lo[0],&m_hi[0],&m_dependencies[0],m_scratchMemory);
+		if (!result)
+			return result;
+
+//		printf("numAllocas = %d\n",numAllocas);
+		for (int i=0;i<n;i++)
+		{
+			volatile btScalar xx = m_x[i];
+			if (xx != m_x[i])
+				return false;
+			if (x[i] >= m_acceptableUpperLimitSolution)
+			{
+				return false;
+			}
+
+			if (x[i] <= -m_acceptableUpperLimitSolution)
+			{
+				return false;
+			}
+		}
+
+		for (int i=0;i<n;i++)
+		{
+			x[i] = m_x[i];
+		}
+
+		return result;
+	}
+
 public:
 
 	btDantzigSolver()
@@ -49,11 +102,6 @@ public:
 		int n = b.rows();
 		if (n)
 		{
-			int nub = 0;
-			btAlignedObjectArray<btScalar> ww;
-			ww.resize(n);
-	
-
 			const btScalar* Aptr = A.getBufferPointer();
 			m_A.resize(n*n);
 			for (int i=0;i<n*n;i++)
@@ -62,47 +110,24 @@ public:
 
 			}
 
-			m_b.resize(n);
-			m_x.resize(n);
-			m_lo.resize(n);
-			m_hi.resize(n);
-			m_dependencies.resize(n);
-			for (int i=0;i<n;i++)
-			{
-				m_lo[i] = lo[i];
-				m_hi[i] = hi[i];
-				m_b[i] = b[i];
-				m_x[i] = x[i];
-				m_dependencies[i] = limitDependency[i];
-			}
-
+			result = solveDantzig(n, b, x, lo, hi, limitDependency);
+		}
 
-			result = btSolveDantzigLCP (n,&m_A[0],&m_x[0],&m_b[0],&ww[0],nub,&m_lo[0],&m_hi[0],&m_dependencies[0],m_scratchMemory);
-			if (!result)
-				return result;
+		return result;
+	}
 
-//			printf("numAllocas = %d\n",numAllocas);
-			for (int i=0;i<n;i++)
-			{
-				volatile btScalar xx = m_x[i];
-				if (xx != m_x[i])
-					return false;
-				if (x[i] >= m_acceptableUpperLimitSolution)
-				{
-					return false;
-				}
-
-				if (x[i] <= -m_acceptableUpperLimitSolution)
-				{
-					return false;
-				}
-			}
+	///the Dantzig pivoting needs the full matrix, but it is written straight from the stored blocks without a dense intermediate copy
+	virtual bool solveMLCPSparse(const btMLCPBlockMatrix& A, const btVectorXu & b, btVectorXu& x, const btVectorXu & lo,const btVectorXu & hi,const btAlignedObjectArray<int>& limitDependency, int numIterations)
+	{
+		bool result = true;
+		int n = b.rows();
+		if (n)
+		{
+			m_A.resize(0);
+			m_A.resize(n*n,btScalar(0));
+			A.copyToDense(&m_A[0]);
 
-			for (int i=0;i<n;i++)
-			{
-				x[i] = m_x[i];
-			}
-			
+			result = solveDantzig(n, b, x, lo, hi, limitDependency);
 		}
 
 		return result;
@@ -18,6 +18,7 @@ subject to the following restrictions:
 #define BT_MLCP_SOLVER_INTERFACE_H
 
 #include "LinearMath/btMatrixX.h"
+#include "btMLCPBlockMatrix.h"
 
 class btMLCPSolverInterface
 {
@@ -28,6 +29,15 @@ public:
 
 	//return true is it solves the problem successfully
 	virtual bool solveMLCP(const btMatrixXu & A, const btVectorXu & b, btVectorXu& x, const btVectorXu & lo,const btVectorXu & hi,const btAlignedObjectArray<int>& limitDependency, int numIterations, bool useSparsity = true)=0;
+
+	///solves the MLCP with A in block sparse format. The default implementation expands A to a dense matrix,
+	///solvers that can exploit the block structure should override it.
+	virtual bool solveMLCPSparse(const btMLCPBlockMatrix& A, const btVectorXu & b, btVectorXu& x, const btVectorXu & lo,const btVectorXu & hi,const btAlignedObjectArray<int>& limitDependency, int numIterations)
+	{
+		btMatrixXu denseA;
+		A.copyToDense(denseA);
+		return solveMLCP(denseA, b, x, lo, hi, limitDependency, numIterations);
+	}
 };
 
 #endif //BT_MLCP_SOLVER_INTERFACE_H
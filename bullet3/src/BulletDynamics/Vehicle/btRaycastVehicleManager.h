@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2005 Erwin Coumans http://bulletphysics.org
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies.
+ * Erwin Coumans makes no representations about the suitability 
+ * of this software for any purpose.  
+ * It is provided "as is" without express or implied warranty.
+*/
+#ifndef BT_RAYCAST_VEHICLE_MANAGER_H
+#define BT_RAYCAST_VEHICLE_MANAGER_H
+
+#include "btRaycastVehicle.h"
+
+///btRaycastVehicleManager updates many btRaycastVehicles as a single action. The vehicles are stepped in phases:
+///the wheel transforms and rays of all vehicles are computed, the rays of each vehicle are cast with one
+///btVehicleRaycaster::castRays call, and the suspension and friction of all vehicles are updated.
+///The phases run in parallel over the vehicles when a task scheduler is set (see btParallelFor), so the raycasters
+///of the vehicles have to be safe to call from several threads at once, as btDefaultVehicleRaycaster is.
+///Add the manager to the world with addAction, instead of the vehicles.
+class btRaycastVehicleManager : public btActionInterface
+{
+protected:
+	struct VehicleLoop;
+
+	enum VehicleStage
+	{
+		VEHICLE_PREPARE,
+		VEHICLE_CAST_RAYS,
+		VEHICLE_COMPLETE
+	};
+
+	btAlignedObjectArray<btRaycastVehicle*>	m_vehicles;
+	//per wheel ray and result, the wheels of vehicle i start at m_wheelStart[i]
+	btAlignedObjectArray<int>	m_wheelStart;
+	btAlignedObjectArray<btVector3>	m_rayFrom;
+	btAlignedObjectArray<btVector3>	m_rayTo;
+	btAlignedObjectArray<btVehicleRaycaster::btVehicleRaycasterResult>	m_rayResults;
+	btAlignedObjectArray<void*>	m_rayObjects;
+	int	m_vehicleGrainSize;
+
+	void	processVehicles(VehicleStage stage, btScalar step);
+
+	void	processVehicleRange(VehicleStage stage, btScalar step, int iBegin, int iEnd);
+
+public:
+
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btRaycastVehicleManager();
+
+	virtual ~btRaycastVehicleManager();
+
+	void	addVehicle(btRaycastVehicle* vehicle);
+
+	void	removeVehicle(btRaycastVehicle* vehicle);
+
+	int		getNumVehicles() const
+	{
+		return m_vehicles.size();
+	}
+
+	btRaycastVehicle*	getVehicle(int index)
+	{
+		return m_vehicles[index];
+	}
+
+	///btActionInterface interface
+	virtual void updateAction( btCollisionWorld* collisionWorld, btScalar step)
+	{
+		(void) collisionWorld;
+		updateVehicles(step);
+	}
+
+	///btActionInterface interface
+	virtual void	debugDraw(btIDebugDraw* debugDrawer);
+
+	void	updateVehicles(btScalar step);
+
+	///the number of vehicles handed to a thread at once
+	int		getVehicleGrainSize() const
+	{
+		return m_vehicleGrainSize;
+	}
+	void	setVehicleGrainSize(int grainSize)
+	{
+		m_vehicleGrainSize = btMax(1, grainSize);
+	}
+};
+
+#endif //BT_RAYCAST_VEHICLE_MANAGER_H
@@ -29,6 +29,16 @@ virtual ~btVehicleRaycaster()
 
 	virtual void* castRay(const btVector3& from,const btVector3& to, btVehicleRaycasterResult& result) = 0;
 
+	///castRays casts numRays rays at once, objects[i] and results[i] receive what castRay returns for the ray from[i] to to[i].
+	///btRaycastVehicleManager calls it once per vehicle, from several threads at once when a task scheduler is set.
+	virtual void castRays(int numRays, const btVector3* from, const btVector3* to, btVehicleRaycasterResult* results, void** objects)
+	{
+		for (int i=0;i<numRays;i++)
+		{
+			objects[i] = castRay(from[i],to[i],results[i]);
+		}
+	}
+
 };
 
 #endif //BT_VEHICLE_RAYCASTER_H
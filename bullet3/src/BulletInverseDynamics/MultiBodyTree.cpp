@@ -7,19 +7,140 @@
 #include "IDMath.hpp"
 #include "details/MultiBodyTreeImpl.hpp"
 #include "details/MultiBodyTreeInitCache.hpp"
+#ifndef BT_ID_WO_BULLET
+#include "LinearMath/btThreads.h"
+#endif
 
 namespace btInverseDynamics {
 
+// state of one thread in the batch calculations
+class MultiBodyTree::BatchWorkspace {
+public:
+	ID_DECLARE_ALIGNED_ALLOCATOR();
+	BatchWorkspace(const MultiBodyImpl &impl, const int num_dofs)
+		: m_impl(impl),
+		  m_q(num_dofs),
+		  m_u(num_dofs),
+		  m_dot_u(num_dofs),
+		  m_joint_forces(num_dofs),
+		  m_mass_matrix(num_dofs, num_dofs),
+		  m_generation(-1),
+		  m_error(false) {}
+	MultiBodyImpl m_impl;
+	vecx m_q;
+	vecx m_u;
+	vecx m_dot_u;
+	vecx m_joint_forces;
+	matxx m_mass_matrix;
+	int m_generation;
+	bool m_error;
+};
+
+class MultiBodyTree::BatchLoop
+#ifndef BT_ID_WO_BULLET
+	: public btIParallelForBody
+#endif
+{
+public:
+	MultiBodyTree *m_tree;
+	const idScalar *m_q;
+	// m_u and m_dot_u are null for mass matrix calculations
+	const idScalar *m_u;
+	const idScalar *m_dot_u;
+	idScalar *m_output;
+	// set if a workspace that is not kept in m_batch_workspaces had an error
+	mutable bool m_local_error;
+#ifndef BT_ID_WO_BULLET
+	mutable btSpinMutex m_local_error_mutex;
+#endif
+
+	void forLoop(int begin, int end) const {
+#ifndef BT_ID_WO_BULLET
+		const int thread_index = btGetCurrentThreadIndex();
+#else
+		const int thread_index = 0;
+#endif
+		const int num_dofs = m_tree->numDoFs();
+		BatchWorkspace *workspace;
+		BatchWorkspace *local_workspace = 0x0;
+		if (thread_index < static_cast<int>(m_tree->m_batch_workspaces.size())) {
+			BatchWorkspace *&thread_workspace = m_tree->m_batch_workspaces[thread_index];
+			if (0x0 == thread_workspace) {
+				thread_workspace = new BatchWorkspace(*m_tree->m_impl, num_dofs);
+			}
+			workspace = thread_workspace;
+		} else {
+			// no slot for this thread, use a temporary workspace for this range
+			local_workspace = new BatchWorkspace(*m_tree->m_impl, num_dofs);
+			workspace = local_workspace;
+		}
+		if (workspace->m_generation != m_tree->m_batch_generation) {
+			workspace->m_impl.copyBodyDataFrom(*m_tree->m_impl);
+			workspace->m_generation = m_tree->m_batch_generation;
+			workspace->m_error = false;
+		}
+		for (int config = begin; config < end; config++) {
+			const int offset = config * num_dofs;
+			for (int i = 0; i < num_dofs; i++) {
+				workspace->m_q(i) = m_q[offset + i];
+			}
+			if (0x0 != m_u) {
+				for (int i = 0; i < num_dofs; i++) {
+					workspace->m_u(i) = m_u[offset + i];
+					workspace->m_dot_u(i) = m_dot_u[offset + i];
+				}
+				if (-1 == workspace->m_impl.calculateInverseDynamics(
+							  workspace->m_q, workspace->m_u, workspace->m_dot_u,
+							  &workspace->m_joint_forces)) {
+					workspace->m_error = true;
+					continue;
+				}
+				for (int i = 0; i < num_dofs; i++) {
+					m_output[offset + i] = workspace->m_joint_forces(i);
+				}
+			} else {
+				if (-1 == workspace->m_impl.calculateMassMatrix(workspace->m_q, true, true, true,
+																&workspace->m_mass_matrix)) {
+					workspace->m_error = true;
+					continue;
+				}
+				idScalar *mass_matrix = &m_output[config * num_dofs * num_dofs];
+				for (int i = 0; i < num_dofs; i++) {
+					for (int j = 0; j < num_dofs; j++) {
+						mass_matrix[i * num_dofs + j] = workspace->m_mass_matrix(i, j);
+					}
+				}
+			}
+		}
+		if (0x0 != local_workspace) {
+			if (local_workspace->m_error) {
+#ifndef BT_ID_WO_BULLET
+				btMutexLock(&m_local_error_mutex);
+#endif
+				m_local_error = true;
+#ifndef BT_ID_WO_BULLET
+				btMutexUnlock(&m_local_error_mutex);
+#endif
+			}
+			delete local_workspace;
+		}
+	}
+};
+
 MultiBodyTree::MultiBodyTree()
 	: m_is_finalized(false),
 	  m_mass_parameters_are_valid(true),
 	  m_accept_invalid_mass_parameters(false),
 	  m_impl(0x0),
-	  m_init_cache(0x0) {
+	  m_init_cache(0x0),
+	  m_batch_generation(0) {
 	m_init_cache = new InitCache();
 }
 
 MultiBodyTree::~MultiBodyTree() {
+	for (idArrayIdx i = 0; i < m_batch_workspaces.size(); i++) {
+		delete m_batch_workspaces[i];
+	}
 	delete m_impl;
 	delete m_init_cache;
 }
@@ -93,6 +214,22 @@ int MultiBodyTree::calculateInverseDynamics(const vecx &q, const vecx &u, const
 	return 0;
 }
 
+int MultiBodyTree::calculateInverseDynamicsDerivatives(const vecx &q, const vecx &u,
+													   const vecx &dot_u, vecx *joint_forces,
+													   matxx *d_joint_forces_d_q,
+													   matxx *d_joint_forces_d_u) {
+	if (false == m_is_finalized) {
+		error_message("system has not been initialized\n");
+		return -1;
+	}
+	if (-1 == m_impl->calculateInverseDynamicsDerivatives(q, u, dot_u, joint_forces,
+														  d_joint_forces_d_q, d_joint_forces_d_u)) {
+		error_message("error in inverse dynamics derivative calculation\n");
+		return -1;
+	}
+	return 0;
+}
+
 int MultiBodyTree::calculateMassMatrix(const vecx &q, const bool update_kinematics,
 									   const bool initialize_matrix,
 									   const bool set_lower_triangular_matrix, matxx *mass_matrix) {
@@ -113,6 +250,77 @@ int MultiBodyTree::calculateMassMatrix(const vecx &q, matxx *mass_matrix) {
 	return calculateMassMatrix(q, true, true, true, mass_matrix);
 }
 
+int MultiBodyTree::calculateBatch(const int num_configurations, const idScalar *q,
+								  const idScalar *u, const idScalar *dot_u, idScalar *output) {
+	if (false == m_is_finalized) {
+		error_message("system has not been initialized\n");
+		return -1;
+	}
+	if (num_configurations < 0) {
+		error_message("number of configurations must be positive (got %d)\n",
+					  num_configurations);
+		return -1;
+	}
+	if (0 == num_configurations) {
+		return 0;
+	}
+	if (0 == m_batch_workspaces.size()) {
+#ifndef BT_ID_WO_BULLET
+		m_batch_workspaces.resize(BT_MAX_THREAD_COUNT, 0x0);
+#else
+		m_batch_workspaces.resize(1, 0x0);
+#endif
+	}
+	m_batch_generation++;
+
+	BatchLoop loop;
+	loop.m_tree = this;
+	loop.m_q = q;
+	loop.m_u = u;
+	loop.m_dot_u = dot_u;
+	loop.m_output = output;
+	loop.m_local_error = false;
+#ifndef BT_ID_WO_BULLET
+	// a configuration takes in the order of a microsecond for small trees,
+	// so hand out several per task
+	const int grain_size = 8;
+	btParallelFor(0, num_configurations, grain_size, loop);
+#else
+	loop.forLoop(0, num_configurations);
+#endif
+
+	if (loop.m_local_error) {
+		return -1;
+	}
+	for (idArrayIdx i = 0; i < m_batch_workspaces.size(); i++) {
+		const BatchWorkspace *workspace = m_batch_workspaces[i];
+		if (0x0 != workspace && workspace->m_generation == m_batch_generation &&
+			workspace->m_error) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int MultiBodyTree::calculateInverseDynamicsBatch(const int num_configurations, const idScalar *q,
+												 const idScalar *u, const idScalar *dot_u,
+												 idScalar *joint_forces) {
+	if (-1 == calculateBatch(num_configurations, q, u, dot_u, joint_forces)) {
+		error_message("error in batch inverse dynamics calculation\n");
+		return -1;
+	}
+	return 0;
+}
+
+int MultiBodyTree::calculateMassMatrixBatch(const int num_configurations, const idScalar *q,
+											idScalar *mass_matrices) {
+	if (-1 == calculateBatch(num_configurations, q, 0x0, 0x0, mass_matrices)) {
+		error_message("error in batch mass matrix calculation\n");
+		return -1;
+	}
+	return 0;
+}
+
 
 
 int MultiBodyTree::calculateKinematics(const vecx& q, const vecx& u, const vecx& dot_u) {
@@ -130,6 +130,26 @@ public:
 	/// @return 0 on success, -1 on error
 	int calculateInverseDynamics(const vecx& q, const vecx& u, const vecx& dot_u,
 								 vecx* joint_forces);
+	/// Calculate joint forces as calculateInverseDynamics, and their partial derivatives
+	/// with respect to the generalized coordinates and velocities.
+	/// The derivatives are calculated analytically by differentiating the recursive
+	/// algorithm, one column at a time. The derivative with respect to dot_u is the
+	/// mass matrix (see calculateMassMatrix).
+	/// Debug builds in double precision check the result against central differences
+	/// and print a warning for derivatives that don't agree.
+	/// @param q generalized coordinates
+	/// @param u generalized velocities
+	/// @param dot_u time derivative of u
+	/// @param joint_forces this is where the resulting joint forces will be
+	///		stored. dim(joint_forces) = dim(u)
+	/// @param d_joint_forces_d_q matrix for the derivative of joint_forces w.r.t. q,
+	///		element (i,j) is d(joint_forces(i))/d(q(j)). (should be dim(u)xdim(q))
+	/// @param d_joint_forces_d_u matrix for the derivative of joint_forces w.r.t. u
+	///		(should be dim(u)xdim(u))
+	/// @return 0 on success, -1 on error
+	int calculateInverseDynamicsDerivatives(const vecx& q, const vecx& u, const vecx& dot_u,
+											vecx* joint_forces, matxx* d_joint_forces_d_q,
+											matxx* d_joint_forces_d_u);
 	/// Calculate joint space mass matrix
 	/// @param q generalized coordinates
 	/// @param initialize_matrix if true, initialize mass matrix with zero.
@@ -152,6 +172,35 @@ public:
 	/// @return -1 on error, 0 on success
 	int calculateMassMatrix(const vecx& q, matxx* mass_matrix);
 
+	/// Calculate joint forces for a batch of configurations, as calculateInverseDynamics.
+	/// The configurations are distributed over the threads of the task scheduler
+	/// (see btParallelFor), each thread works on its own copy of the tree's
+	/// internal state. The body state returned by the getBody* functions is not updated.
+	/// Memory for the per-thread copies is allocated on first use, so the first call
+	/// is not real-time safe. Threads with an index of BT_MAX_THREAD_COUNT or more
+	/// (see btGetCurrentThreadIndex) allocate a temporary copy on every call.
+	/// The per-thread copies belong to the tree, so batch calls must not run
+	/// concurrently on the same tree, not even from different threads.
+	/// @param num_configurations number of configurations
+	/// @param q generalized coordinates, numDoFs() consecutive values per configuration
+	/// @param u generalized velocities, same layout as q
+	/// @param dot_u time derivative of u, same layout as q
+	/// @param joint_forces this is where the resulting joint forces will be
+	///		stored, same layout as q
+	/// @return 0 on success, -1 on error
+	int calculateInverseDynamicsBatch(const int num_configurations, const idScalar* q,
+									  const idScalar* u, const idScalar* dot_u,
+									  idScalar* joint_forces);
+	/// Calculate joint space mass matrices for a batch of configurations, as
+	/// calculateMassMatrix(q, mass_matrix). See calculateInverseDynamicsBatch.
+	/// @param num_configurations number of configurations
+	/// @param q generalized coordinates, numDoFs() consecutive values per configuration
+	/// @param mass_matrices this is where the mass matrices are stored,
+	///		numDoFs()*numDoFs() consecutive values per configuration, row major
+	/// @return 0 on success, -1 on error
+	int calculateMassMatrixBatch(const int num_configurations, const idScalar* q,
+								 idScalar* mass_matrices);
+
 
         /// Calculates kinematics also calculated in calculateInverseDynamics,
         /// but not dynamics.
@@ -358,6 +407,16 @@ private:
 	// cache data structure for initialization
 	class InitCache;
 	InitCache* m_init_cache;
+	// per-thread copies of the implementation for the batch calculations
+	class BatchWorkspace;
+	idArray<BatchWorkspace*>::type m_batch_workspaces;
+	// incremented on every batch call, workspaces with a different
+	// generation copy the current body data before use
+	int m_batch_generation;
+	// btParallelFor loop body for the batch calculations
+	class BatchLoop;
+	int calculateBatch(const int num_configurations, const idScalar* q, const idScalar* u,
+					   const idScalar* dot_u, idScalar* output);
 };
 }  // namespace btInverseDynamics
 #endif  // MULTIBODYTREE_HPP_
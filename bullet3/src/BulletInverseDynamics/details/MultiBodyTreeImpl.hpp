@@ -8,6 +8,12 @@
 #include "../IDConfig.hpp"
 #include "../MultiBodyTree.hpp"
 
+// debug builds in double precision compare the inverse dynamics derivatives with central differences,
+// in single precision the differences are too inaccurate for a check
+#if (defined BT_ID_USE_DOUBLE_PRECISION) && (defined _DEBUG || defined DEBUG) && !(defined BT_ID_CHECK_DERIVATIVES)
+#define BT_ID_CHECK_DERIVATIVES
+#endif
+
 namespace btInverseDynamics {
 
 /// Structure for for rigid body mass properties, connectivity and kinematic state
@@ -111,6 +117,24 @@ struct RigidBody {
 	/// moment of inertia of subtree rooted in this body, w.r.t. body origin, in body-fixed frame
 	mat33 m_body_subtree_I_body;
 
+	// 7 Scratch data for derivatives of the inverse dynamics
+	// (directional derivatives of the kinematic and dynamic quantities above,
+	// for one generalized coordinate or speed at a time)
+	/// derivative of m_body_ang_vel
+	vec3 m_d_body_ang_vel;
+	/// derivative of m_body_vel
+	vec3 m_d_body_vel;
+	/// derivative of m_body_ang_acc
+	vec3 m_d_body_ang_acc;
+	/// derivative of m_body_acc
+	vec3 m_d_body_acc;
+	/// derivative of m_force_at_joint
+	vec3 m_d_force_at_joint;
+	/// derivative of m_moment_at_joint
+	vec3 m_d_moment_at_joint;
+	/// true if the kinematics of this body depend on the coordinate or speed
+	bool m_d_is_affected;
+
 #if (defined BT_ID_HAVE_MAT3X) && (defined BT_ID_WITH_JACOBIANS)
     /// translational jacobian in body-fixed frame d(m_body_vel)/du
     mat3x m_body_Jac_T;
@@ -146,6 +170,10 @@ public:
 	/// \copydoc MultiBodyTree::calculateInverseDynamics
 	int calculateInverseDynamics(const vecx& q, const vecx& u, const vecx& dot_u,
 								 vecx* joint_forces);
+	/// \copydoc MultiBodyTree::calculateInverseDynamicsDerivatives
+	int calculateInverseDynamicsDerivatives(const vecx& q, const vecx& u, const vecx& dot_u,
+											vecx* joint_forces, matxx* d_joint_forces_d_q,
+											matxx* d_joint_forces_d_u);
 	///\copydoc MultiBodyTree::calculateMassMatrix
 	int calculateMassMatrix(const vecx& q, const bool update_kinematics,
 							const bool initialize_matrix, const bool set_lower_triangular_matrix,
@@ -240,8 +268,28 @@ public:
 	int addUserForce(const int body_index, const vec3& body_force);
 	/// \copydoc MultiBodyTree::addUserMoment
 	int addUserMoment(const int body_index, const vec3& body_moment);
+	/// copy mass properties, user forces & moments and gravity from another
+	/// instance of the same tree. This does not allocate memory.
+	/// @param other the source, must have been copied from the same tree
+	void copyBodyDataFrom(const MultiBodyImpl& other);
 
 private:
+	// calculate one column of the inverse dynamics derivative matrix, for a change of the
+	// joint variables of one body. Only the body's subtree and its ancestors are visited.
+	// The change is given by the rotation of the body frame (d(body_T_parent) =
+	// -tilde(body_d_rot)*body_T_parent) and the changes of the relative kinematics.
+	void calculateInverseDynamicsTangent(const int body_index, const vec3& body_d_rot,
+										 const vec3& d_parent_pos_parent_body,
+										 const vec3& d_body_ang_vel_rel, const vec3& d_parent_vel_rel,
+										 const vec3& d_parent_acc_rel, const int column,
+										 matxx* d_joint_forces);
+#ifdef BT_ID_CHECK_DERIVATIVES
+	// debug function. compare the derivatives with central differences of calculateInverseDynamics
+	// and print a warning if they don't agree. Costs 4*dofs inverse dynamics calculations.
+	void checkInverseDynamicsDerivatives(const vecx& q, const vecx& u, const vecx& dot_u,
+										 const matxx& d_joint_forces_d_q,
+										 const matxx& d_joint_forces_d_u);
+#endif
 	// debug function. print tree structure to stdout
 	void printTree(int index, int indentation);
 	// get string representation of JointType (for debugging)
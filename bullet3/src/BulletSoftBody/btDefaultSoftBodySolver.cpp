@@ -20,6 +20,86 @@ subject to the following restrictions:
 #include "btDefaultSoftBodySolver.h"
 #include "BulletCollision/CollisionShapes/btCapsuleShape.h"
 #include "BulletSoftBody/btSoftBody.h"
+#include "BulletSoftBody/btSoftBodyIslands.h"
+#include "BulletDynamics/Featherstone/btMultiBodyLinkCollider.h"
+#include "LinearMath/btThreads.h"
+
+
+struct btDefaultSoftBodySolver::SoftBodyLoop : public btIParallelForBody
+{
+	btDefaultSoftBodySolver* m_solver;
+	SoftBodyStage m_stage;
+	btScalar m_timeStep;
+
+	SoftBodyLoop(btDefaultSoftBodySolver* solver, SoftBodyStage stage, btScalar timeStep)
+		:m_solver(solver),
+		m_stage(stage),
+		m_timeStep(timeStep)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		m_solver->processSoftBodyRange(m_stage, m_timeStep, iBegin, iEnd);
+	}
+};
+
+struct btDefaultSoftBodySolver::SoftBodyIslandLoop : public btIParallelForBody
+{
+	const btAlignedObjectArray< btSoftBody * >* m_bodies;
+	const btSoftBodyIslands* m_islands;
+
+	SoftBodyIslandLoop(const btAlignedObjectArray< btSoftBody * >* bodies, const btSoftBodyIslands* islands)
+		:m_bodies(bodies),
+		m_islands(islands)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int island = iBegin; island < iEnd; ++island)
+		{
+			const int* bodies = m_islands->getIslandBodies(island);
+			for (int i = 0; i < m_islands->getIslandSize(island); ++i)
+			{
+				(*m_bodies)[bodies[i]]->solveConstraints();
+			}
+		}
+	}
+};
+
+//range of the faces of a soft body, used to find the owner of the face of a soft contact
+struct btSoftBodyFaceRange
+{
+	const btSoftBody::Face* m_begin;
+	const btSoftBody::Face* m_end;
+	const btSoftBody* m_body;
+};
+
+struct btSoftBodyFaceRangeSortPredicate
+{
+	bool operator() (const btSoftBodyFaceRange& a, const btSoftBodyFaceRange& b) const
+	{
+		return a.m_begin < b.m_begin;
+	}
+};
+
+static const btSoftBody* btFindFaceOwner(const btAlignedObjectArray<btSoftBodyFaceRange>& ranges, const btSoftBody::Face* face)
+{
+	int lo = 0;
+	int hi = ranges.size() - 1;
+	while (lo <= hi)
+	{
+		int mid = (lo + hi) >> 1;
+		if (face < ranges[mid].m_begin)
+			hi = mid - 1;
+		else if (face >= ranges[mid].m_end)
+			lo = mid + 1;
+		else
+			return ranges[mid].m_body;
+	}
+	return 0;
+}
 
 
 btDefaultSoftBodySolver::btDefaultSoftBodySolver()
@@ -28,10 +108,102 @@ btDefaultSoftBodySolver::btDefaultSoftBodySolver()
 	// For now this is global for the cloths linked with this solver - we should probably make this body specific 
 	// for performance in future once we understand more clearly when constants need to be updated
 	m_updateSolverConstants = true;
+	m_softBodyGrainSize = 1;
+	void* mem = btAlignedAlloc(sizeof(btSoftBodyIslands), 16);
+	m_islands = new (mem) btSoftBodyIslands();
 }
 
 btDefaultSoftBodySolver::~btDefaultSoftBodySolver()
 {
+	m_islands->~btSoftBodyIslands();
+	btAlignedFree(m_islands);
+}
+
+void btDefaultSoftBodySolver::processSoftBodyRange(SoftBodyStage stage, btScalar timeStep, int iBegin, int iEnd)
+{
+	for (int i = iBegin; i < iEnd; ++i)
+	{
+		btSoftBody* psb = m_softBodySet[i];
+		if (!psb->isActive())
+			continue;
+		switch (stage)
+		{
+		case SOFTBODY_PREDICT_MOTION:
+			//the broadphase is updated afterwards, it can't be updated by several threads at once
+			psb->predictMotion(timeStep, false);
+			break;
+		case SOFTBODY_INTEGRATE_MOTION:
+			psb->integrateMotion();
+			break;
+		}
+	}
+}
+
+void btDefaultSoftBodySolver::processSoftBodies(SoftBodyStage stage, btScalar timeStep)
+{
+	btParallelFor(0, m_softBodySet.size(), m_softBodyGrainSize, SoftBodyLoop(this, stage, timeStep));
+}
+
+void btDefaultSoftBodySolver::buildIslands()
+{
+	// A body is coupled with everything its constraints write to: anchored and touched rigid bodies,
+	// multibodies and the soft bodies owning the faces of its soft contacts
+	btAlignedObjectArray<btSoftBodyFaceRange> faceRanges;
+	int i;
+	for (i = 0; i < m_softBodySet.size(); ++i)
+	{
+		const btSoftBody* psb = m_softBodySet[i];
+		if (psb->m_faces.size())
+		{
+			btSoftBodyFaceRange range;
+			range.m_begin = &psb->m_faces[0];
+			range.m_end = range.m_begin + psb->m_faces.size();
+			range.m_body = psb;
+			faceRanges.push_back(range);
+		}
+	}
+	faceRanges.quickSort(btSoftBodyFaceRangeSortPredicate());
+
+	m_islands->reset(m_activeSoftBodies.size());
+	for (i = 0; i < m_activeSoftBodies.size(); ++i)
+	{
+		m_islands->couple(i, m_activeSoftBodies[i]);
+	}
+	for (i = 0; i < m_activeSoftBodies.size(); ++i)
+	{
+		const btSoftBody* psb = m_activeSoftBodies[i];
+		int j;
+		for (j = 0; j < psb->m_anchors.size(); ++j)
+		{
+			const btRigidBody* body = psb->m_anchors[j].m_body;
+			if (!body->isStaticOrKinematicObject())
+				m_islands->couple(i, body);
+		}
+		for (j = 0; j < psb->m_rcontacts.size(); ++j)
+		{
+			const btCollisionObject* colObj = psb->m_rcontacts[j].m_cti.m_colObj;
+			if (!colObj->hasContactResponse())
+				continue;
+			if (colObj->getInternalType() == btCollisionObject::CO_FEATHERSTONE_LINK)
+			{
+				const btMultiBodyLinkCollider* multibodyLinkCol = btMultiBodyLinkCollider::upcast(colObj);
+				if (multibodyLinkCol)
+					m_islands->couple(i, multibodyLinkCol->m_multiBody);
+			}
+			else if (!colObj->isStaticOrKinematicObject())
+			{
+				m_islands->couple(i, colObj);
+			}
+		}
+		for (j = 0; j < psb->m_scontacts.size(); ++j)
+		{
+			const btSoftBody* owner = btFindFaceOwner(faceRanges, psb->m_scontacts[j].m_face);
+			btAssert(owner);
+			if (owner && owner != psb)
+				m_islands->couple(i, owner);
+		}
+	}
+	m_islands->build();
 }
 
 // In this case the data is already in the soft bodies so there is no need for us to do anything
@@ -47,14 +219,7 @@ void btDefaultSoftBodySolver::optimize( btAlignedObjectArray< btSoftBody * > &so
 
 void btDefaultSoftBodySolver::updateSoftBodies( )
 {
-	for ( int i=0; i < m_softBodySet.size(); i++)
-	{
-		btSoftBody*	psb=(btSoftBody*)m_softBodySet[i];
-		if (psb->isActive())
-		{
-			psb->integrateMotion();	
-		}
-	}
+	processSoftBodies(SOFTBODY_INTEGRATE_MOTION, btScalar(0));
 } // updateSoftBodies
 
 bool btDefaultSoftBodySolver::checkInitialized()
@@ -65,14 +230,27 @@ bool btDefaultSoftBodySolver::checkInitialized()
 void btDefaultSoftBodySolver::solveConstraints( float solverdt )
 {
 	// Solve constraints for non-solver softbodies
+	m_activeSoftBodies.resize(0);
 	for(int i=0; i < m_softBodySet.size(); ++i)
 	{
 		btSoftBody*	psb = static_cast<btSoftBody*>(m_softBodySet[i]);
 		if (psb->isActive())
 		{
-			psb->solveConstraints();
+			m_activeSoftBodies.push_back(psb);
 		}
-	}	
+	}
+	if (m_activeSoftBodies.size() > 1 && btGetTaskScheduler()->getNumThreads() > 1)
+	{
+		buildIslands();
+		btParallelFor(0, m_islands->getNumIslands(), 1, SoftBodyIslandLoop(&m_activeSoftBodies, m_islands));
+	}
+	else
+	{
+		for(int i=0; i < m_activeSoftBodies.size(); ++i)
+		{
+			m_activeSoftBodies[i]->solveConstraints();
+		}
+	}
 } // btDefaultSoftBodySolver::solveConstraints
 
 
@@ -138,13 +316,14 @@ void btDefaultSoftBodySolver::processCollision( btSoftBody *softBody, const btCo
 
 void btDefaultSoftBodySolver::predictMotion( float timeStep )
 {
+	processSoftBodies(SOFTBODY_PREDICT_MOTION, timeStep);
 	for ( int i=0; i < m_softBodySet.size(); ++i)
 	{
 		btSoftBody*	psb = m_softBodySet[i];
 
 		if (psb->isActive())
 		{
-			psb->predictMotion(timeStep);		
+			psb->updateBroadphaseAabb();
 		}
 	}
 }
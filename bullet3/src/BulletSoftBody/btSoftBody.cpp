@@ -18,6 +18,7 @@ subject to the following restrictions:
 #include "BulletSoftBody/btSoftBodySolvers.h"
 #include "btSoftBodyData.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
 #include "BulletDynamics/Featherstone/btMultiBodyLinkCollider.h"
 #include "BulletDynamics/Featherstone/btMultiBodyConstraint.h"
 
@@ -267,6 +268,7 @@ void			btSoftBody::appendLink(int model,Material* mat)
 	else
 	{ ZeroInitialize(l);l.m_material=mat?mat:m_materials[0]; }
 	m_links.push_back(l);
+	m_linkBatches.resize(0);
 }
 
 //
@@ -1163,6 +1165,7 @@ void			btSoftBody::randomizeConstraints()
 #define NEXTRAND (seed=(1664525L*seed+1013904223L)&0xffffffff)
 	int i,ni;
 
+	m_linkBatches.resize(0);
 	for(i=0,ni=m_links.size();i<ni;++i)
 	{
 		btSwap(m_links[i],m_links[NEXTRAND%ni]);
@@ -1174,6 +1177,63 @@ void			btSoftBody::randomizeConstraints()
 #undef NEXTRAND
 }
 
+//
+void			btSoftBody::generateLinkBatches()
+{
+	const int	nl=m_links.size();
+	m_linkBatches.resize(0);
+	if(nl==0) return;
+	/* Greedy coloring, each pass takes every remaining link whose nodes are free	*/ 
+	btAlignedObjectArray<int>	nodeBatch;
+	btAlignedObjectArray<int>	linkBatch;
+	nodeBatch.resize(m_nodes.size(),-1);
+	linkBatch.resize(nl,-1);
+	const Node*	nbase=&m_nodes[0];
+	int			remaining=nl;
+	int i;
+	for(int batch=0;remaining>0;++batch)
+	{
+		int	count=0;
+		for(i=0;i<nl;++i)
+		{
+			if(linkBatch[i]>=0) continue;
+			const int	ia=int(m_links[i].m_n[0]-nbase);
+			const int	ib=int(m_links[i].m_n[1]-nbase);
+			if((nodeBatch[ia]==batch)||(nodeBatch[ib]==batch)) continue;
+			nodeBatch[ia]=nodeBatch[ib]=batch;
+			linkBatch[i]=batch;
+			++count;
+		}
+		m_linkBatches.push_back(count);
+		remaining-=count;
+	}
+	/* Offsets				*/ 
+	btAlignedObjectArray<int>	next;
+	next.resize(m_linkBatches.size());
+	int	start=0;
+	for(i=0;i<m_linkBatches.size();++i)
+	{
+		next[i]=start;
+		start+=m_linkBatches[i];
+		m_linkBatches[i]=next[i];
+	}
+	m_linkBatches.push_back(nl);
+	/* Reorder, keeping the original order within a batch	*/ 
+	tLinkArray	links;
+	links.resize(nl);
+	for(i=0;i<nl;++i)
+	{
+		links[next[linkBatch[i]]++]=m_links[i];
+	}
+	m_links.copyFromArray(links);
+}
+
+//
+bool			btSoftBody::hasLinkBatches() const
+{
+	return((m_linkBatches.size()>0)&&(m_linkBatches[m_linkBatches.size()-1]==m_links.size()));
+}
+
 //
 void			btSoftBody::releaseCluster(int index)
 {
@@ -1402,6 +1462,7 @@ void			btSoftBody::refine(ImplicitFn* ifn,btScalar accurary,bool cut)
 			{
 				btSwap(m_links[i],m_links[m_links.size()-1]);
 				m_links.pop_back();--i;
+				m_linkBatches.resize(0);
 			}
 		}	
 	}
@@ -1605,6 +1666,7 @@ void			btSoftBody::refine(ImplicitFn* ifn,btScalar accurary,bool cut)
 				--ranks[id[1]];
 				btSwap(m_links[i],m_links[m_links.size()-1]);
 				m_links.pop_back();--i;
+				m_linkBatches.resize(0);
 			}
 		}
 #if 0	
@@ -1738,7 +1800,7 @@ void			btSoftBody::setSolver(eSolverPresets::_ preset)
 }
 
 //
-void			btSoftBody::predictMotion(btScalar dt)
+void			btSoftBody::predictMotion(btScalar dt,bool updateBroadphase)
 {
 
 	int i,ni;
@@ -1792,7 +1854,7 @@ void			btSoftBody::predictMotion(btScalar dt)
 	/* Clusters				*/ 
 	updateClusters();
 	/* Bounds				*/ 
-	updateBounds();	
+	updateBounds(updateBroadphase);	
 	/* Nodes				*/ 
 	ATTRIBUTE_ALIGNED16(btDbvtVolume)	vol;
 	for(i=0,ni=m_nodes.size();i<ni;++i)
@@ -1861,6 +1923,20 @@ void			btSoftBody::solveConstraints()
 		l.m_c3		=	l.m_n[1]->m_q-l.m_n[0]->m_q;
 		l.m_c2		=	1/(l.m_c3.length2()*l.m_c0);
 	}
+	if(hasLinkBatches())
+	{
+		const Node*	nbase=&m_nodes[0];
+		m_packedLinks.resize(m_links.size());
+		for(i=0,ni=m_links.size();i<ni;++i)
+		{
+			const Link&	l=m_links[i];
+			PackedLink&	pl=m_packedLinks[i];
+			pl.m_n[0]	=	int(l.m_n[0]-nbase);
+			pl.m_n[1]	=	int(l.m_n[1]-nbase);
+			pl.m_c0		=	l.m_c0;
+			pl.m_c1		=	l.m_c1;
+		}
+	}
 	/* Prepare anchors		*/ 
 	for(i=0,ni=m_anchors.size();i<ni;++i)
 	{
@@ -1937,6 +2013,8 @@ void			btSoftBody::solveConstraints()
 	/* Apply clusters		*/ 
 	dampClusters();
 	applyClusters(true);
+	/* The packed links are only valid during this step	*/ 
+	m_packedLinks.resize(0);
 }
 
 //
@@ -1957,27 +2035,94 @@ void			btSoftBody::solveCommonConstraints(btSoftBody** /*bodies*/,int /*count*/,
 	/// placeholder
 }
 
+//
+// Solves the cluster joints of the islands of soft bodies connected by joints
+//
+struct	btSoftClusterIslandLoop : btIParallelForBody
+{
+	const btAlignedObjectArray<btSoftBody*>*	m_bodies;
+	const btSoftBodyIslands*					m_islands;
+	int											m_iterations;
+	void				forLoop(int iBegin,int iEnd) const
+	{
+		const btScalar sor=1;
+		for(int island=iBegin;island<iEnd;++island)
+		{
+			const int*	bodies=m_islands->getIslandBodies(island);
+			const int	nb=m_islands->getIslandSize(island);
+			for(int i=0;i<m_iterations;++i)
+			{
+				for(int j=0;j<nb;++j)
+				{
+					(*m_bodies)[bodies[j]]->solveClusters(sor);
+				}
+			}
+		}
+	}
+};
+
 //
 void			btSoftBody::solveClusters(const btAlignedObjectArray<btSoftBody*>& bodies)
 {
 	const int	nb=bodies.size();
 	int			iterations=0;
+	int			joints=0;
 	int i;
 
 	for(i=0;i<nb;++i)
 	{
 		iterations=btMax(iterations,bodies[i]->m_cfg.citerations);
+		joints+=bodies[i]->m_joints.size();
 	}
 	for(i=0;i<nb;++i)
 	{
 		bodies[i]->prepareClusters(iterations);
 	}
-	for(i=0;i<iterations;++i)
+	if((joints>0)&&(nb>1)&&(btGetTaskScheduler()->getNumThreads()>1))
 	{
-		const btScalar sor=1;
-		for(int j=0;j<nb;++j)
+		/* Joints couple the bodies of their clusters, and dynamic rigid bodies	*/ 
+		btSoftBodyIslands	islands;
+		islands.reset(nb);
+		for(i=0;i<nb;++i)
 		{
-			bodies[j]->solveClusters(sor);
+			const btSoftBody*	psb=bodies[i];
+			for(int j=0;j<psb->m_clusters.size();++j)
+			{
+				islands.couple(i,psb->m_clusters[j]);
+			}
+		}
+		for(i=0;i<nb;++i)
+		{
+			const btSoftBody*	psb=bodies[i];
+			for(int j=0;j<psb->m_joints.size();++j)
+			{
+				const Joint*	joint=psb->m_joints[j];
+				for(int k=0;k<2;++k)
+				{
+					const Body&	body=joint->m_bodies[k];
+					if(body.m_soft)
+						islands.couple(i,body.m_soft);
+					else if(body.m_rigid&&!body.m_rigid->isStaticOrKinematicObject())
+						islands.couple(i,body.m_rigid);
+				}
+			}
+		}
+		islands.build();
+		btSoftClusterIslandLoop	loop;
+		loop.m_bodies=&bodies;
+		loop.m_islands=&islands;
+		loop.m_iterations=iterations;
+		btParallelFor(0,islands.getNumIslands(),1,loop);
+	}
+	else
+	{
+		for(i=0;i<iterations;++i)
+		{
+			const btScalar sor=1;
+			for(int j=0;j<nb;++j)
+			{
+				bodies[j]->solveClusters(sor);
+			}
 		}
 	}
 	for(i=0;i<nb;++i)
@@ -2303,7 +2448,7 @@ void					btSoftBody::updateNormals()
 }
 
 //
-void					btSoftBody::updateBounds()
+void					btSoftBody::updateBounds(bool updateBroadphase)
 {
 	/*if( m_acceleratedSoftBody )
 	{
@@ -2327,12 +2472,9 @@ void					btSoftBody::updateBounds()
 				csm)*1; // ??? to investigate...
 			m_bounds[0]=mins-mrg;
 			m_bounds[1]=maxs+mrg;
-			if(0!=getBroadphaseHandle())
-			{					
-				m_worldInfo->m_broadphase->setAabb(	getBroadphaseHandle(),
-					m_bounds[0],
-					m_bounds[1],
-					m_worldInfo->m_dispatcher);
+			if(updateBroadphase)
+			{
+				updateBroadphaseAabb();
 			}
 		}
 		else
@@ -2343,6 +2485,17 @@ void					btSoftBody::updateBounds()
 	//}
 }
 
+//
+void					btSoftBody::updateBroadphaseAabb()
+{
+	if(m_ndbvt.m_root&&(0!=getBroadphaseHandle()))
+	{					
+		m_worldInfo->m_broadphase->setAabb(	getBroadphaseHandle(),
+			m_bounds[0],
+			m_bounds[1],
+			m_worldInfo->m_dispatcher);
+	}
+}
 
 //
 void					btSoftBody::updatePose()
@@ -3127,15 +3280,15 @@ void				btSoftBody::PSolve_SContacts(btSoftBody* psb,btScalar,btScalar ti)
 }
 
 //
-void				btSoftBody::PSolve_Links(btSoftBody* psb,btScalar kst,btScalar ti)
+static inline void	PSolveLinkRange(btSoftBody* psb,int begin,int end,btScalar kst)
 {
-	for(int i=0,ni=psb->m_links.size();i<ni;++i)
+	for(int i=begin;i<end;++i)
 	{			
-		Link&	l=psb->m_links[i];
+		btSoftBody::Link&	l=psb->m_links[i];
 		if(l.m_c0>0)
 		{
-			Node&			a=*l.m_n[0];
-			Node&			b=*l.m_n[1];
+			btSoftBody::Node&	a=*l.m_n[0];
+			btSoftBody::Node&	b=*l.m_n[1];
 			const btVector3	del=b.m_x-a.m_x;
 			const btScalar	len=del.length2();
 			if (l.m_c1+len > SIMD_EPSILON)
@@ -3149,18 +3302,181 @@ void				btSoftBody::PSolve_Links(btSoftBody* psb,btScalar kst,btScalar ti)
 }
 
 //
-void				btSoftBody::VSolve_Links(btSoftBody* psb,btScalar kst)
+static inline void	VSolveLinkRange(btSoftBody* psb,int begin,int end,btScalar kst)
 {
-	for(int i=0,ni=psb->m_links.size();i<ni;++i)
+	for(int i=begin;i<end;++i)
 	{			
-		Link&			l=psb->m_links[i];
-		Node**			n=l.m_n;
-		const btScalar	j=-btDot(l.m_c3,n[0]->m_v-n[1]->m_v)*l.m_c2*kst;
+		btSoftBody::Link&	l=psb->m_links[i];
+		btSoftBody::Node**	n=l.m_n;
+		const btScalar		j=-btDot(l.m_c3,n[0]->m_v-n[1]->m_v)*l.m_c2*kst;
 		n[0]->m_v+=	l.m_c3*(j*n[0]->m_im);
 		n[1]->m_v-=	l.m_c3*(j*n[1]->m_im);
 	}
 }
 
+//
+// Packed link kernels, the links of a batch are solved on m_packedNodes (x,y,z,1/mass per node),
+// four at a time with SSE: the nodes of four links are transposed into registers holding one
+// coordinate of the four links, which is valid since the links of a batch share no node.
+//
+#if !defined (BT_USE_DOUBLE_PRECISION) && !defined (BT_DETERMINISTIC)
+#if defined (BT_USE_SSE) || defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BT_SOFTBODY_SSE
+#include <xmmintrin.h>
+#endif
+#endif //!BT_USE_DOUBLE_PRECISION && !BT_DETERMINISTIC
+
+//
+static inline void	PSolvePackedLink(btScalar* nodes,const btSoftBody::PackedLink& l,btScalar kst)
+{
+	if(l.m_c0>0)
+	{
+		btScalar*		a=&nodes[l.m_n[0]*4];
+		btScalar*		b=&nodes[l.m_n[1]*4];
+		const btScalar	dx=b[0]-a[0];
+		const btScalar	dy=b[1]-a[1];
+		const btScalar	dz=b[2]-a[2];
+		const btScalar	len=dx*dx+dy*dy+dz*dz;
+		if (l.m_c1+len > SIMD_EPSILON)
+		{
+			const btScalar	k=((l.m_c1-len)/(l.m_c0*(l.m_c1+len)))*kst;
+			const btScalar	ka=k*a[3];
+			const btScalar	kb=k*b[3];
+			a[0]-=dx*ka;a[1]-=dy*ka;a[2]-=dz*ka;
+			b[0]+=dx*kb;b[1]+=dy*kb;b[2]+=dz*kb;
+		}
+	}
+}
+
+//
+static inline void	PSolvePackedLinkRange(btScalar* nodes,const btSoftBody::PackedLink* links,int begin,int end,btScalar kst)
+{
+	int i=begin;
+#ifdef BT_SOFTBODY_SSE
+	const __m128	vkst=_mm_set1_ps(kst);
+	const __m128	veps=_mm_set1_ps(SIMD_EPSILON);
+	const __m128	vzero=_mm_setzero_ps();
+	for(;i+4<=end;i+=4)
+	{
+		const btSoftBody::PackedLink*	l=&links[i];
+		float*	a0=&nodes[l[0].m_n[0]*4];
+		float*	a1=&nodes[l[1].m_n[0]*4];
+		float*	a2=&nodes[l[2].m_n[0]*4];
+		float*	a3=&nodes[l[3].m_n[0]*4];
+		float*	b0=&nodes[l[0].m_n[1]*4];
+		float*	b1=&nodes[l[1].m_n[1]*4];
+		float*	b2=&nodes[l[2].m_n[1]*4];
+		float*	b3=&nodes[l[3].m_n[1]*4];
+		/* Links				*/ 
+		__m128	n0=_mm_load_ps((const float*)&l[0]);
+		__m128	n1=_mm_load_ps((const float*)&l[1]);
+		__m128	c0=_mm_load_ps((const float*)&l[2]);
+		__m128	c1=_mm_load_ps((const float*)&l[3]);
+		_MM_TRANSPOSE4_PS(n0,n1,c0,c1);
+		/* Nodes				*/ 
+		__m128	ax=_mm_load_ps(a0),ay=_mm_load_ps(a1),az=_mm_load_ps(a2),aim=_mm_load_ps(a3);
+		__m128	bx=_mm_load_ps(b0),by=_mm_load_ps(b1),bz=_mm_load_ps(b2),bim=_mm_load_ps(b3);
+		_MM_TRANSPOSE4_PS(ax,ay,az,aim);
+		_MM_TRANSPOSE4_PS(bx,by,bz,bim);
+		/* Solve				*/ 
+		const __m128	dx=_mm_sub_ps(bx,ax);
+		const __m128	dy=_mm_sub_ps(by,ay);
+		const __m128	dz=_mm_sub_ps(bz,az);
+		const __m128	len=_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx,dx),_mm_mul_ps(dy,dy)),_mm_mul_ps(dz,dz));
+		const __m128	sum=_mm_add_ps(c1,len);
+		const __m128	mask=_mm_and_ps(_mm_cmpgt_ps(c0,vzero),_mm_cmpgt_ps(sum,veps));
+		const __m128	k=_mm_and_ps(mask,_mm_mul_ps(_mm_div_ps(_mm_sub_ps(c1,len),_mm_mul_ps(c0,sum)),vkst));
+		const __m128	ka=_mm_mul_ps(k,aim);
+		const __m128	kb=_mm_mul_ps(k,bim);
+		ax=_mm_sub_ps(ax,_mm_mul_ps(dx,ka));
+		ay=_mm_sub_ps(ay,_mm_mul_ps(dy,ka));
+		az=_mm_sub_ps(az,_mm_mul_ps(dz,ka));
+		bx=_mm_add_ps(bx,_mm_mul_ps(dx,kb));
+		by=_mm_add_ps(by,_mm_mul_ps(dy,kb));
+		bz=_mm_add_ps(bz,_mm_mul_ps(dz,kb));
+		/* Store				*/ 
+		_MM_TRANSPOSE4_PS(ax,ay,az,aim);
+		_MM_TRANSPOSE4_PS(bx,by,bz,bim);
+		_mm_store_ps(a0,ax);_mm_store_ps(a1,ay);_mm_store_ps(a2,az);_mm_store_ps(a3,aim);
+		_mm_store_ps(b0,bx);_mm_store_ps(b1,by);_mm_store_ps(b2,bz);_mm_store_ps(b3,bim);
+	}
+#endif //BT_SOFTBODY_SSE
+	for(;i<end;++i)
+	{
+		PSolvePackedLink(nodes,links[i],kst);
+	}
+}
+
+//
+// Solves the links of one batch (see generateLinkBatches), the links of a batch share no node
+//
+struct	btSoftLinkBatchLoop : btIParallelForBody
+{
+	btSoftBody*			m_psb;
+	btScalar			m_kst;
+	bool				m_velocities;
+	void				forLoop(int iBegin,int iEnd) const
+	{
+		if(m_velocities)
+			VSolveLinkRange(m_psb,iBegin,iEnd,m_kst);
+		else
+			PSolvePackedLinkRange(&m_psb->m_packedNodes[0],&m_psb->m_packedLinks[0],iBegin,iEnd,m_kst);
+	}
+};
+
+//
+static void			SolveLinkBatches(btSoftBody* psb,btScalar kst,bool velocities)
+{
+	/* links handed to a thread at once	*/ 
+	const int			grainSize=256;
+	btSoftLinkBatchLoop	loop;
+	loop.m_psb=psb;
+	loop.m_kst=kst;
+	loop.m_velocities=velocities;
+	for(int i=0,ni=psb->m_linkBatches.size()-1;i<ni;++i)
+	{
+		btParallelFor(psb->m_linkBatches[i],psb->m_linkBatches[i+1],grainSize,loop);
+	}
+}
+
+//
+void				btSoftBody::PSolve_Links(btSoftBody* psb,btScalar kst,btScalar ti)
+{
+	if(psb->hasLinkBatches()&&(psb->m_packedLinks.size()==psb->m_links.size()))
+	{
+		/* Gather				*/ 
+		const int	nn=psb->m_nodes.size();
+		psb->m_packedNodes.resize(nn*4);
+		btScalar*	nodes=&psb->m_packedNodes[0];
+		int i;
+		for(i=0;i<nn;++i)
+		{
+			const Node&	n=psb->m_nodes[i];
+			nodes[i*4+0]=n.m_x.x();
+			nodes[i*4+1]=n.m_x.y();
+			nodes[i*4+2]=n.m_x.z();
+			nodes[i*4+3]=n.m_im;
+		}
+		SolveLinkBatches(psb,kst,false);
+		/* Scatter				*/ 
+		for(i=0;i<nn;++i)
+		{
+			psb->m_nodes[i].m_x.setValue(nodes[i*4+0],nodes[i*4+1],nodes[i*4+2]);
+		}
+	}
+	else
+		PSolveLinkRange(psb,0,psb->m_links.size(),kst);
+}
+
+//
+void				btSoftBody::VSolve_Links(btSoftBody* psb,btScalar kst)
+{
+	if(psb->hasLinkBatches())
+		SolveLinkBatches(psb,kst,true);
+	else
+		VSolveLinkRange(psb,0,psb->m_links.size(),kst);
+}
+
 //
 btSoftBody::psolver_t	btSoftBody::getSolver(ePSolver::_ solver)
 {
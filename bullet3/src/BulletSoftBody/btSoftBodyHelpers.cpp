@@ -553,6 +553,9 @@ void btSoftBodyHelpers::ReoptimizeLinkOrder(btSoftBody *psb /* This can be repla
 	LinkDeps_t *linkDepFreeList = new LinkDeps_t[2*nLinks];		// Dependent-on-me list elements (2x# of links, maximum)
 	LinkDepsPtr_t *linkDepListStarts = new LinkDepsPtr_t[nLinks];	// Start nodes of dependent-on-me lists, one for each link
 		
+	// The new order invalidates any link batches
+	psb->m_linkBatches.resize(0);
+
 	// Copy the original, unsorted links to a side buffer
 	btSoftBody::Link *linkBuffer = new btSoftBody::Link[nLinks];
 	memcpy(linkBuffer, &(psb->m_links[0]), sizeof(btSoftBody::Link)*nLinks);
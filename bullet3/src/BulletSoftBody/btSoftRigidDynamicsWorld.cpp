@@ -23,6 +23,7 @@ subject to the following restrictions:
 #include "btSoftBodySolvers.h"
 #include "btDefaultSoftBodySolver.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btStateHash.h"
 
 
 btSoftRigidDynamicsWorld::btSoftRigidDynamicsWorld(
@@ -364,4 +365,19 @@ void	btSoftRigidDynamicsWorld::serialize(btSerializer* serializer)
 	serializer->finishSerialization();
 }
 
+void	btSoftRigidDynamicsWorld::calculateStateHash(btStateHash& stateHash) const
+{
+	btDiscreteDynamicsWorld::calculateStateHash(stateHash);
 
+	stateHash.addInt(m_softBodies.size());
+	for (int i=0;i<m_softBodies.size();i++)
+	{
+		const btSoftBody* psb = m_softBodies[i];
+		stateHash.addInt(psb->m_nodes.size());
+		for (int j=0;j<psb->m_nodes.size();j++)
+		{
+			stateHash.addVector3(psb->m_nodes[j].m_x);
+			stateHash.addVector3(psb->m_nodes[j].m_v);
+		}
+	}
+}
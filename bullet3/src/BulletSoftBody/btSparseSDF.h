@@ -19,6 +19,8 @@ subject to the following restrictions:
 
 #include "BulletCollision/CollisionDispatch/btCollisionObject.h"
 #include "BulletCollision/NarrowPhaseCollision/btGjkEpa2.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btThreads.h"
 
 // Modified Paul Hsieh hash
 template <const int DWORDLEN>
@@ -40,6 +42,10 @@ unsigned int HsiehHash(const void* pdata)
 	return(hash);
 }
 
+///btSparseSdf caches the signed distance to convex shapes in cells of CELLSIZE^3 voxels, built when first queried.
+///The hash table is split into shards with their own lock, so Evaluate can be called by several threads at once
+///(see BT_THREADSAFE), cells are built outside of the locks. Each shard keeps its cells in least recently used
+///order, when a shard holds more than its share of the clampCells limit the least recently used cell is evicted.
 template <const int CELLSIZE>
 struct	btSparseSdf
 {
@@ -60,18 +66,42 @@ struct	btSparseSdf
 		unsigned			hash;
 		const btCollisionShape*	pclient;
 		Cell*				next;
+		Cell*				lruprev;
+		Cell*				lrunext;
+	};
+	struct	ShapeStatistics
+	{
+		int					nqueries;	// Evaluate calls
+		int					nbuilds;	// Cells built
+		int					nevictions;	// Cells evicted to stay below the clampCells limit
+		int					ncells;		// Cells currently cached
+	};
+	enum
+	{
+		NUM_SHARDS	=	16
+	};
+	struct	Shard
+	{
+		btSpinMutex			mutex;
+		Cell*				lruhead;	// Most recently used
+		Cell*				lrutail;	// Least recently used
+		int					ncells;
+		int					nprobes;
+		int					nqueries;
+		btHashMap<btHashPtr,ShapeStatistics>	stats;
 	};
 	//
 	// Fields
 	//
 
 	btAlignedObjectArray<Cell*>		cells;	
+	Shard							shards[NUM_SHARDS];
 	btScalar						voxelsz;
 	int								puid;
-	int								ncells;
+	int								ncells;		// As of the last GarbageCollect, see GetNumCells
 	int								m_clampCells;
-	int								nprobes;
-	int								nqueries;	
+	int								nprobes;	// Between the last two GarbageCollect calls
+	int								nqueries;	// Between the last two GarbageCollect calls
 
 	//
 	// Methods
@@ -81,14 +111,15 @@ struct	btSparseSdf
 	void					Initialize(int hashsize=2383, int clampCells = 256*1024)
 	{
 		//avoid a crash due to running out of memory, so clamp the maximum number of cells allocated
-		//if this limit is reached, the SDF is reset (at the cost of some performance during the reset)
+		//if this limit is reached, the least recently used cells are evicted
 		m_clampCells = clampCells;
-		cells.resize(hashsize,0);
 		Reset();
+		cells.resize(hashsize,0);
 	}
 	//
 	void					Reset()
 	{
+		LockAll();
 		for(int i=0,ni=cells.size();i<ni;++i)
 		{
 			Cell*	pc=cells[i];
@@ -100,61 +131,111 @@ struct	btSparseSdf
 				pc=pn;
 			}
 		}
+		for(int i=0;i<NUM_SHARDS;++i)
+		{
+			Shard&	s=shards[i];
+			s.lruhead	=0;
+			s.lrutail	=0;
+			s.ncells	=0;
+			s.nprobes	=1;
+			s.nqueries	=1;
+			s.stats.clear();
+		}
 		voxelsz		=0.25;
 		puid		=0;
 		ncells		=0;
 		nprobes		=1;
 		nqueries	=1;
+		UnlockAll();
 	}
 	//
 	void					GarbageCollect(int lifetime=256)
 	{
+		LockAll();
 		const int life=puid-lifetime;
-		for(int i=0;i<cells.size();++i)
+		ncells=0;
+		nprobes=0;
+		nqueries=0;
+		for(int i=0;i<NUM_SHARDS;++i)
 		{
-			Cell*&	root=cells[i];
-			Cell*	pp=0;
-			Cell*	pc=root;
-			while(pc)
+			Shard&	s=shards[i];
+			/* The least recently used cells are the oldest ones	*/ 
+			while(s.lrutail&&(s.lrutail->puid<life))
 			{
-				Cell*	pn=pc->next;
-				if(pc->puid<life)
-				{
-					if(pp) pp->next=pn; else root=pn;
-					delete pc;pc=pp;--ncells;
-				}
-				pp=pc;pc=pn;
+				Cell*	pc=s.lrutail;
+				Unlink(s,pc);
+				--StatisticsOf(s,pc->pclient).ncells;
+				delete pc;
 			}
+			ncells		+=	s.ncells;
+			nprobes		+=	s.nprobes;
+			nqueries	+=	s.nqueries;
+			s.nprobes	=1;
+			s.nqueries	=1;
 		}
 		//printf("GC[%d]: %d cells, PpQ: %f\r\n",puid,ncells,nprobes/(btScalar)nqueries);
-		nqueries=1;
-		nprobes=1;
 		++puid;	///@todo: Reset puid's when int range limit is reached	*/ 
-		/* else setup a priority list...						*/ 
+		UnlockAll();
 	}
 	//
 	int						RemoveReferences(btCollisionShape* pcs)
 	{
+		LockAll();
 		int	refcount=0;
-		for(int i=0;i<cells.size();++i)
+		ncells=0;
+		for(int i=0;i<NUM_SHARDS;++i)
 		{
-			Cell*&	root=cells[i];
-			Cell*	pp=0;
-			Cell*	pc=root;
+			Shard&	s=shards[i];
+			Cell*	pc=s.lruhead;
 			while(pc)
 			{
-				Cell*	pn=pc->next;
+				Cell*	pn=pc->lrunext;
 				if(pc->pclient==pcs)
 				{
-					if(pp) pp->next=pn; else root=pn;
-					delete pc;pc=pp;++refcount;
+					Unlink(s,pc);
+					delete pc;++refcount;
 				}
-				pp=pc;pc=pn;
+				pc=pn;
 			}
+			s.stats.remove(btHashPtr(pcs));
+			ncells+=s.ncells;
 		}
+		UnlockAll();
 		return(refcount);
 	}
 	//
+	int						GetNumCells()
+	{
+		int	n=0;
+		for(int i=0;i<NUM_SHARDS;++i)
+		{
+			btMutexLock(&shards[i].mutex);
+			n+=shards[i].ncells;
+			btMutexUnlock(&shards[i].mutex);
+		}
+		return(n);
+	}
+	//
+	ShapeStatistics			GetShapeStatistics(const btCollisionShape* shape)
+	{
+		ShapeStatistics	r;
+		r.nqueries=r.nbuilds=r.nevictions=r.ncells=0;
+		for(int i=0;i<NUM_SHARDS;++i)
+		{
+			btMutexLock(&shards[i].mutex);
+			const ShapeStatistics*	ss=shards[i].stats.find(btHashPtr(shape));
+			if(ss)
+			{
+				r.nqueries		+=	ss->nqueries;
+				r.nbuilds		+=	ss->nbuilds;
+				r.nevictions	+=	ss->nevictions;
+				r.ncells		+=	ss->ncells;
+			}
+			btMutexUnlock(&shards[i].mutex);
+		}
+		return(r);
+	}
+	//
 	btScalar				Evaluate(	const btVector3& x,
 		const btCollisionShape* shape,
 		btVector3& normal,
@@ -166,52 +247,54 @@ struct	btSparseSdf
 		const IntFrac	iy=Decompose(scx.y());
 		const IntFrac	iz=Decompose(scx.z());
 		const unsigned	h=Hash(ix.b,iy.b,iz.b,shape);
-		Cell*&			root=cells[static_cast<int>(h%cells.size())];
-		Cell*			c=root;
-		++nqueries;
-		while(c)
+		const int		bucket=static_cast<int>(h%cells.size());
+		Shard&			s=shards[bucket%NUM_SHARDS];
+		const int		o[]={	ix.i,iy.i,iz.i};
+		btScalar		d[8];
+		btMutexLock(&s.mutex);
+		++s.nqueries;
+		++StatisticsOf(s,shape).nqueries;
+		Cell*			c=Find(s,bucket,h,ix.b,iy.b,iz.b,shape);
+		if(c)
 		{
-			++nprobes;
-			if(	(c->hash==h)	&&
-				(c->c[0]==ix.b)	&&
-				(c->c[1]==iy.b)	&&
-				(c->c[2]==iz.b)	&&
-				(c->pclient==shape))
-			{ break; }
-			else
-			{ c=c->next; }
+			Touch(s,c);
+			Extract(*c,o,d);
+			btMutexUnlock(&s.mutex);
 		}
-		if(!c)
+		else
 		{
-			++nprobes;		
-			++ncells;
-			//int sz = sizeof(Cell);
-			if (ncells>m_clampCells)
+			btMutexUnlock(&s.mutex);
+			/* Build the cell outside of the lock, other threads may build cells meanwhile	*/ 
+			Cell*	nc=new Cell();
+			nc->pclient=shape;
+			nc->hash=h;
+			nc->c[0]=ix.b;nc->c[1]=iy.b;nc->c[2]=iz.b;
+			BuildCell(*nc);
+			btMutexLock(&s.mutex);
+			c=Find(s,bucket,h,ix.b,iy.b,iz.b,shape);
+			if(c)
 			{
-				static int numResets=0;
-				numResets++;
-//				printf("numResets=%d\n",numResets);
-				Reset();
+				/* Another thread built the same cell	*/ 
+				Touch(s,c);
 			}
-
-			c=new Cell();
-			c->next=root;root=c;
-			c->pclient=shape;
-			c->hash=h;
-			c->c[0]=ix.b;c->c[1]=iy.b;c->c[2]=iz.b;
-			BuildCell(*c);
+			else
+			{
+				c=nc;nc=0;
+				Insert(s,bucket,c);
+				const int	capacity=btMax(1,(m_clampCells+NUM_SHARDS-1)/NUM_SHARDS);
+				while(s.ncells>capacity)
+				{
+					Cell*	pc=s.lrutail;
+					Unlink(s,pc);
+					ShapeStatistics&	ss=StatisticsOf(s,pc->pclient);
+					--ss.ncells;++ss.nevictions;
+					delete pc;
+				}
+			}
+			Extract(*c,o,d);
+			btMutexUnlock(&s.mutex);
+			delete nc;
 		}
-		c->puid=puid;
-		/* Extract infos		*/ 
-		const int		o[]={	ix.i,iy.i,iz.i};
-		const btScalar	d[]={	c->d[o[0]+0][o[1]+0][o[2]+0],
-			c->d[o[0]+1][o[1]+0][o[2]+0],
-			c->d[o[0]+1][o[1]+1][o[2]+0],
-			c->d[o[0]+0][o[1]+1][o[2]+0],
-			c->d[o[0]+0][o[1]+0][o[2]+1],
-			c->d[o[0]+1][o[1]+0][o[2]+1],
-			c->d[o[0]+1][o[1]+1][o[2]+1],
-			c->d[o[0]+0][o[1]+1][o[2]+1]};
 		/* Normal	*/ 
 #if 1
 		const btScalar	gx[]={	d[1]-d[0],d[2]-d[3],
@@ -238,6 +321,98 @@ struct	btSparseSdf
 		return(Lerp(d0,d1,iz.f)-margin);
 	}
 	//
+	// Helpers, the shard of the cells has to be locked
+	//
+	Cell*					Find(Shard& s,int bucket,unsigned h,int x,int y,int z,const btCollisionShape* shape)
+	{
+		Cell*	c=cells[bucket];
+		while(c)
+		{
+			++s.nprobes;
+			if(	(c->hash==h)	&&
+				(c->c[0]==x)	&&
+				(c->c[1]==y)	&&
+				(c->c[2]==z)	&&
+				(c->pclient==shape))
+			{ break; }
+			else
+			{ c=c->next; }
+		}
+		return(c);
+	}
+	//
+	void					Insert(Shard& s,int bucket,Cell* c)
+	{
+		c->next=cells[bucket];cells[bucket]=c;
+		c->lruprev=0;
+		c->lrunext=s.lruhead;
+		if(s.lruhead) s.lruhead->lruprev=c; else s.lrutail=c;
+		s.lruhead=c;
+		c->puid=puid;
+		++s.ncells;
+		ShapeStatistics&	ss=StatisticsOf(s,c->pclient);
+		++ss.ncells;++ss.nbuilds;
+	}
+	//
+	void					Touch(Shard& s,Cell* c)
+	{
+		c->puid=puid;
+		if(c!=s.lruhead)
+		{
+			c->lruprev->lrunext=c->lrunext;
+			if(c->lrunext) c->lrunext->lruprev=c->lruprev; else s.lrutail=c->lruprev;
+			c->lruprev=0;
+			c->lrunext=s.lruhead;
+			s.lruhead->lruprev=c;
+			s.lruhead=c;
+		}
+	}
+	//
+	void					Unlink(Shard& s,Cell* c)
+	{
+		Cell**	pp=&cells[static_cast<int>(c->hash%cells.size())];
+		while(*pp!=c) pp=&(*pp)->next;
+		*pp=c->next;
+		if(c->lruprev) c->lruprev->lrunext=c->lrunext; else s.lruhead=c->lrunext;
+		if(c->lrunext) c->lrunext->lruprev=c->lruprev; else s.lrutail=c->lruprev;
+		--s.ncells;
+	}
+	//
+	static inline void		Extract(const Cell& c,const int o[3],btScalar d[8])
+	{
+		d[0]=c.d[o[0]+0][o[1]+0][o[2]+0];
+		d[1]=c.d[o[0]+1][o[1]+0][o[2]+0];
+		d[2]=c.d[o[0]+1][o[1]+1][o[2]+0];
+		d[3]=c.d[o[0]+0][o[1]+1][o[2]+0];
+		d[4]=c.d[o[0]+0][o[1]+0][o[2]+1];
+		d[5]=c.d[o[0]+1][o[1]+0][o[2]+1];
+		d[6]=c.d[o[0]+1][o[1]+1][o[2]+1];
+		d[7]=c.d[o[0]+0][o[1]+1][o[2]+1];
+	}
+	//
+	static inline ShapeStatistics&	StatisticsOf(Shard& s,const btCollisionShape* shape)
+	{
+		ShapeStatistics*	ss=s.stats.find(btHashPtr(shape));
+		if(!ss)
+		{
+			ShapeStatistics	zero;
+			zero.nqueries=zero.nbuilds=zero.nevictions=zero.ncells=0;
+			s.stats.insert(btHashPtr(shape),zero);
+			ss=s.stats.find(btHashPtr(shape));
+		}
+		return(*ss);
+	}
+	//
+	void					LockAll()
+	{
+		for(int i=0;i<NUM_SHARDS;++i) btMutexLock(&shards[i].mutex);
+	}
+	//
+	void					UnlockAll()
+	{
+		for(int i=NUM_SHARDS-1;i>=0;--i) btMutexUnlock(&shards[i].mutex);
+	}
+	//
 	void					BuildCell(Cell& c)
 	{
 		const btVector3	org=btVector3(	(btScalar)c.c[0],
@@ -0,0 +1,462 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btConvexHullCache.h"
+#include "btMappedFile.h"
+#include "btAlignedAllocator.h"
+#include <stdio.h>
+#include <string.h>
+#include <new>
+
+#define BT_CONVEX_HULL_CACHE_VERSION 1
+
+///the binary image is a header, followed by one record per hull and the hull data,
+///each hull stores its vertices (3 btScalar each), edges (3 int each) and faces (1 int each), 16 byte aligned
+struct btConvexHullCacheHeader
+{
+	char	m_magic[4];
+	int		m_version;
+	int		m_scalarSize;
+	int		m_numHulls;
+};
+
+struct btConvexHullCacheRecord
+{
+	unsigned int	m_hashLow;
+	unsigned int	m_hashHigh;
+	int				m_count;
+	int				m_numVertices;
+	int				m_numEdges;
+	int				m_numFaces;
+	int				m_dataOffset;
+	int				m_padding;
+	double			m_shift;
+};
+
+static const char btConvexHullCacheMagic[4] = {'B','H','U','L'};
+
+static int getHullDataSize(int numVertices, int numEdges, int numFaces)
+{
+	int size = numVertices * 3 * int(sizeof(btScalar)) + (numEdges * 3 + numFaces) * int(sizeof(int));
+	return (size + 15) & ~15;
+}
+
+static int getRecordsEnd(int numHulls)
+{
+	int size = int(sizeof(btConvexHullCacheHeader)) + numHulls * int(sizeof(btConvexHullCacheRecord));
+	return (size + 15) & ~15;
+}
+
+///checks that the edge and face indices of a hull stay inside its arrays and that every face loop closes,
+///so hull queries on attached data never read out of bounds or loop forever
+static bool isValidHullData(const int* edges, const int* faces, int numVertices, int numEdges, int numFaces)
+{
+	for (int i = 0; i < numEdges; i++)
+	{
+		const int* e = &edges[i * 3];
+		int next = i + e[0];
+		int reverse = i + e[1];
+		if (next < 0 || next >= numEdges || reverse < 0 || reverse >= numEdges || reverse == i ||
+			reverse + edges[reverse * 3 + 1] != i ||
+			e[2] < 0 || e[2] >= numVertices)
+		{
+			return false;
+		}
+	}
+	for (int i = 0; i < numFaces; i++)
+	{
+		int first = faces[i];
+		if (first < 0 || first >= numEdges)
+		{
+			return false;
+		}
+		//same walk as btConvexHullComputer::Edge::getNextEdgeOfFace
+		int edge = first;
+		int steps = 0;
+		do
+		{
+			int reverse = edge + edges[edge * 3 + 1];
+			edge = reverse + edges[reverse * 3];
+			if (++steps > numEdges)
+			{
+				return false;
+			}
+		} while (edge != first);
+	}
+	return true;
+}
+
+static void hashBytes(unsigned long long& hash, const void* data, int size)
+{
+	//64 bit FNV-1a
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (int i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+}
+
+static btConvexHullCache* gConvexHullCache = 0;
+
+void btSetConvexHullCache(btConvexHullCache* cache)
+{
+	gConvexHullCache = cache;
+}
+
+btConvexHullCache* btGetConvexHullCache()
+{
+	return gConvexHullCache;
+}
+
+btConvexHullCache::btConvexHullCache()
+{
+}
+
+btConvexHullCache::~btConvexHullCache()
+{
+	clear();
+}
+
+btConvexHullCacheKey btConvexHullCache::computeKey(const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	const char* ptr = static_cast<const char*>(coords);
+	int coordSize = doubleCoords ? 3 * int(sizeof(double)) : 3 * int(sizeof(float));
+	for (int i = 0; i < count; i++, ptr += stride)
+	{
+		hashBytes(hash, ptr, coordSize);
+	}
+	hashBytes(hash, &doubleCoords, sizeof(doubleCoords));
+	hashBytes(hash, &shrink, sizeof(shrink));
+	hashBytes(hash, &shrinkClamp, sizeof(shrinkClamp));
+
+	btConvexHullCacheKey key;
+	key.m_hashLow = (unsigned int)(hash & 0xffffffffULL);
+	key.m_hashHigh = (unsigned int)(hash >> 32);
+	key.m_count = count;
+	return key;
+}
+
+btScalar btConvexHullCache::compute(btConvexHullComputer& hull, const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
+{
+	btConvexHullCacheKey key = computeKey(coords, doubleCoords, stride, count, shrink, shrinkClamp);
+
+	btScalar shift;
+	if (findInternal(key, hull, shift))
+	{
+		return shift;
+	}
+
+	//compute outside of the lock, so several threads can build hulls at the same time
+	if (doubleCoords)
+	{
+		shift = hull.computeParallel(static_cast<const double*>(coords), stride, count, shrink, shrinkClamp);
+	}
+	else
+	{
+		shift = hull.computeParallel(static_cast<const float*>(coords), stride, count, shrink, shrinkClamp);
+	}
+	insertInternal(key, hull, shift);
+	return shift;
+}
+
+bool btConvexHullCache::findInternal(const btConvexHullCacheKey& key, btConvexHullComputer& hull, btScalar& shift) const
+{
+	btMutexLock(&m_mutex);
+	const int* index = m_entryMap.find(key);
+	if (!index)
+	{
+		btMutexUnlock(&m_mutex);
+		return false;
+	}
+	const Entry& entry = m_entries[*index];
+
+	hull.vertices.resize(entry.m_numVertices);
+	for (int i = 0; i < entry.m_numVertices; i++)
+	{
+		const btScalar* v = &entry.m_vertices[i * 3];
+		hull.vertices[i].setValue(v[0], v[1], v[2]);
+	}
+	hull.edges.resize(entry.m_numEdges);
+	for (int i = 0; i < entry.m_numEdges; i++)
+	{
+		const int* e = &entry.m_edges[i * 3];
+		btConvexHullComputer::Edge& edge = hull.edges[i];
+		edge.next = e[0];
+		edge.reverse = e[1];
+		edge.targetVertex = e[2];
+	}
+	hull.faces.resize(entry.m_numFaces);
+	for (int i = 0; i < entry.m_numFaces; i++)
+	{
+		hull.faces[i] = entry.m_faces[i];
+	}
+	shift = entry.m_shift;
+
+	btMutexUnlock(&m_mutex);
+	return true;
+}
+
+void btConvexHullCache::insertInternal(const btConvexHullCacheKey& key, const btConvexHullComputer& hull, btScalar shift)
+{
+	int numVertices = hull.vertices.size();
+	int numEdges = hull.edges.size();
+	int numFaces = hull.faces.size();
+
+	void* mem = btAlignedAlloc(getHullDataSize(numVertices, numEdges, numFaces), 16);
+	btScalar* vertices = static_cast<btScalar*>(mem);
+	int* edges = reinterpret_cast<int*>(vertices + numVertices * 3);
+	int* faces = edges + numEdges * 3;
+	for (int i = 0; i < numVertices; i++)
+	{
+		vertices[i * 3] = hull.vertices[i].getX();
+		vertices[i * 3 + 1] = hull.vertices[i].getY();
+		vertices[i * 3 + 2] = hull.vertices[i].getZ();
+	}
+	for (int i = 0; i < numEdges; i++)
+	{
+		const btConvexHullComputer::Edge& edge = hull.edges[i];
+		edges[i * 3] = edge.next;
+		edges[i * 3 + 1] = edge.reverse;
+		edges[i * 3 + 2] = edge.targetVertex;
+	}
+	for (int i = 0; i < numFaces; i++)
+	{
+		faces[i] = hull.faces[i];
+	}
+
+	btMutexLock(&m_mutex);
+	if (m_entryMap.find(key))
+	{
+		//another thread was faster
+		btMutexUnlock(&m_mutex);
+		btAlignedFree(mem);
+		return;
+	}
+	Entry entry;
+	entry.m_key = key;
+	entry.m_shift = shift;
+	entry.m_numVertices = numVertices;
+	entry.m_numEdges = numEdges;
+	entry.m_numFaces = numFaces;
+	entry.m_vertices = vertices;
+	entry.m_edges = edges;
+	entry.m_faces = faces;
+	m_entryMap.insert(key, m_entries.size());
+	m_entries.push_back(entry);
+	m_ownedData.push_back(mem);
+	btMutexUnlock(&m_mutex);
+}
+
+void btConvexHullCache::clear()
+{
+	btMutexLock(&m_mutex);
+	for (int i = 0; i < m_ownedData.size(); i++)
+	{
+		btAlignedFree(m_ownedData[i]);
+	}
+	for (int i = 0; i < m_mappedFiles.size(); i++)
+	{
+		m_mappedFiles[i]->~btMappedFile();
+		btAlignedFree(m_mappedFiles[i]);
+	}
+	m_ownedData.clear();
+	m_mappedFiles.clear();
+	m_entries.clear();
+	m_entryMap.clear();
+	btMutexUnlock(&m_mutex);
+}
+
+int btConvexHullCache::calculateSerializeBufferSizeInternal() const
+{
+	int size = getRecordsEnd(m_entries.size());
+	for (int i = 0; i < m_entries.size(); i++)
+	{
+		const Entry& entry = m_entries[i];
+		size += getHullDataSize(entry.m_numVertices, entry.m_numEdges, entry.m_numFaces);
+	}
+	return size;
+}
+
+void btConvexHullCache::serializeInternal(void* buffer) const
+{
+	char* bytes = static_cast<char*>(buffer);
+
+	btConvexHullCacheHeader* header = reinterpret_cast<btConvexHullCacheHeader*>(bytes);
+	memcpy(header->m_magic, btConvexHullCacheMagic, 4);
+	header->m_version = BT_CONVEX_HULL_CACHE_VERSION;
+	header->m_scalarSize = sizeof(btScalar);
+	header->m_numHulls = m_entries.size();
+
+	btConvexHullCacheRecord* records = reinterpret_cast<btConvexHullCacheRecord*>(header + 1);
+	int offset = getRecordsEnd(m_entries.size());
+	memset(records, 0, offset - sizeof(btConvexHullCacheHeader));
+
+	for (int i = 0; i < m_entries.size(); i++)
+	{
+		const Entry& entry = m_entries[i];
+		btConvexHullCacheRecord& record = records[i];
+		record.m_hashLow = entry.m_key.m_hashLow;
+		record.m_hashHigh = entry.m_key.m_hashHigh;
+		record.m_count = entry.m_key.m_count;
+		record.m_numVertices = entry.m_numVertices;
+		record.m_numEdges = entry.m_numEdges;
+		record.m_numFaces = entry.m_numFaces;
+		record.m_dataOffset = offset;
+		record.m_shift = entry.m_shift;
+
+		int dataSize = getHullDataSize(entry.m_numVertices, entry.m_numEdges, entry.m_numFaces);
+		char* data = bytes + offset;
+		memset(data, 0, dataSize);
+		int vertexSize = entry.m_numVertices * 3 * sizeof(btScalar);
+		int edgeSize = entry.m_numEdges * 3 * sizeof(int);
+		memcpy(data, entry.m_vertices, vertexSize);
+		memcpy(data + vertexSize, entry.m_edges, edgeSize);
+		memcpy(data + vertexSize + edgeSize, entry.m_faces, entry.m_numFaces * sizeof(int));
+		offset += dataSize;
+	}
+}
+
+int btConvexHullCache::calculateSerializeBufferSize() const
+{
+	btMutexLock(&m_mutex);
+	int size = calculateSerializeBufferSizeInternal();
+	btMutexUnlock(&m_mutex);
+	return size;
+}
+
+void btConvexHullCache::serialize(void* buffer) const
+{
+	btMutexLock(&m_mutex);
+	serializeInternal(buffer);
+	btMutexUnlock(&m_mutex);
+}
+
+bool btConvexHullCache::save(const char* fileName) const
+{
+	btMutexLock(&m_mutex);
+	int size = calculateSerializeBufferSizeInternal();
+	void* buffer = btAlignedAlloc(size, 16);
+	serializeInternal(buffer);
+	btMutexUnlock(&m_mutex);
+
+	bool ok = false;
+	FILE* file = fopen(fileName, "wb");
+	if (file)
+	{
+		ok = (fwrite(buffer, 1, size, file) == size_t(size));
+		ok = (fclose(file) == 0) && ok;
+	}
+	btAlignedFree(buffer);
+	return ok;
+}
+
+bool btConvexHullCache::attach(const void* data, int size)
+{
+	const char* bytes = static_cast<const char*>(data);
+	if (!data || size < int(sizeof(btConvexHullCacheHeader)) || (size_t(bytes) & (sizeof(double) - 1)))
+	{
+		return false;
+	}
+	const btConvexHullCacheHeader* header = static_cast<const btConvexHullCacheHeader*>(data);
+	if (memcmp(header->m_magic, btConvexHullCacheMagic, 4) != 0 ||
+		header->m_version != BT_CONVEX_HULL_CACHE_VERSION ||
+		header->m_scalarSize != int(sizeof(btScalar)) ||
+		header->m_numHulls < 0 ||
+		header->m_numHulls > (size - int(sizeof(btConvexHullCacheHeader))) / int(sizeof(btConvexHullCacheRecord)))
+	{
+		return false;
+	}
+
+	const btConvexHullCacheRecord* records = reinterpret_cast<const btConvexHullCacheRecord*>(header + 1);
+	int recordsEnd = getRecordsEnd(header->m_numHulls);
+	for (int i = 0; i < header->m_numHulls; i++)
+	{
+		const btConvexHullCacheRecord& record = records[i];
+		if (record.m_numVertices < 0 || record.m_numEdges < 0 || record.m_numFaces < 0 ||
+			record.m_dataOffset < recordsEnd || record.m_dataOffset > size || (record.m_dataOffset & 15))
+		{
+			return false;
+		}
+		//check each array against the bytes left, so the sizes can't overflow
+		int remaining = size - record.m_dataOffset;
+		if (record.m_numVertices > remaining / int(3 * sizeof(btScalar)))
+		{
+			return false;
+		}
+		remaining -= record.m_numVertices * 3 * int(sizeof(btScalar));
+		if (record.m_numEdges > remaining / int(3 * sizeof(int)))
+		{
+			return false;
+		}
+		remaining -= record.m_numEdges * 3 * int(sizeof(int));
+		if (record.m_numFaces > remaining / int(sizeof(int)) ||
+			getHullDataSize(record.m_numVertices, record.m_numEdges, record.m_numFaces) > size - record.m_dataOffset)
+		{
+			return false;
+		}
+		const int* edges = reinterpret_cast<const int*>(bytes + record.m_dataOffset + record.m_numVertices * 3 * int(sizeof(btScalar)));
+		if (!isValidHullData(edges, edges + record.m_numEdges * 3, record.m_numVertices, record.m_numEdges, record.m_numFaces))
+		{
+			return false;
+		}
+	}
+
+	btMutexLock(&m_mutex);
+	for (int i = 0; i < header->m_numHulls; i++)
+	{
+		const btConvexHullCacheRecord& record = records[i];
+		btConvexHullCacheKey key;
+		key.m_hashLow = record.m_hashLow;
+		key.m_hashHigh = record.m_hashHigh;
+		key.m_count = record.m_count;
+		if (m_entryMap.find(key))
+		{
+			continue;
+		}
+
+		const char* hullData = bytes + record.m_dataOffset;
+		Entry entry;
+		entry.m_key = key;
+		entry.m_shift = btScalar(record.m_shift);
+		entry.m_numVertices = record.m_numVertices;
+		entry.m_numEdges = record.m_numEdges;
+		entry.m_numFaces = record.m_numFaces;
+		entry.m_vertices = reinterpret_cast<const btScalar*>(hullData);
+		entry.m_edges = reinterpret_cast<const int*>(entry.m_vertices + record.m_numVertices * 3);
+		entry.m_faces = entry.m_edges + record.m_numEdges * 3;
+		m_entryMap.insert(key, m_entries.size());
+		m_entries.push_back(entry);
+	}
+	btMutexUnlock(&m_mutex);
+	return true;
+}
+
+bool btConvexHullCache::load(const char* fileName)
+{
+	void* mem = btAlignedAlloc(sizeof(btMappedFile), 16);
+	btMappedFile* file = new (mem) btMappedFile();
+	if (!file->open(fileName) || file->getSize() > size_t(0x7fffffff) || !attach(file->getData(), int(file->getSize())))
+	{
+		file->~btMappedFile();
+		btAlignedFree(mem);
+		return false;
+	}
+	btMutexLock(&m_mutex);
+	m_mappedFiles.push_back(file);
+	btMutexUnlock(&m_mutex);
+	return true;
+}
@@ -15,6 +15,7 @@ subject to the following restrictions:
 #include <string.h>
 
 #include "btConvexHullComputer.h"
+#include "btThreads.h"
 #include "btAlignedObjectArray.h"
 #include "btMinMax.h"
 #include "btVector3.h"
@@ -827,7 +828,13 @@ class btConvexHullInternal
 	public:
 		Vertex* vertexList;
 
-		void compute(const void* coords, bool doubleCoords, int stride, int count);
+		void compute(const void* coords, bool doubleCoords, int stride, int count, int pointsPerTask);
+
+		void computeFromPoints(btAlignedObjectArray<Point32>& points);
+
+		void getHullPoints(btAlignedObjectArray<Point32>& points);
+
+		void reducePoints(btAlignedObjectArray<Point32>& points, int pointsPerTask);
 
 		btVector3 getCoordinates(const Vertex* v);
 
@@ -1941,7 +1948,7 @@ class pointCmp
 		}
 };
 
-void btConvexHullInternal::compute(const void* coords, bool doubleCoords, int stride, int count)
+void btConvexHullInternal::compute(const void* coords, bool doubleCoords, int stride, int count, int pointsPerTask)
 {
 	btVector3 min(btScalar(1e30), btScalar(1e30), btScalar(1e30)), max(btScalar(-1e30), btScalar(-1e30), btScalar(-1e30));
 	const char* ptr = (const char*) coords;
@@ -2030,6 +2037,18 @@ void btConvexHullInternal::compute(const void* coords, bool doubleCoords, int st
 			points[i].index = i;
 		}
 	}
+
+	if ((pointsPerTask > 0) && (count >= 2 * pointsPerTask))
+	{
+		reducePoints(points, pointsPerTask);
+	}
+
+	computeFromPoints(points);
+}
+
+void btConvexHullInternal::computeFromPoints(btAlignedObjectArray<Point32>& points)
+{
+	int count = points.size();
 	points.quickSort(pointCmp());
 
 	vertexPool.reset();
@@ -2062,6 +2081,89 @@ void btConvexHullInternal::compute(const void* coords, bool doubleCoords, int st
 #endif
 }
 
+void btConvexHullInternal::getHullPoints(btAlignedObjectArray<Point32>& points)
+{
+	if (!vertexList)
+	{
+		return;
+	}
+	int stamp = --mergeStamp;
+	btAlignedObjectArray<Vertex*> stack;
+	vertexList->copy = stamp;
+	stack.push_back(vertexList);
+	while (stack.size() > 0)
+	{
+		Vertex* v = stack[stack.size() - 1];
+		stack.pop_back();
+		points.push_back(v->point);
+		Edge* firstEdge = v->edges;
+		if (firstEdge)
+		{
+			Edge* e = firstEdge;
+			do
+			{
+				if (e->target->copy != stamp)
+				{
+					e->target->copy = stamp;
+					stack.push_back(e->target);
+				}
+				e = e->next;
+			} while (e != firstEdge);
+		}
+	}
+}
+
+//computes the hulls of chunks of the points, only their vertices can be vertices of the whole hull
+struct btConvexHullReduceTask : public btIParallelForBody
+{
+	const btConvexHullInternal::Point32* m_points;
+	int m_count;
+	int m_pointsPerTask;
+	btAlignedObjectArray<btConvexHullInternal::Point32>* m_chunkVertices;
+
+	virtual void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			int begin = i * m_pointsPerTask;
+			int end = btMin(begin + m_pointsPerTask, m_count);
+			btAlignedObjectArray<btConvexHullInternal::Point32> chunk;
+			chunk.resize(end - begin);
+			for (int j = begin; j < end; j++)
+			{
+				chunk[j - begin] = m_points[j];
+			}
+			btConvexHullInternal chunkHull;
+			chunkHull.computeFromPoints(chunk);
+			chunkHull.getHullPoints(m_chunkVertices[i]);
+		}
+	}
+};
+
+void btConvexHullInternal::reducePoints(btAlignedObjectArray<Point32>& points, int pointsPerTask)
+{
+	int count = points.size();
+	int numChunks = (count + pointsPerTask - 1) / pointsPerTask;
+	btAlignedObjectArray<btAlignedObjectArray<Point32> > chunkVertices;
+	chunkVertices.resize(numChunks);
+
+	btConvexHullReduceTask task;
+	task.m_points = &points[0];
+	task.m_count = count;
+	task.m_pointsPerTask = pointsPerTask;
+	task.m_chunkVertices = &chunkVertices[0];
+	btParallelFor(0, numChunks, 1, task);
+
+	points.resize(0);
+	for (int i = 0; i < numChunks; i++)
+	{
+		for (int j = 0; j < chunkVertices[i].size(); j++)
+		{
+			points.push_back(chunkVertices[i][j]);
+		}
+	}
+}
+
 btVector3 btConvexHullInternal::toBtVector(const Point32& v)
 {
 	btVector3 p;
@@ -2642,7 +2744,7 @@ static int getVertexCopy(btConvexHullInternal::Vertex* vertex, btAlignedObjectAr
 	return index;
 }
 
-btScalar btConvexHullComputer::compute(const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
+btScalar btConvexHullComputer::compute(const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp, int pointsPerTask)
 {
 	if (count <= 0)
 	{
@@ -2653,7 +2755,7 @@ btScalar btConvexHullComputer::compute(const void* coords, bool doubleCoords, in
 	}
 
 	btConvexHullInternal hull;
-	hull.compute(coords, doubleCoords, stride, count);
+	hull.compute(coords, doubleCoords, stride, count, pointsPerTask);
 
 	btScalar shift = 0;
 	if ((shrink > 0) && ((shift = hull.shrink(shrink, shrinkClamp)) < 0))
@@ -0,0 +1,247 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+///The elementary functions of the C library are not correctly rounded, and their results differ between
+///platforms and library versions. The functions below only use additions, multiplications, divisions and
+///the square root, which IEEE 754 rounds exactly, and the exact operations floor, frexp and ldexp, so they
+///return the same bits everywhere, as long as the compiler doesn't contract a*b+c into fused multiply-adds.
+///They are accurate to a few units in the last place of a double, btDeterministicPow to about a dozen.
+
+#include "btScalar.h"
+
+//pi/2 split into three parts, the first two have 33 significant bits, so n*part is exact for |n| < 2^20
+static const double btPio2_1 = 1.57079632673412561417e+00;
+static const double btPio2_2 = 6.07710050630396597660e-11;
+static const double btPio2_3 = 2.02226624879595063154e-21;
+static const double btInvPio2 = 6.36619772367581382433e-01;
+static const double btPi = 3.14159265358979311600e+00;
+static const double btPio2 = 1.57079632679489655800e+00;
+static const double btPio6 = 5.23598775598298815658e-01;
+static const double btSqrt3 = 1.73205080756887719318e+00;
+static const double btTanPio12 = 2.67949192431122706473e-01;
+static const double btLn2Hi = 6.93147180369123816490e-01;
+static const double btLn2Lo = 1.90821492927058770002e-10;
+static const double btInvLn2 = 1.44269504088896338700e+00;
+static const double btSqrtHalf = 7.07106781186547572737e-01;
+
+//sin and cos on [-pi/4,pi/4], the coefficients of the fdlibm kernels
+static double btKernelSin(double x)
+{
+	const double z = x*x;
+	const double r = 8.33333333332248946124e-03+z*(-1.98412698298579493134e-04+z*(2.75573137070700676789e-06+
+		z*(-2.50507602534068634195e-08+z*1.58969099521155010221e-10)));
+	return x+x*z*(-1.66666666666666324348e-01+z*r);
+}
+
+static double btKernelCos(double x)
+{
+	const double z = x*x;
+	const double r = z*(4.16666666666666019037e-02+z*(-1.38888888888741095749e-03+z*(2.48015872894767294178e-05+
+		z*(-2.75573143513906633035e-07+z*(2.08757232129817482790e-09+z*-1.13596475577881948265e-11)))));
+	const double hz = 0.5*z;
+	const double w = 1.0-hz;
+	return w+(((1.0-w)-hz)+z*r);
+}
+
+//reduces x to r in [-pi/4,pi/4], returns the quadrant of x
+static int btReducePio2(double x, double& r)
+{
+	const double n = floor(x*btInvPio2+0.5);
+	r = ((x-n*btPio2_1)-n*btPio2_2)-n*btPio2_3;
+	return int(n-4.0*floor(n*0.25));
+}
+
+static bool btIsFinite(double x)
+{
+	return (x-x)==0.0;
+}
+
+double btDeterministicSin(double x)
+{
+	if (!btIsFinite(x))
+		return x-x;
+	double r;
+	switch (btReducePio2(x, r))
+	{
+	case 0: return btKernelSin(r);
+	case 1: return btKernelCos(r);
+	case 2: return -btKernelSin(r);
+	default: return -btKernelCos(r);
+	}
+}
+
+double btDeterministicCos(double x)
+{
+	if (!btIsFinite(x))
+		return x-x;
+	double r;
+	switch (btReducePio2(x, r))
+	{
+	case 0: return btKernelCos(r);
+	case 1: return -btKernelSin(r);
+	case 2: return -btKernelCos(r);
+	default: return btKernelSin(r);
+	}
+}
+
+double btDeterministicTan(double x)
+{
+	if (!btIsFinite(x))
+		return x-x;
+	double r;
+	const int quadrant = btReducePio2(x, r);
+	const double s = btKernelSin(r);
+	const double c = btKernelCos(r);
+	return (quadrant&1) ? -c/s : s/c;
+}
+
+double btDeterministicAtan(double x)
+{
+	if (x!=x)
+		return x;
+	double a = fabs(x);
+	const bool inverted = a>1.0;
+	if (inverted)
+		a = 1.0/a;
+	double offset = 0.0;
+	if (a>btTanPio12)
+	{
+		//atan(a) = pi/6 + atan((a*sqrt(3)-1)/(a+sqrt(3)))
+		a = (a*btSqrt3-1.0)/(a+btSqrt3);
+		offset = btPio6;
+	}
+	//|a| <= tan(pi/12), the series converges with a factor of 0.072 per term
+	const double z = a*a;
+	double sum = 0.0;
+	for (int k=14;k>0;k--)
+	{
+		sum = z*((k&1 ? -1.0 : 1.0)/double(2*k+1)+sum);
+	}
+	double result = offset+(a+a*sum);
+	if (inverted)
+		result = btPio2-result;
+	return x<0.0 ? -result : result;
+}
+
+double btDeterministicAtan2(double y, double x)
+{
+	if (x!=x || y!=y)
+		return x+y;
+	if (y==0.0)
+	{
+		//keeps the signs of atan2 for zero and negative zero
+		if (x<0.0 || (x==0.0 && 1.0/x<0.0))
+			return (1.0/y<0.0) ? -btPi : btPi;
+		return y;
+	}
+	if (x==0.0)
+		return y>0.0 ? btPio2 : -btPio2;
+	const double a = btDeterministicAtan(y/x);
+	if (x>0.0)
+		return a;
+	return y>0.0 ? a+btPi : a-btPi;
+}
+
+double btDeterministicAsin(double x)
+{
+	return btDeterministicAtan2(x, sqrt((1.0-x)*(1.0+x)));
+}
+
+double btDeterministicAcos(double x)
+{
+	return btDeterministicAtan2(sqrt((1.0-x)*(1.0+x)), x);
+}
+
+double btDeterministicExp(double x)
+{
+	if (x!=x)
+		return x;
+	if (x>709.782712893384)
+		return HUGE_VAL;
+	if (x<-745.1332191019412)
+		return 0.0;
+	//x = n*ln(2) + r with |r| <= ln(2)/2
+	const double n = floor(x*btInvLn2+0.5);
+	const double r = (x-n*btLn2Hi)-n*btLn2Lo;
+	double sum = 1.0;
+	for (int k=14;k>0;k--)
+	{
+		sum = 1.0+sum*r/double(k);
+	}
+	return ldexp(sum, int(n));
+}
+
+double btDeterministicLog(double x)
+{
+	if (x!=x)
+		return x;
+	if (x<0.0)
+		return (x-x)/(x-x);
+	if (x==0.0)
+		return -HUGE_VAL;
+	if (!btIsFinite(x))
+		return x;
+	int exponent;
+	double m = frexp(x, &exponent);
+	if (m<btSqrtHalf)
+	{
+		m *= 2.0;
+		exponent--;
+	}
+	//log(m) = 2*atanh(f) with f = (m-1)/(m+1), |f| <= 0.172
+	const double f = (m-1.0)/(m+1.0);
+	const double s = f*f;
+	double sum = 0.0;
+	for (int k=12;k>0;k--)
+	{
+		sum = s*(1.0/double(2*k+1)+sum);
+	}
+	const double e = double(exponent);
+	return e*btLn2Hi+((2.0*f+2.0*f*sum)+e*btLn2Lo);
+}
+
+double btDeterministicPow(double x, double y)
+{
+	if (y==0.0 || x==1.0)
+		return 1.0;
+	if (x!=x || y!=y)
+		return x+y;
+	const bool integerExponent = (y==floor(y));
+	if (integerExponent && fabs(y)<=64.0)
+	{
+		//exponentiation by squaring
+		int n = int(fabs(y));
+		double base = x;
+		double result = 1.0;
+		while (n)
+		{
+			if (n&1)
+				result *= base;
+			base *= base;
+			n >>= 1;
+		}
+		return y<0.0 ? 1.0/result : result;
+	}
+	if (x==0.0)
+		return y>0.0 ? 0.0 : HUGE_VAL;
+	if (x<0.0)
+	{
+		if (!integerExponent)
+			return (x-x)/(x-x);
+		const double magnitude = btDeterministicExp(y*btDeterministicLog(-x));
+		return (fabs(y)<9007199254740992.0 && floor(y*0.5)*2.0!=y) ? -magnitude : magnitude;
+	}
+	return btDeterministicExp(y*btDeterministicLog(x));
+}
@@ -0,0 +1,156 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btMappedFile.h"
+#include "btAlignedAllocator.h"
+
+#if defined(WIN32) || defined(_WIN32)
+
+#define BT_USE_WINDOWS_FILE_MAPPING
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#elif defined(__unix__) || defined(__unix) || defined(__APPLE__) || defined(__ANDROID__)
+
+#define BT_USE_POSIX_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#else
+
+#include <stdio.h>
+
+#endif
+
+
+btMappedFile::btMappedFile()
+:m_data(0),
+m_size(0),
+m_isHeapCopy(false),
+m_isWritable(false),
+m_fileHandle(0),
+m_mappingHandle(0)
+{
+}
+
+btMappedFile::~btMappedFile()
+{
+	close();
+}
+
+bool	btMappedFile::open(const char* fileName, bool copyOnWrite)
+{
+	close();
+
+#ifdef BT_USE_WINDOWS_FILE_MAPPING
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, 0, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, 0);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	const void* data = MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_data = data;
+	m_size = (size_t)size.QuadPart;
+	m_isWritable = copyOnWrite;
+	return true;
+#elif defined(BT_USE_POSIX_MMAP)
+	int fd = ::open(fileName, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(0, (size_t)st.st_size, copyOnWrite ? PROT_READ|PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+	//the mapping keeps its own reference to the file
+	::close(fd);
+	if (data == MAP_FAILED)
+		return false;
+	m_data = data;
+	m_size = (size_t)st.st_size;
+	m_isWritable = copyOnWrite;
+	return true;
+#else
+	FILE* file = fopen(fileName, "rb");
+	if (!file)
+		return false;
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size <= 0)
+	{
+		fclose(file);
+		return false;
+	}
+	void* data = btAlignedAlloc((size_t)size, 16);
+	if (fread(data, 1, (size_t)size, file) != (size_t)size)
+	{
+		btAlignedFree(data);
+		fclose(file);
+		return false;
+	}
+	fclose(file);
+	m_data = data;
+	m_size = (size_t)size;
+	m_isHeapCopy = true;
+	m_isWritable = true;
+	return true;
+#endif
+}
+
+void	btMappedFile::close()
+{
+	if (!m_data)
+		return;
+
+#ifdef BT_USE_WINDOWS_FILE_MAPPING
+	UnmapViewOfFile(m_data);
+	CloseHandle((HANDLE)m_mappingHandle);
+	CloseHandle((HANDLE)m_fileHandle);
+#elif defined(BT_USE_POSIX_MMAP)
+	munmap((void*)m_data, m_size);
+#else
+	btAlignedFree((void*)m_data);
+#endif
+
+	m_data = 0;
+	m_size = 0;
+	m_isHeapCopy = false;
+	m_isWritable = false;
+	m_fileHandle = 0;
+	m_mappingHandle = 0;
+}
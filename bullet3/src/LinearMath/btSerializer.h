@@ -98,6 +98,12 @@ public:
 
 	virtual void	setSerializationFlags(int flags) = 0;
 
+	///true if objects can be serialized from several threads at once, see btStreamSerializer
+	virtual bool	isThreadSafe() const
+	{
+		return false;
+	}
+
 	virtual int getNumChunks() const = 0;
 
 	virtual const btChunk* getChunk(int chunkIndex) const = 0;
@@ -107,6 +113,14 @@ public:
 
 
 #define BT_HEADER_LENGTH 12
+
+///returns the number of zero bytes to append to a chunk that ends at fileOffset, so the data of the next chunk starts
+///16 byte aligned in the file. Readers that map the file can then use aligned arrays, like quantized bvh nodes, in place.
+///Padding only grows m_length, m_number still gives the number of elements.
+SIMD_FORCE_INLINE int btGetChunkPadding(int fileOffset)
+{
+	return (16 - ((fileOffset + int(sizeof(btChunk))) & 15)) & 15;
+}
 #if defined(__sgi) || defined (__sparc) || defined (__sparc__) || defined (__PPC__) || defined (__ppc__) || defined (__BIG_ENDIAN__)
 #	define BT_MAKE_ID(a,b,c,d) ( (int)(a)<<24 | (int)(b)<<16 | (c)<<8 | (d) )
 #else
@@ -531,20 +545,32 @@ public:
 				if (m_buffer)
 					btAlignedFree(m_buffer);
 
-				m_currentSize += BT_HEADER_LENGTH;
+				m_currentSize = BT_HEADER_LENGTH;
+				int i;
+				for (i=0;i<	m_chunkPtrs.size();i++)
+				{
+					m_currentSize += sizeof(btChunk)+m_chunkPtrs[i]->m_length;
+					if (i+1<m_chunkPtrs.size())
+						m_currentSize += btGetChunkPadding(m_currentSize);
+				}
 				m_buffer = (unsigned char*)btAlignedAlloc(m_currentSize,16);
 
 				unsigned char* currentPtr = m_buffer;
 				writeHeader(m_buffer);
 				currentPtr += BT_HEADER_LENGTH;
 				mysize+=BT_HEADER_LENGTH;
-				for (int i=0;i<	m_chunkPtrs.size();i++)
+				for (i=0;i<	m_chunkPtrs.size();i++)
 				{
 					int curLength = sizeof(btChunk)+m_chunkPtrs[i]->m_length;
 					memcpy(currentPtr,m_chunkPtrs[i], curLength);
 					btAlignedFree(m_chunkPtrs[i]);
-					currentPtr+=curLength;
 					mysize+=curLength;
+					//pad the chunk so the data of the next one is 16 byte aligned
+					int padding = (i+1<m_chunkPtrs.size()) ? btGetChunkPadding(mysize) : 0;
+					memset(currentPtr+curLength,0,padding);
+					((btChunk*)currentPtr)->m_length += padding;
+					currentPtr+=curLength+padding;
+					mysize+=padding;
 				}
 			}
 
@@ -638,6 +664,16 @@ public:
 
 		virtual	btChunk*	allocate(size_t size, int numElements)
 		{
+			//in a pre-allocated buffer the chunks are placed right away, pad the previous one so the data of this one is 16 byte aligned
+			if (m_totalSize && m_chunkPtrs.size())
+			{
+				int padding = btGetChunkPadding(m_currentSize);
+				if (padding)
+				{
+					memset(internalAlloc(padding),0,padding);
+					m_chunkPtrs[m_chunkPtrs.size()-1]->m_length += padding;
+				}
+			}
 
 			unsigned char* ptr = internalAlloc(int(size)*numElements+sizeof(btChunk));
 
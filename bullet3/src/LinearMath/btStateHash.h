@@ -0,0 +1,108 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_STATE_HASH_H
+#define BT_STATE_HASH_H
+
+#include "btTransform.h"
+#include <string.h>
+
+///btStateHash accumulates a 64 bit FNV-1a hash of the bits of simulation state, see btCollisionWorld::calculateStateHash.
+///Values are hashed in the order they are added. Hashes of elements that have no canonical order, like contact
+///manifolds, are combined with addUnordered, which sums them, so the result doesn't depend on their order.
+class btStateHash
+{
+	unsigned long long	m_hash;
+	unsigned long long	m_unorderedSum;
+
+public:
+
+	btStateHash()
+		:m_hash(14695981039346656037ULL),
+		m_unorderedSum(0)
+	{
+	}
+
+	void	addWord(unsigned int word)
+	{
+		m_hash = (m_hash ^ word) * 1099511628211ULL;
+	}
+
+	void	addInt(int value)
+	{
+		addWord((unsigned int)value);
+	}
+
+	void	addScalar(btScalar value)
+	{
+		//+0 and -0 compare equal but have different bits, they hash the same
+		if (value == btScalar(0))
+			value = btScalar(0);
+		unsigned int words[sizeof(btScalar)/sizeof(unsigned int)];
+		memcpy(words, &value, sizeof(btScalar));
+		for (int i=0;i<int(sizeof(btScalar)/sizeof(unsigned int));i++)
+		{
+			addWord(words[i]);
+		}
+	}
+
+	void	addVector3(const btVector3& v)
+	{
+		addScalar(v.getX());
+		addScalar(v.getY());
+		addScalar(v.getZ());
+	}
+
+	void	addTransform(const btTransform& t)
+	{
+		addVector3(t.getBasis()[0]);
+		addVector3(t.getBasis()[1]);
+		addVector3(t.getBasis()[2]);
+		addVector3(t.getOrigin());
+	}
+
+	///adds the value of another hash, independent of the order in which the hashes are added
+	void	addUnordered(const btStateHash& other)
+	{
+		m_unorderedSum += other.getHash();
+	}
+
+	unsigned long long	getHash() const
+	{
+		return (m_hash ^ m_unorderedSum) * 1099511628211ULL;
+	}
+
+	unsigned int	getHashLow() const
+	{
+		return (unsigned int)getHash();
+	}
+
+	unsigned int	getHashHigh() const
+	{
+		return (unsigned int)(getHash() >> 32);
+	}
+
+	bool operator==(const btStateHash& other) const
+	{
+		return getHash() == other.getHash();
+	}
+
+	bool operator!=(const btStateHash& other) const
+	{
+		return getHash() != other.getHash();
+	}
+};
+
+#endif //BT_STATE_HASH_H
@@ -0,0 +1,130 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2017 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btStreamSerializer.h"
+
+btStreamSerializer::btStreamSerializer(btSerializerSink* sink)
+:m_sink(sink),
+m_writeFailed(false)
+{
+}
+
+btStreamSerializer::~btStreamSerializer()
+{
+}
+
+void	btStreamSerializer::writeToSink(const void* data, int size)
+{
+	if (!m_writeFailed && !m_sink->write(data,size))
+	{
+		m_writeFailed = true;
+	}
+	m_currentSize += size;
+}
+
+void	btStreamSerializer::startSerialization()
+{
+	m_uniqueIdGenerator = 1;
+	m_currentSize = 0;
+	m_writeFailed = false;
+
+	unsigned char header[BT_HEADER_LENGTH];
+	writeHeader(header);
+	writeToSink(header,BT_HEADER_LENGTH);
+}
+
+void	btStreamSerializer::finishSerialization()
+{
+	writeDNA();
+
+	//the structure tables stay for the next serialization, unlike btDefaultSerializer
+	m_skipPointers.clear();
+	m_chunkP.clear();
+	m_uniquePointers.clear();
+}
+
+btChunk*	btStreamSerializer::allocate(size_t size, int numElements)
+{
+	unsigned char* ptr = (unsigned char*)btAlignedAlloc(size*numElements+sizeof(btChunk),16);
+
+	btChunk* chunk = (btChunk*)ptr;
+	chunk->m_chunkCode = 0;
+	chunk->m_oldPtr = ptr+sizeof(btChunk);
+	chunk->m_length = int(size)*numElements;
+	chunk->m_number = numElements;
+	return chunk;
+}
+
+void	btStreamSerializer::finalizeChunk(btChunk* chunk, const char* structType, int chunkCode, void* oldPtr)
+{
+	btMutexLock(&m_mutex);
+
+	chunk->m_dna_nr = getReverseType(structType);
+	chunk->m_chunkCode = chunkCode;
+
+	void* uniquePtr = btDefaultSerializer::getUniquePointer(oldPtr);
+	m_chunkP.insert(oldPtr,uniquePtr);
+
+	//arrays are keyed by their chunk data, which is freed below and can be allocated again for another chunk
+	const bool keyedByData = (oldPtr==chunk->m_oldPtr);
+	chunk->m_oldPtr = uniquePtr;
+	if (keyedByData)
+	{
+		m_chunkP.remove(oldPtr);
+		m_uniquePointers.remove(oldPtr);
+	}
+
+	//pad the chunk so the data of the next one is 16 byte aligned, nothing follows the DNA
+	const int length = int(sizeof(btChunk))+chunk->m_length;
+	const int padding = (chunkCode==BT_DNA_CODE) ? 0 : btGetChunkPadding(m_currentSize+length);
+	chunk->m_length += padding;
+	writeToSink(chunk,length);
+	if (padding)
+	{
+		static const unsigned char zeros[16] = {0};
+		writeToSink(zeros,padding);
+	}
+
+	btMutexUnlock(&m_mutex);
+
+	btAlignedFree(chunk);
+}
+
+void*	btStreamSerializer::findPointer(void* oldPtr)
+{
+	btMutexLock(&m_mutex);
+
+	void* uniquePtr = 0;
+	void** ptr = m_chunkP.find(oldPtr);
+	if (ptr)
+	{
+		uniquePtr = *ptr;
+	} else
+	{
+		//reserve the pointer for the caller, who serializes it
+		m_chunkP.insert(oldPtr,btDefaultSerializer::getUniquePointer(oldPtr));
+	}
+
+	btMutexUnlock(&m_mutex);
+	return uniquePtr;
+}
+
+void*	btStreamSerializer::getUniquePointer(void* oldPtr)
+{
+	btMutexLock(&m_mutex);
+	void* uniquePtr = btDefaultSerializer::getUniquePointer(oldPtr);
+	btMutexUnlock(&m_mutex);
+	return uniquePtr;
+}
@@ -14,6 +14,7 @@ subject to the following restrictions:
 
 
 #include "btThreads.h"
+#include "btMinMax.h"
 
 //
 // Lightweight spin-mutex based on atomics
@@ -229,3 +230,299 @@ bool btSpinMutex::tryLock()
 
 #endif // #if BT_THREADSAFE
 
+
+
+//
+// Task schedulers
+//
+// btParallelFor forwards to the current task scheduler. The sequential scheduler is the default, so
+// nothing runs in parallel until the application picks a threaded scheduler with btSetTaskScheduler.
+//
+
+btITaskScheduler::btITaskScheduler( const char* name )
+{
+    m_name = name;
+}
+
+
+class btTaskSchedulerSequential : public btITaskScheduler
+{
+public:
+    btTaskSchedulerSequential() : btITaskScheduler( "Sequential" ) {}
+    virtual int getMaxNumThreads() const { return 1; }
+    virtual int getNumThreads() const { return 1; }
+    virtual void setNumThreads( int ) {}
+    virtual void parallelFor( int iBegin, int iEnd, int, const btIParallelForBody& body )
+    {
+        body.forLoop( iBegin, iEnd );
+    }
+};
+
+
+#if BT_THREADSAFE && BT_USE_OPENMP
+
+#include <omp.h>
+
+class btTaskSchedulerOpenMP : public btITaskScheduler
+{
+    int m_numThreads;
+public:
+    btTaskSchedulerOpenMP() : btITaskScheduler( "OpenMP" )
+    {
+        m_numThreads = 0;
+    }
+    virtual int getMaxNumThreads() const
+    {
+        return omp_get_max_threads();
+    }
+    virtual int getNumThreads() const
+    {
+        return m_numThreads;
+    }
+    virtual void setNumThreads( int numThreads )
+    {
+        m_numThreads = btMax( 1, btMin( int( BT_MAX_THREAD_COUNT ), numThreads ) );
+        omp_set_num_threads( m_numThreads );
+    }
+    virtual void parallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body )
+    {
+        if ( omp_in_parallel() || iEnd - iBegin <= grainSize )
+        {
+            body.forLoop( iBegin, iEnd );
+            return;
+        }
+#pragma omp parallel for schedule( static, 1 )
+        for ( int i = iBegin; i < iEnd; i += grainSize )
+        {
+            body.forLoop( i, btMin( i + grainSize, iEnd ) );
+        }
+    }
+};
+
+#endif // #if BT_THREADSAFE && BT_USE_OPENMP
+
+
+#if BT_THREADSAFE && USE_CPP11_ATOMICS
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+//
+// btTaskSchedulerThreadPool -- a pool of sleeping worker threads. The calling thread takes part in
+// the work, and items are handed out in chunks of grainSize through an atomic counter.
+// Workers live as long as the pool: setNumThreads parks the ones it doesn't need instead of
+// joining them, so the thread indices (see btGetCurrentThreadIndex) of the workers stay the same.
+//
+class btTaskSchedulerThreadPool : public btITaskScheduler
+{
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+    unsigned int m_generation;
+    // the workers with a slot below m_numActiveWorkers take part in the jobs, the others are parked
+    int m_numActiveWorkers;
+    int m_jobWorkers;
+    int m_pendingWorkers;
+    bool m_quit;
+
+    const btIParallelForBody* m_body;
+    std::atomic<int> m_nextIndex;
+    int m_endIndex;
+    int m_grainSize;
+
+    // held while a parallelFor is running, nested or concurrent calls run on the calling thread
+    btSpinMutex m_busy;
+
+    void runJob()
+    {
+        for ( ;; )
+        {
+            int i = m_nextIndex.fetch_add( m_grainSize );
+            if ( i >= m_endIndex )
+            {
+                break;
+            }
+            m_body->forLoop( i, btMin( i + m_grainSize, m_endIndex ) );
+        }
+    }
+
+    // generation is the job generation when the worker was started, read under m_mutex
+    void workerLoop( int slot, unsigned int generation )
+    {
+        // claim a thread index before any job runs
+        btGetCurrentThreadIndex();
+        for ( ;; )
+        {
+            {
+                std::unique_lock<std::mutex> lock( m_mutex );
+                while ( !m_quit && m_generation == generation )
+                {
+                    m_wakeCondition.wait( lock );
+                }
+                if ( m_quit )
+                {
+                    return;
+                }
+                generation = m_generation;
+                if ( slot >= m_jobWorkers )
+                {
+                    // parked, this job isn't counting on us
+                    continue;
+                }
+            }
+            runJob();
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                if ( --m_pendingWorkers == 0 )
+                {
+                    m_doneCondition.notify_one();
+                }
+            }
+        }
+    }
+
+    void stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_quit = true;
+        }
+        m_wakeCondition.notify_all();
+        for ( size_t i = 0; i < m_workers.size(); ++i )
+        {
+            m_workers[ i ].join();
+        }
+        m_workers.clear();
+        m_quit = false;
+    }
+
+public:
+    btTaskSchedulerThreadPool() : btITaskScheduler( "ThreadPool" )
+    {
+        m_generation = 0;
+        m_numActiveWorkers = 0;
+        m_jobWorkers = 0;
+        m_pendingWorkers = 0;
+        m_quit = false;
+        m_body = NULL;
+        m_endIndex = 0;
+        m_grainSize = 1;
+    }
+    virtual ~btTaskSchedulerThreadPool()
+    {
+        stopWorkers();
+    }
+    virtual int getMaxNumThreads() const
+    {
+        int hardwareThreads = int( std::thread::hardware_concurrency() );
+        return btMax( 1, btMin( int( BT_MAX_THREAD_COUNT ), hardwareThreads ) );
+    }
+    virtual int getNumThreads() const
+    {
+        return m_numActiveWorkers + 1;
+    }
+    virtual void setNumThreads( int numThreads )
+    {
+        numThreads = btMax( 1, btMin( int( BT_MAX_THREAD_COUNT ), numThreads ) );
+        m_busy.lock();
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            // only start the workers that are missing, so no thread index is used up twice
+            for ( int slot = int( m_workers.size() ); slot < numThreads - 1; ++slot )
+            {
+                m_workers.push_back( std::thread( &btTaskSchedulerThreadPool::workerLoop, this, slot, m_generation ) );
+            }
+            m_numActiveWorkers = numThreads - 1;
+        }
+        m_busy.unlock();
+    }
+    virtual void parallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body )
+    {
+        grainSize = btMax( 1, grainSize );
+        if ( iEnd - iBegin <= grainSize || m_numActiveWorkers == 0 || !m_busy.tryLock() )
+        {
+            body.forLoop( iBegin, iEnd );
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_body = &body;
+            m_nextIndex.store( iBegin );
+            m_endIndex = iEnd;
+            m_grainSize = grainSize;
+            m_jobWorkers = m_numActiveWorkers;
+            m_pendingWorkers = m_jobWorkers;
+            ++m_generation;
+        }
+        m_wakeCondition.notify_all();
+        runJob();
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            while ( m_pendingWorkers > 0 )
+            {
+                m_doneCondition.wait( lock );
+            }
+            m_body = NULL;
+        }
+        m_busy.unlock();
+    }
+};
+
+#endif // #if BT_THREADSAFE && USE_CPP11_ATOMICS
+
+
+static btTaskSchedulerSequential gSequentialTaskScheduler;
+static btITaskScheduler* gBtTaskScheduler = &gSequentialTaskScheduler;
+
+
+void btSetTaskScheduler( btITaskScheduler* ts )
+{
+#if BT_THREADSAFE
+    // the main thread must get thread index 0
+    btGetCurrentThreadIndex();
+#endif
+    gBtTaskScheduler = ts ? ts : &gSequentialTaskScheduler;
+}
+
+btITaskScheduler* btGetTaskScheduler()
+{
+    return gBtTaskScheduler;
+}
+
+btITaskScheduler* btGetSequentialTaskScheduler()
+{
+    return &gSequentialTaskScheduler;
+}
+
+btITaskScheduler* btGetThreadPoolTaskScheduler()
+{
+#if BT_THREADSAFE && USE_CPP11_ATOMICS
+    static btTaskSchedulerThreadPool sThreadPoolScheduler;
+    return &sThreadPoolScheduler;
+#else
+    return NULL;
+#endif
+}
+
+btITaskScheduler* btGetOpenMPTaskScheduler()
+{
+#if BT_THREADSAFE && BT_USE_OPENMP
+    static btTaskSchedulerOpenMP sOpenMPScheduler;
+    return &sOpenMPScheduler;
+#else
+    return NULL;
+#endif
+}
+
+void btParallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body )
+{
+#if BT_THREADSAFE
+    gBtTaskScheduler->parallelFor( iBegin, iEnd, grainSize, body );
+#else
+    // without threads, skip the scheduler altogether
+    (void) grainSize;
+    body.forLoop( iBegin, iEnd );
+#endif
+}
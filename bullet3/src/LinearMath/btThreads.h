@@ -60,7 +60,6 @@ SIMD_FORCE_INLINE bool btMutexTryLock( btSpinMutex* mutex )
 // for internal use only
 bool btIsMainThread();
 unsigned int btGetCurrentThreadIndex();
-const unsigned int BT_MAX_THREAD_COUNT = 64;
 
 #else
 
@@ -69,7 +68,65 @@ const unsigned int BT_MAX_THREAD_COUNT = 64;
 SIMD_FORCE_INLINE void btMutexLock( btSpinMutex* ) {}
 SIMD_FORCE_INLINE void btMutexUnlock( btSpinMutex* ) {}
 SIMD_FORCE_INLINE bool btMutexTryLock( btSpinMutex* ) {return true;}
+
+// without threads, everything runs on the main thread
+SIMD_FORCE_INLINE bool btIsMainThread() {return true;}
+SIMD_FORCE_INLINE unsigned int btGetCurrentThreadIndex() {return 0;}
 #endif
 
+const unsigned int BT_MAX_THREAD_COUNT = 64;
+
+///
+/// btIParallelForBody -- subclass this to express work that can be done in parallel
+///
+class btIParallelForBody
+{
+public:
+    virtual ~btIParallelForBody() {}
+    virtual void forLoop( int iBegin, int iEnd ) const = 0;
+};
+
+///
+/// btITaskScheduler -- subclass this to implement a task scheduler that can dispatch work to
+///                     worker threads
+///
+class btITaskScheduler
+{
+public:
+    btITaskScheduler( const char* name );
+    virtual ~btITaskScheduler() {}
+    const char* getName() const { return m_name; }
+
+    virtual int getMaxNumThreads() const = 0;
+    virtual int getNumThreads() const = 0;
+    virtual void setNumThreads( int numThreads ) = 0;
+    // calls body.forLoop on subranges of [iBegin, iEnd) of at most grainSize items, possibly from several threads.
+    // Must be safe to call from inside a body: nested calls may run the whole range on the calling thread.
+    virtual void parallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body ) = 0;
+
+protected:
+    const char* m_name;
+};
+
+// set the task scheduler to use for all calls to btParallelFor()
+// NOTE: call this from the main thread, before any parallel work is started
+void btSetTaskScheduler( btITaskScheduler* ts );
+
+// get the current task scheduler (the sequential one unless another was set)
+btITaskScheduler* btGetTaskScheduler();
+
+// get non-threaded task scheduler (always available)
+btITaskScheduler* btGetSequentialTaskScheduler();
+
+// get a pool of C++11 worker threads (returns NULL unless BT_THREADSAFE is set and the compiler supports C++11 threads)
+btITaskScheduler* btGetThreadPoolTaskScheduler();
+
+// get OpenMP task scheduler (returns NULL unless BT_THREADSAFE and BT_USE_OPENMP are set)
+btITaskScheduler* btGetOpenMPTaskScheduler();
+
+// btParallelFor -- call this to dispatch work like a for-loop
+//                 (iterations may be done out of order, so no dependencies are allowed)
+void btParallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body );
+
 
 #endif //BT_THREADS_H